@@ -69,14 +69,17 @@ function(libstored_lib libprefix libpath)
 		${LIBSTORED_SOURCE_DIR}/include/libstored/components.h
 		${LIBSTORED_SOURCE_DIR}/include/libstored/debugger.h
 		${LIBSTORED_SOURCE_DIR}/include/libstored/directory.h
+		${LIBSTORED_SOURCE_DIR}/include/libstored/doublebuffer.h
 		${LIBSTORED_SOURCE_DIR}/include/libstored/macros.h
 		${LIBSTORED_SOURCE_DIR}/include/libstored/poller.h
+		${LIBSTORED_SOURCE_DIR}/include/libstored/snapshot.h
 		${LIBSTORED_SOURCE_DIR}/include/libstored/spm.h
 		${LIBSTORED_SOURCE_DIR}/include/libstored/synchronizer.h
 		${LIBSTORED_SOURCE_DIR}/include/libstored/types.h
 		${LIBSTORED_SOURCE_DIR}/include/libstored/util.h
 		${LIBSTORED_SOURCE_DIR}/include/libstored/version.h
 		${LIBSTORED_SOURCE_DIR}/include/libstored/zmq.h
+		${LIBSTORED_SOURCE_DIR}/src/allocator.cpp
 		${LIBSTORED_SOURCE_DIR}/src/compress.cpp
 		${LIBSTORED_SOURCE_DIR}/src/directory.cpp
 		${LIBSTORED_SOURCE_DIR}/src/debugger.cpp
@@ -166,6 +169,9 @@ function(libstored_lib libprefix libpath)
 
 	if(WIN32)
 		target_link_libraries(${LIBSTORED_LIB_TARGET} INTERFACE ws2_32)
+	elseif(CMAKE_SYSTEM_NAME STREQUAL "Linux")
+		# shm_open() of the ShmLayer, for glibc < 2.34.
+		target_link_libraries(${LIBSTORED_LIB_TARGET} INTERFACE rt)
 	endif()
 
 	if(LIBSTORED_HAVE_HEATSHRINK)
@@ -8,6 +8,7 @@
 import re
 import struct
 import copy
+import os
 import sys
 
 cnames = {}
@@ -161,8 +162,10 @@ class Directory(object):
         return res
 
     def hierarchical(self, objects):
-        # Extract and sort on name.
-        objects = sorted(map(lambda o: (o.name, o), objects), key=lambda x: x[0])
+        # Extract and sort on name.  An array resolves the index of the
+        # element itself, so its entry ends at the [.
+        objects = sorted(map(lambda o: (o.name + '[' if isinstance(o, ArrayVariable) else o.name, o),
+            objects), key=lambda x: x[0])
 
         # Split in hierarchy.
         objects = map(lambda x: (list(x[0] + '\x00'), x[1]), objects)
@@ -198,6 +201,8 @@ class Directory(object):
     def generateDict(self, h):
         if isinstance(h, Variable):
             return self.encodeType(h) + self.encodeInt(h.offset)
+        elif isinstance(h, ArrayVariable):
+            return [0x7f] + self.encodeInt(h.len) + self.encodeType(h.element) + self.encodeInt(h.offset)
         elif isinstance(h, Function):
 #            print(f'function {h.name} {h.f}')
             return self.encodeType(h) + self.encodeInt(h.f)
@@ -318,17 +323,73 @@ class Directory(object):
                     del v[vk]
 #        print(f'stripped {h}')
 
-    def generate(self, objects):
-        h = self.hierarchical(objects)
+    def generate(self, objects, arrays = None):
+        # Contiguous arrays are single objects, instead of one per element.
+        if arrays is None:
+            arrays = []
+        names = set(a.name for a in arrays)
+        objects = [o for o in objects
+            if not (isinstance(o, Variable) and o.element is not None and o.arrayName() in names)]
+        h = self.hierarchical(objects + arrays)
         self.longdata = [ord('/')] + self.generateDict(h) + [0]
         self.stripUnambig(h)
         self.data = [ord('/')] + self.generateDict(h) + [0]
 #        print(self.data)
 
+def cuint(xs):
+    # Smallest unsigned C type that can hold all given values.
+    m = max(xs, default=0)
+    if m < 0x100:
+        return 'uint8_t'
+    elif m < 0x10000:
+        return 'uint16_t'
+    else:
+        return 'uint32_t'
+
+class VariableTable(object):
+    # Flat arrays of all variables, sorted by offset, for bulk operations.
+    def __init__(self):
+        self.count = 0
+        self.types = [0]
+        self.offsets = [0]
+        self.sizes = [0]
+        self.nameOffsets = [0]
+        self.names = [0]
+        self.offsetType = 'uint8_t'
+        self.sizeType = 'uint8_t'
+        self.nameOffsetType = 'uint8_t'
+
+    def generate(self, objects):
+        variables = sorted(filter(lambda o: isinstance(o, Variable), objects),
+            key=lambda o: o.offset)
+
+        self.count = len(variables)
+        if self.count == 0:
+            # Prevent zero-length arrays.
+            return
+
+        self.types = [typeflags(v.type) for v in variables]
+        self.offsets = [v.offset for v in variables]
+        self.sizes = [v.size for v in variables]
+        self.nameOffsets = []
+        self.names = []
+        for v in variables:
+            self.nameOffsets.append(len(self.names))
+            self.names += list(('/' + v.name).encode()) + [0]
+
+        self.offsetType = cuint(self.offsets)
+        self.sizeType = cuint(self.sizes)
+        self.nameOffsetType = cuint(self.nameOffsets)
+
 class Buffer(object):
     def __init__(self):
         self.size = 0
         self.init = []
+        self.initRanges = []
+        self.initData = []
+        self.initRangeType = 'uint8_t'
+        self.alignment = None
+        self.layout = None
 
     def align(self, size, force=None):
         a = 8
@@ -368,6 +429,83 @@ class Buffer(object):
         if self.size == 0:
             self.size = 1
 
+        self.generateInitRanges()
+
+    def generateInitRanges(self, gap = 8):
+        # Only the non-zero bytes of the initial buffer image are emitted, as
+        # (offset, length) ranges.  Ranges that are separated by less than
+        # gap zeros are merged, as copying a few zeros is cheaper than an
+        # additional range.
+        ranges = []
+        for i in range(0, len(self.init)):
+            if self.init[i] == 0:
+                continue
+            if len(ranges) > 0 and i - ranges[-1][1] < gap:
+                ranges[-1][1] = i + 1
+            else:
+                ranges.append([i, i + 1])
+
+        self.initRanges = [(start, end - start) for (start, end) in ranges]
+        self.initData = []
+        for (start, end) in ranges:
+            self.initData += self.init[start:end]
+        self.initRangeType = cuint([self.size])
+
+    def generateGroups(self, groups, littleEndian = True, cacheline = 64):
+        # Every group is a (label, align start, align end, variables) tuple.
+        init = bytearray()
+        offset = 0
+        padded = False
+        self.used = 0
+        self.layout = []
+        self.alignment = None
+
+        for (label, alignStart, alignEnd, variables) in groups:
+            padding = 0
+            if alignStart or padded:
+                start = self.align(offset, cacheline)
+                padding += start - offset
+                offset = start
+                self.alignment = cacheline
+
+            start = offset
+            for v in variables:
+                size = v.buffersize()
+                o = self.align(offset, max(1, min(self.align(size), 8)))
+                padding += o - offset
+                self.used += size
+                v.offset = o
+                offset = o + size
+                if v.init is not None:
+                    if len(init) < o:
+                        init += bytes(o - len(init))
+                    init += v.encode(v.init, littleEndian)
+
+            padded = alignEnd
+            self.layout.append((label, start, offset - start, padding))
+
+        self.size = self.align(offset, self.alignment if self.alignment is not None else 8)
+        if self.size == 0:
+            self.size = 1
+        self.init = list(init)
+        self.generateInitRanges()
+
+    def padding(self):
+        return self.size - self.used
+
+    def keySize(self):
+        # Number of bytes of a key, like stored::StoreJournal::keySize().
+        return (self.size.bit_length() + 7) // 8
+
+    def report(self):
+        res = ['  offset     size  padding  group']
+        for (label, offset, size, padding) in self.layout:
+            res.append(f'{offset:8} {size:8} {padding:8}  {label}')
+        pad = self.padding()
+        res.append(f'buffer size {self.size} bytes, of which {pad} bytes ' +
+            f'({100 * pad / self.size:.1f}%) padding')
+        return res
+
 class ArrayLookup(object):
     def __init__(self, objects):
         # All objects should have the same name, but only differ in their array index.
@@ -441,18 +579,41 @@ class ArrayLookup(object):
         return self.cname + '(' + ', '.join([f'int {x}' for x in self.placeholders()]) + ')'
 
 class Store(object):
-    def __init__(self, objects):
+    def __init__(self, objects, pragmas = []):
         self.objects = objects
         self.buffer = Buffer()
         self.directory = Directory()
+        self.variableTable = VariableTable()
         self.littleEndian = True
         self.hash = None
+        self.cacheline = 64
+        self.separateWriters = False
+        self.layout = len(pragmas) > 0
+
+        for p in pragmas:
+            if p.key == 'cacheline' and p.value is not None:
+                try:
+                    self.cacheline = int(p.value, 0)
+                except ValueError:
+                    self.cacheline = 0
+                if self.cacheline <= 0 or self.cacheline & (self.cacheline - 1) != 0:
+                    sys.exit(f'Cache line size must be a power of 2')
+            elif p.key == 'cacheline':
+                sys.exit(f'Pragma @@cacheline requires a value, like @@cacheline=64')
+            elif p.key == 'separate_writers' and p.value is None:
+                self.separateWriters = True
+            elif p.key == 'separate_writers':
+                sys.exit(f'Pragma @@separate_writers does not take a value')
+            else:
+                sys.exit(f'Unknown pragma @@{p.key}')
 
     def process(self):
         self.flattenScopes()
         self.checkNames()
         self.generateBuffer()
+        self.generateArrayVariables()
         self.generateDirectory()
+        self.generateVariableTable()
         self.extractArrayAccessors()
         self.generateAxiAddresses()
 
@@ -465,6 +626,7 @@ class Store(object):
                 flatten = self.flattenScope(self.expandArrays(o.objects))
                 for f in flatten:
                     f.setName(o.name + '/' + f.name)
+                    f.inherit(o)
                 res += flatten
             else:
                 res.append(o)
@@ -489,6 +651,8 @@ class Store(object):
                     newo = self.copy(o)
                     newo.len = 1
                     newo.setName(newo.name + f'[{i}]')
+                    if isinstance(newo, Variable):
+                        newo.element = (i, o.len)
                     os.append(newo)
             else:
                 os.append(o)
@@ -516,10 +680,86 @@ class Store(object):
 
         initvars.sort(key=lambda o: o.size, reverse=True)
         defaultvars.sort(key=lambda o: o.size, reverse=True)
-        self.buffer.generate(initvars, defaultvars, self.littleEndian)
+
+        if self.layout or any(map(lambda o: o.annotated(), initvars + defaultvars)):
+            self.buffer.generateGroups(
+                self.layoutGroups(initvars + defaultvars), self.littleEndian, self.cacheline)
+        else:
+            self.buffer.generate(initvars, defaultvars, self.littleEndian)
+
+    def layoutGroups(self, variables):
+        # Split the variables, which are sorted by size, into groups.  Per
+        # writer: hot variables, normal ones, cold ones.  Every @align
+        # block gets a group of its own, following the group of its
+        # temperature.  Hot variables start at a cache line, such that
+        # they occupy as few lines as possible.  Writers and @align blocks
+        # do not share cache lines with others.
+        writers = [None]
+        if self.separateWriters:
+            writers = []
+            for o in self.objects:
+                if isinstance(o, Variable) and o.writer not in writers:
+                    writers.append(o.writer)
+            if None in writers:
+                # Variables without writer go last.
+                writers.remove(None)
+                writers.append(None)
+
+        groups = []
+        for w in writers:
+            first = self.separateWriters
+            for t in ['hot', None, 'cold']:
+                vs = [v for v in variables if v.temperature == t and \
+                    (not self.separateWriters or v.writer == w)]
+                blocks = []
+                for v in vs:
+                    if v.block is not None and v.block not in blocks:
+                        blocks.append(v.block)
+
+                label = ' '.join(filter(None, [
+                    (w if w is not None else '(no writer)') if self.separateWriters else None,
+                    t if t is not None else 'normal']))
+
+                packed = [v for v in vs if v.block is None]
+                if len(packed) > 0:
+                    groups.append((label, t == 'hot' or first, False, packed))
+                    first = False
+
+                for b in blocks:
+                    bvs = [v for v in vs if v.block is b]
+                    name = os.path.commonprefix([v.name for v in bvs]).rstrip('/[')
+                    groups.append((f'{label} {name}', True, True, bvs))
+                    first = False
+
+        return groups
+
+    def generateArrayVariables(self):
+        # Arrays of fixed-length variables get an accessor for all elements,
+        # and a single entry in the directory.  The elements are normally
+        # contiguous in the buffer, as they have the same size and
+        # annotations, and are sorted stably.  If the layout separated them
+        # anyway, the array only gets its per-element variables, which are in
+        # the directory one by one.
+        self.arrayVariables = []
+        byName = {x.name: x for x in self.objects}
+        for o in self.objects:
+            if isinstance(o, Variable) and not o.isBlob() and \
+                o.element is not None and o.element[0] == 0:
+                    a = ArrayVariable(o)
+                    contiguous = True
+                    for i in range(1, a.len):
+                        e = byName[f'{a.name}[{i}]']
+                        if e.offset != o.offset + i * o.size:
+                            contiguous = False
+                            break
+                    if contiguous:
+                        self.arrayVariables.append(a)
 
     def generateDirectory(self):
-        self.directory.generate(self.objects)
+        self.directory.generate(self.objects, self.arrayVariables)
+
+    def generateVariableTable(self):
+        self.variableTable.generate(self.objects)
 
     def extractArrayAccessors(self):
         # Find all objects that look like having one or more arrays
@@ -556,9 +796,41 @@ class Store(object):
 
 
 class Object(object):
-    def __init__(self, parent, name, len = 0):
+    def __init__(self, parent, name, len = 0, annotations = []):
         self.setName(name)
         self.len = len if isinstance(len, int) and len > 1 else 1
+        self.temperature = None
+        self.writer = None
+        self.block = None
+        self.aligned = False
+        self.element = None
+
+        for a in annotations:
+            if a.key in ['hot', 'cold'] and a.value is None:
+                self.temperature = a.key
+            elif a.key == 'writer' and a.value is not None:
+                self.writer = a.value
+            elif a.key == 'align' and a.value is None:
+                self.aligned = True
+            elif a.key in ['hot', 'cold', 'align']:
+                sys.exit(f'Annotation @{a.key} of "{self.name}" does not take a value')
+            elif a.key == 'writer':
+                sys.exit(f'Annotation @writer of "{self.name}" requires a value')
+            else:
+                sys.exit(f'Unknown annotation @{a.key} of "{self.name}"')
+
+    def annotated(self):
+        return self.temperature is not None or self.writer is not None or self.block is not None
+
+    def inherit(self, scope):
+        # Annotations of the object itself take precedence over the ones of
+        # the scope it is in.
+        if self.temperature is None:
+            self.temperature = scope.temperature
+        if self.writer is None:
+            self.writer = scope.writer
+        if self.block is None and scope.aligned:
+            self.block = scope
 
     def setName(self, name):
         self.name = object_name(name)
@@ -587,10 +859,12 @@ class Object(object):
             self.name_index.append((chunks[i], chunks[i+1]))
 
 class Variable(Object):
-    def __init__(self, parent, type, name):
-        super().__init__(self, name)
+    def __init__(self, parent, type, name, annotations = []):
+        super().__init__(self, name, annotations=annotations)
         self.parent = parent
         self.offset = 0
+        if self.aligned:
+            self.block = self
         if type.fixed != None:
             self.type = type.fixed.type
             self.size = csize(type.fixed.type)
@@ -610,6 +884,10 @@ class Variable(Object):
     def isBlob(self):
         return self.type in ['blob', 'string']
 
+    def arrayName(self):
+        # The name of the array this variable is an element of.
+        return self.name[0:self.name.rindex('[')]
+
     def _encode_string(self, x):
         s = x.encode()
         assert len(s) <= self.size
@@ -648,8 +926,11 @@ class Variable(Object):
 class Function(Object):
     f = 1
 
-    def __init__(self, parent, type, name, len):
+    def __init__(self, parent, type, name, len, annotations = []):
         super().__init__(self, name, len)
+        if annotations:
+            # Functions have no memory in the buffer to lay out.
+            sys.exit(f'Annotations are not supported for function "{self.name}"')
         self.parent = parent
         self.offset = self.f
         self.axi = None
@@ -670,9 +951,21 @@ class Function(Object):
     def __str__(self):
         return self.name
 
+class ArrayVariable(object):
+    def __init__(self, element):
+        # element is the first element of the array.
+        self.element = element
+        self.name = element.arrayName()
+        self.cname = cname(self.name)
+        self.offset = element.offset
+        self.len = element.element[1]
+
+    def __str__(self):
+        return self.name
+
 class Scope(Object):
-    def __init__(self, parent, objects, name, len):
-        super().__init__(self, name, len)
+    def __init__(self, parent, objects, name, len, annotations = []):
+        super().__init__(self, name, len, annotations)
         self.parent = parent
         self.objects = objects
 
@@ -284,6 +284,10 @@ def generate_store(model_file, output_dir, littleEndian=True):
     model = load_model(model_file, littleEndian)
     mname = model_name(model_file)
 
+    if model.buffer.layout is not None:
+        for l in model.buffer.report():
+            logger.info(f'  {l}')
+
     with open(model_file, 'rb') as f:
         model.hash = hashlib.sha1(f.read().replace(b'\r\n', b'\n')).hexdigest()
 
@@ -114,12 +114,30 @@ static inline void cleanup(T* p) noexcept
 
 /*!
  * \brief libstored-allocator-aware \c std::function-like type.
+ *
+ * Use \c Callable<R(Args...)>::type as the type.  A callable object that
+ * fits in \p Capacity bytes is stored within the Callable; larger ones are
+ * allocated using the Config::Allocator.  Invoking costs one indirect call,
+ * like a function pointer, for any callable object that is stored within the
+ * Callable, such as (capture-less) lambdas.
+ *
+ * When an lvalue functor is passed, a reference to it is stored, not a copy.
+ *
+ * \see #stored::MoveOnlyCallable
  */
 #	if STORED_cplusplus < 201103L
-template <typename F>
+template <typename F, size_t Capacity = 2 * sizeof(void*)>
 struct Callable {
 	typedef F* type;
 };
+
+/*!
+ * \brief Like #stored::Callable, but the callable object does not have to be copyable.
+ */
+template <typename F, size_t Capacity = 2 * sizeof(void*)>
+struct MoveOnlyCallable {
+	typedef F* type;
+};
 #	else // STORED_cplusplus >= 201103L
 namespace impl {
 
@@ -164,262 +182,228 @@ struct CallableArgType<T&&> {
 	using type = T&&;
 };
 
-template <typename R, typename... Args>
+struct CallableNoCopy {};
+
+template <size_t Capacity, bool Copyable, typename R, typename... Args>
 class Callable {
-protected:
-	// NOLINTNEXTLINE(hicpp-special-member-functions,cppcoreguidelines-special-member-functions)
-	class Base {
-	public:
-		virtual ~Base() noexcept = default;
-		virtual R operator()(typename CallableArgType<Args>::type... args) const = 0;
-		// NOLINTNEXTLINE(hicpp-explicit-conversions)
-		virtual operator bool() const
-		{
-			return true;
-		}
-		virtual void clone(void* buffer) const = 0;
-		virtual void move(void* buffer)
-		{
-			clone(buffer);
-		}
+public:
+	enum {
+		/*! \brief Size of the buffer for the callable object. */
+		capacity = max<size_t>(Capacity, sizeof(void*))
 	};
 
-	// NOLINTNEXTLINE(hicpp-special-member-functions,cppcoreguidelines-special-member-functions)
-	class Reset final : public Base {
-	public:
-		// NOLINTNEXTLINE(hicpp-special-member-functions,cppcoreguidelines-special-member-functions)
-		virtual ~Reset() noexcept = default;
+protected:
+	using Invoke = R (*)(void*, typename CallableArgType<Args>::type...);
 
-		R operator()(typename CallableArgType<Args>::type... /*args*/) const final
+	struct Ops {
+		void (*destroy)(void* buffer);
+		void (*copy)(void* dst, void const* src);
+		// Move src to dst, and leave src destroyed.
+		void (*move)(void* dst, void* src);
+	};
+
+	/*!
+	 * \brief Handler for a callable object that is stored in the buffer.
+	 */
+	template <typename F>
+	struct Inline {
+		static F& target(void* buffer) noexcept
 		{
-#		ifdef STORED_cpp_exceptions
-			throw std::bad_function_call();
-#		else
-			std::terminate();
-#		endif
+			return *static_cast<F*>(buffer);
 		}
 
-		// NOLINTNEXTLINE(hicpp-explicit-conversions)
-		operator bool() const final
+		template <typename G>
+		static void construct(void* buffer, G&& g)
 		{
-			return false;
+			new(buffer) F{std::forward<G>(g)};
 		}
 
-		void clone(void* buffer) const final
+		static R invoke(void* buffer, typename CallableArgType<Args>::type... args)
 		{
-			new(buffer) Reset;
+			return target(buffer)(
+				std::forward<typename CallableArgType<Args>::type>(args)...);
 		}
-	};
 
-	template <typename F, bool Dummy = false>
-	// NOLINTNEXTLINE(hicpp-special-member-functions,cppcoreguidelines-special-member-functions)
-	class Wrapper final : public Base {
-	public:
-		virtual ~Wrapper() noexcept = default;
-
-		template <
-			typename F_,
-			typename std::enable_if<
-				!std::is_same<typename std::decay<F_>::type, Wrapper>::value,
-				int>::type = 0>
-		// NOLINTNEXTLINE(misc-forwarding-reference-overload,bugprone-forwarding-reference-overload)
-		explicit Wrapper(F_&& f)
-			: m_f{std::forward<F_>(f)}
-		{}
-
-		R operator()(typename CallableArgType<Args>::type... args) const final
+		static void destroy(void* buffer) noexcept
 		{
-			return m_f(std::forward<typename CallableArgType<Args>::type>(args)...);
+			target(buffer).~F();
 		}
 
-		void clone(void* buffer) const final
+		static void copy(void* dst, void const* src)
 		{
-			new(buffer) Wrapper(m_f);
+			new(dst) F{*static_cast<F const*>(src)};
 		}
 
-		void move(void* buffer) final
+		static void move(void* dst, void* src) noexcept
 		{
-			new(buffer) Wrapper(std::move(m_f));
+			new(dst) F{std::move(target(src))};
+			destroy(src);
 		}
-
-	private:
-		F m_f;
 	};
 
-	template <bool Dummy>
-	// NOLINTNEXTLINE(hicpp-special-member-functions,cppcoreguidelines-special-member-functions)
-	class Wrapper<R(Args...), Dummy> final : public Base {
-	public:
-		virtual ~Wrapper() noexcept = default;
-
-		template <typename F_>
-		explicit Wrapper(R (*f)(Args...)) noexcept
-			: m_f{f}
-		{}
-
-		R operator()(typename CallableArgType<Args>::type... args) const final
+	/*!
+	 * \brief Handler for a callable object that does not fit in the buffer.
+	 */
+	template <typename F>
+	struct Heap {
+		static F*& ptr(void* buffer) noexcept
 		{
-			return m_f(std::forward<typename CallableArgType<Args>::type>(args)...);
+			return *static_cast<F**>(buffer);
 		}
 
-		void clone(void* buffer) const final
+		template <typename G>
+		static void construct(void* buffer, G&& g)
 		{
-			new(buffer) Wrapper(m_f);
+			new(buffer) F*{new(allocate<F>()) F{std::forward<G>(g)}};
 		}
 
-	private:
-		R (*m_f)(Args...);
-	};
-
-	template <typename T, bool Dummy>
-	// NOLINTNEXTLINE(hicpp-special-member-functions,cppcoreguidelines-special-member-functions)
-	class Wrapper<T&, Dummy> final : public Base {
-	public:
-		virtual ~Wrapper() noexcept = default;
-
-		// cppcheck-suppress uninitMemberVar
-		explicit Wrapper(T& obj) noexcept
-			: m_obj{&obj}
-		{}
-
-		R operator()(typename CallableArgType<Args>::type... args) const final
+		static R invoke(void* buffer, typename CallableArgType<Args>::type... args)
 		{
-			return (*m_obj)(
+			return (*ptr(buffer))(
 				std::forward<typename CallableArgType<Args>::type>(args)...);
 		}
 
-		void clone(void* buffer) const final
+		static void destroy(void* buffer) noexcept
 		{
-			new(buffer) Wrapper(*m_obj);
+			cleanup(ptr(buffer));
 		}
 
-	private:
-		T* m_obj;
-	};
-
-	template <typename F>
-	class Forwarder final : public Base {
-	public:
-		template <
-			typename F_,
-			typename std::enable_if<
-				!std::is_same<typename std::decay<F_>::type, Forwarder>::value,
-				int>::type = 0>
-		// NOLINTNEXTLINE(misc-forwarding-reference-overload,bugprone-forwarding-reference-overload)
-		explicit Forwarder(F_&& f)
-			: m_w{new(allocate<Wrapper<F>>()) Wrapper<F>(std::forward<F_>(f))}
-		{}
-
-		explicit Forwarder(Wrapper<F>& w) noexcept
-			: m_w{&w}
-		{}
-
-		Forwarder(Forwarder&& f) noexcept
-			: m_w{}
+		static void copy(void* dst, void const* src)
 		{
-			(*this) = std::move(f);
+			construct(dst, **static_cast<F* const*>(src));
 		}
 
-		Forwarder& operator=(Forwarder&& f) noexcept
+		static void move(void* dst, void* src) noexcept
 		{
-			cleanup(m_w);
-			m_w = f.m_w;
-			f.m_w = nullptr;
-			return *this;
+			new(dst) F*{ptr(src)};
 		}
+	};
 
-		Forwarder(Forwarder const& f)
-			: m_w{}
+	/*!
+	 * \brief Handler for a reference to a callable object.
+	 */
+	template <typename T>
+	struct Reference {
+		static T*& ptr(void* buffer) noexcept
 		{
-			(*this) = f;
+			return *static_cast<T**>(buffer);
 		}
 
-		Forwarder& operator=(Forwarder const& f)
+		static void construct(void* buffer, T& t) noexcept
 		{
-			if(&f != this) {
-				auto w = allocate<Wrapper<F>>();
-				try {
-					f.m_w->clone(w);
-					m_w = w;
-				} catch(...) {
-					cleanup(w);
-#		ifdef STORED_cpp_exceptions
-					throw;
-#		endif
-				}
-			}
-			return *this;
+			new(buffer) T*{&t};
 		}
 
-		virtual ~Forwarder() noexcept
+		static R invoke(void* buffer, typename CallableArgType<Args>::type... args)
 		{
-			cleanup(m_w);
+			return (*ptr(buffer))(
+				std::forward<typename CallableArgType<Args>::type>(args)...);
 		}
 
-		R operator()(typename CallableArgType<Args>::type... args) const final
-		{
-			return (*m_w)(std::forward<typename CallableArgType<Args>::type>(args)...);
-		}
+		static void destroy(void* /*buffer*/) noexcept {}
 
-		void clone(void* buffer) const final
+		static void copy(void* dst, void const* src) noexcept
 		{
-			new(buffer) Forwarder(*this);
+			new(dst) T*{*static_cast<T* const*>(src)};
 		}
 
-		void move(void* buffer) final
+		static void move(void* dst, void* src) noexcept
 		{
-			new(buffer) Forwarder(std::move(*this));
+			new(dst) T*{ptr(src)};
 		}
+	};
 
-	private:
-		Wrapper<F>* m_w;
+	template <typename F>
+	struct HandlerType {
+		using type = typename std::conditional<
+			sizeof(F) <= (size_t)capacity && alignof(F) <= alignof(void*)
+				&& std::is_nothrow_move_constructible<F>::value,
+			Inline<F>, Heap<F>>::type;
 	};
 
-	using Buffer = std::array<
-		char, max(sizeof(Reset), sizeof(Forwarder<R (*)(Args...)>),
-			  sizeof(Wrapper<R (*)(Args...)>) + sizeof(void*))>;
+	template <typename T>
+	struct HandlerType<T&> {
+		using type = Reference<T>;
+	};
 
-public:
-	explicit Callable()
+	template <typename H>
+	static constexpr void (*copyOp(std::true_type) noexcept)(void*, void const*)
+	{
+		return &H::copy;
+	}
+
+	template <typename H>
+	static constexpr void (*copyOp(std::false_type) noexcept)(void*, void const*)
 	{
-		construct<Reset>();
+		return nullptr;
 	}
 
+	template <typename H>
+	static Ops const* ops() noexcept
+	{
+		static Ops const o = {
+			&H::destroy, copyOp<H>(std::integral_constant<bool, Copyable>()), &H::move};
+		return &o;
+	}
+
+	static R invokeReset(void* /*buffer*/, typename CallableArgType<Args>::type... /*args*/)
+	{
+#		ifdef STORED_cpp_exceptions
+		throw std::bad_function_call();
+#		else
+		std::terminate();
+#		endif
+	}
+
+	using CopySource =
+		typename std::conditional<Copyable, Callable, CallableNoCopy>::type;
+
+public:
+	explicit Callable() noexcept
+		: m_invoke{&invokeReset}
+		, m_ops{}
+	{}
+
 	template <
 		typename G, typename std::enable_if<
 				    !std::is_same<typename std::decay<G>::type, Callable>::value,
 				    int>::type = 0>
 	// NOLINTNEXTLINE(misc-forwarding-reference-overload,bugprone-forwarding-reference-overload)
 	explicit Callable(G&& g)
+		: Callable{}
 	{
 		assign(std::forward<G>(g));
 	}
 
-	Callable(Callable const& c)
+	// This is the copy constructor, if Copyable.
+	// NOLINTNEXTLINE(hicpp-explicit-conversions)
+	Callable(CopySource const& c)
+		: Callable{}
 	{
-		c.get().clone(m_buffer.data());
+		copy(c);
 	}
 
 	Callable(Callable&& c) noexcept
+		: Callable{}
 	{
-		c.get().move(m_buffer.data());
-		c = nullptr;
+		move(c);
 	}
 
 	~Callable() noexcept
 	{
-		get().~Base();
+		destroy();
 	}
 
 	R operator()(typename CallableArgType<Args>::type... args) const
 	{
-		return get()(std::forward<typename CallableArgType<Args>::type>(args)...);
+		return m_invoke(
+			m_buffer.data(), std::forward<typename CallableArgType<Args>::type>(args)...);
 	}
 
 	// NOLINTNEXTLINE(hicpp-explicit-conversions)
 	operator bool() const noexcept
 	{
-		return get();
+		return m_ops != nullptr;
 	}
 
 	template <
@@ -428,113 +412,114 @@ public:
 				    int>::type = 0>
 	Callable& operator=(G&& g)
 	{
-		replace(std::forward<G>(g));
+		destroy();
+		assign(std::forward<G>(g));
 		return *this;
 	}
 
-	Callable& operator=(Callable const& c)
+	// This is the copy assignment, if Copyable.
+	Callable& operator=(CopySource const& c)
 	{
 		if(&c != this) {
 			destroy();
-			try {
-				c.get().clone(m_buffer.data());
-			} catch(...) {
-				construct<Reset>();
-#		ifdef STORED_cpp_exceptions
-				throw;
-#		endif
-			}
+			copy(c);
 		}
 		return *this;
 	}
 
 	Callable& operator=(Callable&& c) noexcept
 	{
-		destroy();
-		c.get().move(m_buffer.data());
-		c = nullptr;
+		if(&c != this) {
+			destroy();
+			move(c);
+		}
 		return *this;
 	}
 
 protected:
-	Base const& get() const noexcept
-	{
-		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-		return *reinterpret_cast<Base const*>(m_buffer.data());
-	}
-
-	Base& get() noexcept
+	/*!
+	 * \brief Construct the given callable object in the (empty) buffer.
+	 * \details If construction throws, the Callable remains empty.
+	 */
+	template <typename H, typename G>
+	void emplace(G&& g)
 	{
-		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-		return *reinterpret_cast<Base*>(m_buffer.data());
+		H::construct(m_buffer.data(), std::forward<G>(g));
+		m_ops = ops<H>();
+		m_invoke = &H::invoke;
 	}
 
 	template <typename G, typename F_ = typename CallableType<G>::type>
-	typename std::enable_if<(sizeof(Wrapper<F_>) > std::tuple_size<Buffer>::value)>::type
-	/* void */
-	assign(G&& g)
+	void assign(G&& g)
 	{
-		construct<Forwarder<F_>>(std::forward<G>(g));
-	}
-
-	template <typename G, typename F_ = typename CallableType<G>::type>
-	typename std::enable_if<(sizeof(Wrapper<F_>) <= std::tuple_size<Buffer>::value)>::type
-	/* void */
-	assign(G&& g)
-	{
-		construct<Wrapper<F_>>(std::forward<G>(g));
+		emplace<typename HandlerType<F_>::type>(std::forward<G>(g));
 	}
 
 	void assign(R (*g)(Args...))
 	{
 		if(g)
-			construct<Wrapper<R (*)(Args...)>>(g);
-		else
-			construct<Reset>();
+			emplace<Inline<R (*)(Args...)>>(g);
 	}
 
-	void assign(std::nullptr_t)
-	{
-		construct<Reset>();
-	}
+	void assign(std::nullptr_t) noexcept {}
 
-	template <typename T, typename... TArgs>
-	void construct(TArgs&&... args)
+	void copy(Callable const& c)
 	{
-		static_assert(sizeof(T) <= std::tuple_size<Buffer>::value, "");
-		new(m_buffer.data()) T{std::forward<TArgs>(args)...};
+		if(c.m_ops) {
+			c.m_ops->copy(m_buffer.data(), c.m_buffer.data());
+			m_ops = c.m_ops;
+			m_invoke = c.m_invoke;
+		}
 	}
 
-	void destroy() noexcept
+	void move(Callable& c) noexcept
 	{
-		get().~Base();
+		if(c.m_ops) {
+			c.m_ops->move(m_buffer.data(), c.m_buffer.data());
+			m_ops = c.m_ops;
+			m_invoke = c.m_invoke;
+			c.m_ops = nullptr;
+			c.m_invoke = &invokeReset;
+		}
 	}
 
-	template <typename G>
-	void replace(G&& g)
+	/*!
+	 * \brief Destroy the callable object, and leave the Callable empty.
+	 */
+	void destroy() noexcept
 	{
-		destroy();
-		try {
-			assign(std::forward<G>(g));
-		} catch(...) {
-			// Make sure we always have a valid instance in the buffer.
-			construct<Reset>();
-#		ifdef STORED_cpp_exceptions
-			throw;
-#		endif
+		if(m_ops) {
+			m_ops->destroy(m_buffer.data());
+			m_ops = nullptr;
+			m_invoke = &invokeReset;
 		}
 	}
 
 private:
-	alignas(sizeof(void*)) Buffer m_buffer;
+	Invoke m_invoke;
+	Ops const* m_ops;
+	alignas(sizeof(void*)) mutable std::array<char, capacity> m_buffer;
 };
 
 } // namespace impl
 
-template <typename F>
+template <typename F, size_t Capacity = 2 * sizeof(void*)>
 struct Callable {
 	template <typename R, typename... Args>
-	static impl::Callable<R, Args...> callable_impl(R(Args...));
+	static impl::Callable<Capacity, true, R, Args...> callable_impl(R(Args...));
+	using type = decltype(callable_impl(std::declval<F>()));
+};
+
+/*!
+ * \brief Like #stored::Callable, but the callable object does not have to be copyable.
+ *
+ * Use this for lambdas that capture move-only objects, like a \c std::unique_ptr.
+ * The resulting type can be moved, but not copied.
+ */
+template <typename F, size_t Capacity = 2 * sizeof(void*)>
+struct MoveOnlyCallable {
+	template <typename R, typename... Args>
+	static impl::Callable<Capacity, false, R, Args...> callable_impl(R(Args...));
 	using type = decltype(callable_impl(std::declval<F>()));
 };
 
@@ -588,6 +573,149 @@ private:
 	bool m_valid = false;
 };
 
+
+/*!
+ * \brief Statistics of the stored::Pool.
+ * \see stored::Pool::stats()
+ */
+struct PoolStats {
+	/*! \brief Total number of Pool::allocate() calls. */
+	size_t allocations;
+	/*! \brief Total number of Pool::deallocate() calls. */
+	size_t deallocations;
+	/*! \brief Number of blocks currently allocated. */
+	size_t inUse;
+	/*! \brief Maximum of #inUse. */
+	size_t peakInUse;
+	/*! \brief Number of allocations that were larger than Pool::MaxBlockSize. */
+	size_t large;
+	/*! \brief Number of chunks requested from the system. */
+	size_t chunks;
+	/*! \brief Total size in bytes of all chunks. */
+	size_t reserved;
+	/*! \brief Number of allocations served by the thread-local cache. */
+	size_t cacheHits;
+};
+
+/*!
+ * \brief Size-class memory pool.
+ *
+ * Allocations up to #MaxBlockSize bytes are rounded up to a power of two
+ * (the size class) and served from a per-class free list.  Free lists are
+ * filled by carving Config::PoolChunkSize chunks, which are requested from
+ * \c ::operator new and never returned to the system.  Larger allocations
+ * are forwarded to \c ::operator new directly.
+ *
+ * When Config::PoolThreadSafe is set, the free lists are protected by a
+ * mutex.  Additionally, every thread keeps up to Config::PoolThreadCache
+ * free blocks per size class, such that most allocations do not need the
+ * lock.  Blocks may be freed by another thread than the one that allocated it.
+ *
+ * Usually, this class is not used directly, but via stored::PoolAllocator.
+ */
+class Pool {
+public:
+	Pool() = delete;
+
+	enum {
+		/*! \brief Smallest size class in bytes. */
+		MinBlockSize = 16,
+		/*! \brief Largest size class in bytes. */
+		MaxBlockSize = 1024,
+		/*! \brief Number of size classes. */
+		SizeClasses = 7,
+	};
+
+	static void* allocate(size_t size);
+	static void deallocate(void* p, size_t size) noexcept;
+	static PoolStats stats() noexcept;
+	static void flushThreadCache() noexcept;
+
+	/*!
+	 * \brief Return the size class index for an allocation of the given size.
+	 *
+	 * Only valid for <tt>size <= MaxBlockSize</tt>.
+	 */
+	static size_t sizeClass(size_t size) noexcept
+	{
+		return size <= MinBlockSize ? 0U : sizeClassTable()[(size - 1U) / MinBlockSize];
+	}
+
+	/*!
+	 * \brief Return the block size of the given size class index.
+	 */
+	static constexpr size_t blockSize(size_t sizeClass) noexcept
+	{
+		return (size_t)MinBlockSize << sizeClass;
+	}
+
+private:
+	static uint8_t const* sizeClassTable() noexcept;
+};
+
+/*!
+ * \brief Allocator that uses the stored::Pool.
+ *
+ * To use it for all allocations of libstored, put the following in your
+ * \c stored_config.h:
+ *
+ * \code
+ * namespace stored {
+ * template <typename T>
+ * class PoolAllocator;
+ *
+ * struct Config : public DefaultConfig {
+ *	template <typename T>
+ *	struct Allocator {
+ *		typedef PoolAllocator<T> type;
+ *	};
+ * };
+ * } // namespace stored
+ * \endcode
+ */
+template <typename T>
+class PoolAllocator {
+public:
+	using value_type = T;
+
+	template <typename U>
+	struct rebind {
+		using other = PoolAllocator<U>;
+	};
+
+	PoolAllocator() noexcept is_default
+
+	template <typename U>
+	// cppcheck-suppress noExplicitConstructor
+	PoolAllocator(PoolAllocator<U> const& /*a*/) noexcept
+	{}
+
+	T* allocate(size_t n)
+	{
+		static_assert(
+			alignof(T) <= Pool::MinBlockSize,
+			"Alignment requirement of T cannot be met by the pool");
+		return static_cast<T*>(Pool::allocate(sizeof(T) * n));
+	}
+
+	void deallocate(T* p, size_t n) noexcept
+	{
+		Pool::deallocate(p, sizeof(T) * n);
+	}
+
+	template <typename U>
+	constexpr bool operator==(PoolAllocator<U> const& /*a*/) const noexcept
+	{
+		return true;
+	}
+
+	template <typename U>
+	constexpr bool operator!=(PoolAllocator<U> const& /*a*/) const noexcept
+	{
+		return false;
+	}
+};
+
 #	endif // STORED_cplusplus >= 201103L
 
 /*!
@@ -652,6 +780,127 @@ struct Vector {
 	typedef typename std::vector<T, typename Config::Allocator<T>::type> type;
 };
 
+/*!
+ * \brief Sorted associative container with a capacity that is allocated upfront.
+ *
+ * It implements the subset of the \c std::map interface that is used
+ * within libstored, backed by a sorted stored::Vector.  The capacity is
+ * reserved during construction; as long as #size() does not exceed \p
+ * Capacity, no allocations are done afterwards.  Contrary to \c std::map,
+ * #insert() and #erase() invalidate iterators.
+ */
+template <typename Key, typename T, size_t Capacity, typename Compare = std::less<Key> /**/>
+class FixedMap {
+public:
+	typedef Key key_type;
+	typedef T mapped_type;
+	typedef std::pair<Key, T> value_type;
+	typedef typename Vector<value_type>::type container_type;
+	typedef typename container_type::iterator iterator;
+	typedef typename container_type::const_iterator const_iterator;
+
+	FixedMap()
+	{
+		m_c.reserve(Capacity);
+	}
+
+	iterator begin()
+	{
+		return m_c.begin();
+	}
+
+	const_iterator begin() const
+	{
+		return m_c.begin();
+	}
+
+	iterator end()
+	{
+		return m_c.end();
+	}
+
+	const_iterator end() const
+	{
+		return m_c.end();
+	}
+
+	size_t size() const
+	{
+		return m_c.size();
+	}
+
+	bool empty() const
+	{
+		return m_c.empty();
+	}
+
+	static size_t capacity()
+	{
+		return Capacity;
+	}
+
+	void clear()
+	{
+		m_c.clear();
+	}
+
+	iterator find(Key const& key)
+	{
+		iterator it = lower_bound(key);
+		return it != end() && !Compare()(key, it->first) ? it : end();
+	}
+
+	const_iterator find(Key const& key) const
+	{
+		const_iterator it = lower_bound(key);
+		return it != end() && !Compare()(key, it->first) ? it : end();
+	}
+
+	iterator lower_bound(Key const& key)
+	{
+		return std::lower_bound(m_c.begin(), m_c.end(), key, KeyCompare());
+	}
+
+	const_iterator lower_bound(Key const& key) const
+	{
+		return std::lower_bound(m_c.begin(), m_c.end(), key, KeyCompare());
+	}
+
+	std::pair<iterator, bool> insert(value_type const& value)
+	{
+		iterator it = lower_bound(value.first);
+		if(it != end() && !Compare()(value.first, it->first))
+			return std::make_pair(it, false);
+
+		return std::make_pair(m_c.insert(it, value), true);
+	}
+
+	iterator erase(iterator it)
+	{
+		return m_c.erase(it);
+	}
+
+	size_t erase(Key const& key)
+	{
+		iterator it = find(key);
+		if(it == end())
+			return 0;
+
+		m_c.erase(it);
+		return 1;
+	}
+
+private:
+	struct KeyCompare {
+		bool operator()(value_type const& v, Key const& key) const
+		{
+			return Compare()(v.first, key);
+		}
+	};
+
+	container_type m_c;
+};
+
 } // namespace stored
 #endif // __cplusplus
 
@@ -32,6 +32,8 @@
 #			include <libstored/util.h>
 
 #			include <cmath>
+#			include <cstdint>
+#			include <limits>
 #			include <type_traits>
 #			include <utility>
 
@@ -1326,6 +1328,570 @@ public:
 
 
 
+//////////////////////////////////////////////////////////
+// Parameter caching
+//////////////////////////////////////////////////////////
+
+namespace impl {
+/*!
+ * \brief Check if the given bound object is located at \p buffer.
+ */
+template <typename T, typename Container>
+bool is_object_buffer(Variable<T, Container, true> const& o, void const* buffer) noexcept
+{
+	return o.valid() && o.key() == o.container().bufferToKey(buffer);
+}
+
+// Functions and variables without hooks cannot be identified this way.
+template <typename O>
+constexpr bool is_object_buffer(O const& /*o*/, void const* /*buffer*/) noexcept
+{
+	return false;
+}
+
+/*!
+ * \brief Check if the given bound object has changed in the \p journal since \p seq.
+ */
+template <typename T, typename Container, typename Journal>
+bool is_object_changed(
+	Variable<T, Container, true> const& o, Journal const& journal,
+	typename Journal::Seq seq) noexcept
+{
+	return o.valid() && journal.hasChanged((typename Journal::Key)o.key(), seq);
+}
+
+// Functions and variables without hooks are not in the journal.
+template <typename O, typename Journal>
+constexpr bool is_object_changed(
+	O const& /*o*/, Journal const& /*journal*/, typename Journal::Seq /*seq*/) noexcept
+{
+	return false;
+}
+
+/*!
+ * \brief Parameter administration of a component.
+ *
+ * A component reads its parameters via #cached(). When \p Cached is \c
+ * false, the parameters are read from the store every time.
+ */
+template <typename Bound, typename Parameters, bool Cached, char... Id>
+class ParameterCache {
+public:
+	template <typename Load>
+	static Parameters cached(Load&& load) noexcept
+	{
+		return load();
+	}
+
+	template <typename Load>
+	static Parameters reload(Load&& load) noexcept
+	{
+		return load();
+	}
+
+	void refresh() noexcept {}
+
+	static constexpr bool refreshIfUsed(Bound const& /*o*/, void const* /*buffer*/) noexcept
+	{
+		return false;
+	}
+
+	template <typename Journal>
+	static constexpr bool refreshIfChanged(Bound const& /*o*/, Journal& /*journal*/) noexcept
+	{
+		return false;
+	}
+};
+
+/*!
+ * \brief Parameter administration of a component, which keeps a snapshot of the parameters.
+ *
+ * The snapshot is taken at the first #cached() after a #refresh().  The
+ * objects with the given \p Id are the ones that are in the snapshot.
+ */
+template <typename Bound, typename Parameters, char... Id>
+class ParameterCache<Bound, Parameters, true, Id...> {
+public:
+	/*!
+	 * \brief Return the snapshot, which is taken using \p load when required.
+	 */
+	template <typename Load>
+	Parameters const& cached(Load&& load) noexcept
+	{
+		if(unlikely(m_stale))
+			return reload(std::forward<Load>(load));
+
+		return m_parameters;
+	}
+
+	/*!
+	 * \brief Take a new snapshot using \p load.
+	 */
+	template <typename Load>
+	Parameters const& reload(Load&& load) noexcept
+	{
+		m_parameters = load();
+		m_stale = false;
+		return m_parameters;
+	}
+
+	/*!
+	 * \brief Force taking a new snapshot at the next #cached().
+	 */
+	void refresh() noexcept
+	{
+		m_stale = true;
+	}
+
+	/*!
+	 * \brief Call #refresh() when the given \p buffer is one of the cached objects.
+	 * \return \c true when the snapshot is to be refreshed
+	 */
+	bool refreshIfUsed(Bound const& o, void const* buffer) noexcept
+	{
+		if(!m_stale) {
+			bool used = false;
+			bool dummy[] = {
+				false, (used |= is_object_buffer(o.template get<Id>(), buffer))...};
+			(void)dummy;
+
+			if(used)
+				refresh();
+		}
+
+		return m_stale;
+	}
+
+	/*!
+	 * \brief Call #refresh() when one of the cached objects has changed in the \p journal.
+	 *
+	 * Call this function regularly, such as before running the
+	 * component. Only when anything has changed in the journal,
+	 * the objects are looked up.
+	 *
+	 * \return \c true when the snapshot is to be refreshed
+	 */
+	template <typename Journal>
+	bool refreshIfChanged(Bound const& o, Journal& journal) noexcept
+	{
+		if(m_stale || journal.hasChanged((typename Journal::Seq)m_seq)) {
+			if(!m_stale) {
+				auto seq = (typename Journal::Seq)m_seq;
+				bool changed = false;
+				bool dummy[] = {
+					false, (changed |= is_object_changed(
+							o.template get<Id>(), journal, seq))...};
+				(void)dummy;
+
+				if(changed)
+					refresh();
+			}
+
+			// Changes from now on will get this seq (or later).
+			m_seq = (unsigned long long)journal.bumpSeq();
+		}
+
+		return m_stale;
+	}
+
+private:
+	Parameters m_parameters{};
+	unsigned long long m_seq{};
+	bool m_stale{true};
+};
+} // namespace impl
+
+
+//////////////////////////////////////////////////////////
+// Fixed-point
+//////////////////////////////////////////////////////////
+
+/*!
+ * \brief A saturating fixed-point number.
+ *
+ * The number is stored as an \p Int, with \p Frac fractional bits.  So,
+ * the value is <tt>raw() / 2^Frac</tt>.  #stored::Q15 and #stored::Q31
+ * are the common formats, but when the parameters of a component do not
+ * fit in [-1, 1), like the frequency of a #stored::Sine, choose a format
+ * with more integer bits, like <tt>Fixed<int32_t, 16></tt>.
+ *
+ * All arithmetic saturates to [-max(), max()], and is done in integers
+ * only.  The most negative raw value is reserved as NaN, such that
+ * defaults like the \c override of components work as for floats.  NaN
+ * is only a marker; it is not propagated by arithmetic.  There is no
+ * infinity; max() is used instead.
+ *
+ * Fixed has the same size and layout as \p Int.  It can be used as
+ * component type, in which case the objects in the store are of the
+ * corresponding integer type.
+ */
+template <typename Int, int Frac>
+class Fixed {
+	static_assert(std::is_integral<Int>::value && std::is_signed<Int>::value, "");
+	static_assert(sizeof(Int) <= sizeof(int32_t), "");
+	static_assert(Frac >= 0 && Frac < (int)sizeof(Int) * 8, "");
+
+public:
+	using int_type = Int;
+	using wide_type = std::conditional_t<(sizeof(Int) < sizeof(int32_t)), int32_t, int64_t>;
+
+	static constexpr int frac = Frac;
+	static constexpr Int RawMax = std::numeric_limits<Int>::max();
+	static constexpr Int RawNaN = std::numeric_limits<Int>::min();
+
+	/*!
+	 * \brief Default ctor.
+	 *
+	 * The value is uninitialized, like a float.
+	 */
+	Fixed() noexcept = default;
+
+	/*!
+	 * \brief Convert an integer value, with saturation.
+	 */
+	template <typename U, std::enable_if_t<std::is_integral<U>::value, int> = 0>
+	// NOLINTNEXTLINE(hicpp-explicit-conversions)
+	constexpr Fixed(U value) noexcept
+		: m_raw(fromInteger((long long)value))
+	{}
+
+	/*!
+	 * \brief Convert a floating point value, with rounding and saturation.
+	 *
+	 * NaN is converted to NaN.
+	 */
+	template <typename U, std::enable_if_t<std::is_floating_point<U>::value, int> = 0>
+	// NOLINTNEXTLINE(hicpp-explicit-conversions)
+	constexpr Fixed(U value) noexcept
+		: m_raw(fromFloat(value))
+	{}
+
+	/*!
+	 * \brief Construct from the raw integer representation.
+	 */
+	static constexpr Fixed fromRaw(Int raw) noexcept
+	{
+		Fixed f{};
+		f.m_raw = raw;
+		return f;
+	}
+
+	/*!
+	 * \brief Return the raw integer representation.
+	 */
+	constexpr Int raw() const noexcept
+	{
+		return m_raw;
+	}
+
+	/*!
+	 * \brief Convert to a floating point value.
+	 */
+	template <typename U, std::enable_if_t<std::is_floating_point<U>::value, int> = 0>
+	explicit constexpr operator U() const noexcept
+	{
+		return isnan() ? std::numeric_limits<U>::quiet_NaN() : (U)m_raw / scale<U>();
+	}
+
+	/*!
+	 * \brief Check if this is the NaN marker.
+	 */
+	constexpr bool isnan() const noexcept
+	{
+		return m_raw == RawNaN;
+	}
+
+	/*!
+	 * \brief Saturate the given wide value to the valid range of raw values.
+	 */
+	static constexpr Fixed saturate(wide_type raw) noexcept
+	{
+		if(raw > (wide_type)RawMax)
+			return fromRaw(RawMax);
+		if(raw < -(wide_type)RawMax)
+			return fromRaw((Int)-RawMax);
+		return fromRaw((Int)raw);
+	}
+
+	friend constexpr Fixed operator+(Fixed a, Fixed b) noexcept
+	{
+		return saturate((wide_type)a.m_raw + (wide_type)b.m_raw);
+	}
+
+	friend constexpr Fixed operator-(Fixed a, Fixed b) noexcept
+	{
+		return saturate((wide_type)a.m_raw - (wide_type)b.m_raw);
+	}
+
+	friend constexpr Fixed operator-(Fixed a) noexcept
+	{
+		return saturate(-(wide_type)a.m_raw);
+	}
+
+	friend constexpr Fixed operator*(Fixed a, Fixed b) noexcept
+	{
+		// Round to nearest.
+		return saturate(((wide_type)a.m_raw * (wide_type)b.m_raw + half()) >> Frac);
+	}
+
+	/*!
+	 * \brief Divide.
+	 *
+	 * Division by zero saturates, except for 0 / 0, which is 0.
+	 */
+	friend constexpr Fixed operator/(Fixed a, Fixed b) noexcept
+	{
+		if(b.m_raw == 0)
+			return a.m_raw == 0 ? Fixed(0) : a.m_raw > 0 ? max() : -max();
+
+		return saturate((wide_type)a.m_raw * ((wide_type)1 << Frac) / (wide_type)b.m_raw);
+	}
+
+	Fixed& operator+=(Fixed b) noexcept
+	{
+		return *this = *this + b;
+	}
+
+	Fixed& operator-=(Fixed b) noexcept
+	{
+		return *this = *this - b;
+	}
+
+	Fixed& operator*=(Fixed b) noexcept
+	{
+		return *this = *this * b;
+	}
+
+	Fixed& operator/=(Fixed b) noexcept
+	{
+		return *this = *this / b;
+	}
+
+	friend constexpr bool operator==(Fixed a, Fixed b) noexcept
+	{
+		return a.m_raw == b.m_raw;
+	}
+
+	friend constexpr bool operator!=(Fixed a, Fixed b) noexcept
+	{
+		return a.m_raw != b.m_raw;
+	}
+
+	friend constexpr bool operator<(Fixed a, Fixed b) noexcept
+	{
+		return a.m_raw < b.m_raw;
+	}
+
+	friend constexpr bool operator<=(Fixed a, Fixed b) noexcept
+	{
+		return a.m_raw <= b.m_raw;
+	}
+
+	friend constexpr bool operator>(Fixed a, Fixed b) noexcept
+	{
+		return a.m_raw > b.m_raw;
+	}
+
+	friend constexpr bool operator>=(Fixed a, Fixed b) noexcept
+	{
+		return a.m_raw >= b.m_raw;
+	}
+
+private:
+	static constexpr Fixed max() noexcept
+	{
+		return fromRaw(RawMax);
+	}
+
+	static constexpr wide_type half() noexcept
+	{
+		return Frac > 0 ? (wide_type)1 << (Frac > 0 ? Frac - 1 : 0) : 0;
+	}
+
+	template <typename U>
+	static constexpr U scale() noexcept
+	{
+		return (U)((long long)1 << Frac);
+	}
+
+	static constexpr Int fromInteger(long long value) noexcept
+	{
+		if(value > ((long long)RawMax >> Frac))
+			return RawMax;
+		if(value < -((long long)RawMax >> Frac))
+			return (Int)-RawMax;
+		return (Int)(value * ((long long)1 << Frac));
+	}
+
+	template <typename U>
+	static constexpr Int fromFloat(U value) noexcept
+	{
+		// NOLINTNEXTLINE(misc-redundant-expression)
+		if(value != value)
+			return RawNaN;
+
+		U x = value * scale<U>();
+		if(x >= (U)RawMax)
+			return RawMax;
+		if(x <= -(U)RawMax)
+			return (Int)-RawMax;
+		return (Int)(x + (x < 0 ? (U)-0.5 : (U)0.5));
+	}
+
+	Int m_raw;
+};
+
+/*! \brief Q15 fixed-point number, stored as \c int16_t. */
+using Q15 = Fixed<int16_t, 15>;
+/*! \brief Q31 fixed-point number, stored as \c int32_t. */
+using Q31 = Fixed<int32_t, 31>;
+
+// A fixed-point variable is an integer in the store.
+template <typename Int, int Frac>
+struct toType<Fixed<Int, Frac>> : public toType<Int> {};
+
+namespace impl {
+/*!
+ * \brief Check if \p T is a #stored::Fixed type.
+ */
+template <typename T>
+struct is_fixed : public std::false_type {};
+
+template <typename Int, int Frac>
+struct is_fixed<Fixed<Int, Frac>> : public std::true_type {};
+
+/*!
+ * \brief The floating point type to compute coefficients of a component with type \p T.
+ *
+ * This is \p T itself for floating point types.  Fixed-point components
+ * use it only when (re)initializing, not during normal operation.
+ */
+template <typename T>
+using float_type = std::conditional_t<
+	is_fixed<T>::value, std::conditional_t<(sizeof(T) > sizeof(int16_t)), double, float>, T>;
+
+template <typename T>
+bool isnan(T x) noexcept
+{
+	return std::isnan(x);
+}
+
+template <typename Int, int Frac>
+constexpr bool isnan(Fixed<Int, Frac> x) noexcept
+{
+	return x.isnan();
+}
+
+template <typename T>
+T fabs(T x) noexcept
+{
+	return std::fabs(x);
+}
+
+template <typename Int, int Frac>
+constexpr Fixed<Int, Frac> fabs(Fixed<Int, Frac> x) noexcept
+{
+	return x < 0 ? -x : x;
+}
+
+/*!
+ * \brief Compute the sine of \p phase, which is in turns (2^32 is one period).
+ *
+ * This uses a 7th order polynomial on a quarter period in integer
+ * arithmetic.  The maximum error is about 6e-7.
+ */
+template <typename Int, int Frac>
+Fixed<Int, Frac> sin_turns(uint32_t phase) noexcept
+{
+	// Map the phase to z in [-1, 1] (Q31), such that sin(2 pi phase) = sin(pi/2 z).
+	int64_t x = (int64_t)(int32_t)phase;
+	int64_t z;
+	if(x > (int64_t)1 << 30)
+		z = ((int64_t)1 << 32) - 2 * x;
+	else if(x < -((int64_t)1 << 30))
+		z = -((int64_t)1 << 32) - 2 * x;
+	else
+		z = 2 * x;
+
+	int64_t z2 = (z * z) >> 31;
+
+	// Coefficients in Q30.
+	int64_t r = -4652685;
+	r = 85292077 + ((r * z2) >> 31);
+	r = -693522213 + ((r * z2) >> 31);
+	r = 1686624011 + ((r * z2) >> 31);
+	r = (r * z) >> 31;
+
+	using F = Fixed<Int, Frac>;
+	using W = typename F::wide_type;
+
+	if(Frac > 30)
+		return F::saturate((W)(r * ((int64_t)1 << (Frac > 30 ? Frac - 30 : 0))));
+
+	int s = Frac > 30 ? 0 : 30 - Frac;
+	return F::saturate((W)((r + (s > 0 ? (int64_t)1 << (s - 1) : 0)) >> s));
+}
+} // namespace impl
+
+} // namespace stored
+
+namespace std {
+template <typename Int, int Frac>
+class numeric_limits<stored::Fixed<Int, Frac>> {
+public:
+	using type = stored::Fixed<Int, Frac>;
+
+	static constexpr bool is_specialized = true;
+	static constexpr bool is_signed = true;
+	static constexpr bool is_integer = false;
+	static constexpr bool is_exact = true;
+	static constexpr bool has_infinity = false;
+	static constexpr bool has_quiet_NaN = true;
+	static constexpr bool has_signaling_NaN = false;
+	static constexpr bool is_bounded = true;
+	static constexpr bool is_modulo = false;
+	static constexpr int digits = numeric_limits<Int>::digits;
+	static constexpr int radix = 2;
+
+	// Like floats, min() is the smallest positive value, not the most
+	// negative one; that is lowest().
+	static constexpr type min() noexcept
+	{
+		return type::fromRaw(1);
+	}
+
+	static constexpr type lowest() noexcept
+	{
+		return type::fromRaw((Int)-type::RawMax);
+	}
+
+	static constexpr type max() noexcept
+	{
+		return type::fromRaw(type::RawMax);
+	}
+
+	static constexpr type epsilon() noexcept
+	{
+		return type::fromRaw(1);
+	}
+
+	// There is no infinity, but saturation has the same effect.
+	static constexpr type infinity() noexcept
+	{
+		return max();
+	}
+
+	static constexpr type quiet_NaN() noexcept
+	{
+		return type::fromRaw(type::RawNaN);
+	}
+};
+} // namespace std
+
+namespace stored {
+
+
+
 //////////////////////////////////////////////////////////
 // Amplifier
 //////////////////////////////////////////////////////////
@@ -1336,6 +1902,19 @@ using AmplifierObjects = FreeObjectsList<
 	FreeVariables<T, Container, 'I', 'g', 'o', 'l', 'h', 'F', 'O'>,
 	FreeVariables<bool, Container, 'e'>>;
 
+/*!
+ * \brief The parameters of an #stored::Amplifier.
+ */
+template <typename T>
+struct AmplifierParameters {
+	T gain;
+	T offset;
+	T low;
+	T high;
+	T override_;
+	bool enabled;
+};
+
 /*!
  * \brief An offset/gain amplifier, based on store variables.
  *
@@ -1409,12 +1988,26 @@ using AmplifierObjects = FreeObjectsList<
  * Calling \c amp() now uses the \c input and produces the value in \c
  * output.  Alternatively, or when the \c input field is absent in the
  * store, call \c amp(x), where \c x is the input.
+ *
+ * By default, all fields are read from the store every time the
+ * Amplifier runs. When \p Cached is \c true, the parameters (all fields,
+ * except for \c input and \c output) are read only once and saved in the
+ * Amplifier instance. Then, running it only accesses \c input and \c
+ * output in the store.  Call #refresh() to re-read them at the next run.
+ * Alternatively, call #refreshIfUsed() from the store's \c __hookExitX()
+ * or #refreshIfChanged() with the store's journal, which only refresh
+ * when one of the parameters has been written.
  */
-template <typename Container, unsigned long long flags = 0, typename T = float>
-class Amplifier {
+template <
+	typename Container, unsigned long long flags = 0, typename T = float, bool Cached = false>
+class Amplifier
+	: private impl::ParameterCache<
+		  typename AmplifierObjects<Container, T>::template Bound<flags>,
+		  AmplifierParameters<T>, Cached, 'g', 'o', 'l', 'h', 'F', 'e'> {
 public:
 	using type = T;
 	using Bound = typename AmplifierObjects<Container, type>::template Bound<flags>;
+	using Parameters = AmplifierParameters<type>;
 
 	/*!
 	 * \brief Default ctor.
@@ -1626,17 +2219,56 @@ public:
 	}
 
 	/*!
-	 * \brief Compute the Amplifier output, given the input as stored in the store.
+	 * \brief Read all parameters from the store.
 	 */
-	type operator()() noexcept
+	Parameters parameters() const noexcept
 	{
-		return run(input());
+		return Parameters{gain(), offset(), low(), high(), override_(), enabled()};
 	}
 
 	/*!
-	 * \brief Compute the Amplifier output, given an input.
+	 * \brief Re-read the parameters at the next run.
+	 *
+	 * Only has effect when the parameters are \p Cached.
 	 */
-	type operator()(type input) noexcept
+	void refresh() noexcept
+	{
+		base_cache::refresh();
+	}
+
+	/*!
+	 * \brief Call #refresh() when the given \p buffer is one of the parameters.
+	 *
+	 * Call this from the store's \c __hookExitX().
+	 */
+	bool refreshIfUsed(void const* buffer) noexcept
+	{
+		return base_cache::refreshIfUsed(m_o, buffer);
+	}
+
+	/*!
+	 * \brief Call #refresh() when one of the parameters has changed in the given journal.
+	 *
+	 * Pass the #stored::StoreJournal of a #stored::Synchronizable store.
+	 */
+	template <typename Journal>
+	bool refreshIfChanged(Journal& journal) noexcept
+	{
+		return base_cache::refreshIfChanged(m_o, journal);
+	}
+
+	/*!
+	 * \brief Compute the Amplifier output, given the input as stored in the store.
+	 */
+	type operator()() noexcept
+	{
+		return run(input());
+	}
+
+	/*!
+	 * \brief Compute the Amplifier output, given an input.
+	 */
+	type operator()(type input) noexcept
 	{
 		decltype(auto) o = inputObject();
 		if(o.valid())
@@ -1645,33 +2277,80 @@ public:
 		return run(input);
 	}
 
+	/*!
+	 * \brief Compute the Amplifier output for a block of \p len inputs.
+	 *
+	 * The outputs are written to \p out.  Only the last input and output
+	 * are written to the store.
+	 */
+	void operator()(type const* in, type* out, size_t len) noexcept
+	{
+		if(unlikely(!len))
+			return;
+
+		decltype(auto) o = inputObject();
+		if(o.valid())
+			o = in[len - 1];
+
+		run(in, out, len);
+	}
+
+	/*!
+	 * \brief Compute the Amplifier output for a block of inputs.
+	 */
+	template <size_t N>
+	void operator()(type const (&in)[N], type (&out)[N]) noexcept
+	{
+		(*this)(in, out, N);
+	}
+
 protected:
 	/*!
 	 * \brief Compute the Amplifier output.
 	 */
 	type run(type input) noexcept
 	{
-		type output = override_();
+		type output;
+		run(&input, &output, 1);
+		return output;
+	}
+
+	/*!
+	 * \brief Compute the Amplifier output for a block of inputs.
+	 */
+	void run(type const* in, type* out, size_t len) noexcept
+	{
+		stored_assert(len > 0);
+
+		auto const& p = this->cached([this]() { return parameters(); });
+		type forced = p.override_;
 
-		if(!std::isnan(output)) {
+		if(!impl::isnan(forced)) {
 			// Keep override value.
+			for(size_t i = 0; i < len; i++)
+				out[i] = forced;
+		} else if(!p.enabled) {
+			for(size_t i = 0; i < len; i++)
+				out[i] = std::min(std::max(p.low, in[i]), p.high);
 		} else {
-			if(!enabled())
-				output = input;
-			else if(std::isnan(output))
-				output = input * gain() + offset();
+			type gain = p.gain;
+			type offset = p.offset;
+			type low = p.low;
+			type high = p.high;
 
-			output = std::min(std::max(low(), output), high());
+			for(size_t i = 0; i < len; i++)
+				out[i] = std::min(std::max(low, in[i] * gain + offset), high);
 		}
 
 		decltype(auto) oo = outputObject();
 		if(oo.valid())
-			oo = output;
-
-		return output;
+			oo = out[len - 1];
 	}
 
 private:
+	using base_cache =
+		impl::ParameterCache<Bound, Parameters, Cached, 'g', 'o', 'l', 'h', 'F', 'e'>;
+
 	Bound m_o;
 };
 
@@ -2085,6 +2764,22 @@ using PIDObjects = FreeObjectsList<
 		'u'>,
 	FreeVariables<bool, Container, 'e', 'r'>>;
 
+/*!
+ * \brief The parameters of a #stored::PID.
+ */
+template <typename T>
+struct PIDParameters {
+	T Kp;
+	T Kff;
+	T intLow;
+	T intHigh;
+	T low;
+	T high;
+	T errorMax;
+	T override_;
+	bool enabled;
+};
+
 /*!
  * \brief PID controller, based on store variables.
  *
@@ -2157,12 +2852,22 @@ using PIDObjects = FreeObjectsList<
  * - Changing Ti is implemented smoothly; changing the parameters (and
  *   setting \c reset afterwards) can be done while running.
  * - #isHealthy() checks for numerical stability.
+ *
+ * When \p Cached is \c true, the parameters are read once and saved in
+ * the PID instance. Then, running it only accesses \c y, \c setpoint,
+ * \c reset, \c int, and \c u in the store. Setting \c reset re-reads
+ * them. See #stored::Amplifier for other ways to refresh them.
  */
-template <typename Container, unsigned long long flags = 0, typename T = float>
-class PID {
+template <
+	typename Container, unsigned long long flags = 0, typename T = float, bool Cached = false>
+class PID
+	: private impl::ParameterCache<
+		  typename PIDObjects<Container, T>::template Bound<flags>, PIDParameters<T>,
+		  Cached, 'p', 'k', 'L', 'H', 'l', 'h', 'E', 'F', 'e'> {
 public:
 	using type = T;
 	using Bound = typename PIDObjects<Container, type>::template Bound<flags>;
+	using Parameters = PIDParameters<type>;
 
 	/*!
 	 * \brief Default ctor.
@@ -2511,7 +3216,7 @@ public:
 	type u() const noexcept
 	{
 		type o = override_();
-		return std::isnan(o) ? m_u : o;
+		return impl::isnan(o) ? m_u : o;
 	}
 
 	/*! \brief Return the \c enable object. */
@@ -2622,23 +3327,63 @@ public:
 			return true;
 
 		auto e = epsilon();
-		auto i = std::fabs(int_());
+		auto i = impl::fabs(int_());
 
 		// If the result is true, the integrator is not too
 		// large, such that smallest error can still reduce it.
 		return i - e * k < i;
 	}
 
+	/*!
+	 * \brief Read all parameters from the store.
+	 */
+	Parameters parameters() const noexcept
+	{
+		return Parameters{
+			Kp(), Kff(), intLow(), intHigh(), low(), high(), errorMax(), override_(),
+			enabled()};
+	}
+
+	/*!
+	 * \brief Re-read the parameters at the next run.
+	 *
+	 * Only has effect when the parameters are \p Cached.
+	 */
+	void refresh() noexcept
+	{
+		base_cache::refresh();
+	}
+
+	/*!
+	 * \brief Call #refresh() when the given \p buffer is one of the parameters.
+	 * \see #stored::Amplifier::refreshIfUsed()
+	 */
+	bool refreshIfUsed(void const* buffer) noexcept
+	{
+		return base_cache::refreshIfUsed(m_o, buffer);
+	}
+
+	/*!
+	 * \brief Call #refresh() when one of the parameters has changed in the given journal.
+	 * \see #stored::Amplifier::refreshIfChanged()
+	 */
+	template <typename Journal>
+	bool refreshIfChanged(Journal& journal) noexcept
+	{
+		return base_cache::refreshIfChanged(m_o, journal);
+	}
+
 protected:
 	/*!
 	 * \brief Compute control output.
 	 */
 	type run(type y) noexcept
 	{
-		type u = override_();
+		auto const& p = this->cached([this]() { return parameters(); });
+		type u = p.override_;
 
-		if(likely(std::isnan(u))) {
-			if(!enabled())
+		if(likely(impl::isnan(u))) {
+			if(!p.enabled)
 				return m_u;
 
 			bool doReset = false;
@@ -2648,16 +3393,15 @@ protected:
 					doReset = true;
 					reset_o = false;
 				}
-			} else if(unlikely(std::isnan(m_y_prev))) {
+			} else if(unlikely(impl::isnan(m_y_prev))) {
 				doReset = true;
 			}
 
 			type sp = setpoint();
 			type e = sp - y;
 
-			auto e_o = errorMaxObject();
-			if(e_o.valid()) {
-				auto em = e_o.get();
+			if(Bound::template valid<'E'>()) {
+				auto em = p.errorMax;
 				if(e < -em)
 					e = -em;
 				else if(e > em)
@@ -2665,26 +3409,36 @@ protected:
 			}
 
 			if(unlikely(doReset)) {
+				if(Cached)
+					// Take all changed parameters into account.
+					this->reload([this]() { return parameters(); });
+
 				float f = frequency();
 				m_Ki = 0;
 				m_Kd = 0;
 				m_y_prev = y;
 
-				if(!std::isnan(f) && f > 0) {
-					float dt = 1.0f / frequency();
-					if(Ti() != 0)
-						m_Ki = Kp() * dt / Ti();
-					m_Kd = -Kp() * Td() / dt;
+				if(!impl::isnan(f) && f > 0) {
+					// Compute the coefficients in floating point, as
+					// fixed-point types may not be able to represent
+					// intermediate values.
+					using F = impl::float_type<type>;
+					float dt = 1.0f / f;
+					F Kp = (F)p.Kp;
+					F Ti_ = (F)Ti();
+					if(Ti_ != 0)
+						m_Ki = (type)(Kp * dt / Ti_);
+					m_Kd = (type)(-Kp * (F)Td() / dt);
 				}
 			}
 
-			u = Kp() * e + m_int + Kff() * sp;
+			u = p.Kp * e + m_int + p.Kff * sp;
 
 			type di = Ki() * e;
-			if(likely((u >= low() || di > 0) && (u <= high() || di < 0))) {
+			if(likely((u >= p.low || di > 0) && (u <= p.high || di < 0))) {
 				// Anti-windup: only update m_int when we are within output
 				// bounds, or if we get back into those bounds.
-				type i = std::max(intLow(), std::min(intHigh(), m_int + di));
+				type i = std::max(p.intLow, std::min(p.intHigh, m_int + di));
 				u += i - m_int;
 				m_int = i;
 
@@ -2698,7 +3452,7 @@ protected:
 				m_y_prev = y;
 			}
 
-			m_u = u = std::max(low(), std::min(high(), u));
+			m_u = u = std::max(p.low, std::min(p.high, u));
 		}
 
 		decltype(auto) uo = uObject();
@@ -2709,6 +3463,9 @@ protected:
 	}
 
 private:
+	using base_cache = impl::ParameterCache<
+		Bound, Parameters, Cached, 'p', 'k', 'L', 'H', 'l', 'h', 'E', 'F', 'e'>;
+
 	Bound m_o;
 	type m_y_prev{std::numeric_limits<type>::quiet_NaN()};
 	type m_Ki{};
@@ -2719,6 +3476,427 @@ private:
 
 
 
+//////////////////////////////////////////////////////////
+// PIDBank
+//////////////////////////////////////////////////////////
+
+/*!
+ * \brief A bank of \p N PID controllers, evaluated in one go.
+ *
+ * Every controller is bound to its own scope in the store, as described
+ * for #stored::PID. All scopes must have the same set of objects, such
+ * that they share the same \p flags.
+ *
+ * Instantiate the bank like this:
+ *
+ * \code
+ * constexpr stored::PIDObjects<stored::YourStore> pid_o[] = {
+ *     stored::PID<stored::YourStore>::objects("/pid x/"),
+ *     stored::PID<stored::YourStore>::objects("/pid y/"),
+ * };
+ *
+ * stored::PIDBank<stored::YourStore, 2, pid_o[0].flags()> pids{pid_o, yourStore};
+ * \endcode
+ *
+ * The difference with \p N individual #stored::PID instances, is that the
+ * controller state and parameters are kept as arrays (struct of arrays).
+ * Every controller behaves like a #stored::PID with \c Cached parameters:
+ * the parameters are read at the first run, when \c reset of that
+ * controller is set, or after #refresh(). Then, running only accesses \c y,
+ * \c setpoint, \c reset, \c int, and \c u in the store. The control law
+ * itself is evaluated for all controllers in one branch-free loop, which
+ * the compiler vectorizes.
+ *
+ * Like the components with cached parameters, call #refreshIfUsed() from
+ * the store's \c __hookExitX(), or #refreshIfChanged() with the store's
+ * journal, to pick up parameter changes, such as writes by the debugger.
+ */
+template <typename Container, size_t N, unsigned long long flags = 0, typename T = float>
+class PIDBank {
+	static_assert(N > 0, "");
+
+public:
+	using type = T;
+	using PID_type = PID<Container, flags, T>;
+	using Objects = PIDObjects<Container, type>;
+	using Bound = typename PID_type::Bound;
+
+	/*!
+	 * \brief Default ctor.
+	 *
+	 * Use this when initialization is postponed. You can assign
+	 * another instance later on.
+	 */
+	PIDBank() noexcept = default;
+
+	/*!
+	 * \brief Initialize the bank, given a list of objects per controller and a container.
+	 */
+	PIDBank(Objects const (&o)[N], Container& container)
+	{
+		static_assert(Bound::template valid<'f'>(), "'frequency' function is mandatory");
+		static_assert(Bound::template valid<'s'>(), "'setpoint' variable is mandatory");
+		static_assert(Bound::template valid<'p'>(), "'Kp' variable is mandatory");
+
+		for(size_t i = 0; i < N; i++) {
+			stored_assert(o[i].flags() == flags);
+			m_o[i] = Bound::create(o[i], container);
+			m_y_prev[i] = std::numeric_limits<type>::quiet_NaN();
+
+			decltype(auto) uo = m_o[i].template get<'u'>();
+			decltype(auto) lo = m_o[i].template get<'l'>();
+			if(uo.valid())
+				m_u[i] = uo.get();
+			else if(lo.valid())
+				m_u[i] = std::max<type>(lo.get(), 0);
+		}
+	}
+
+	/*!
+	 * \brief Create the list of objects in the store for one controller.
+	 * \see #stored::PID::objects()
+	 */
+	template <char... OnlyId, size_t L>
+	static constexpr auto objects(char const (&prefix)[L]) noexcept
+	{
+		return PID_type::template objects<OnlyId...>(prefix);
+	}
+
+	/*! \brief Return the number of controllers. */
+	static constexpr size_t size() noexcept
+	{
+		return N;
+	}
+
+	/*! \brief Return the bound objects of controller \p i. */
+	Bound const& bound(size_t i) const noexcept
+	{
+		stored_assert(i < N);
+		return m_o[i];
+	}
+
+	/*!
+	 * \brief Re-read the parameters of controller \p i from the store at the next run.
+	 */
+	void refresh(size_t i) noexcept
+	{
+		stored_assert(i < N);
+		m_cache[i].refresh();
+	}
+
+	/*!
+	 * \brief Re-read the parameters of all controllers from the store at the next run.
+	 */
+	void refresh() noexcept
+	{
+		for(size_t i = 0; i < N; i++)
+			m_cache[i].refresh();
+	}
+
+	/*!
+	 * \brief Call #refresh(size_t) when the given \p buffer is one of the parameters of
+	 *	controller \p i.
+	 * \see #stored::Amplifier::refreshIfUsed()
+	 */
+	bool refreshIfUsed(size_t i, void const* buffer) noexcept
+	{
+		stored_assert(i < N);
+		return m_cache[i].refreshIfUsed(m_o[i], buffer);
+	}
+
+	/*!
+	 * \brief Call #refresh(size_t) for every controller that uses the given \p buffer as
+	 *	parameter.
+	 * \return \c true when any of the controllers is to be refreshed
+	 */
+	bool refreshIfUsed(void const* buffer) noexcept
+	{
+		bool stale = false;
+		for(size_t i = 0; i < N; i++)
+			stale |= refreshIfUsed(i, buffer);
+		return stale;
+	}
+
+	/*!
+	 * \brief Call #refresh(size_t) when one of the parameters of controller \p i has
+	 *	changed in the given journal.
+	 * \see #stored::Amplifier::refreshIfChanged()
+	 */
+	template <typename Journal>
+	bool refreshIfChanged(size_t i, Journal& journal) noexcept
+	{
+		stored_assert(i < N);
+		return m_cache[i].refreshIfChanged(m_o[i], journal);
+	}
+
+	/*!
+	 * \brief Call #refresh(size_t) for every controller of which one of the parameters has
+	 *	changed in the given journal.
+	 * \return \c true when any of the controllers is to be refreshed
+	 */
+	template <typename Journal>
+	bool refreshIfChanged(Journal& journal) noexcept
+	{
+		bool stale = false;
+		for(size_t i = 0; i < N; i++)
+			stale |= refreshIfChanged(i, journal);
+		return stale;
+	}
+
+	/*! \brief Return the last output of controller \p i, with the override applied. */
+	type u(size_t i) const noexcept
+	{
+		stored_assert(i < N);
+		decltype(auto) o = m_o[i].template get<'F'>();
+		type override_ = o.valid() ? o.get() : std::numeric_limits<type>::quiet_NaN();
+		return impl::isnan(override_) ? m_u[i] : override_;
+	}
+
+	/*! \brief Return the current integral value of controller \p i. */
+	type int_(size_t i) const noexcept
+	{
+		stored_assert(i < N);
+		return m_int[i];
+	}
+
+	/*! \brief Return the computed Ki value of controller \p i. */
+	type Ki(size_t i) const noexcept
+	{
+		stored_assert(i < N);
+		return m_Ki[i];
+	}
+
+	/*! \brief Return the computed Kd value of controller \p i. */
+	type Kd(size_t i) const noexcept
+	{
+		stored_assert(i < N);
+		return m_Kd[i];
+	}
+
+	/*!
+	 * \brief Check numerical stability of controller \p i.
+	 * \see #stored::PID::isHealthy()
+	 */
+	bool isHealthy(size_t i) const noexcept
+	{
+		auto k = Ki(i);
+		if(k == 0)
+			return true;
+
+		decltype(auto) o = m_o[i].template get<'3'>();
+		auto e = o.valid() ? o.get() : std::numeric_limits<type>::infinity();
+		auto a = impl::fabs(int_(i));
+		return a - e * k < a;
+	}
+
+	/*!
+	 * \brief Compute the outputs of all controllers, given their \c y.
+	 *
+	 * The outputs are written to \p u.
+	 */
+	void operator()(type const (&y)[N], type (&u)[N]) noexcept
+	{
+		for(size_t i = 0; i < N; i++) {
+			decltype(auto) o = m_o[i].template get<'y'>();
+			if(o.valid())
+				o = y[i];
+		}
+
+		run(y, u);
+	}
+
+	/*!
+	 * \brief Compute the outputs of all controllers, given the \c y as stored in the store.
+	 *
+	 * The outputs are written to \p u.
+	 */
+	void operator()(type (&u)[N]) noexcept
+	{
+		type y[N];
+		for(size_t i = 0; i < N; i++) {
+			decltype(auto) o = m_o[i].template get<'y'>();
+			y[i] = o.valid() ? o.get() : type();
+		}
+
+		run(y, u);
+	}
+
+protected:
+	/*!
+	 * \brief Read the parameters of controller \p i from the store.
+	 *
+	 * These are the parameters that a #stored::PID caches.
+	 */
+	void load(size_t i) noexcept
+	{
+		Bound& b = m_o[i];
+		auto inf = std::numeric_limits<type>::infinity();
+
+		decltype(auto) Kff_o = b.template get<'k'>();
+		decltype(auto) intLow_o = b.template get<'L'>();
+		decltype(auto) intHigh_o = b.template get<'H'>();
+		decltype(auto) low_o = b.template get<'l'>();
+		decltype(auto) high_o = b.template get<'h'>();
+		decltype(auto) errorMax_o = b.template get<'E'>();
+		decltype(auto) override_o = b.template get<'F'>();
+		decltype(auto) enable_o = b.template get<'e'>();
+
+		m_Kp[i] = b.template get<'p'>().get();
+		m_Kff[i] = Kff_o.valid() ? Kff_o.get() : (type)0;
+		m_intLow[i] = intLow_o.valid() ? intLow_o.get() : -inf;
+		m_intHigh[i] = intHigh_o.valid() ? intHigh_o.get() : inf;
+		m_low[i] = low_o.valid() ? low_o.get() : -inf;
+		m_high[i] = high_o.valid() ? high_o.get() : inf;
+		m_errorMax[i] = errorMax_o.valid() ? errorMax_o.get() : inf;
+		m_override[i] = override_o.valid() ? override_o.get()
+						   : std::numeric_limits<type>::quiet_NaN();
+		m_enabled[i] = !enable_o.valid() || enable_o.get();
+	}
+
+	/*!
+	 * \brief Reset controller \p i, like setting \c reset of a #stored::PID.
+	 *
+	 * The parameters are reloaded, and Ki and Kd are recomputed.
+	 */
+	void reset(size_t i, type y) noexcept
+	{
+		m_cache[i].reload([&]() noexcept {
+			load(i);
+			return Loaded{};
+		});
+
+		Bound& b = m_o[i];
+		decltype(auto) Ti_o = b.template get<'i'>();
+		decltype(auto) Td_o = b.template get<'d'>();
+
+		float f = b.template get<'f'>()();
+		m_Ki[i] = 0;
+		m_Kd[i] = 0;
+		m_y_prev[i] = y;
+
+		if(!impl::isnan(f) && f > 0) {
+			// Like a #stored::PID, compute the coefficients in floating point.
+			using F = impl::float_type<type>;
+			float dt = 1.0f / f;
+			F Kp = (F)m_Kp[i];
+			F Ti = Ti_o.valid() ? (F)Ti_o.get() : std::numeric_limits<F>::infinity();
+			F Td = Td_o.valid() ? (F)Td_o.get() : (F)0;
+			if(Ti != 0)
+				m_Ki[i] = (type)(Kp * dt / Ti);
+			m_Kd[i] = (type)(-Kp * Td / dt);
+		}
+	}
+
+	/*!
+	 * \brief Compute control outputs.
+	 */
+	void run(type const* y, type* u) noexcept
+	{
+		type sp[N];
+
+		// Gather inputs from the store.
+		for(size_t i = 0; i < N; i++) {
+			Bound& b = m_o[i];
+
+			m_cache[i].cached([&]() noexcept {
+				load(i);
+				return Loaded{};
+			});
+
+			// Like a #stored::PID, a reset is only processed when the
+			// controller is enabled and not overridden.
+			m_active[i] = m_enabled[i] && impl::isnan(m_override[i]);
+			if(likely(m_active[i])) {
+				bool doReset = false;
+				decltype(auto) reset_o = b.template get<'r'>();
+				if(reset_o.valid()) {
+					if(unlikely(reset_o.get())) {
+						doReset = true;
+						reset_o = false;
+					}
+				} else if(unlikely(impl::isnan(m_y_prev[i]))) {
+					doReset = true;
+				}
+
+				if(unlikely(doReset))
+					reset(i, y[i]);
+			}
+
+			sp[i] = b.template get<'s'>().get();
+		}
+
+		// Evaluate all controllers. Keep this loop branch-free, such that
+		// it can be vectorized.
+		for(size_t i = 0; i < N; i++) {
+			type yi = y[i];
+			type e = std::max(-m_errorMax[i], std::min(m_errorMax[i], sp[i] - yi));
+			type ui = m_Kp[i] * e + m_int[i] + m_Kff[i] * sp[i];
+
+			// Anti-windup: only update the integral when we are within output
+			// bounds, or if we get back into those bounds.
+			type di = m_Ki[i] * e;
+			bool integrate = (ui >= m_low[i] || di > 0) && (ui <= m_high[i] || di < 0);
+			type in = std::max(m_intLow[i], std::min(m_intHigh[i], m_int[i] + di));
+			in = integrate ? in : m_int[i];
+			ui += in - m_int[i];
+
+			bool derive = m_Kd[i] != 0;
+			ui += derive ? m_Kd[i] * (yi - m_y_prev[i]) : (type)0;
+			ui = std::max(m_low[i], std::min(m_high[i], ui));
+
+			bool active = m_active[i];
+			m_int[i] = active ? in : m_int[i];
+			m_y_prev[i] = active && derive ? yi : m_y_prev[i];
+			m_u[i] = active ? ui : m_u[i];
+			u[i] = impl::isnan(m_override[i]) ? m_u[i] : m_override[i];
+		}
+
+		// Scatter outputs to the store. Like a #stored::PID, \c u is left
+		// alone while disabled.
+		for(size_t i = 0; i < N; i++) {
+			if(!m_enabled[i] && impl::isnan(m_override[i]))
+				continue;
+
+			Bound& b = m_o[i];
+
+			decltype(auto) io = b.template get<'I'>();
+			if(io.valid() && m_active[i])
+				io = m_int[i];
+
+			decltype(auto) uo = b.template get<'u'>();
+			if(uo.valid())
+				uo = u[i];
+		}
+	}
+
+private:
+	/*! \brief The parameters are loaded into the arrays below, not in the cache. */
+	struct Loaded {};
+
+	/*! \brief Administration of the parameters that #load() reads. */
+	using Cache = impl::ParameterCache<
+		Bound, Loaded, true, 'p', 'k', 'L', 'H', 'l', 'h', 'E', 'F', 'e'>;
+
+	Bound m_o[N]{};
+	Cache m_cache[N]{};
+	type m_Kp[N]{};
+	type m_Ki[N]{};
+	type m_Kd[N]{};
+	type m_Kff[N]{};
+	type m_intLow[N]{};
+	type m_intHigh[N]{};
+	type m_low[N]{};
+	type m_high[N]{};
+	type m_errorMax[N]{};
+	type m_override[N]{};
+	type m_int[N]{};
+	type m_y_prev[N]{};
+	type m_u[N]{};
+	bool m_enabled[N]{};
+	bool m_active[N]{};
+};
+
+
 //////////////////////////////////////////////////////////
 // Sine
 //////////////////////////////////////////////////////////
@@ -2726,11 +3904,159 @@ private:
 template <typename T>
 constexpr T pi = T(3.141592653589793238462643383279502884L);
 
+/*!
+ * \brief The way a #stored::Sine computes its output.
+ */
+enum class SineMethod {
+	/*! \brief Call \c std::sin() for every sample. */
+	Exact,
+	/*! \brief Phase accumulator with an interpolated lookup table. */
+	Table,
+	/*! \brief Recursive (rotating phasor) oscillator, renormalized periodically. */
+	Oscillator,
+};
+
+namespace impl {
+/*!
+ * \brief Compute sin(x) for x in [0, pi/2] at compile time.
+ */
+constexpr long double constexpr_sin(long double x) noexcept
+{
+	long double term = x;
+	long double sum = x;
+	for(int i = 1; i < 20; i++) {
+		term *= -x * x / (long double)((2 * i) * (2 * i + 1));
+		sum += term;
+	}
+	return sum;
+}
+
+/*!
+ * \brief Quarter-period sine lookup table, computed at compile time.
+ *
+ * The table has \c Size + 1 entries, such that the last entry (sin(pi/2))
+ * can be used for interpolation.
+ */
+template <typename T>
+struct SineTable {
+	enum { Bits = 8, Size = 1 << Bits };
+
+	constexpr SineTable() noexcept
+		: value{}
+	{
+		for(int i = 0; i <= Size; i++)
+			value[i] = (T)constexpr_sin(
+				(long double)i * pi<long double> / (long double)(2 * Size));
+	}
+
+	/*!
+	 * \brief Return sin(2 pi k / (4 * Size)), for any \p k in the full period.
+	 */
+	constexpr T operator[](unsigned k) const noexcept
+	{
+		k &= 4U * Size - 1U;
+		if(k < Size)
+			return value[k];
+		if(k < 2U * Size)
+			return value[2U * Size - k];
+		if(k < 3U * Size)
+			return -value[k - 2U * Size];
+		return -value[4U * Size - k];
+	}
+
+	/*!
+	 * \brief Compute the sine of the given \p phase in turns (2^32 is one period).
+	 *
+	 * The result is linearly interpolated. The maximum error is about 5e-6.
+	 */
+	T sin(uint32_t phase) const noexcept
+	{
+		constexpr int Shift = 32 - Bits - 2;
+		unsigned k = (unsigned)(phase >> Shift);
+		T frac = (T)(phase & ((1U << Shift) - 1U)) * ((T)1 / (T)(1U << Shift));
+		T v0 = (*this)[k];
+		T v1 = (*this)[k + 1U];
+		return v0 + (v1 - v0) * frac;
+	}
+
+	T value[Size + 1];
+};
+
+template <typename T>
+constexpr SineTable<T> sine_table{};
+
+/*!
+ * \brief Convert a (floating point) fraction of a period to a phase in turns.
+ *
+ * 2^32 is one period. The \p turns can be any value; it wraps around.
+ */
+template <typename T>
+uint32_t to_turns(T turns) noexcept
+{
+	turns -= std::floor(turns);
+	return (uint32_t)(uint64_t)(turns * (T)4294967296.0);
+}
+
+/*!
+ * \brief The state of a #stored::Sine, which depends on the type and method.
+ */
+template <typename T, SineMethod Method, bool Fixed = is_fixed<T>::value>
+struct SineState {
+	static_assert(
+		!Fixed && Method == SineMethod::Exact,
+		"Fixed-point types only support SineMethod::Exact");
+
+	// The time in the period.
+	T t{};
+};
+
+template <typename T>
+struct SineState<T, SineMethod::Exact, true> {
+	// The phase, in turns.
+	uint32_t t{};
+};
+
+template <typename T>
+struct SineState<T, SineMethod::Table, false> {
+	// The phase, in turns.
+	uint32_t t{};
+};
+
+template <typename T>
+struct SineState<T, SineMethod::Oscillator, false> {
+	// The phasor of the time in the period.
+	T c{1};
+	T s{};
+	// The rotation per sample, for the given frequency and sample frequency.
+	T cw{1};
+	T sw{};
+	T f{std::numeric_limits<T>::quiet_NaN()};
+	float sf{};
+	// The rotation of the phase, for the given phase.
+	T cp{1};
+	T sp{};
+	T phase{};
+};
+} // namespace impl
+
 template <typename Container, typename T = float>
 using SineObjects = FreeObjectsList<
 	FreeFunctions<float, Container, 's'>, FreeVariables<T, Container, 'A', 'f', 'p', 'F', 'O'>,
 	FreeVariables<bool, Container, 'e'>>;
 
+/*!
+ * \brief The parameters of a #stored::Sine.
+ */
+template <typename T>
+struct SineParameters {
+	float sampleFrequency;
+	T amplitude;
+	T frequency;
+	T phase;
+	T override_;
+	bool enabled;
+};
+
 /*!
  * \brief Sine wave generator, based on store variables.
  *
@@ -2778,12 +4104,41 @@ using SineObjects = FreeObjectsList<
  *
  * When the parameters of the sine wave are changed while running, they
  * are applied immediately, without a smooth transition.
+ *
+ * When \p Cached is \c true, the parameters, including the <tt>sample
+ * frequency</tt>, are read once and saved in the instance. See
+ * #stored::Amplifier for how to refresh them.
+ *
+ * By default, \c std::sin() is called for every sample. When many
+ * generators run at a high rate, set \p Method to:
+ *
+ * - #stored::SineMethod::Table, which uses a phase accumulator and a
+ *   linearly interpolated lookup table. The interpolation error is below
+ *   1e-5 times the amplitude.
+ * - #stored::SineMethod::Oscillator, which rotates a phasor every sample,
+ *   and only calls \c std::sin() and \c std::cos() when the frequency or
+ *   phase changes. The amplitude is renormalized every block of at most
+ *   #RenormalizeInterval samples.
+ *
+ * Both are faster than the default, and not less accurate in the long run,
+ * as the default accumulates rounding errors in the time.  Contrary to the
+ * default, the phase remains continuous when the frequency changes.  These
+ * methods are only supported for floating point types.
  */
-template <typename Container, unsigned long long flags = 0, typename T = float>
-class Sine {
+template <
+	typename Container, unsigned long long flags = 0, typename T = float, bool Cached = false,
+	SineMethod Method = SineMethod::Exact>
+class Sine
+	: private impl::ParameterCache<
+		  typename SineObjects<Container, T>::template Bound<flags>, SineParameters<T>,
+		  Cached, 'A', 'f', 'p', 'F', 'e'> {
 public:
 	using type = T;
 	using Bound = typename SineObjects<Container, type>::template Bound<flags>;
+	using Parameters = SineParameters<type>;
+
+	/*! \brief Maximum number of samples between renormalizations of SineMethod::Oscillator. */
+	enum { RenormalizeInterval = 64 };
 
 	/*!
 	 * \brief Default ctor.
@@ -2861,7 +4216,8 @@ public:
 	type frequency() const noexcept
 	{
 		decltype(auto) o = frequencyObject();
-		return o.valid() ? o.get() : (type)0.5 / pi<type>;
+		using F = impl::float_type<type>;
+		return o.valid() ? o.get() : (type)((F)0.5 / pi<F>);
 	}
 
 	/*! \brief Return the \c phase object. */
@@ -2914,85 +4270,318 @@ public:
 		return m_o.template get<'O'>();
 	}
 
-	/*! \brief Return the \c output value, or 0 when not available. */
-	type output() const noexcept
+	/*! \brief Return the \c output value, or 0 when not available. */
+	type output() const noexcept
+	{
+		decltype(auto) o = outputObject();
+		return o.valid() ? o.get() : type();
+	}
+
+	/*! \brief Return the \c enable object. */
+	decltype(auto) enableObject() const noexcept
+	{
+		return m_o.template get<'e'>();
+	}
+
+	/*! \brief Return the \c enable object. */
+	decltype(auto) enableObject() noexcept
+	{
+		return m_o.template get<'e'>();
+	}
+
+	/*! \brief Return the \c enable value, or \c true when not available. */
+	bool enabled() const noexcept
+	{
+		decltype(auto) o = enableObject();
+		return !o.valid() || o.get();
+	}
+
+	/*!
+	 * \brief Enable (or disable) the sine wave.
+	 *
+	 * Ignored when the \c enable object is not available.
+	 */
+	void enable(bool value = true) noexcept
+	{
+		decltype(auto) o = enableObject();
+		if(o.valid())
+			o = value;
+	}
+
+	/*!
+	 * \brief Disable the sine wave.
+	 *
+	 * Ignored when the \c enable object is not available.
+	 */
+	void disable() noexcept
+	{
+		enable(false);
+	}
+
+	/*!
+	 * \brief Read all parameters from the store.
+	 */
+	Parameters parameters() const noexcept
+	{
+		return Parameters{
+			sampleFrequency(), amplitude(), frequency(), phase(), override_(),
+			enabled()};
+	}
+
+	/*!
+	 * \brief Re-read the parameters at the next run.
+	 *
+	 * Only has effect when the parameters are \p Cached.
+	 */
+	void refresh() noexcept
+	{
+		base_cache::refresh();
+	}
+
+	/*!
+	 * \brief Call #refresh() when the given \p buffer is one of the parameters.
+	 * \see #stored::Amplifier::refreshIfUsed()
+	 */
+	bool refreshIfUsed(void const* buffer) noexcept
+	{
+		return base_cache::refreshIfUsed(m_o, buffer);
+	}
+
+	/*!
+	 * \brief Call #refresh() when one of the parameters has changed in the given journal.
+	 * \see #stored::Amplifier::refreshIfChanged()
+	 */
+	template <typename Journal>
+	bool refreshIfChanged(Journal& journal) noexcept
+	{
+		return base_cache::refreshIfChanged(m_o, journal);
+	}
+
+	/*!
+	 * \brief Compute the sine output.
+	 */
+	type operator()() noexcept
+	{
+		type output;
+		run(&output, 1);
+		return output;
+	}
+
+	/*!
+	 * \brief Compute the next \p len sine outputs.
+	 *
+	 * Only the last output is written to the store.
+	 */
+	void operator()(type* out, size_t len) noexcept
 	{
-		decltype(auto) o = outputObject();
-		return o.valid() ? o.get() : type();
+		if(likely(len))
+			run(out, len);
 	}
 
-	/*! \brief Return the \c enable object. */
-	decltype(auto) enableObject() const noexcept
+	/*!
+	 * \brief Compute the next block of sine outputs.
+	 */
+	template <size_t N>
+	void operator()(type (&out)[N]) noexcept
 	{
-		return m_o.template get<'e'>();
+		run(out, N);
 	}
 
-	/*! \brief Return the \c enable object. */
-	decltype(auto) enableObject() noexcept
+protected:
+	/*!
+	 * \brief Compute the next block of sine outputs.
+	 */
+	void run(type* out, size_t len) noexcept
 	{
-		return m_o.template get<'e'>();
+		stored_assert(len > 0);
+
+		auto const& p = this->cached([this]() { return parameters(); });
+		run(out, len, p, impl::is_fixed<type>(), std::integral_constant<SineMethod, Method>());
+
+		decltype(auto) oo = outputObject();
+		if(oo.valid())
+			oo = out[len - 1];
 	}
 
-	/*! \brief Return the \c enable value, or \c true when not available. */
-	bool enabled() const noexcept
+	/*!
+	 * \brief Compute the next block of sine outputs, using floating point.
+	 */
+	void run(type* out, size_t len, Parameters const& p, std::false_type /*fixed*/,
+		 std::integral_constant<SineMethod, SineMethod::Exact> /*method*/) noexcept
 	{
-		decltype(auto) o = enableObject();
-		return !o.valid() || o.get();
+		auto f = p.frequency;
+		type period = f > 0 ? (type)1 / f : 0;
+		type dt = 0;
+
+		if(likely(period > 0)) {
+			auto sf = p.sampleFrequency;
+			if(likely(sf > 0))
+				dt = (type)(1.0f / sf);
+		}
+
+		type forced = p.override_;
+		type t = m_state.t;
+
+		if(unlikely(!impl::isnan(forced))) {
+			for(size_t i = 0; i < len; i++)
+				out[i] = forced;
+		} else if(unlikely(!p.enabled)) {
+			for(size_t i = 0; i < len; i++)
+				out[i] = 0;
+		} else {
+			type a = p.amplitude;
+			type w = (type)2 * pi<type> * f;
+			type phase = p.phase;
+
+			for(size_t i = 0; i < len; i++) {
+				out[i] = a * std::sin(w * t + phase);
+				if(dt > 0)
+					t = std::fmod(t + dt, period);
+			}
+		}
+
+		if(dt > 0 && (!impl::isnan(forced) || !p.enabled)) {
+			// Keep the phase running, as if the output was computed.
+			for(size_t i = 0; i < len; i++)
+				t = std::fmod(t + dt, period);
+		}
+
+		m_state.t = t;
 	}
 
 	/*!
-	 * \brief Enable (or disable) the sine wave.
+	 * \brief Compute the next block of sine outputs, using fixed-point.
 	 *
-	 * Ignored when the \c enable object is not available.
+	 * Instead of keeping the time, the phase is accumulated in turns,
+	 * where 2^32 is one period, which wraps around naturally.  Only the
+	 * phase increment is computed in floating point, once per block.
 	 */
-	void enable(bool value = true) noexcept
+	void run(type* out, size_t len, Parameters const& p, std::true_type /*fixed*/,
+		 std::integral_constant<SineMethod, SineMethod::Exact> /*method*/) noexcept
 	{
-		decltype(auto) o = enableObject();
-		if(o.valid())
-			o = value;
+		using F = impl::float_type<type>;
+
+		uint32_t inc = 0;
+		auto sf = p.sampleFrequency;
+		if(likely(p.frequency > 0 && sf > 0)) {
+			F turns = (F)p.frequency / (F)sf;
+			turns -= std::floor(turns);
+			inc = (uint32_t)(uint64_t)(turns * (F)4294967296.0);
+		}
+
+		type forced = p.override_;
+
+		if(unlikely(!impl::isnan(forced))) {
+			for(size_t i = 0; i < len; i++)
+				out[i] = forced;
+		} else if(unlikely(!p.enabled)) {
+			for(size_t i = 0; i < len; i++)
+				out[i] = 0;
+		} else {
+			type a = p.amplitude;
+			// Convert the phase in rad to turns: 2^32 / (2 pi) = 683565276.
+			uint32_t phase = (uint32_t)(
+				((int64_t)p.phase.raw() * 683565276) >> type::frac);
+			uint32_t t = m_state.t;
+
+			for(size_t i = 0; i < len; i++, t += inc)
+				out[i] = a
+					 * impl::sin_turns<typename type::int_type, type::frac>(
+						 t + phase);
+		}
+
+		m_state.t += (uint32_t)(inc * len);
 	}
 
 	/*!
-	 * \brief Disable the sine wave.
-	 *
-	 * Ignored when the \c enable object is not available.
+	 * \brief Compute the next block of sine outputs, using a lookup table.
 	 */
-	void disable() noexcept
+	void run(type* out, size_t len, Parameters const& p, std::false_type /*fixed*/,
+		 std::integral_constant<SineMethod, SineMethod::Table> /*method*/) noexcept
 	{
-		enable(false);
+		uint32_t inc = 0;
+		auto sf = p.sampleFrequency;
+		if(likely(p.frequency > 0 && sf > 0))
+			inc = impl::to_turns(p.frequency / (type)sf);
+
+		type forced = p.override_;
+
+		if(unlikely(!impl::isnan(forced))) {
+			for(size_t i = 0; i < len; i++)
+				out[i] = forced;
+		} else if(unlikely(!p.enabled)) {
+			for(size_t i = 0; i < len; i++)
+				out[i] = 0;
+		} else {
+			type a = p.amplitude;
+			uint32_t phase = impl::to_turns(p.phase * ((type)0.5 / pi<type>));
+			uint32_t t = m_state.t;
+
+			for(size_t i = 0; i < len; i++, t += inc)
+				out[i] = a * impl::sine_table<type>.sin(t + phase);
+		}
+
+		m_state.t += (uint32_t)(inc * len);
 	}
 
 	/*!
-	 * \brief Compute the sine output.
+	 * \brief Compute the next block of sine outputs, using a recursive oscillator.
 	 */
-	type operator()() noexcept
+	void run(type* out, size_t len, Parameters const& p, std::false_type /*fixed*/,
+		 std::integral_constant<SineMethod, SineMethod::Oscillator> /*method*/) noexcept
 	{
-		auto f = frequency();
-		type period = f > 0 ? (type)1 / f : 0;
+		auto& st = m_state;
 
-		type output = override_();
+		// NOLINTNEXTLINE(clang-diagnostic-float-equal)
+		if(unlikely(p.frequency != st.f || p.sampleFrequency != st.sf)) {
+			st.f = p.frequency;
+			st.sf = p.sampleFrequency;
+			type w = st.f > 0 && st.sf > 0 ? (type)2 * pi<type> * st.f / (type)st.sf : 0;
+			st.cw = std::cos(w);
+			st.sw = std::sin(w);
+		}
 
-		if(likely(std::isnan(output))) {
-			if(likely(enabled()))
-				output = amplitude()
-					 * std::sin((type)2 * pi<type> * f * m_t + phase());
-			else
-				output = 0;
+		// NOLINTNEXTLINE(clang-diagnostic-float-equal)
+		if(unlikely(p.phase != st.phase)) {
+			st.phase = p.phase;
+			st.cp = std::cos(st.phase);
+			st.sp = std::sin(st.phase);
 		}
 
-		if(likely(period > 0)) {
-			auto sf = sampleFrequency();
-			if(likely(sf > 0)) {
-				type dt = (type)(1.0f / sf);
-				m_t = std::fmod(m_t + dt, period);
+		type forced = p.override_;
+		bool active = impl::isnan(forced) && p.enabled;
+		type a = active ? p.amplitude : impl::isnan(forced) ? (type)0 : forced;
+		type ac = active ? a * st.sp : 0;
+		type as = active ? a * st.cp : 0;
+		type cw = st.cw;
+		type sw = st.sw;
+		type c_ = st.c;
+		type s_ = st.s;
+
+		while(len > 0) {
+			size_t chunk = std::min<size_t>(len, (size_t)RenormalizeInterval);
+
+			for(size_t i = 0; i < chunk; i++) {
+				// sin(wt + phase) = sin(wt) cos(phase) + cos(wt) sin(phase)
+				out[i] = active ? as * s_ + ac * c_ : a;
+
+				type c_next = c_ * cw - s_ * sw;
+				s_ = s_ * cw + c_ * sw;
+				c_ = c_next;
 			}
-		}
 
-		decltype(auto) oo = outputObject();
-		if(oo.valid())
-			oo = output;
+			// Correct the amplitude of the phasor. As it is already close
+			// to 1, a first-order approximation of 1 / sqrt(x) suffices.
+			type g = ((type)3 - (c_ * c_ + s_ * s_)) * (type)0.5;
+			c_ *= g;
+			s_ *= g;
 
-		return output;
+			out += chunk;
+			len -= chunk;
+		}
+
+		st.c = c_;
+		st.s = s_;
 	}
 
 	/*!
@@ -3029,8 +4618,10 @@ public:
 	}
 
 private:
+	using base_cache = impl::ParameterCache<Bound, Parameters, Cached, 'A', 'f', 'p', 'F', 'e'>;
+
 	Bound m_o;
-	type m_t{};
+	impl::SineState<type, Method> m_state;
 };
 
 
@@ -3045,6 +4636,20 @@ using PulseWaveObjects = FreeObjectsList<
 	FreeVariables<T, Container, 'A', 'f', 'p', 'd', 'F', 'O'>,
 	FreeVariables<bool, Container, 'e'>>;
 
+/*!
+ * \brief The parameters of a #stored::PulseWave.
+ */
+template <typename T>
+struct PulseWaveParameters {
+	float sampleFrequency;
+	T amplitude;
+	T frequency;
+	T phase;
+	T dutyCycle;
+	T override_;
+	bool enabled;
+};
+
 /*!
  * \brief Pulse wave generator, based on store variables.
  *
@@ -3091,12 +4696,21 @@ using PulseWaveObjects = FreeObjectsList<
  * // Instantiate the generator, tailored to the available fields in the store.
  * stored::PulseWave<stored::YourStore, pulse_o.flags()> pulse{pulse_o, yourStore};
  * \endcode
+ *
+ * When \p Cached is \c true, the parameters, including the <tt>sample
+ * frequency</tt>, are read once and saved in the instance. See
+ * #stored::Amplifier for how to refresh them.
  */
-template <typename Container, unsigned long long flags = 0, typename T = float>
-class PulseWave {
+template <
+	typename Container, unsigned long long flags = 0, typename T = float, bool Cached = false>
+class PulseWave
+	: private impl::ParameterCache<
+		  typename PulseWaveObjects<Container, T>::template Bound<flags>,
+		  PulseWaveParameters<T>, Cached, 'A', 'f', 'p', 'd', 'F', 'e'> {
 public:
 	using type = T;
 	using Bound = typename PulseWaveObjects<Container, type>::template Bound<flags>;
+	using Parameters = PulseWaveParameters<type>;
 
 	/*!
 	 * \brief Default ctor.
@@ -3294,31 +4908,70 @@ public:
 		enable(false);
 	}
 
+	/*!
+	 * \brief Read all parameters from the store.
+	 */
+	Parameters parameters() const noexcept
+	{
+		return Parameters{
+			sampleFrequency(), amplitude(), frequency(), phase(), dutyCycle(),
+			override_(), enabled()};
+	}
+
+	/*!
+	 * \brief Re-read the parameters at the next run.
+	 *
+	 * Only has effect when the parameters are \p Cached.
+	 */
+	void refresh() noexcept
+	{
+		base_cache::refresh();
+	}
+
+	/*!
+	 * \brief Call #refresh() when the given \p buffer is one of the parameters.
+	 * \see #stored::Amplifier::refreshIfUsed()
+	 */
+	bool refreshIfUsed(void const* buffer) noexcept
+	{
+		return base_cache::refreshIfUsed(m_o, buffer);
+	}
+
+	/*!
+	 * \brief Call #refresh() when one of the parameters has changed in the given journal.
+	 * \see #stored::Amplifier::refreshIfChanged()
+	 */
+	template <typename Journal>
+	bool refreshIfChanged(Journal& journal) noexcept
+	{
+		return base_cache::refreshIfChanged(m_o, journal);
+	}
+
 	/*!
 	 * \brief Compute the pulse wave output.
 	 */
 	type operator()() noexcept
 	{
-		auto f = frequency();
+		auto const& p = this->cached([this]() { return parameters(); });
+		auto f = p.frequency;
 		type period = f > 0 ? (type)1 / f : 0;
 
-		type output = override_();
+		type output = p.override_;
 
-		if(likely(std::isnan(output))) {
-			if(likely(enabled())) {
-				type pulse = period * dutyCycle();
+		if(likely(impl::isnan(output))) {
+			if(likely(p.enabled)) {
+				type pulse = period * p.dutyCycle;
 
 				type t = m_t;
-				decltype(auto) po = phaseObject();
-				if(po.valid())
+				if(Bound::template valid<'p'>())
 					t = std::fmod(
 						t
-							+ phase() * ((type)1 / ((type)2 * pi<type>))
+							+ p.phase * ((type)1 / ((type)2 * pi<type>))
 								  * period,
 						period);
 
 				if(t < pulse)
-					output = amplitude();
+					output = p.amplitude;
 				else
 					output = 0;
 			} else {
@@ -3327,7 +4980,7 @@ public:
 		}
 
 		if(likely(period > 0)) {
-			auto sf = sampleFrequency();
+			auto sf = p.sampleFrequency;
 			if(likely(sf > 0)) {
 				type dt = (type)(1.0f / sf);
 				m_t = std::fmod(m_t + dt, period);
@@ -3375,6 +5028,9 @@ public:
 	}
 
 private:
+	using base_cache =
+		impl::ParameterCache<Bound, Parameters, Cached, 'A', 'f', 'p', 'd', 'F', 'e'>;
+
 	Bound m_o;
 	type m_t{};
 };
@@ -3390,6 +5046,15 @@ using LowPassObjects = FreeObjectsList<
 	FreeFunctions<float, Container, 's'>, FreeVariables<T, Container, 'I', 'c', 'F', 'O'>,
 	FreeVariables<bool, Container, 'e', 'r'>>;
 
+/*!
+ * \brief The parameters of a #stored::LowPass.
+ */
+template <typename T>
+struct LowPassParameters {
+	T override_;
+	bool enabled;
+};
+
 /*!
  * \brief First-order low-pass filter, based on store variables.
  *
@@ -3425,12 +5090,23 @@ using LowPassObjects = FreeObjectsList<
  * The cutoff frequency can be changed while running (by setting \c
  * reset to \c true).  It will applied smoothly; the output will
  * gradually take the new cutoff frequency into account.
+ *
+ * When \p Cached is \c true, \c enable and \c override are read once
+ * and saved in the instance, like the <tt>cutoff frequency</tt> and
+ * <tt>sample frequency</tt>, which are read at reset. Setting \c reset
+ * re-reads all of them. See #stored::Amplifier for other ways to refresh
+ * them.
  */
-template <typename Container, unsigned long long flags = 0, typename T = float>
-class LowPass {
+template <
+	typename Container, unsigned long long flags = 0, typename T = float, bool Cached = false>
+class LowPass
+	: private impl::ParameterCache<
+		  typename LowPassObjects<Container, T>::template Bound<flags>,
+		  LowPassParameters<T>, Cached, 'F', 'e'> {
 public:
 	using type = T;
 	using Bound = typename LowPassObjects<Container, type>::template Bound<flags>;
+	using Parameters = LowPassParameters<type>;
 
 	/*!
 	 * \brief Default ctor.
@@ -3610,6 +5286,43 @@ public:
 		return o.valid() && o.get();
 	}
 
+	/*!
+	 * \brief Read all parameters from the store.
+	 */
+	Parameters parameters() const noexcept
+	{
+		return Parameters{override_(), enabled()};
+	}
+
+	/*!
+	 * \brief Re-read the parameters at the next run.
+	 *
+	 * Only has effect when the parameters are \p Cached.
+	 */
+	void refresh() noexcept
+	{
+		base_cache::refresh();
+	}
+
+	/*!
+	 * \brief Call #refresh() when the given \p buffer is one of the parameters.
+	 * \see #stored::Amplifier::refreshIfUsed()
+	 */
+	bool refreshIfUsed(void const* buffer) noexcept
+	{
+		return base_cache::refreshIfUsed(m_o, buffer);
+	}
+
+	/*!
+	 * \brief Call #refresh() when one of the parameters has changed in the given journal.
+	 * \see #stored::Amplifier::refreshIfChanged()
+	 */
+	template <typename Journal>
+	bool refreshIfChanged(Journal& journal) noexcept
+	{
+		return base_cache::refreshIfChanged(m_o, journal);
+	}
+
 	/*!
 	 * \brief Compute filter output, given an \p input.
 	 */
@@ -3630,17 +5343,60 @@ public:
 		return run(input());
 	}
 
+	/*!
+	 * \brief Compute filter output for a block of \p len inputs.
+	 *
+	 * The outputs are written to \p out.  Only the last input and output
+	 * are written to the store.
+	 */
+	void operator()(type const* in, type* out, size_t len) noexcept
+	{
+		if(unlikely(!len))
+			return;
+
+		decltype(auto) o = inputObject();
+		if(o.valid())
+			o = in[len - 1];
+
+		run(in, out, len);
+	}
+
+	/*!
+	 * \brief Compute filter output for a block of inputs.
+	 */
+	template <size_t N>
+	void operator()(type const (&in)[N], type (&out)[N]) noexcept
+	{
+		(*this)(in, out, N);
+	}
+
 protected:
 	/*!
 	 * \brief Compute filter output.
 	 */
 	type run(type input) noexcept
 	{
-		type output = override_();
+		type output;
+		run(&input, &output, 1);
+		return output;
+	}
+
+	/*!
+	 * \brief Compute filter output for a block of inputs.
+	 */
+	void run(type const* in, type* out, size_t len) noexcept
+	{
+		stored_assert(len > 0);
+
+		auto const& p = this->cached([this]() { return parameters(); });
+		type forced = p.override_;
 
-		if(likely(std::isnan(output))) {
-			if(!enabled()) {
-				m_prev = output = input;
+		if(likely(impl::isnan(forced))) {
+			if(!p.enabled) {
+				for(size_t i = 0; i < len; i++)
+					out[i] = in[i];
+
+				m_prev = in[len - 1];
 			} else {
 				bool doReset = false;
 
@@ -3650,37 +5406,56 @@ protected:
 					ro = false;
 				}
 
-				if(unlikely(std::isnan(m_alpha))) {
+				if(unlikely(impl::isnan(m_alpha))) {
 					doReset = true;
-					m_prev = input;
+					m_prev = in[0];
 				}
 
 				if(unlikely(doReset)) {
-					type cutoff = cutoffFrequency();
-					type rc = cutoff > 0
-							  ? (type)1 / ((type)2 * pi<type> * cutoff)
-							  : 0;
+					if(Cached)
+						this->refresh();
+
+					// Compute the coefficients in floating point, as
+					// fixed-point types cannot represent 1 / cutoff.
+					using F = impl::float_type<type>;
+					F cutoff = (F)cutoffFrequency();
+					F rc = cutoff > 0 ? (F)1 / ((F)2 * pi<F> * cutoff) : 0;
 					auto sf = sampleFrequency();
-					type dt = sf > 0 ? (type)(1.0f / sampleFrequency()) : 0;
-					m_alpha = dt > 0 ? dt / (rc + dt) : 1;
+					F dt = sf > 0 ? (F)(1.0f / sampleFrequency()) : 0;
+					F alpha = dt > 0 ? dt / (rc + dt) : 1;
+					m_alpha = (type)alpha;
+					m_beta = (type)((F)1 - alpha);
 				}
 
-				m_prev = output = m_alpha * input + ((type)1 - m_alpha) * m_prev;
+				// This is a recursive filter, so it does not vectorize.
+				// However, it is only a few operations per sample.
+				type alpha = m_alpha;
+				type beta = m_beta;
+				type prev = m_prev;
+
+				for(size_t i = 0; i < len; i++)
+					out[i] = prev = alpha * in[i] + beta * prev;
+
+				m_prev = prev;
 			}
 		} else {
-			m_prev = input;
+			for(size_t i = 0; i < len; i++)
+				out[i] = forced;
+
+			m_prev = in[len - 1];
 		}
 
 		decltype(auto) oo = outputObject();
 		if(oo.valid())
-			oo = output;
-
-		return output;
+			oo = out[len - 1];
 	}
 
 private:
+	using base_cache = impl::ParameterCache<Bound, Parameters, Cached, 'F', 'e'>;
+
 	Bound m_o;
 	type m_alpha{std::numeric_limits<type>::quiet_NaN()};
+	type m_beta{};
 	type m_prev{};
 };
 
@@ -3695,6 +5470,15 @@ using RampObjects = FreeObjectsList<
 	FreeFunctions<float, Container, 's'>, FreeVariables<T, Container, 'I', 'v', 'a', 'F', 'O'>,
 	FreeVariables<bool, Container, 'r', 'e'>>;
 
+/*!
+ * \brief The parameters of a #stored::Ramp.
+ */
+template <typename T>
+struct RampParameters {
+	T override_;
+	bool enabled;
+};
+
 /*!
  * \brief Ramping setpoints, based on store variables.
  *
@@ -3733,13 +5517,23 @@ using RampObjects = FreeObjectsList<
  *
  * The parameters can be changed while running (when \c reset is set to
  * \c true).  The change will be applied smoothly to the path.
+ *
+ * When \p Cached is \c true, \c enable and \c override are read once
+ * and saved in the instance, like the limits and the <tt>sample
+ * frequency</tt>, which are read at reset. Setting \c reset re-reads all
+ * of them. See #stored::Amplifier for other ways to refresh them.
  */
-template <typename Container, unsigned long long flags = 0, typename T = float>
-class Ramp {
+template <
+	typename Container, unsigned long long flags = 0, typename T = float, bool Cached = false>
+class Ramp
+	: private impl::ParameterCache<
+		  typename RampObjects<Container, T>::template Bound<flags>, RampParameters<T>,
+		  Cached, 'F', 'e'> {
 public:
 	using type = T;
 	using type_ = long;
 	using Bound = typename RampObjects<Container, type>::template Bound<flags>;
+	using Parameters = RampParameters<type>;
 
 	/*!
 	 * \brief Default ctor.
@@ -3937,6 +5731,43 @@ public:
 		return o.valid() ? o.get() : type();
 	}
 
+	/*!
+	 * \brief Read all parameters from the store.
+	 */
+	Parameters parameters() const noexcept
+	{
+		return Parameters{override_(), enabled()};
+	}
+
+	/*!
+	 * \brief Re-read the parameters at the next run.
+	 *
+	 * Only has effect when the parameters are \p Cached.
+	 */
+	void refresh() noexcept
+	{
+		base_cache::refresh();
+	}
+
+	/*!
+	 * \brief Call #refresh() when the given \p buffer is one of the parameters.
+	 * \see #stored::Amplifier::refreshIfUsed()
+	 */
+	bool refreshIfUsed(void const* buffer) noexcept
+	{
+		return base_cache::refreshIfUsed(m_o, buffer);
+	}
+
+	/*!
+	 * \brief Call #refresh() when one of the parameters has changed in the given journal.
+	 * \see #stored::Amplifier::refreshIfChanged()
+	 */
+	template <typename Journal>
+	bool refreshIfChanged(Journal& journal) noexcept
+	{
+		return base_cache::refreshIfChanged(m_o, journal);
+	}
+
 	/*!
 	 * \brief Compute the next ramp output, given an input.
 	 */
@@ -3957,6 +5788,33 @@ public:
 		return run(input());
 	}
 
+	/*!
+	 * \brief Compute the ramp output for a block of \p len inputs.
+	 *
+	 * The outputs are written to \p out.  Only the last input and output
+	 * are written to the store.
+	 */
+	void operator()(type const* in, type* out, size_t len) noexcept
+	{
+		if(unlikely(!len))
+			return;
+
+		decltype(auto) o = inputObject();
+		if(o.valid())
+			o = in[len - 1];
+
+		run(in, out, len);
+	}
+
+	/*!
+	 * \brief Compute the ramp output for a block of inputs.
+	 */
+	template <size_t N>
+	void operator()(type const (&in)[N], type (&out)[N]) noexcept
+	{
+		(*this)(in, out, N);
+	}
+
 	/*!
 	 * \brief Check numerical stability.
 	 *
@@ -3970,7 +5828,7 @@ public:
 	 */
 	bool isHealthy() const noexcept
 	{
-		if(std::isnan(m_adt))
+		if(impl::isnan(m_adt))
 			// No ramping configured.
 			return true;
 
@@ -4006,25 +5864,41 @@ protected:
 	 */
 	type run(type input) noexcept
 	{
-		type output = override_();
+		type output;
+		run(&input, &output, 1);
+		return output;
+	}
+
+	/*!
+	 * \brief Compute the output of the ramp for a block of inputs.
+	 */
+	void run(type const* in, type* out, size_t len) noexcept
+	{
+		stored_assert(len > 0);
+
+		auto const& p = this->cached([this]() { return parameters(); });
+		type forced = p.override_;
 
-		if(likely(std::isnan(output))) {
+		if(likely(impl::isnan(forced))) {
 			decltype(auto) ro = resetObject();
-			if(unlikely((ro.valid() && ro.get()) || std::isnan(m_adt))) {
+			if(unlikely((ro.valid() && ro.get()) || impl::isnan(m_adt))) {
 				type v = m_adt > 0 ? (type)m_v_ * m_adt : 0;
 
 				if(ro.valid())
 					ro = false;
 
+				if(Cached)
+					this->refresh();
+
 				float f = sampleFrequency();
 				type dt = f > 0 ? (type)(1.0f / f) : 0;
 
 				auto sl = speedLimit();
-				if(std::isnan(sl) || sl < 0)
+				if(impl::isnan(sl) || sl < 0)
 					sl = 0;
 
 				auto a = accelerationLimit();
-				if(std::isnan(a) || a < 0)
+				if(impl::isnan(a) || a < 0)
 					a = 0;
 
 				// Compute a as the acceleration per tick.
@@ -4048,82 +5922,101 @@ protected:
 			}
 
 			if(unlikely(!(m_adt > 0))) {
-				output = input;
-			} else if(unlikely(!enabled())) {
-				m_start = output = input;
-				m_v_ = (type_)std::lround((output - m_x) / m_adt);
+				for(size_t i = 0; i < len; i++)
+					out[i] = in[i];
+			} else if(unlikely(!p.enabled)) {
+				for(size_t i = 0; i < len; i++)
+					out[i] = in[i];
+
+				type prev = len > 1 ? in[len - 2] : m_x;
+				m_start = in[len - 1];
+				m_v_ = (type_)std::lround((m_start - prev) / m_adt);
 				m_x_ = 0;
 				m_x_stop_ = m_v_ * std::abs(m_v_) / 2;
 			} else {
-				auto err = input - m_x;
-
-				if(std::fabs(err) < m_adt && (m_v_ >= -1 && m_v_ <= 1)) {
-					// Close enough. Stop.
-					m_x_ = m_x_stop_ = m_v_ = 0;
-					output = m_start = input;
-				} else if(err > 0) {
-					// Should be moving up towards target.
-					auto x_stop_ = m_x_stop_;
-					auto v_ = m_v_;
-
-					if(v_ < m_v_max_) {
-						// Speed up towards target.
-						if(v_ >= 0)
-							x_stop_ += v_++;
-						else
-							x_stop_ -= ++v_;
-					}
-
-					if(m_v_ > 0 && err < (type)(x_stop_ + v_ + 1) * m_adt) {
-						if(err < (type)(m_x_stop_ + m_v_) * m_adt)
-							// Break.
-							m_x_stop_ -= --m_v_;
-						// else hold speed.
-					} else {
-						m_x_stop_ = x_stop_;
-						m_v_ = v_;
-					}
-				} else {
-					// Should be moving down towards target.
-					auto x_stop_ = m_x_stop_;
-					auto v_ = m_v_;
-
-					if(v_ > -m_v_max_) {
-						// Speed up towards target.
-						if(v_ <= 0)
-							x_stop_ += v_--;
-						else
-							x_stop_ -= --v_;
-					}
-
-					if(m_v_ < 0 && err > (type)(x_stop_ + v_ - 1) * m_adt) {
-						if(err > (type)(m_x_stop_ + m_v_) * m_adt)
-							// Break.
-							m_x_stop_ -= ++m_v_;
-						// else hold speed.
-					} else {
-						m_x_stop_ = x_stop_;
-						m_v_ = v_;
-					}
-				}
-
-				m_x_ += m_v_;
-				output = m_start + (type)m_x_ * m_adt;
+				// The ramp is a state machine, which has to be evaluated
+				// sample by sample.
+				for(size_t i = 0; i < len; i++)
+					out[i] = step(in[i]);
 			}
 
-			m_x = output;
+			m_x = out[len - 1];
 		} else {
+			for(size_t i = 0; i < len; i++)
+				out[i] = forced;
+
 			m_v_ = m_x_stop_ = 0;
 		}
 
 		decltype(auto) oo = outputObject();
 		if(oo.valid())
-			oo = output;
-
-		return output;
+			oo = out[len - 1];
 	}
 
 private:
+	/*!
+	 * \brief Compute one step of the enabled ramp towards \p input.
+	 */
+	type step(type input) noexcept
+	{
+		auto err = input - m_x;
+
+		if(impl::fabs(err) < m_adt && (m_v_ >= -1 && m_v_ <= 1)) {
+			// Close enough. Stop.
+			m_x_ = m_x_stop_ = m_v_ = 0;
+			return m_x = m_start = input;
+		} else if(err > 0) {
+			// Should be moving up towards target.
+			auto x_stop_ = m_x_stop_;
+			auto v_ = m_v_;
+
+			if(v_ < m_v_max_) {
+				// Speed up towards target.
+				if(v_ >= 0)
+					x_stop_ += v_++;
+				else
+					x_stop_ -= ++v_;
+			}
+
+			if(m_v_ > 0 && err < (type)(x_stop_ + v_ + 1) * m_adt) {
+				if(err < (type)(m_x_stop_ + m_v_) * m_adt)
+					// Break.
+					m_x_stop_ -= --m_v_;
+				// else hold speed.
+			} else {
+				m_x_stop_ = x_stop_;
+				m_v_ = v_;
+			}
+		} else {
+			// Should be moving down towards target.
+			auto x_stop_ = m_x_stop_;
+			auto v_ = m_v_;
+
+			if(v_ > -m_v_max_) {
+				// Speed up towards target.
+				if(v_ <= 0)
+					x_stop_ += v_--;
+				else
+					x_stop_ -= --v_;
+			}
+
+			if(m_v_ < 0 && err > (type)(x_stop_ + v_ - 1) * m_adt) {
+				if(err > (type)(m_x_stop_ + m_v_) * m_adt)
+					// Break.
+					m_x_stop_ -= ++m_v_;
+				// else hold speed.
+			} else {
+				m_x_stop_ = x_stop_;
+				m_v_ = v_;
+			}
+		}
+
+		m_x_ += m_v_;
+		return m_x = m_start + (type)m_x_ * m_adt;
+	}
+
+	using base_cache = impl::ParameterCache<Bound, Parameters, Cached, 'F', 'e'>;
+
 	Bound m_o;
 	type m_adt{std::numeric_limits<type>::quiet_NaN()};
 	type_ m_v_{};
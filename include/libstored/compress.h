@@ -14,6 +14,101 @@
 #include <libstored/protocol.h>
 
 #ifdef __cplusplus
+namespace stored {
+
+/*!
+ * \brief Delta/zigzag/varint transform for fixed-layout samples.
+ *
+ * When a stream consists of records with a fixed layout, like trace
+ * samples of binary data, subsequent records are usually very much alike.
+ * General-purpose compressors like heatshrink do not exploit that well,
+ * as the same field has a different value every time.
+ *
+ * This layer interprets the encoded data as a sequence of records of \c
+ * stride bytes, each consisting of little-endian words of \c word bytes.
+ * Every word is replaced by the difference with the same word in the
+ * previous record.  This difference is zigzag encoded (small negative
+ * values become small positive values) and written as a LEB128 varint.
+ * Slowly changing fields therefore shrink to one byte, which is very
+ * compressible by a stacked stored::CompressLayer.
+ *
+ * The state is reset when the last part of a message is encoded, and
+ * after every decoded message.  When \c stride is 0, this layer is a
+ * pass-through.  When the encoded data does not end at a word boundary,
+ * the remaining bytes are appended raw, after the marker \c 0x80 \c 0x00.
+ * This is a varint of 0 in two bytes, which the encoder never produces
+ * otherwise.
+ */
+class DeltaLayer : public ProtocolLayer {
+	STORED_CLASS_NOCOPY(DeltaLayer)
+public:
+	typedef ProtocolLayer base;
+
+	enum {
+		/*! \brief Maximum word size in bytes. */
+		MaxWord = 8,
+	};
+
+	explicit DeltaLayer(
+		size_t stride = 0, size_t word = 4, ProtocolLayer* up = nullptr,
+		ProtocolLayer* down = nullptr);
+	virtual ~DeltaLayer() override is_default
+
+	virtual void decode(void* buffer, size_t len) override;
+	virtual void encode(void const* buffer, size_t len, bool last = true) override;
+#	ifndef DOXYGEN
+	using base::encode;
+#	endif
+	virtual size_t mtu() const override;
+	virtual void reset() override;
+
+	/*! \brief Return the configured record size in bytes. */
+	size_t stride() const
+	{
+		return m_stride;
+	}
+
+	/*! \brief Return the configured word size in bytes. */
+	size_t word() const
+	{
+		return m_word;
+	}
+
+	bool idle() const;
+	size_t maxInput(size_t len) const;
+
+protected:
+	void encodeWord();
+	void encodeTail();
+	void encodeFlush(bool last);
+
+private:
+	/*! \brief Record size in bytes. */
+	size_t m_stride;
+	/*! \brief Word size in bytes. */
+	size_t m_word;
+
+	/*! \brief Previous record, as seen by the encoder. */
+	Vector<uint8_t>::type m_encodePrev;
+	/*! \brief Offset within the record of the word being encoded. */
+	size_t m_encodePos;
+	/*! \brief Partially received word. */
+	uint64_t m_encodeWord;
+	/*! \brief Number of bytes in #m_encodeWord. */
+	size_t m_encodeWordFill;
+	/*! \brief Output buffer of the encoder. */
+	uint8_t m_encodeBuffer[64];
+	/*! \brief Number of bytes in #m_encodeBuffer. */
+	size_t m_encodeBufferSize;
+
+	/*! \brief Previous record, as seen by the decoder. */
+	Vector<uint8_t>::type m_decodePrev;
+	/*! \brief Fully decoded message. */
+	Vector<uint8_t>::type m_decodeBuffer;
+};
+
+} // namespace stored
+
 #	ifndef STORED_HAVE_HEATSHRINK
 namespace stored {
 // No compression available, just use a pass-through.
@@ -39,6 +134,13 @@ namespace stored {
  * where it compresses a full stream (not separate messages), which are
  * sent in chunks to the other side.
  *
+ * The default window and lookahead sizes are tuned for small memory
+ * usage. For repetitive data, like trace samples, a larger window usually
+ * gives a better compression ratio, at the cost of (2 << window) bytes of
+ * RAM for the encoder.  Note that the decoder (e.g., the client) must use
+ * the same parameters.  Stack a stored::DeltaLayer on top to improve
+ * compression of fixed-layout samples further.
+ *
  * When heatshrink is not available, this layer is just a pass-through.
  */
 class CompressLayer : public ProtocolLayer {
@@ -61,6 +163,9 @@ public:
 	};
 
 	explicit CompressLayer(ProtocolLayer* up = nullptr, ProtocolLayer* down = nullptr);
+	explicit CompressLayer(
+		uint8_t window, uint8_t lookahead, ProtocolLayer* up = nullptr,
+		ProtocolLayer* down = nullptr);
 	virtual ~CompressLayer() override;
 
 	virtual void decode(void* buffer, size_t len) override;
@@ -77,6 +182,18 @@ public:
 
 	bool idle() const;
 
+	/*! \brief Return the configured window size (base-2 log). */
+	uint8_t window() const
+	{
+		return m_window;
+	}
+
+	/*! \brief Return the configured lookahead size (base-2 log). */
+	uint8_t lookahead() const
+	{
+		return m_lookahead;
+	}
+
 protected:
 	void encoderPoll();
 	void decoderPoll();
@@ -110,6 +227,12 @@ private:
 	 * \brief Current state of the encoder and decoder.
 	 */
 	uint8_t m_state;
+
+	/*! \brief Window size (base-2 log). */
+	uint8_t m_window;
+
+	/*! \brief Lookahead size (base-2 log). */
+	uint8_t m_lookahead;
 };
 
 } // namespace stored
@@ -15,6 +15,12 @@
 #	include <cstddef>
 #	include <memory>
 
+#	if STORED_cplusplus < 201103L
+#		include <stdint.h>
+#	else
+#		include <cstdint>
+#	endif
+
 namespace stored {
 /*!
  * \brief Default configuration.
@@ -97,6 +103,17 @@ struct DefaultConfig {
 		false;
 #	endif
 
+	/*!
+	 * \brief When \c true, stored::Debugger and stored::Synchronizer use
+	 *	fixed-capacity containers.
+	 *
+	 * All memory is allocated while constructing the Debugger, mapping
+	 * stores and connecting Synchronizers.  Afterwards, processing requests
+	 * and messages does not use the Allocator anymore.  This requires
+	 * #AvoidDynamicMemory.
+	 */
+	static bool const FixedCapacityContainers = false;
+
 	/*! \brief When \c true, stored::Debugger implements the read capability. */
 	static bool const DebuggerRead = true;
 	/*! \brief When \c true, stored::Debugger implements the write capability. */
@@ -160,6 +177,21 @@ struct DefaultConfig {
 		0;
 #	endif
 
+	/*!
+	 * \brief Decay of the high-water mark of a stored::ScratchPad.
+	 *
+	 * Upon every stored::ScratchPad::reset(), the high-water mark is
+	 * lowered by 1/ScratchPadDecay of its value.  When the single chunk of
+	 * the ScratchPad has become more than twice as large as the high-water
+	 * mark, it is replaced by a smaller one.  Set to 0 to never shrink.
+	 */
+	static size_t const ScratchPadDecay =
+#	ifndef DOXYGEN
+		AvoidDynamicMemory ? 0 : 256;
+#	else
+		256;
+#	endif
+
 	/*! \brief When \c true, stored::Debugger implements the trace capability. */
 	static bool const DebuggerTrace = DebuggerStreams > 0 && DebuggerMacro > 0;
 
@@ -174,6 +206,31 @@ struct DefaultConfig {
 		false;
 #	endif
 
+	/*!
+	 * \brief Base-2 log of the heatshrink window size of compressed streams.
+	 *
+	 * A larger window improves the compression ratio of repetitive trace
+	 * data, but costs (2 << window) bytes of RAM per stream.  The client
+	 * must be configured accordingly.
+	 */
+	static uint8_t const CompressStreamsWindow = 8;
+
+	/*! \brief Base-2 log of the heatshrink lookahead size of compressed streams. */
+	static uint8_t const CompressStreamsLookahead = 4;
+
+	/*!
+	 * \brief Record size in bytes of stream data for stored::DeltaLayer.
+	 *
+	 * When non-zero, all data written to compressed streams is passed
+	 * through a stored::DeltaLayer before compression.  Only use this when
+	 * streams contain fixed-layout binary records, such as binary trace
+	 * samples.  Set to 0 to disable.
+	 */
+	static size_t const CompressStreamsDelta = 0;
+
+	/*! \brief Word size in bytes of stream data for stored::DeltaLayer. */
+	static size_t const CompressStreamsDeltaWord = 4;
+
 	/*!
 	 * \brief Allocator to be used for all dynamic memory allocations.
 	 *
@@ -188,6 +245,27 @@ struct DefaultConfig {
 		typedef std::allocator<T> type;
 	};
 
+	/*!
+	 * \brief When \c true, stored::Pool may be used by multiple threads concurrently.
+	 */
+	static bool const PoolThreadSafe =
+#	ifdef STORED_HAVE_THREADS
+		true;
+#	else
+		false;
+#	endif
+
+	/*!
+	 * \brief Number of free blocks per size class stored::Pool keeps per thread.
+	 *
+	 * This cache avoids locking for most allocations.  Only used when
+	 * #PoolThreadSafe is set.  Set to 0 to disable.
+	 */
+	static size_t const PoolThreadCache = 32;
+
+	/*! \brief Size in bytes of the chunks stored::Pool requests from the system. */
+	static size_t const PoolChunkSize = 4096;
+
 	/*!
 	 * \brief Allow unaligned memory access.
 	 */
@@ -28,6 +28,10 @@
 #		include <functional>
 #	endif
 
+#	ifdef STORED_HAVE_THREADS
+#		include <mutex>
+#	endif
+
 namespace stored {
 
 template <bool Compress = Config::CompressStreams>
@@ -166,8 +170,13 @@ public:
 	typedef ProtocolLayer base;
 
 	Stream()
+		: m_delta(Config::CompressStreamsDelta, Config::CompressStreamsDeltaWord)
+#	ifdef STORED_HAVE_HEATSHRINK
+		, m_compress(Config::CompressStreamsWindow, Config::CompressStreamsLookahead)
+#	endif
 	{
-		m_compress.wrap(*this);
+		m_delta.wrap(*this);
+		m_compress.wrap(m_delta);
 		m_string.wrap(m_compress);
 	}
 
@@ -186,7 +195,7 @@ public:
 		if(blocked())
 			return;
 
-		m_compress.encode(buffer, len, false);
+		m_delta.encode(buffer, len, false);
 	}
 
 	using base::encode;
@@ -198,8 +207,8 @@ public:
 
 	bool flush() final
 	{
-		m_compress.encode();
-		return m_compress.flush();
+		m_delta.encode();
+		return m_delta.flush();
 	}
 
 	void clear() noexcept
@@ -214,11 +223,11 @@ public:
 
 	bool empty() const noexcept
 	{
-		return
+		return m_delta.idle() &&
 #	ifdef STORED_HAVE_HEATSHRINK
-			m_compress.idle() &&
+		       m_compress.idle() &&
 #	endif
-			m_string.empty();
+		       m_string.empty();
 	}
 
 	String::type const& buffer() const noexcept
@@ -250,16 +259,17 @@ public:
 	{
 		// Use the overflow region only for unexpected compression output.
 		size_t const default_max = Config::DebuggerStreamBuffer;
-		more = std::min(more, default_max);
 		size_t size = buffer().size();
 
 		if(size >= default_max)
 			return 0;
 
-		return std::min(more, default_max - size);
+		// The DeltaLayer may expand the data.
+		return std::min(more, m_delta.maxInput(default_max - size));
 	}
 
 private:
+	DeltaLayer m_delta;
 	CompressLayer m_compress;
 	Stream<false> m_string;
 };
@@ -306,6 +316,29 @@ public:
 	 */
 	virtual bool valid() const = 0;
 
+	/*!
+	 * \brief Retrieve \p count consecutive array elements, starting at this object.
+	 * \param dst the destination buffer, which must hold \p count times #size() bytes
+	 * \return the number of bytes written into \p dst, or 0 when the range is invalid
+	 * \see #stored::Variant::getRange()
+	 */
+	virtual size_t getRange(void* dst, size_t count) const = 0;
+
+	/*!
+	 * \brief Set \p count consecutive array elements, starting at this object.
+	 * \param src the data to be written, which must hold \p count times #size() bytes
+	 * \return the number of bytes consumed, or 0 when the range is invalid
+	 * \see #stored::Variant::setRange()
+	 */
+	virtual size_t setRange(void const* src, size_t count) = 0;
+
+	/*!
+	 * \brief Returns the number of array elements from this object up to the end of its array.
+	 * \return the number of elements, or 0 when this object is not an array element
+	 * \see #stored::Variant::arrayRemaining()
+	 */
+	virtual size_t arrayRemaining() const = 0;
+
 	/*!
 	 * \brief Checks if the object is a function.
 	 */
@@ -344,6 +377,11 @@ protected:
 	 */
 	virtual void* container() const = 0;
 
+	/*!
+	 * \brief Returns the data of this object in the container's buffer.
+	 */
+	virtual void* buffer() const = 0;
+
 	// For operator==().
 	template <typename Container>
 	friend class DebugVariantTyped;
@@ -406,6 +444,21 @@ public:
 		return variant().valid();
 	}
 
+	size_t getRange(void* dst, size_t count) const final
+	{
+		return variant().getRange(dst, count);
+	}
+
+	size_t setRange(void const* src, size_t count) final
+	{
+		return variant().setRange(src, count);
+	}
+
+	size_t arrayRemaining() const final
+	{
+		return variant().arrayRemaining();
+	}
+
 	/*! \brief Returns the variant this object is a wrapper of. */
 	Variant<Container> const& variant() const
 	{
@@ -435,6 +488,11 @@ protected:
 		return variant().valid() ? &variant().container() : nullptr;
 	}
 
+	void* buffer() const final
+	{
+		return variant().valid() && variant().isVariable() ? variant().buffer() : nullptr;
+	}
+
 private:
 	/*! \brief The wrapped variant. */
 	Variant<Container> m_variant;
@@ -522,6 +580,49 @@ public:
 		return variant().valid();
 	}
 
+	size_t getRange(void* dst, size_t count) const final
+	{
+		return variant().getRange(dst, count);
+	}
+
+	size_t setRange(void const* src, size_t count) final
+	{
+		return variant().setRange(src, count);
+	}
+
+	size_t arrayRemaining() const final
+	{
+		return variant().arrayRemaining();
+	}
+
+	/*!
+	 * \brief Returns the number of array elements from this object up to and including \p last.
+	 *
+	 * The elements must be contiguous fixed-length variables of the same
+	 * type in the same store, and both must be elements of the same array,
+	 * such that they can be passed to #getRange() and #setRange().
+	 *
+	 * \return the number of elements, or 0 when they do not form a range
+	 */
+	size_t rangeTo(DebugVariant const& last) const
+	{
+		if(!isVariable() || !last.isVariable() || !Type::isFixed(type())
+		   || type() != last.type() || container() != last.container())
+			return 0;
+
+		char const* b = static_cast<char const*>(buffer());
+		char const* e = static_cast<char const*>(last.buffer());
+		size_t s = size();
+		if(!b || !e || e < b || (size_t)(e - b) % s != 0)
+			return 0;
+
+		size_t count = (size_t)(e - b) / s + 1U;
+		if(arrayRemaining() < count)
+			return 0;
+
+		return count;
+	}
+
 	bool operator==(DebugVariant const& rhs) const
 	{
 		return variant() == rhs.variant();
@@ -560,6 +661,11 @@ protected:
 		return variant().container();
 	}
 
+	void* buffer() const final
+	{
+		return variant().buffer();
+	}
+
 private:
 	/*!
 	 * \brief The buffer to create the contained #stored::DebugVariantTyped into.
@@ -722,6 +828,126 @@ private:
 	Store& m_store;
 };
 
+namespace impl {
+/*!
+ * \brief Location of a macro definition within the macro buffer of stored::Debugger.
+ */
+struct DebuggerMacro {
+	DebuggerMacro()
+		: offset()
+		, size()
+	{}
+
+	/*! \brief Offset within the macro buffer. */
+	size_t offset;
+	/*! \brief Length of the definition. */
+	size_t size;
+};
+
+/*!
+ * \brief Containers of stored::Debugger.
+ * \see stored::Config::FixedCapacityContainers
+ */
+template <bool Fixed = Config::FixedCapacityContainers>
+struct DebuggerContainers {
+	typedef Map<char, DebugVariant>::type AliasMap;
+	typedef Map<char, String::type>::type MacroMap;
+	typedef Map<char, Stream<>*>::type StreamMap;
+};
+
+template <>
+struct DebuggerContainers<true> {
+	// Aliases are printable chars, except for '/'.
+	typedef FixedMap<
+		char, DebugVariant,
+		(size_t)(Config::DebuggerAlias < 0x5e ? Config::DebuggerAlias : 0x5e)>
+		AliasMap;
+	// Every macro takes at least one byte of Config::DebuggerMacro.  The
+	// definitions are in Debugger::macroBuffer().
+	typedef FixedMap<
+		char, DebuggerMacro,
+		(size_t)(Config::DebuggerMacro < 0x100 ? Config::DebuggerMacro : 0x100)>
+		MacroMap;
+	typedef FixedMap<char, Stream<>*, (size_t)Config::DebuggerStreams> StreamMap;
+};
+
+class ScratchPadPoolCache;
+} // namespace impl
+
+/*!
+ * \brief A pool of ScratchPads for concurrent Debugger requests.
+ *
+ * A Debugger normally uses its own ScratchPad for every request, which
+ * only allows processing one request at a time.  When a pool is set via
+ * Debugger::setScratchPadPool(), every request gets a ScratchPad from the
+ * pool instead.  Pads are reused; the pool only grows to the number of
+ * concurrently processed requests.  Every thread keeps the last pad it
+ * released, such that a thread that processes requests in a loop does not
+ * need to lock the pool.  The pad goes back to the pool when the thread
+ * exits, or releases a pad of another pool.
+ */
+class ScratchPadPool {
+	STORED_CLASS_NOCOPY(ScratchPadPool)
+public:
+	typedef ScratchPad<> Pad;
+
+	explicit ScratchPadPool(size_t reserve = 0);
+	~ScratchPadPool();
+
+	Pad& acquire();
+	void release(Pad& pad) noexcept;
+	size_t pads() const;
+
+	/*!
+	 * \brief RAII wrapper to acquire a Pad from a ScratchPadPool.
+	 */
+	class Lease {
+		STORED_CLASS_NOCOPY(Lease)
+	public:
+		explicit Lease(ScratchPadPool& pool)
+			: m_pool(pool)
+			, m_pad(pool.acquire())
+		{}
+
+		~Lease()
+		{
+			m_pool.release(m_pad);
+		}
+
+		Pad& operator*() const noexcept
+		{
+			return m_pad;
+		}
+
+		Pad* operator->() const noexcept
+		{
+			return &m_pad;
+		}
+
+	private:
+		ScratchPadPool& m_pool;
+		Pad& m_pad;
+	};
+
+private:
+	void giveBack(Pad& pad) noexcept;
+	friend class impl::ScratchPadPoolCache;
+
+	/*! \brief Number of bytes to reserve in new pads. */
+	size_t m_reserve;
+	/*! \brief Unique id of this pool, to recognize the thread's cached pad. */
+	uint64_t m_id;
+	/*! \brief Next pool in the list of existing pools. */
+	ScratchPadPool* m_next;
+	/*! \brief All pads of this pool. */
+	Vector<Pad*>::type m_all;
+	/*! \brief Pads that are not in use, and not cached by a thread. */
+	Vector<Pad*>::type m_free;
+#	ifdef STORED_HAVE_THREADS
+	mutable std::mutex m_mutex;
+#	endif
+};
+
 /*!
  * \brief The application-layer implementation of the Embedded %Debugger protocol.
  *
@@ -792,6 +1018,7 @@ public:
 	// Variable access
 
 	DebugVariant find(char const* name, size_t len = std::numeric_limits<size_t>::max()) const;
+	bool findSlice(char const* name, size_t len, DebugVariant& first, size_t& count) const;
 
 	/*!
 	 * \typedef ListCallbackArg
@@ -871,18 +1098,40 @@ public:
 	virtual void process(void const* frame, size_t len, ProtocolLayer& response);
 	virtual void decode(void* buffer, size_t len) override;
 
+	void setScratchPadPool(ScratchPadPool* pool = nullptr);
+	ScratchPadPool* scratchPadPool() const;
+
+	/*!
+	 * \brief Let all Debugger operations in the current thread use the given ScratchPad.
+	 *
+	 * The ScratchPad is used while this object exists.  Scopes may be nested.
+	 */
+	class ScratchPadScope {
+		STORED_CLASS_NOCOPY(ScratchPadScope)
+	public:
+		explicit ScratchPadScope(ScratchPad<>& spm) noexcept;
+		~ScratchPadScope();
+		static ScratchPad<>* current() noexcept;
+
+	private:
+		ScratchPad<>* m_prev;
+	};
+
 protected:
 	ScratchPad<>& spm() const;
 
 	/*! \brief Type of alias map. */
-	typedef Map<char, DebugVariant>::type AliasMap;
+	typedef impl::DebuggerContainers<>::AliasMap AliasMap;
 	AliasMap& aliases();
 	AliasMap const& aliases() const;
 
 	/*! \brief Type of macro map. */
-	typedef Map<char, String::type>::type MacroMap;
+	typedef impl::DebuggerContainers<>::MacroMap MacroMap;
 	MacroMap& macros();
 	MacroMap const& macros() const;
+	String::type const& macroBuffer() const;
+	bool defineMacro(char m, char const* definition, size_t len);
+	void eraseMacro(char m);
 	virtual bool runMacro(char m, ProtocolLayer& response);
 
 	/*!
@@ -902,8 +1151,13 @@ protected:
 	bool decodeHex(Type::type type, void const*& data, size_t& len);
 
 private:
+	Stream<>* newStream();
+	void deleteStream(Stream<>* s);
+
 	/*! \brief A scratch pad memory for any Debugger operation. */
 	mutable ScratchPad<> m_scratchpad;
+	/*! \brief The pool for concurrent requests, if any. */
+	ScratchPadPool* m_spmPool;
 
 	/*! \brief The identification. */
 	char const* m_identification;
@@ -917,11 +1171,15 @@ private:
 	MacroMap m_macros;
 	/*! \brief Total size of macro definitions. */
 	size_t m_macroSize;
+	/*! \brief All macro definitions, when using Config::FixedCapacityContainers. */
+	String::type m_macroBuffer;
 
 	/*! \brief The streams map type. */
-	typedef Map<char, Stream<>*>::type StreamMap;
+	typedef impl::DebuggerContainers<>::StreamMap StreamMap;
 	/*! \brief The streams. */
 	StreamMap m_streams;
+	/*! \brief Preallocated streams, when using Config::FixedCapacityContainers. */
+	Vector<Stream<>*>::type m_spareStreams;
 
 	/*! \brief Macro of #trace(). */
 	char m_traceMacro;
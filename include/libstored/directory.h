@@ -52,6 +52,8 @@ constexpr14 void skipOffset(uint8_t const*& p) noexcept
  * \param directory the binary directory description
  * \param name the name to find, can be abbreviated as long as it is unambiguous
  * \param len the maximum length of \p name to parse
+ * \param end when not \c nullptr and \p name is not found, set to the position in \p name
+ *	where the lookup stopped
  * \return a container-independent variant, which is not valid when not found
  * \see #stored::find()
  * \private
@@ -67,7 +69,7 @@ __attribute__((no_sanitize("pointer-overflow")))
 #	endif
 constexpr14 Variant<>
 find(uint8_t const* directory, char const* name,
-     size_t len = std::numeric_limits<size_t>::max()) noexcept
+     size_t len = std::numeric_limits<size_t>::max(), char const** end = nullptr) noexcept
 {
 	Variant<> const notfound;
 
@@ -75,6 +77,7 @@ find(uint8_t const* directory, char const* name,
 		return notfound;
 
 	uint8_t const* p = directory;
+	char const* const start = name;
 	while(true) {
 		bool nameEnd = !*name || len == 0;
 		if(*p == 0) {
@@ -87,6 +90,41 @@ find(uint8_t const* directory, char const* name,
 				!Type::isFixed(type) ? decodeInt<size_t>(p) : Type::size(type);
 			size_t offset = decodeInt<size_t>(p);
 			return Variant<>(type, (uintptr_t)offset, datalen);
+		} else if(*p == 0x7fu) {
+			// array
+			p++;
+			size_t count = decodeInt<size_t>(p);
+			Type::type type = (Type::type)(*p++ ^ 0x80u);
+			size_t offset = decodeInt<size_t>(p);
+
+			// The [ may have been matched already.  Otherwise, the
+			// directory has skipped (part of) the name up to the index.
+			if(name == start || name[-1] != '[') {
+				while(len > 0 && *name && *name != '[' && *name != '/') {
+					name++;
+					len--;
+				}
+
+				if(len == 0 || *name != '[')
+					break;
+
+				name++;
+				len--;
+			}
+
+			size_t index = 0;
+			bool digits = false;
+			while(len > 0 && *name >= '0' && *name <= '9') {
+				index = index * 10U + (size_t)(*name++ - '0');
+				len--;
+				digits = true;
+			}
+
+			if(!digits || len == 0 || *name != ']' || index >= count)
+				break;
+
+			size_t size = Type::size(type);
+			return Variant<>(type, (uintptr_t)(offset + index * size), size);
 		} else if(*p <= 0x1f) {
 			// skip
 			if(nameEnd)
@@ -142,6 +180,9 @@ find(uint8_t const* directory, char const* name,
 		}
 	}
 
+	if(end)
+		*end = len == 0 ? "" : name;
+
 	return Variant<>();
 }
 #	if defined(STORED_ENABLE_UBSAN) \
@@ -150,6 +191,62 @@ find(uint8_t const* directory, char const* name,
 #			pragma GCC diagnostic pop
 #		endif
 #	endif
+
+#	if STORED_cplusplus >= 201402L
+// The following functions are not constexpr.  When one is called while
+// evaluating findStrict() in a constant expression, compilation fails and the
+// compiler reports the name of the function as reason.
+
+/*! \private */
+inline void path_is_unknown() noexcept
+{
+	stored_assert(false);
+}
+
+/*! \private */
+inline void path_is_ambiguous() noexcept
+{
+	stored_assert(false);
+}
+
+/*! \private */
+inline void path_has_other_type() noexcept
+{
+	stored_assert(false);
+}
+
+/*!
+ * \brief Finds an object of the given type in a directory.
+ *
+ * Like #find(), but \p name must be resolved, and the object must have the
+ * given \p type, which includes Type::FlagFunction for functions.
+ * Otherwise, it fails to compile when evaluated in a constant expression,
+ * or an assert is triggered when evaluated at run time.
+ *
+ * \return the variant, which is not valid when not found
+ * \private
+ */
+constexpr Variant<>
+findStrict(uint8_t const* directory, char const* name, size_t len, Type::type type) noexcept
+{
+	char const* end = nullptr;
+	Variant<> v = find(directory, name, len, &end);
+
+	if(!v.valid()) {
+		if(name && *name == '/' && end && (!*end || *end == '/'))
+			// The name was consumed (or a scope name ended) before
+			// a single object was selected.
+			path_is_ambiguous();
+		else
+			path_is_unknown();
+	} else if(v.type() != type) {
+		path_has_other_type();
+		return Variant<>();
+	}
+
+	return v;
+}
+#	endif // C++14
 } // namespace impl
 
 /*!
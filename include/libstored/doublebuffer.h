@@ -0,0 +1,304 @@
+#ifndef LIBSTORED_DOUBLEBUFFER_H
+#define LIBSTORED_DOUBLEBUFFER_H
+/*
+ * libstored, distributed debuggable data stores.
+ * Copyright (C) 2020-2022  Jochem Rutgers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifdef __cplusplus
+
+#	include <libstored/macros.h>
+
+#	if STORED_cplusplus >= 201103L
+
+#		include <libstored/allocator.h>
+#		include <libstored/types.h>
+#		include <libstored/util.h>
+
+#		include <algorithm>
+#		include <cstring>
+#		include <utility>
+
+#		ifdef STORED_HAVE_THREADS
+#			include <mutex>
+#		endif
+
+namespace stored {
+
+/*!
+ * \brief A pair of stores, which exchange their changes at tick boundaries.
+ *
+ * A control loop wants to read a consistent image of its inputs during a
+ * tick, and publish all its outputs at once at the end of it.  Meanwhile,
+ * the Debugger and Synchronizer may change the store at any moment.
+ *
+ * The DoubleBuffer holds two instances of the same store.  The control loop
+ * only uses the #back() store.  The #front() store is the one to map into the
+ * #stored::Debugger and #stored::Synchronizer.  #swap() is called by the
+ * control loop at the tick boundary.  It merges the changes of both sides:
+ *
+ * - variables that were changed in the front store (by the Debugger or
+ *   Synchronizer) are copied to the back store, and
+ * - the other variables that were changed in the back store (by the control
+ *   loop) are copied to the front store.
+ *
+ * So, when both sides write the same variable, the front store wins.  The
+ * changes are detected by comparing both stores to the state of the previous
+ * swap.  All changes are written to each store with one \c hookEntryBatchX() /
+ * \c hookExitBatchX() pair.  When the front store is #stored::Synchronizable,
+ * its journal therefore records all outputs of a tick in one sorted pass.
+ *
+ * The variables of the stores cannot be moved, so the swap copies the changed
+ * variables, instead of exchanging pointers to the buffers.  The costs scale
+ * with the size of the store for the comparison, and with the number of
+ * changed variables for the copy.
+ *
+ * Next to both stores, the DoubleBuffer needs a copy of the buffer, and a
+ * few tables with an entry per variable.  These are allocated via
+ * #stored::Config::Allocator, so the DoubleBuffer itself is not much larger
+ * than the two stores, even for large stores.
+ *
+ * When the Debugger or Synchronizer runs in another thread, it must lock the
+ * DoubleBuffer while it accesses the front store, like:
+ *
+ * \code
+ * stored::DoubleBuffer<MySyncStore> db;
+ *
+ * // Control thread:
+ * db.back().input.get(); ...; db.back().output = 1;
+ * db.swap();
+ *
+ * // Debugger thread:
+ * std::lock_guard<decltype(db)> lock(db);
+ * debugger.recv();
+ * \endcode
+ *
+ * \p Back may be another implementation of the same store, such as the one
+ * without the #stored::Synchronizable wrapper.
+ */
+template <typename Front, typename Back = Front>
+class DoubleBuffer {
+	STORED_CLASS_NOCOPY(DoubleBuffer)
+public:
+	/*! \brief The type of the front store. */
+	typedef Front Front_type;
+	/*! \brief The type of the back store. */
+	typedef Back Back_type;
+
+	/*!
+	 * \brief Ctor.
+	 * \details All arguments are passed to the constructor of both stores.
+	 */
+	template <typename... Args>
+	explicit DoubleBuffer(Args&&... args)
+		: m_front(args...)
+		, m_back(std::forward<Args>(args)...)
+		, m_count()
+		, m_swaps()
+	{
+		static_assert((size_t)Front::BufferSize == (size_t)Back::BufferSize, "");
+		static_assert((size_t)Front::VariableCount == (size_t)Back::VariableCount, "");
+		stored_assert(strcmp(Front::hash(), Back::hash()) == 0);
+
+		// Both stores have the same variable tables, which are sorted by offset.
+		m_count = (size_t)Front::VariableCount;
+		m_vars.resize(m_count);
+		m_shadow.resize((size_t)Front::BufferSize);
+		m_batchFront.resize(m_count);
+		m_batchBack.resize(m_count);
+
+		for(size_t i = 0; i < m_count; i++) {
+			Var& v = m_vars[i];
+			v.offset = Front::variableOffsets()[i];
+			v.len = Front::variableSizes()[i];
+			v.type = (Type::type)Front::variableTypes()[i];
+			v.front = m_front.buffer() + v.offset;
+			v.back = m_back.buffer() + v.offset;
+		}
+
+		// Start with equal stores.
+		for(size_t i = 0; i < m_count; i++) {
+			Var const& v = m_vars[i];
+			memcpy(v.back, v.front, v.len);
+			memcpy(&m_shadow[v.offset], v.front, v.len);
+		}
+	}
+
+	~DoubleBuffer() is_default
+
+	/*!
+	 * \brief The store for the Debugger and Synchronizer.
+	 * \details Lock this DoubleBuffer when accessing it outside the control thread.
+	 */
+	Front& front() noexcept
+	{
+		return m_front;
+	}
+
+	/*! \copydoc front() */
+	Front const& front() const noexcept
+	{
+		return m_front;
+	}
+
+	/*!
+	 * \brief The store for the control loop.
+	 * \details Only access it from the thread that calls #swap().
+	 */
+	Back& back() noexcept
+	{
+		return m_back;
+	}
+
+	/*! \copydoc back() */
+	Back const& back() const noexcept
+	{
+		return m_back;
+	}
+
+	/*!
+	 * \brief Returns the number of calls to #swap().
+	 */
+	size_t swaps() const noexcept
+	{
+		return m_swaps;
+	}
+
+	/*!
+	 * \brief Exchanges the changes of both stores, at a tick boundary.
+	 * \return the number of variables that were copied
+	 */
+	size_t swap() noexcept
+	{
+#		ifdef STORED_HAVE_THREADS
+		std::lock_guard<std::mutex> l(m_mutex);
+#		endif
+		m_swaps++;
+
+		if(unlikely(!m_count))
+			return 0;
+
+		// Find the changes.  Skip blocks without changes as a whole.
+		char const* front = m_vars[0].front - m_vars[0].offset;
+		char const* back = m_vars[0].back - m_vars[0].offset;
+		size_t toFront = 0;
+		size_t toBack = 0;
+		size_t i = 0;
+
+		for(size_t offset = 0; offset < (size_t)Front::BufferSize && i < m_count;
+		    offset += ScanBlock) {
+			size_t len = std::min<size_t>(ScanBlock, (size_t)Front::BufferSize - offset);
+			if(likely(memcmp(&front[offset], &m_shadow[offset], len) == 0
+				  && memcmp(&back[offset], &m_shadow[offset], len) == 0))
+				continue;
+
+			for(; i < m_count && m_vars[i].offset + m_vars[i].len <= offset; i++)
+				;
+
+			for(; i < m_count && m_vars[i].offset < offset + len; i++) {
+				Var const& v = m_vars[i];
+				if(memcmp(v.front, &m_shadow[v.offset], v.len) != 0)
+					m_batchBack[toBack++] = BatchEntry{v.back, v.len, v.type, true};
+				else if(memcmp(v.back, &m_shadow[v.offset], v.len) != 0)
+					m_batchFront[toFront++] = BatchEntry{v.front, v.len, v.type, true};
+			}
+		}
+
+		if(!toFront && !toBack)
+			return 0;
+
+		if(toFront)
+			m_front.hookEntryBatchX(m_batchFront.data(), toFront);
+		if(toBack)
+			m_back.hookEntryBatchX(m_batchBack.data(), toBack);
+
+		for(i = 0; i < toFront; i++) {
+			BatchEntry const& e = m_batchFront[i];
+			size_t offset = m_front.bufferToKey(e.buffer);
+			memcpy(e.buffer, &back[offset], e.len);
+			memcpy(&m_shadow[offset], &back[offset], e.len);
+		}
+
+		for(i = 0; i < toBack; i++) {
+			BatchEntry const& e = m_batchBack[i];
+			size_t offset = m_back.bufferToKey(e.buffer);
+			memcpy(e.buffer, &front[offset], e.len);
+			memcpy(&m_shadow[offset], &front[offset], e.len);
+		}
+
+		if(toBack)
+			m_back.hookExitBatchX(m_batchBack.data(), toBack);
+		if(toFront)
+			m_front.hookExitBatchX(m_batchFront.data(), toFront);
+
+		return toFront + toBack;
+	}
+
+	/*!
+	 * \brief Locks the front store for access by another thread.
+	 * \details This makes the DoubleBuffer usable with \c std::lock_guard.
+	 */
+	void lock()
+	{
+#		ifdef STORED_HAVE_THREADS
+		m_mutex.lock();
+#		endif
+	}
+
+	/*!
+	 * \brief Unlocks the front store.
+	 * \see #lock()
+	 */
+	void unlock()
+	{
+#		ifdef STORED_HAVE_THREADS
+		m_mutex.unlock();
+#		endif
+	}
+
+private:
+	enum {
+		/*! \brief Number of bytes that are compared at once to find changes. */
+		ScanBlock = 64,
+	};
+
+	/*! \brief A variable in both stores. */
+	struct Var {
+		char* front;
+		char* back;
+		size_t offset;
+		size_t len;
+		Type::type type;
+	};
+
+	/*! \brief The store of the Debugger and Synchronizer. */
+	Front m_front;
+	/*! \brief The store of the control loop. */
+	Back m_back;
+	/*! \brief All variables, sorted by offset. */
+	typename Vector<Var>::type m_vars;
+	/*! \brief Number of valid elements in \c m_vars. */
+	size_t m_count;
+	/*! \brief The buffer of both stores after the previous #swap(). */
+	Vector<char>::type m_shadow;
+	/*! \brief The changes to be written to the front store. */
+	Vector<BatchEntry>::type m_batchFront;
+	/*! \brief The changes to be written to the back store. */
+	Vector<BatchEntry>::type m_batchBack;
+	/*! \brief Number of swaps. */
+	size_t m_swaps;
+#		ifdef STORED_HAVE_THREADS
+	/*! \brief Mutex to protect the front store. */
+	std::mutex m_mutex;
+#		endif
+};
+
+} // namespace stored
+
+#	endif // C++11
+#endif // __cplusplus
+#endif // LIBSTORED_DOUBLEBUFFER_H
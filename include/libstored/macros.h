@@ -271,6 +271,12 @@ typedef SSIZE_T ssize_t;
 #	endif
 #endif
 
+#if defined(STORED_cplusplus) && STORED_cplusplus >= 201103L && !defined(STORED_OS_BAREMETAL) \
+	&& !defined(STORED_OS_GENERIC) && !defined(STORED_COMPILER_MINGW)
+// std::thread, std::mutex and thread_local are available.
+#	define STORED_HAVE_THREADS 1
+#endif
+
 #if defined(STORED_cplusplus) && STORED_cplusplus >= 201402L
 #	undef STORED_DEPRECATED
 #	define STORED_DEPRECATED(msg) [[deprecated(msg)]]
@@ -1528,6 +1528,91 @@ public:
 };
 #	endif // STORED_OS_WINDOWS || STORED_OS_POSIX
 
+#	if (defined(STORED_OS_LINUX) && STORED_cplusplus >= 201103L) || defined(DOXYGEN)
+/*!
+ * \brief A layer that exchanges messages with another process on the same host via shared
+ * memory.
+ *
+ * Two instances that use the same \p name form a pair. One of them creates
+ * the POSIX shared memory object, the other one attaches to it.  The shared
+ * memory holds a single-producer/single-consumer ring buffer per direction.
+ * Messages are copied into the ring by encode() and decoded in place by
+ * recv(), so message boundaries are preserved, like for the #stored::ZmqLayer.
+ *
+ * A side that finds its receive ring empty arms its doorbell: a datagram
+ * socket in the abstract Unix namespace, which is returned by #fd() and
+ * therefore pollable by the #stored::Poller.  The peer only rings it when it
+ * was armed, so a busy consumer does not cost the producer a system call per
+ * message.
+ *
+ * This layer is only available for Linux.
+ */
+class ShmLayer : public PolledFileLayer {
+	STORED_CLASS_NOCOPY(ShmLayer)
+public:
+	typedef PolledFileLayer base;
+	using base::fd_type;
+
+	enum {
+		/*! \brief Default size of one ring. */
+		DefaultSize = 0x10000,
+		/*! \brief Number of polls of the ring before a blocking #recv() arms the doorbell. */
+		SpinCount = 2000,
+	};
+
+	explicit ShmLayer(
+		char const* name, bool create, size_t size = DefaultSize,
+		ProtocolLayer* up = nullptr, ProtocolLayer* down = nullptr);
+	virtual ~ShmLayer() override;
+
+	virtual void encode(void const* buffer, size_t len, bool last = true) override;
+#		ifndef DOXYGEN
+	using base::encode;
+#		endif
+
+	virtual size_t mtu() const override;
+	virtual fd_type fd() const override;
+	virtual int recv(long timeout_us = 0) override;
+	virtual bool isOpen() const override;
+
+protected:
+	virtual void close() override;
+	void close_();
+
+private:
+	struct Ring;
+	struct Shm;
+
+	Ring& ring(int side) const;
+	char* ringData(int side) const;
+	bool waitForSpace(Ring& r, uint32_t head, uint32_t len);
+	void ringBell(int side);
+	void drainBell();
+
+private:
+	/*! \brief The name of the shared memory object. */
+	String::type m_name;
+	/*! \brief Flag to indicate that this instance created (and unlinks) the shared memory. */
+	bool m_create;
+	/*! \brief The mapped shared memory. */
+	Shm* m_shm;
+	/*! \brief Size of the mapping. */
+	size_t m_mapSize;
+	/*! \brief The doorbell socket. */
+	int m_bell;
+	/*! \brief Our side; we transmit via the ring with this index. */
+	int m_side;
+	/*! \brief Size of the partially encoded message. */
+	uint32_t m_txLen;
+	/*! \brief Flag to indicate that the rest of the current message is to be dropped. */
+	bool m_txDrop;
+	/*! \brief Flag to indicate that the doorbell is armed. */
+	bool m_armed;
+	/*! \brief Buffer for messages that wrap around the end of the ring. */
+	Vector<char>::type m_rxBuffer;
+};
+#	endif // (STORED_OS_LINUX && C++11) || DOXYGEN
+
 } // namespace stored
 #endif // __cplusplus
 
@@ -0,0 +1,213 @@
+#ifndef LIBSTORED_SNAPSHOT_H
+#define LIBSTORED_SNAPSHOT_H
+/*
+ * libstored, distributed debuggable data stores.
+ * Copyright (C) 2020-2022  Jochem Rutgers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifdef __cplusplus
+
+#	include <libstored/macros.h>
+
+#	if STORED_cplusplus >= 201103L
+
+#		include <libstored/types.h>
+#		include <libstored/util.h>
+
+#		include <atomic>
+#		include <cstring>
+#		include <utility>
+
+#		ifdef STORED_HAVE_THREADS
+#			include <thread>
+#		endif
+
+namespace stored {
+
+/*!
+ * \brief An extension of a store that lets other threads take consistent snapshots.
+ *
+ * Stores are not thread-safe.  This wrapper implements a seqlock around all
+ * writes: the \c __hookEntryX() and \c __hookExitX() hooks make the sequence
+ * number odd while a write is in progress, and even again afterwards.  One
+ * thread may write the store, any number of other threads may call
+ * #snapshot() or #read() concurrently.  Readers do not lock and never block
+ * the writer; they retry when a write happened while they were reading.
+ *
+ * Every Variable::set() is a separate update.  To publish multiple writes at
+ * once, use a #stored::Transaction, or surround the writes by
+ * #beginWrite() and #endWrite().
+ *
+ * Use it like #stored::Synchronizable:
+ *
+ * \code
+ * class ActualStore : public STORE_T(ActualStore, stored::Snapshottable, stored::MyStoreBase) {
+ *     STORE_CLASS(ActualStore, stored::Snapshottable, stored::MyStoreBase)
+ * public:
+ *     ActualStore() is_default
+ * };
+ * \endcode
+ *
+ * As usual for a seqlock, the reader copies the data while the writer may
+ * modify it.  The copy is discarded in that case, but race detectors will
+ * report it nevertheless.
+ */
+template <typename Base>
+class Snapshottable : public Base {
+	STORE_WRAPPER_CLASS(Snapshottable, Base)
+public:
+	typedef typename base::Objects Objects;
+
+	/*! \brief Type of the sequence number. */
+	typedef uint32_t Seq;
+
+	template <typename... Args>
+	explicit Snapshottable(Args&&... args)
+		: base(std::forward<Args>(args)...)
+		, m_seq()
+		, m_depth()
+	{
+		// Useless without hooks.
+		// NOLINTNEXTLINE(hicpp-static-assert,misc-static-assert)
+		stored_assert(Config::EnableHooks);
+	}
+
+	~Snapshottable() is_default
+
+	/*!
+	 * \brief Returns the current sequence number.
+	 *
+	 * The number is odd while a write is in progress.  It changes with
+	 * every update of the store.
+	 */
+	Seq seq() const noexcept
+	{
+		return m_seq.load(std::memory_order_acquire);
+	}
+
+	/*!
+	 * \brief Copies the store's buffer to \p dst, consistently.
+	 *
+	 * \p dst must hold at least \c BufferSize bytes.  May be called from any thread.
+	 * \return the sequence number that belongs to the snapshot
+	 */
+	Seq snapshot(void* dst) const noexcept
+	{
+		return read([&]() { memcpy(dst, this->buffer(), sizeof(this->data().buffer)); });
+	}
+
+	/*!
+	 * \brief Calls \p f until it has read a consistent state of the store.
+	 *
+	 * Use this to read a few variables, like the ones of a scope.
+	 * \p f may be called multiple times, so it should only read from the
+	 * store and save the values it needs.  May be called from any thread.
+	 *
+	 * \return the sequence number that belongs to the state read by \p f
+	 */
+	template <typename F>
+	Seq read(F&& f) const
+	{
+		size_t spin = 0;
+		while(true) {
+			Seq s = m_seq.load(std::memory_order_acquire);
+			if(likely(!(s & 1U))) {
+				f();
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if(likely(m_seq.load(std::memory_order_relaxed) == s))
+					return s;
+			}
+
+			backoff(spin);
+		}
+	}
+
+	/*!
+	 * \brief Starts an update of the store.
+	 *
+	 * Readers will not observe any write until the matching #endWrite().
+	 * Calls may be nested.  Only call this from the writing thread.
+	 */
+	void beginWrite() noexcept
+	{
+		if(m_depth++)
+			return;
+
+		m_seq.store(m_seq.load(std::memory_order_relaxed) + 1U, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+
+	/*!
+	 * \brief Publishes the update, started by #beginWrite().
+	 */
+	void endWrite() noexcept
+	{
+		stored_assert(m_depth > 0);
+		if(--m_depth)
+			return;
+
+		m_seq.store(m_seq.load(std::memory_order_relaxed) + 1U, std::memory_order_release);
+	}
+
+protected:
+	/*!
+	 * \brief Keeps the hooks enabled.
+	 *
+	 * Without hooks, writes do not update the sequence number, and readers
+	 * would not notice them.  Therefore, the hooks cannot be disabled.
+	 */
+	bool __hooksRequired() const noexcept
+	{
+		return true;
+	}
+
+	void __hookEntryX(Type::type type, void* buffer, size_t len) noexcept
+	{
+		beginWrite();
+		base::__hookEntryX(type, buffer, len);
+	}
+
+	void __hookExitX(Type::type type, void* buffer, size_t len, bool changed) noexcept
+	{
+		base::__hookExitX(type, buffer, len, changed);
+		endWrite();
+	}
+
+	void __hookEntryBatchX(BatchEntry const* batch, size_t count) noexcept
+	{
+		beginWrite();
+		base::__hookEntryBatchX(batch, count);
+	}
+
+	void __hookExitBatchX(BatchEntry const* batch, size_t count) noexcept
+	{
+		base::__hookExitBatchX(batch, count);
+		endWrite();
+	}
+
+private:
+	static void backoff(size_t& spin) noexcept
+	{
+#		ifdef STORED_HAVE_THREADS
+		// Give a preempted writer the chance to finish.
+		if(++spin % 64U == 0)
+			std::this_thread::yield();
+#		else
+		UNUSED(spin)
+#		endif
+	}
+
+private:
+	std::atomic<Seq> m_seq;
+	size_t m_depth;
+};
+
+} // namespace stored
+
+#	endif // C++11
+#endif // __cplusplus
+#endif // LIBSTORED_SNAPSHOT_H
@@ -37,35 +37,78 @@ namespace stored {
  * like a stack; you can #reset() it, or make a #snapshot(), which you can
  * rollback to.
  *
+ * The ScratchPad tracks a high-water mark of its #size(), which decays
+ * upon every #reset().  A reset coalesces all chunks into a single chunk
+ * of the high-water mark, and only shrinks that chunk when it has become
+ * more than twice as large.  A chunk that is released by a rollback is
+ * retained for the next time the ScratchPad overflows.  So, sporadic large
+ * allocations do not cause allocate/free cycles.  See #stats() to check
+ * the behavior.
+ *
  * \tparam MaxSize the maximum total size to be allocated, which is used to
  *         determine the type of the internal counters.
+ * \tparam Decay the high-water mark is lowered by 1/\p Decay upon every
+ *         #reset(), or never when 0
  */
-template <size_t MaxSize = 0xffff>
+template <size_t MaxSize = 0xffff, size_t Decay = Config::ScratchPadDecay>
 class ScratchPad {
 	STORED_CLASS_NOCOPY(ScratchPad)
+private:
+	/*! \brief Header of every chunk. */
+	struct ChunkHeader {
+		/*! \brief The previous chunk in use, or \c nullptr. */
+		char* prev;
+		/*! \brief The size of the buffer, excluding this header. */
+		size_t size;
+	};
+
 public:
 	enum {
 		/*! \brief Maximum total size of allocated memory. */
 		maxSize = MaxSize,
 		/*! \brief Size of the header of a chunk. */
-		chunkHeader = sizeof(size_t),
+		chunkHeader = sizeof(ChunkHeader),
 		/*! \brief Extra amount to reserve when the chunk is allocated. */
 		spare = 8 * sizeof(void*)
 	};
 	/*! \brief Type of all internally used size counters. */
 	typedef typename value_type<MaxSize>::type size_type;
 
+	/*!
+	 * \brief Statistics of a ScratchPad.
+	 * \see #stats()
+	 */
+	struct Stats {
+		/*! \brief Number of chunks allocated from the Allocator. */
+		size_t allocations;
+		/*! \brief Number of chunks returned to the Allocator. */
+		size_t deallocations;
+		/*! \brief Number of calls to #reset(). */
+		size_t resets;
+		/*! \brief Number of resets that had to replace or merge chunks. */
+		size_t coalesces;
+		/*! \brief Largest #max() ever. */
+		size_t peak;
+	};
+
 	/*!
 	 * \brief Ctor.
 	 * \param reserve number of bytes to reserve during construction
 	 */
 	explicit ScratchPad(size_t reserve = 0)
 		: m_buffer()
+		, m_spare()
+		, m_chunks()
 		, m_size()
 		, m_total()
 		, m_max()
+		, m_stats()
 	{
 		this->reserve(reserve);
+
+		// Take the reservation as the initial high-water mark.
+		m_max = (size_type)std::min<size_t>(reserve, maxSize);
+		m_stats.peak = m_max;
 	}
 
 	/*!
@@ -73,31 +116,28 @@ public:
 	 */
 	~ScratchPad() noexcept
 	{
-		deallocate<char>((char*)chunk(), bufferSize() + chunkHeader);
-
-		for(List<char*>::type::iterator it = m_old.begin(); it != m_old.end(); ++it)
-			deallocate<char>((char*)chunk(*it), bufferSize(*it) + chunkHeader);
+		freeAll();
 	}
 
 	/*!
 	 * \brief Resets the content of the ScratchPad.
 	 *
-	 * Coalesce chunks when required. It leaves #max() untouched.
-	 * To actually free all used memory, call #shrink_to_fit() afterwards.
+	 * Coalesce chunks when required, such that one chunk of #max() bytes
+	 * remains.  Afterwards, #max() is decayed.  To actually free all used
+	 * memory, call #shrink_to_fit() afterwards.
 	 */
 	void reset() noexcept
 	{
 		m_size = 0;
 		m_total = 0;
+		m_stats.resets++;
 
-		if(unlikely(!m_old.empty())) {
-			// Coalesce chunks.
-			for(List<char*>::type::iterator it = m_old.begin(); it != m_old.end(); ++it)
-				deallocate<char>((char*)chunk(*it), bufferSize(*it) + chunkHeader);
+		size_t hwm = (size_t)m_max;
+		if(Decay > 0)
+			m_max = (size_type)(hwm - hwm / Decay);
 
-			m_old.clear();
-			reserve(m_max);
-		}
+		if(unlikely(m_chunks > 1 || m_spare || bufferSize() > 2 * hwm + spare))
+			coalesce(hwm);
 
 #	ifdef STORED_HAVE_VALGRIND
 		if(m_buffer)
@@ -124,8 +164,8 @@ public:
 	}
 
 	/*!
-	 * \brief Returns the maximum size.
-	 * \details To reset this value, use #shrink_to_fit().
+	 * \brief Returns the high-water mark of #size().
+	 * \details It decays upon every #reset(). To reset this value, use #shrink_to_fit().
 	 */
 	constexpr size_t max() const noexcept
 	{
@@ -306,41 +346,147 @@ private:
 	}
 
 	/*!
-	 * \brief Allocate a new buffer with the given size.
-	 * \details The current buffer is moved to the #m_old list.
+	 * \brief Allocate a new chunk from the Allocator.
+	 * \return the buffer within the chunk
+	 */
+	char* chunkNew(size_t size)
+	{
+		stored_assert(size > 0);
+
+		char* b = buffer(allocate<char>(size + chunkHeader));
+		header(b)->prev = nullptr;
+		header(b)->size = size;
+		m_stats.allocations++;
+		return b;
+	}
+
+	/*!
+	 * \brief Return the chunk of the given buffer to the Allocator.
+	 */
+	void chunkFree(char* buffer) noexcept
+	{
+		deallocate<char>((char*)chunk(buffer), bufferSize(buffer) + chunkHeader);
+		m_stats.deallocations++;
+	}
+
+	/*!
+	 * \brief Keep the given unused buffer as #m_spare, if it is larger than the current one.
+	 */
+	void chunkRetain(char* buffer) noexcept
+	{
+		if(m_spare && bufferSize(m_spare) >= bufferSize(buffer)) {
+			chunkFree(buffer);
+		} else {
+			if(m_spare)
+				chunkFree(m_spare);
+			m_spare = buffer;
+		}
+	}
+
+	/*!
+	 * \brief Free all chunks, including #m_spare.
+	 */
+	void freeAll() noexcept
+	{
+		while(m_buffer) {
+			char* prev = header(m_buffer)->prev;
+			chunkFree(m_buffer);
+			m_buffer = prev;
+		}
+
+		if(m_spare) {
+			chunkFree(m_spare);
+			m_spare = nullptr;
+		}
+
+		m_chunks = 0;
+	}
+
+	/*!
+	 * \brief Replace all chunks by one chunk of at least the given size.
+	 * \details The ScratchPad must be empty.  An existing chunk is reused when
+	 *	it is not more than twice as large as required.
+	 */
+	void coalesce(size_t size) noexcept
+	{
+		stored_assert(empty());
+		m_stats.coalesces++;
+
+		size_t limit = 2 * size + spare;
+		char* keep = nullptr;
+
+		if(m_spare) {
+			// Consider the spare chunk too.
+			header(m_spare)->prev = m_buffer;
+			m_buffer = m_spare;
+			m_spare = nullptr;
+		}
+
+		while(m_buffer) {
+			char* b = m_buffer;
+			m_buffer = header(b)->prev;
+
+			size_t bs = bufferSize(b);
+			if(bs >= size && bs <= limit && (!keep || bs < bufferSize(keep))) {
+				if(keep)
+					chunkFree(keep);
+				keep = b;
+			} else {
+				chunkFree(b);
+			}
+		}
+
+		if(!keep && size > 0)
+			keep = chunkNew(size);
+
+		if(keep)
+			header(keep)->prev = nullptr;
+
+		m_buffer = keep;
+		m_chunks = keep ? 1 : 0;
+	}
+
+	/*!
+	 * \brief Make a new buffer with at least the given size the current one.
+	 * \details The current buffer is kept in the chain of chunks.  The #m_spare
+	 *	chunk is used, if it is large enough.
 	 */
 	void bufferPush(size_t size)
 	{
 		stored_assert(size > 0);
 
-		if(m_buffer)
-			m_old.push_back(m_buffer);
+		char* b = nullptr;
+		if(m_spare && bufferSize(m_spare) >= size) {
+			b = m_spare;
+			m_spare = nullptr;
+		} else {
+			b = chunkNew(size);
+		}
 
-		m_buffer = buffer(allocate<char>(size + chunkHeader));
-		setBufferSize(size);
+		header(b)->prev = m_buffer;
+		m_buffer = b;
+		m_chunks++;
 		m_size = 0;
 
 #	ifdef STORED_HAVE_VALGRIND
 		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-cstyle-cast,hicpp-no-assembler)
-		(void)VALGRIND_MAKE_MEM_NOACCESS(m_buffer, size);
+		(void)VALGRIND_MAKE_MEM_NOACCESS(m_buffer, bufferSize());
 #	endif
 	}
 
 	/*!
-	 * \brief Discard the current buffer and get the next one from the #m_old list.
+	 * \brief Discard the current buffer and continue with the previous one.
+	 * \details The discarded buffer is retained as #m_spare.
 	 */
 	void bufferPop() noexcept
 	{
-		stored_assert(m_buffer || m_old.empty());
+		stored_assert(m_buffer || m_chunks == 0);
 
 		if(m_buffer) {
-			deallocate<char>((char*)chunk(), bufferSize() + chunkHeader);
-			m_buffer = nullptr;
-		}
-
-		if(!m_old.empty()) {
-			m_buffer = m_old.back();
-			m_old.pop_back();
+			char* b = m_buffer;
+			m_buffer = header(b)->prev;
+			m_chunks--;
+			chunkRetain(b);
 		}
 
 		stored_assert(m_size <= m_total);
@@ -362,44 +508,59 @@ private:
 	 */
 	void bufferGrow(size_t size)
 	{
+		stored_assert(m_buffer);
 		stored_assert(size > bufferSize());
 
-		// Standard allocators don't have realloc. So, deallocate first,
-		// and then allocate a new one.
-		deallocate<char>((char*)chunk(), bufferSize() + chunkHeader);
-		m_buffer = buffer(allocate<char>(size + chunkHeader));
-		setBufferSize(size);
+		char* prev = header(m_buffer)->prev;
+		char* b = nullptr;
+
+		if(m_spare && bufferSize(m_spare) >= size) {
+			b = m_spare;
+			m_spare = nullptr;
+		} else {
+			// Standard allocators don't have realloc. So, deallocate first,
+			// and then allocate a new one.
+			chunkFree(m_buffer);
+			m_buffer = nullptr;
+			b = chunkNew(size);
+		}
+
+		if(m_buffer)
+			chunkRetain(m_buffer);
+
+		header(b)->prev = prev;
+		m_buffer = b;
 
 #	ifdef STORED_HAVE_VALGRIND
 		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-cstyle-cast,hicpp-no-assembler)
-		(void)VALGRIND_MAKE_MEM_NOACCESS(&m_buffer[m_size], size - m_size);
+		(void)VALGRIND_MAKE_MEM_NOACCESS(&m_buffer[m_size], bufferSize() - m_size);
 #	endif
 	}
 
 	/*!
-	 * \brief Returns the size of the given buffer.
+	 * \brief Returns the header of the chunk of the given buffer.
 	 */
-	static constexpr size_t bufferSize(char* buffer) noexcept
+	static ChunkHeader* header(char* buffer) noexcept
 	{
-		return likely(buffer) ? *(size_t*)(chunk(buffer)) : 0;
+		stored_assert(buffer);
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+		return reinterpret_cast<ChunkHeader*>(chunk(buffer));
 	}
 
 	/*!
-	 * \brief Returns the size of the current buffer.
+	 * \brief Returns the size of the given buffer.
 	 */
-	size_t bufferSize() const noexcept
+	static size_t bufferSize(char* buffer) noexcept
 	{
-		return bufferSize(m_buffer);
+		return likely(buffer) ? header(buffer)->size : 0;
 	}
 
 	/*!
-	 * \brief Saves the malloc()ed size of the current buffer.
+	 * \brief Returns the size of the current buffer.
 	 */
-	void setBufferSize(size_t size) noexcept
+	size_t bufferSize() const noexcept
 	{
-		stored_assert(m_buffer);
-		stored_assert(size > 0);
-		*(size_t*)(chunk(m_buffer)) = size;
+		return bufferSize(m_buffer);
 	}
 
 	/*!
@@ -466,10 +627,8 @@ public:
 	{
 		if(unlikely(empty())) {
 			m_max = 0;
-			reset();
-			// Also pop the current buffer.
-			bufferPop();
 			m_size = 0;
+			freeAll();
 		} else {
 			// realloc() may still return another chunk of memory, even if it gets
 			// smaller. So, we cannot actually shrink, until reset() is called.
@@ -487,7 +646,15 @@ public:
 	 */
 	constexpr size_t chunks() const noexcept
 	{
-		return m_old.size() + (m_buffer ? 1 : 0);
+		return m_chunks;
+	}
+
+	/*!
+	 * \brief Returns the statistics of this ScratchPad.
+	 */
+	constexpr Stats const& stats() const noexcept
+	{
+		return m_stats;
 	}
 
 	/*!
@@ -524,19 +691,10 @@ public:
 #	endif
 		}
 
-		size_t bs = bufferSize();
-		if(likely(m_size + padding <= bs)) {
-			// The padding (which may be 0) still fits in the buffer.
+		if(likely(m_size + padding + alloc_size <= bufferSize()))
 			m_size = (size_type)(m_size + padding);
-			// Now reserve the size, which still may add a new chunk.
-			if(unlikely(m_size + alloc_size > bs))
-				// Reserve all we probably need, if we are reserving anyway.
-				reserve(std::max(max() - this->size(), alloc_size));
-		} else {
-			// Not enough room for the padding, let alone the size.
-			// Just create a new buffer, which has always the correct alignment.
-			bufferPush(std::max(max() - this->size(), alloc_size + spare));
-		}
+		else
+			overflow(padding, alloc_size);
 
 		char* p = m_buffer + m_size;
 		m_size = (size_type)(m_size + alloc_size);
@@ -545,8 +703,11 @@ public:
 		// required anyway if the buffers are coalesced.
 		m_total = (size_type)(m_total + padding + alloc_size);
 
-		if(unlikely(m_total > m_max))
+		if(unlikely(m_total > m_max)) {
 			m_max = m_total;
+			if(m_max > m_stats.peak)
+				m_stats.peak = m_max;
+		}
 
 #	ifdef STORED_HAVE_VALGRIND
 		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-cstyle-cast,hicpp-no-assembler)
@@ -561,17 +722,40 @@ public:
 	}
 
 private:
-	/*! \brief Current buffer chunk. If it gets full, it is pushed onto #m_old and a new one is
-	 * allocated. */
+	/*!
+	 * \brief Make room for an #alloc() that does not fit in the current buffer.
+	 * \details Afterwards, \p alloc_size bytes are available at #m_size.
+	 */
+	__attribute__((noinline)) void overflow(size_t padding, size_t alloc_size)
+	{
+		if(m_size + padding <= bufferSize()) {
+			// The padding (which may be 0) still fits in the buffer.
+			m_size = (size_type)(m_size + padding);
+			// Reserve all we probably need, if we are reserving anyway.
+			// Grow at least geometrically, as max() may have decayed.
+			reserve(std::max(max() - size(), std::max(size(), alloc_size)));
+		} else {
+			// Not enough room for the padding, let alone the size.
+			// Just create a new buffer, which has always the correct alignment.
+			bufferPush(std::max(max() - size(), std::max(size(), alloc_size + spare)));
+		}
+	}
+
+	/*! \brief Current buffer chunk. If it gets full, a new one is allocated, which links to
+	 * this one. */
 	char* m_buffer;
-	/*! \brief Previous buffer chunks. */
-	List<char*>::type m_old;
+	/*! \brief An unused chunk, retained for reuse. */
+	char* m_spare;
+	/*! \brief Number of chunks in use. */
+	size_t m_chunks;
 	/*! \brief Used offset within #m_buffer. */
 	size_type m_size;
 	/*! \brief Total memory usage of all chunks. */
 	size_type m_total;
-	/*! \brief Maximum value of #m_total. */
+	/*! \brief Decaying maximum value of #m_total. */
 	size_type m_max;
+	/*! \brief Statistics. */
+	Stats m_stats;
 };
 
 } // namespace stored
@@ -16,6 +16,7 @@
 #	include <libstored/types.h>
 #	include <libstored/util.h>
 
+#	include <algorithm>
 #	include <cstring>
 #	include <map>
 #	include <set>
@@ -81,6 +82,13 @@ public:
 	 */
 	typedef Key Size;
 
+#	if STORED_cplusplus >= 201103L
+	// breathe does not like function typedefs
+	using ObjectSizeCallback = Size(Key);
+#	else
+	typedef Size(ObjectSizeCallback)(Key);
+#	endif
+
 	enum {
 		/*! \brief Maximum offset of seq() that is a valid short seq. */
 		ShortSeqWindow = 1u << (sizeof(ShortSeq) * 8u),
@@ -90,7 +98,9 @@ public:
 		SeqCleanThreshold = SeqLowerMargin * 2u,
 	};
 
-	StoreJournal(char const* hash, void* buffer, size_t size);
+	StoreJournal(
+		char const* hash, void* buffer, size_t size, uint8_t keySize = 0,
+		ObjectSizeCallback* objectSize = nullptr);
 	~StoreJournal() is_default
 
 	static uint8_t keySize(size_t bufferSize);
@@ -102,6 +112,8 @@ public:
 
 	void clean(Seq oldest = 0);
 	void changed(Key key, size_t len, bool insertIfNew = true);
+	void changed(BatchEntry const* batch, size_t count);
+	void changedRange(Key key, size_t len, size_t range, bool insertIfNew = true);
 	bool hasChanged(Key key, Seq since) const;
 	bool hasChanged(Seq since) const;
 
@@ -151,17 +163,21 @@ protected:
 	struct ObjectInfo {
 		ObjectInfo(
 			StoreJournal::Key key_, StoreJournal::Size len_,
-			StoreJournal::ShortSeq seq_)
+			StoreJournal::ShortSeq seq_, StoreJournal::Size range_ = 0)
 			: key(key_)
 			, len(len_)
+			, range(range_)
 			, seq(seq_)
 			, highest(seq_)
+			, rangeSeq(seq_)
 		{}
 
 		StoreJournal::Key key;
 		StoreJournal::Size len;
-		StoreJournal::ShortSeq seq;	// of this object
-		StoreJournal::ShortSeq highest; // of all seqs in this part of the tree
+		StoreJournal::Size range;	 // of array elements, starting at this object
+		StoreJournal::ShortSeq seq;	 // of this object
+		StoreJournal::ShortSeq highest;	 // of all seqs in this part of the tree
+		StoreJournal::ShortSeq rangeSeq; // of the last write of the range
 	};
 
 	/*!
@@ -179,13 +195,16 @@ protected:
 	Seq toLong(ShortSeq seq) const;
 
 protected:
-	bool update(Key key, size_t len, Seq seq, size_t lower, size_t upper);
+	bool update(Key key, size_t len, Seq seq, size_t lower, size_t upper, size_t range = 0);
+	bool rangeChanged(Key key, Seq since) const;
+	size_t update(BatchEntry const* batch, size_t count, Seq seq, size_t lower, size_t upper);
 
 	void regenerate();
 	Seq regenerate(size_t lower, size_t upper);
 
-	void encodeUpdates(ProtocolLayer& p, Seq sinceSeq, size_t lower, size_t upper);
-	void encodeUpdate(ProtocolLayer& p, ObjectInfo& o);
+	void encodeUpdates(
+		ProtocolLayer& p, Seq sinceSeq, size_t lower, size_t upper, Key& covered);
+	Size encodeUpdate(ProtocolLayer& p, ObjectInfo& o, Seq sinceSeq);
 
 	void encodeKey(ProtocolLayer& p, Key key);
 	Key decodeKey(uint8_t*& buffer, size_t& len, bool& ok);
@@ -195,7 +214,8 @@ protected:
 	size_t keySize() const;
 
 	void iterateChanged(
-		Seq since, IterateChangedCallback* cb, void* arg, size_t lower, size_t upper) const;
+		Seq since, IterateChangedCallback* cb, void* arg, size_t lower, size_t upper,
+		Key& next) const;
 
 private:
 	char const* m_hash;
@@ -205,6 +225,8 @@ private:
 	Seq m_seq;
 	Seq m_seqLower;
 	bool m_partialSeq;
+	ObjectSizeCallback* m_objectSize;
+	Size m_maxRange;
 
 
 	// sorted based on key
@@ -265,11 +287,18 @@ public:
 	Synchronizable()
 		: base()
 #	endif
-		, m_journal(base::hash(), base::buffer(), sizeof(base::data().buffer))
+		, m_journal(
+			  base::hash(), base::buffer(), sizeof(base::data().buffer),
+			  (uint8_t)Base::KeySize, &objectSize)
+		, m_batch()
+		, m_mapped()
 	{
 		// Useless without hooks.
 		// NOLINTNEXTLINE(hicpp-static-assert,misc-static-assert)
 		stored_assert(Config::EnableHooks);
+
+		if(Config::FixedCapacityContainers)
+			reserveHeap();
 	}
 
 	~Synchronizable() is_default
@@ -296,6 +325,29 @@ public:
 		return journal();
 	}
 
+	/*!
+	 * \brief Returns the size of the fixed-length variable at the given key.
+	 *
+	 * The journal uses this to recognize a range of array elements in a
+	 * received update.
+	 *
+	 * \return the size, or 0 when there is no fixed-length variable at \p key
+	 */
+	static StoreJournal::Size objectSize(StoreJournal::Key key) noexcept
+	{
+		typename Base::VariableOffset const* offsets = Base::variableOffsets();
+		typename Base::VariableOffset const* end = offsets + (size_t)Base::VariableCount;
+		typename Base::VariableOffset const* o = std::lower_bound(offsets, end, key);
+		if(o == end || *o != key)
+			return 0;
+
+		size_t i = (size_t)(o - offsets);
+		if(!Type::isFixed((Type::type)Base::variableTypes()[i]))
+			return 0;
+
+		return (StoreJournal::Size)Base::variableSizes()[i];
+	}
+
 	/*!
 	 * \brief Reserve worst-case heap usage.
 	 *
@@ -330,9 +382,21 @@ public:
 #	undef MAX2
 
 protected:
+	/*!
+	 * \brief Keeps the hooks enabled while mapped to a #stored::Synchronizer.
+	 *
+	 * Otherwise, changes are not recorded in the journal, and are never
+	 * sent to the other party.
+	 */
+	bool __hooksRequired() const noexcept
+	{
+		return m_mapped || base::__hooksRequired();
+	}
+
 	void __hookExitX(Type::type type, void* buffer, size_t len, bool changed)
 	{
-		if(changed) {
+		// Batches are recorded by __hookExitBatchX() at once.
+		if(changed && !m_batch) {
 			StoreJournal::Key key = (StoreJournal::Key)this->bufferToKey(buffer);
 
 			if(Config::EnableAssert) {
@@ -345,14 +409,33 @@ protected:
 				stored_assert(ok);
 			}
 
-			journal().changed(key, len);
+			size_t size = Type::isFixed(type) ? Type::size(type) : len;
+			if(unlikely(size && size < len))
+				// A range of array elements.
+				journal().changedRange(key, size, len);
+			else
+				journal().changed(key, len);
 		}
 
 		base::__hookExitX(type, buffer, len, changed);
 	}
 
+	void __hookExitBatchX(BatchEntry const* batch, size_t count)
+	{
+		journal().changed(batch, count);
+
+		m_batch = true;
+		base::__hookExitBatchX(batch, count);
+		m_batch = false;
+	}
+
 private:
+	friend class Synchronizer;
+
 	StoreJournal m_journal;
+	bool m_batch;
+	/*! \brief Number of #stored::Synchronizer instances this store is mapped to. */
+	unsigned int m_mapped;
 };
 
 /*! \deprecated Use \c stored::store or \c STORE_T instead. */
@@ -481,11 +564,14 @@ public:
 
 	/*!
 	 * \brief Register a store in this Synchronizer.
+	 * \details The store's hooks are kept enabled until it is unmapped, as the
+	 *	journal depends on them.
 	 */
 	template <typename Store>
 	void map(Synchronizable<Store>& store)
 	{
-		m_storeMap.insert(std::make_pair(store.hash(), &store.journal()));
+		if(m_storeMap.insert(std::make_pair(store.hash(), &store.journal())).second)
+			store.m_mapped++;
 	}
 
 	/*!
@@ -494,7 +580,8 @@ public:
 	template <typename Store>
 	void unmap(Synchronizable<Store>& store)
 	{
-		m_storeMap.erase(store.hash());
+		if(m_storeMap.erase(store.hash()))
+			store.m_mapped--;
 
 		for(Connections::iterator it = m_connections.begin(); it != m_connections.end();
 		    ++it)
@@ -261,6 +261,9 @@ struct toType<T*> {
 template <typename Container = void>
 class Variant;
 
+template <typename Container, size_t Capacity = 64>
+class Transaction;
+
 /*!
  * \brief A typed variable in a store.
  *
@@ -448,12 +451,57 @@ protected:
 
 	// Make Variant a friend, such that a Variable can be converted to a Variant.
 	friend class Variant<Container>;
+	template <typename C, size_t N>
+	friend class Transaction;
 
 private:
 	/*! \brief The buffer of this Variable. */
 	type* m_buffer;
 };
 
+namespace impl {
+/*!
+ * \brief Checks if the \p Container provides \c hooksEnabled().
+ */
+template <typename Container>
+class has_hooksEnabled {
+	typedef char yes;
+	typedef char (&no)[2];
+
+	template <size_t>
+	struct check {};
+
+	template <typename C>
+	static yes test(check<sizeof(static_cast<C const*>(nullptr)->hooksEnabled())>*);
+
+	template <typename C>
+	static no test(...);
+
+public:
+	enum { value = sizeof(test<Container>(nullptr)) == sizeof(yes) };
+};
+
+/*!
+ * \brief Returns \c hooksEnabled() of the \p Container, or \c true when it does not have it.
+ */
+template <typename Container, bool has = has_hooksEnabled<Container>::value>
+struct hooksEnabled {
+	static bool get(Container const& container) noexcept
+	{
+		return container.hooksEnabled();
+	}
+};
+
+template <typename Container>
+struct hooksEnabled<Container, false> {
+	static bool get(Container const& container) noexcept
+	{
+		UNUSED(container)
+		return true;
+	}
+};
+} // namespace impl
+
 /*!
  * \brief A typed variable in a store, with hook support.
  *
@@ -462,6 +510,10 @@ private:
  *
  * This Variable is very small (it contains two pointers).
  * It is copyable and assignable, so it is fine to pass it by value.
+ *
+ * When the \p Container provides \c hooksEnabled(), like generated stores
+ * do, #get() and #set() check it first.  Otherwise, the hooks are always
+ * invoked.
  */
 template <typename T, typename Container>
 class Variable<T, Container, true> : public Variable<T, Container, false> {
@@ -550,10 +602,14 @@ public:
 
 	/*!
 	 * \copydoc stored::Variable::get()
-	 * \details #entryRO()/#exitRO() are called around the actual data retrieval.
+	 * \details #entryRO()/#exitRO() are called around the actual data retrieval,
+	 *	unless the container's hooks are disabled at run time.
 	 */
 	type get() const noexcept
 	{
+		if(!impl::hooksEnabled<Container>::get(container()))
+			return base::get();
+
 		entryRO();
 		type res = base::get();
 		exitRO();
@@ -580,10 +636,16 @@ public:
 
 	/*!
 	 * \copydoc stored::Variable::set()
-	 * \details #entryX()/#exitX() are called around the actual data retrieval.
+	 * \details #entryX()/#exitX() are called around the actual data retrieval,
+	 *	unless the container's hooks are disabled at run time.
 	 */
 	void set(type v) noexcept
 	{
+		if(!impl::hooksEnabled<Container>::get(container())) {
+			base::set(v);
+			return;
+		}
+
 		entryX();
 
 		bool changed = false;
@@ -1093,6 +1155,10 @@ private:
 	f_type m_f;
 };
 
+namespace impl {
+size_t arrayRemaining(uint8_t const* directory, size_t offset, Type::type type) noexcept;
+} // namespace impl
+
 /*!
  * \brief A untyped interface to an object in a store.
  *
@@ -1352,6 +1418,72 @@ public:
 		set(data, strlen(data));
 	}
 
+	/*!
+	 * \brief Reads \p count consecutive variables, starting at this one.
+	 *
+	 * This only works for the elements of an array of fixed-length
+	 * variables, which are contiguous in the buffer.  The range must not
+	 * exceed the end of the array, see #arrayRemaining().  The hooks are
+	 * invoked once for the whole range.  The values are written to \p dst
+	 * in host endianness.
+	 *
+	 * \return the number of bytes written to \p dst, or 0 when the range is invalid
+	 */
+	size_t getRange(void* dst, size_t count) const noexcept
+	{
+		size_t len = rangeLen(count);
+		if(unlikely(!len))
+			return 0;
+
+		entryRO(len);
+		if(Type::isStoreSwapped(type()))
+			for(size_t i = 0, s = size(); i < len; i += s)
+				memcpy_swap(static_cast<char*>(dst) + i, static_cast<char*>(m_buffer) + i, s);
+		else
+			memcpy(dst, m_buffer, len);
+		exitRO(len);
+		return len;
+	}
+
+	/*!
+	 * \brief Writes \p count consecutive variables, starting at this one.
+	 *
+	 * The counterpart of #getRange().  The values in \p src are in host endianness.
+	 *
+	 * \return the number of bytes consumed from \p src, or 0 when the range is invalid
+	 */
+	size_t setRange(void const* src, size_t count) noexcept
+	{
+		size_t len = rangeLen(count);
+		if(unlikely(!len))
+			return 0;
+
+		entryX(len);
+		bool changed = true;
+		if(Type::isStoreSwapped(type())) {
+			if(Config::EnableHooks) {
+				changed = false;
+				for(size_t i = 0, s = size(); !changed && i < len; i += s)
+					changed = memcmp_swap(
+							  static_cast<char const*>(src) + i,
+							  static_cast<char*>(m_buffer) + i, s)
+						  != 0;
+			}
+			if(changed)
+				for(size_t i = 0, s = size(); i < len; i += s)
+					memcpy_swap(
+						static_cast<char*>(m_buffer) + i,
+						static_cast<char const*>(src) + i, s);
+		} else {
+			if(Config::EnableHooks)
+				changed = memcmp(src, m_buffer, len) != 0;
+			if(changed)
+				memcpy(m_buffer, src, len);
+		}
+		exitX(changed, len);
+		return len;
+	}
+
 	/*!
 	 * \brief Invoke the function callback.
 	 * \details Only works if this variant is a function.
@@ -1540,7 +1672,7 @@ public:
 	void entryRO(size_t len) const noexcept
 	{
 		if(Config::EnableHooks) {
-			container().hookExitRO(type(), m_buffer, len);
+			container().hookEntryRO(type(), m_buffer, len);
 #	ifdef _DEBUG
 			stored_assert(m_entry == EntryNone);
 			m_entry = EntryRO;
@@ -1683,7 +1815,7 @@ public:
 	typename Container::Key key() const noexcept
 	{
 		stored_assert(isVariable());
-		return container()->bufferToKey(m_buffer);
+		return container().bufferToKey(m_buffer);
 	}
 
 	/*!
@@ -1758,7 +1890,42 @@ public:
 		other.exitRO(len);
 	}
 
+	/*!
+	 * \brief Returns the number of array elements from this variable up to the end of its array.
+	 *
+	 * The array is looked up in the store's directory, which takes some
+	 * time.  Prefer #stored::Array when the array is known at compile time.
+	 *
+	 * \return the number of elements, including this one, or 0 when this
+	 *	variable is not an element of an array
+	 */
+	size_t arrayRemaining() const noexcept
+	{
+		if(!isVariable() || !Type::isFixed(type()))
+			return 0;
+
+		return impl::arrayRemaining(
+			container().shortDirectory(), (size_t)container().bufferToKey(m_buffer),
+			type());
+	}
+
 private:
+	/*!
+	 * \brief Returns the length of \p count elements, starting at this variable.
+	 * \return the length in bytes, or 0 when the range is not within one array
+	 */
+	size_t rangeLen(size_t count) const noexcept
+	{
+		if(unlikely(!isVariable() || !Type::isFixed(type()) || count == 0))
+			return 0;
+
+		// A single element does not need the array bounds.
+		if(count > 1U && arrayRemaining() < count)
+			return 0;
+
+		return count * size();
+	}
+
 	/*! \brief The container. */
 	Container* m_container;
 	union {
@@ -1930,6 +2097,38 @@ public:
 		stored_assert(valid());
 	}
 
+	/*! \brief Don't use. */
+	size_t getRange(void* dst, size_t count) const noexcept
+	{
+		UNUSED(dst)
+		UNUSED(count)
+		stored_assert(valid());
+		return 0;
+	}
+
+	/*! \brief Don't use. */
+	size_t setRange(void const* src, size_t count) noexcept
+	{
+		UNUSED(src)
+		UNUSED(count)
+		stored_assert(valid());
+		return 0;
+	}
+
+	/*! \brief Don't use. */
+	size_t arrayRemaining() const noexcept
+	{
+		stored_assert(valid());
+		return 0;
+	}
+
+	/*! \brief Don't use. */
+	void* buffer() const noexcept
+	{
+		stored_assert(valid());
+		return nullptr;
+	}
+
 	/*! \brief Don't use. */
 	void entryX(size_t len = 0) const noexcept
 	{
@@ -2033,6 +2232,612 @@ private:
 #	endif
 };
 
+/*!
+ * \brief A typed array of variables in a store.
+ *
+ * The elements of an array of fixed-length variables, like \c float[1024]
+ * in the store's description, are contiguous in the store's buffer.  This
+ * class gives span-like access to them.  An element is accessed as
+ * #stored::Variable via #operator[]().  The bulk #get(type*,size_t,size_t)
+ * and #set(type const*,size_t,size_t) copy a range of elements, and invoke
+ * the hooks of the store once for the whole range.
+ *
+ * This Array is very small (two pointers and a size).
+ * It is copyable and assignable, so it is fine to pass it by value.
+ */
+template <typename T, typename Container>
+class Array {
+public:
+	/*! \brief The (fixed-length) type of the elements. */
+	typedef T type;
+	/*! \brief The type of an element. */
+	typedef Variable<type, Container> Variable_type;
+
+	/*!
+	 * \brief Constructor for a valid Array.
+	 * \param container the Container this Array belongs to
+	 * \param buffer the reference to the first element inside container's buffer
+	 * \param size the number of elements
+	 */
+	Array(Container& container, type& buffer, size_t size) noexcept
+		: m_container(&container)
+		, m_buffer(&buffer)
+		, m_size(size)
+	{}
+
+	/*!
+	 * \brief Constructor for an invalid Array.
+	 */
+	constexpr Array() noexcept
+		: m_container()
+		, m_buffer()
+		, m_size()
+	{}
+
+	/*! \brief Checks if this Array is valid. */
+	constexpr bool valid() const noexcept
+	{
+		return m_buffer != nullptr;
+	}
+
+	/*! \brief Returns the number of elements. */
+	constexpr size_t size() const noexcept
+	{
+		return m_size;
+	}
+
+	/*!
+	 * \brief Returns the container.
+	 * \details Only call this function when it is #valid().
+	 */
+	Container& container() const noexcept
+	{
+		stored_assert(valid());
+		return *m_container;
+	}
+
+	/*!
+	 * \brief Returns the key of the first element.
+	 * \see your store's \c bufferToKey()
+	 */
+	typename Container::Key key() const noexcept
+	{
+		return container().bufferToKey(m_buffer);
+	}
+
+	/*!
+	 * \brief Returns the element at the given index.
+	 */
+	Variable_type operator[](size_t index) const noexcept
+	{
+		stored_assert(valid() && index < size());
+		return Variable_type(container(), m_buffer[index]);
+	}
+
+	/*!
+	 * \brief Returns the value of the element at the given index.
+	 */
+	type get(size_t index) const noexcept
+	{
+		return (*this)[index].get();
+	}
+
+	/*!
+	 * \brief Sets the value of the element at the given index.
+	 */
+	void set(size_t index, type value) noexcept
+	{
+		(*this)[index].set(value);
+	}
+
+	/*!
+	 * \brief Copies \p count elements, starting at \p start, to \p dst.
+	 *
+	 * The range is clipped to the end of the array.  The entry and exit
+	 * hooks are invoked once for the whole range.
+	 *
+	 * \return the number of elements copied
+	 */
+	size_t
+	get(type* dst, size_t start = 0,
+	    size_t count = std::numeric_limits<size_t>::max()) const noexcept
+	{
+		count = clip(start, count);
+		if(unlikely(!count))
+			return 0;
+
+		type* b = &m_buffer[start];
+		size_t len = count * sizeof(type);
+
+		if(Config::EnableHooks)
+			container().hookEntryRO(toType<type>::type, b, len);
+
+		if(Type::isStoreSwapped(toType<type>::type))
+			for(size_t i = 0; i < count; i++)
+				dst[i] = endian_s2h(b[i]);
+		else
+			memcpy(dst, b, len);
+
+		if(Config::EnableHooks)
+			container().hookExitRO(toType<type>::type, b, len);
+
+		return count;
+	}
+
+	/*!
+	 * \brief Copies \p count elements from \p src into the array, starting at \p start.
+	 *
+	 * The range is clipped to the end of the array.  The entry and exit
+	 * hooks are invoked once for the whole range.
+	 *
+	 * \return the number of elements copied
+	 */
+	size_t
+	set(type const* src, size_t start = 0,
+	    size_t count = std::numeric_limits<size_t>::max()) noexcept
+	{
+		count = clip(start, count);
+		if(unlikely(!count))
+			return 0;
+
+		type* b = &m_buffer[start];
+		size_t len = count * sizeof(type);
+		bool changed = true;
+
+		if(Config::EnableHooks)
+			container().hookEntryX(toType<type>::type, b, len);
+
+		if(Type::isStoreSwapped(toType<type>::type)) {
+			changed = false;
+			for(size_t i = 0; i < count; i++) {
+				type v = endian_h2s(src[i]);
+				if(memcmp(&v, &b[i], sizeof(type)) != 0) {
+					b[i] = v;
+					changed = true;
+				}
+			}
+		} else {
+			if(Config::EnableHooks)
+				changed = memcmp(src, b, len) != 0;
+			if(changed)
+				memcpy(b, src, len);
+		}
+
+		if(Config::EnableHooks)
+			container().hookExitX(toType<type>::type, b, len, changed);
+
+		return count;
+	}
+
+	/*!
+	 * \brief Returns the #stored::Variant of the first element.
+	 * \details Use Variant::getRange() for type-independent bulk access.
+	 */
+	Variant<Container> variant() const noexcept
+	{
+		return valid() ? Variant<Container>((*this)[0]) : Variant<Container>();
+	}
+
+private:
+	/*! \brief Returns the number of elements in the range, clipped to the array. */
+	size_t clip(size_t start, size_t count) const noexcept
+	{
+		if(unlikely(!valid() || start >= size()))
+			return 0;
+		return std::min(count, size() - start);
+	}
+
+private:
+	/*! \brief The container of this Array. */
+	Container* m_container;
+	/*! \brief The first element. */
+	type* m_buffer;
+	/*! \brief The number of elements. */
+	size_t m_size;
+};
+
+/*!
+ * \brief Description of one object in a batch of store accesses.
+ * \see stored::Transaction
+ */
+struct BatchEntry {
+	/*! \brief The object's buffer within the store. */
+	void* buffer;
+	/*! \brief The size of the object. */
+	size_t len;
+	/*! \brief The type of the object. */
+	Type::type type;
+	/*! \brief Whether the object has changed. Only valid for the exit hook. */
+	bool changed;
+};
+
+/*!
+ * \brief Stages writes to multiple variables, and commits them with one hook round trip.
+ *
+ * Every Variable::set() invokes the entry and exit hooks of the store.  For a
+ * #stored::Synchronizable store, this includes a journal lookup per write.
+ * A Transaction collects the writes instead.  #commit() applies them between a
+ * single \c hookEntryBatchX() and \c hookExitBatchX() call.  When the writes
+ * are staged in store order, the journal is updated in one pass.
+ *
+ * Staged values are not visible in the store until #commit(), which is also
+ * called by the destructor.  When more than \p Capacity writes are staged,
+ * the pending ones are committed first.  Staging the same variable twice is
+ * allowed; the last value wins.
+ *
+ * Only fixed-length variables of at most 8 bytes are supported.
+ *
+ * \code
+ * {
+ *     stored::Transaction<MyStore> t(store);
+ *     t.set(store.x, 1);
+ *     t.set(store.y, 2.5);
+ * } // committed here
+ * \endcode
+ */
+template <typename Container, size_t Capacity>
+class Transaction {
+	STORED_CLASS_NOCOPY(Transaction)
+public:
+	/*!
+	 * \brief Ctor.
+	 */
+	explicit Transaction(Container& container) noexcept
+		: m_container(&container)
+		, m_count()
+	{}
+
+	/*!
+	 * \brief Dtor, which commits all staged writes.
+	 */
+	~Transaction()
+	{
+		commit();
+	}
+
+	/*!
+	 * \brief Stages a write of the given variable.
+	 */
+	template <typename T, bool Hooks>
+	void set(Variable<T, Container, Hooks> const& v,
+		 typename Variable<T, Container, Hooks>::type value) noexcept
+	{
+		static_assert(sizeof(value) <= sizeof(uint64_t), "");
+		stored_assert(v.valid());
+
+		if(unlikely(m_count == Capacity))
+			commit();
+
+		BatchEntry& e = m_batch[m_count];
+		e.buffer = &v.buffer();
+		e.len = sizeof(value);
+		e.type = toType<T>::type;
+		e.changed = false;
+
+		value = endian_h2s(value);
+		memcpy(&m_data[m_count], &value, sizeof(value));
+		m_count++;
+	}
+
+	/*!
+	 * \brief Stages a write of the given store object.
+	 */
+	template <typename V>
+	void set(V const& v, typename V::Variable_type::type value) noexcept
+	{
+		set(v.variable(), value);
+	}
+
+	/*!
+	 * \brief Returns the number of staged writes.
+	 */
+	size_t size() const noexcept
+	{
+		return m_count;
+	}
+
+	/*!
+	 * \brief Discards all staged writes.
+	 */
+	void clear() noexcept
+	{
+		m_count = 0;
+	}
+
+	/*!
+	 * \brief Applies all staged writes to the store.
+	 *
+	 * The batch hooks receive the entries in staging order.
+	 */
+	void commit() noexcept
+	{
+		if(!m_count)
+			return;
+
+		if(Config::EnableHooks)
+			m_container->hookEntryBatchX(m_batch, m_count);
+
+		for(size_t i = 0; i < m_count; i++) {
+			BatchEntry& e = m_batch[i];
+			switch(e.len) {
+			case 1:
+				e.changed = apply<uint8_t>(e.buffer, m_data[i]);
+				break;
+			case 2:
+				e.changed = apply<uint16_t>(e.buffer, m_data[i]);
+				break;
+			case 4:
+				e.changed = apply<uint32_t>(e.buffer, m_data[i]);
+				break;
+			default:
+				e.changed = apply<uint64_t>(e.buffer, m_data[i]);
+			}
+		}
+
+		if(Config::EnableHooks)
+			m_container->hookExitBatchX(m_batch, m_count);
+
+		m_count = 0;
+	}
+
+private:
+	/*!
+	 * \brief Copies the staged value to the store, if it differs.
+	 * \details Values are compared bitwise, like Variable::set() does.
+	 */
+	template <typename U>
+	static bool apply(void* buffer, uint64_t const& data) noexcept
+	{
+		U d;
+		U b;
+		memcpy(&d, &data, sizeof(U));
+		memcpy(&b, buffer, sizeof(U));
+		if(d == b)
+			return false;
+
+		memcpy(buffer, &d, sizeof(U));
+		return true;
+	}
+
+private:
+	Container* m_container;
+	size_t m_count;
+	BatchEntry m_batch[Capacity];
+	uint64_t m_data[Capacity];
+};
+
+/*!
+ * \brief The differences between two instances of the same store.
+ *
+ * A patch is a list of (key, bytes) pairs, sorted by key, where every entry
+ * holds the full data of one variable, as it is in the store's buffer.
+ * It is produced by the \c diff() of a store, and applied to another
+ * instance by its \c apply().
+ *
+ * \code
+ * stored::StorePatch patch;
+ * a.diff(b, patch); // the changes to turn a into b
+ * a.apply(patch);   // now a equals b
+ * \endcode
+ *
+ * The patch reuses its memory.  Use #reserve() to prevent heap allocations
+ * during diffing.
+ */
+class StorePatch {
+public:
+	/*! \brief Type of a key, like the \c Key of a store. */
+	typedef uintptr_t Key;
+
+	StorePatch() is_default
+
+	/*!
+	 * \brief Returns the number of variables in this patch.
+	 */
+	size_t size() const noexcept
+	{
+		return m_entries.size();
+	}
+
+	/*!
+	 * \brief Checks if the patch does not contain any changes.
+	 */
+	bool empty() const noexcept
+	{
+		return m_entries.empty();
+	}
+
+	/*!
+	 * \brief Returns the total number of data bytes in this patch.
+	 */
+	size_t bytes() const noexcept
+	{
+		return m_data.size();
+	}
+
+	/*!
+	 * \brief Removes all entries, while keeping the allocated memory.
+	 */
+	void clear() noexcept
+	{
+		m_entries.clear();
+		m_data.clear();
+	}
+
+	/*!
+	 * \brief Allocates memory for the given number of variables and data bytes.
+	 *
+	 * Reserving the \c VariableCount and \c BufferSize of the store makes
+	 * sure that diffing never allocates.
+	 */
+	void reserve(size_t variables, size_t bytes)
+	{
+		m_entries.reserve(variables);
+		m_batch.reserve(variables);
+		m_data.reserve(bytes);
+	}
+
+	/*!
+	 * \brief Adds a variable to the patch.
+	 *
+	 * Variables must be added in increasing order of their key.
+	 */
+	void add(Key key, Type::type type, void const* data, size_t len)
+	{
+		stored_assert(empty() || m_entries.back().key + m_entries.back().len <= key);
+
+		Entry e = {key, len, m_data.size(), type};
+		m_entries.push_back(e);
+		char const* d = static_cast<char const*>(data);
+		m_data.insert(m_data.end(), d, d + len);
+	}
+
+	/*!
+	 * \brief Returns the key of the variable at the given index.
+	 */
+	Key key(size_t index) const noexcept
+	{
+		stored_assert(index < size());
+		return m_entries[index].key;
+	}
+
+	/*!
+	 * \brief Returns the type of the variable at the given index.
+	 */
+	Type::type type(size_t index) const noexcept
+	{
+		stored_assert(index < size());
+		return m_entries[index].type;
+	}
+
+	/*!
+	 * \brief Returns the size of the variable at the given index.
+	 */
+	size_t len(size_t index) const noexcept
+	{
+		stored_assert(index < size());
+		return m_entries[index].len;
+	}
+
+	/*!
+	 * \brief Returns the data of the variable at the given index.
+	 */
+	char const* data(size_t index) const noexcept
+	{
+		stored_assert(index < size());
+		return &m_data[m_entries[index].data];
+	}
+
+	/*!
+	 * \brief Writes the patch to the given store buffer, between the store's batch hooks.
+	 *
+	 * Used by the \c apply() of a store.  The \c changed flag of the hook is
+	 * only set for variables that actually differ.
+	 *
+	 * \return the number of variables that were changed
+	 */
+	template <typename Container>
+	size_t apply(Container& container, char* buffer, size_t bufferSize) const
+	{
+		size_t count = size();
+		if(!count)
+			return 0;
+
+		// This does not allocate after a diff() or reserve().
+		m_batch.resize(count);
+
+		for(size_t i = 0; i < count; i++) {
+			Entry const& e = m_entries[i];
+			stored_assert(e.key + e.len <= bufferSize);
+			BatchEntry& b = m_batch[i];
+			b.buffer = buffer + e.key;
+			b.len = e.len;
+			b.type = e.type;
+			b.changed = false;
+		}
+		UNUSED(bufferSize)
+
+		container.hookEntryBatchX(&m_batch[0], count);
+
+		size_t changed = 0;
+		for(size_t i = 0; i < count; i++) {
+			BatchEntry& b = m_batch[i];
+			char const* d = &m_data[m_entries[i].data];
+			if(memcmp(b.buffer, d, b.len) != 0) {
+				memcpy(b.buffer, d, b.len);
+				b.changed = true;
+				changed++;
+			}
+		}
+
+		container.hookExitBatchX(&m_batch[0], count);
+		return changed;
+	}
+
+	/*!
+	 * \brief Fills the patch with the variables that differ between two store buffers.
+	 *
+	 * Used by the \c diff() of a store.  The buffers are compared by
+	 * stored::memdiff().  Only when a difference is found, the variable
+	 * tables of the store are searched for the variable that holds it.
+	 * Differences in padding between variables are ignored.  The patch
+	 * gets the data of \p to.
+	 */
+	template <typename Offset, typename Size>
+	void diff(char const* from, char const* to, uint8_t const* types, Offset const* offsets,
+		  Size const* sizes, size_t count)
+	{
+		clear();
+		if(!count)
+			return;
+
+		size_t end = (size_t)offsets[count - 1] + (size_t)sizes[count - 1];
+		size_t pos = 0;
+		size_t i = 0;
+
+		while(true) {
+			pos += memdiff(from + pos, to + pos, end - pos);
+			if(pos >= end)
+				return;
+
+			// Find the first variable that ends after pos.
+			Offset const* o = std::upper_bound(offsets + i, offsets + count, pos);
+			i = (size_t)(o - offsets);
+			if(i > 0 && (size_t)offsets[i - 1] + (size_t)sizes[i - 1] > pos)
+				i--;
+			if(i == count)
+				return;
+
+			size_t offset = (size_t)offsets[i];
+			if(offset > pos) {
+				// pos is in the padding before this variable.
+				pos = offset;
+				continue;
+			}
+
+			add(offset, (Type::type)types[i], to + offset, (size_t)sizes[i]);
+			pos = offset + (size_t)sizes[i];
+			i++;
+		}
+	}
+
+private:
+	/*! \brief A variable in the patch. */
+	struct Entry {
+		Key key;
+		size_t len;
+		/*! \brief Offset in \c m_data. */
+		size_t data;
+		Type::type type;
+	};
+
+	/*! \brief All variables, sorted by key. */
+	Vector<Entry>::type m_entries;
+	/*! \brief The data of all variables. */
+	Vector<char>::type m_data;
+	/*! \brief Scratch pad for the batch hooks of #apply(). */
+	mutable Vector<BatchEntry>::type m_batch;
+};
+
 
 namespace impl {
 template <typename StoreBase, typename T>
@@ -2138,6 +2943,80 @@ public:
 	}
 };
 
+/*!
+ * \brief Array class as used in the *Objects base class of a store.
+ *
+ * Do not use. Only the *Objects class is allowed to use it.
+ */
+template <typename Store, typename Implementation, typename T, size_t offset, size_t size_>
+// NOLINTNEXTLINE(cppcoreguidelines-special-member-functions,hicpp-special-member-functions)
+class StoreArray {
+public:
+#	if STORED_cplusplus >= 201103L
+	// Prevent accidental copying this object.  This only
+	// works for C++11, as these special functions must be
+	// trivial otherwise being used as union member.
+	StoreArray(StoreArray const&) = delete;
+	StoreArray(StoreArray&&) = delete;
+	void operator=(StoreArray const&) = delete;
+	void operator=(StoreArray&&) = delete;
+#	endif
+
+	typedef T type;
+	typedef Array<type, Implementation> Array_type;
+	typedef Variable<type, Implementation> Variable_type;
+
+	static constexpr uintptr_t key() noexcept
+	{
+		return static_cast<uintptr_t>(offset);
+	}
+
+	constexpr Array_type array() const noexcept
+	{
+		return objectToStore<Store>(*this).template _array<type>(offset, size_);
+	}
+
+	// NOLINTNEXTLINE(hicpp-explicit-conversions)
+	constexpr operator Array_type() const noexcept
+	{
+		return array();
+	}
+
+	Variable_type operator[](size_t index) const noexcept
+	{
+		return array()[index];
+	}
+
+	type get(size_t index) const noexcept
+	{
+		return array().get(index);
+	}
+
+	void set(size_t index, type value) noexcept
+	{
+		array().set(index, value);
+	}
+
+	size_t
+	get(type* dst, size_t start = 0,
+	    size_t count = std::numeric_limits<size_t>::max()) const noexcept
+	{
+		return array().get(dst, start, count);
+	}
+
+	size_t
+	set(type const* src, size_t start = 0,
+	    size_t count = std::numeric_limits<size_t>::max()) noexcept
+	{
+		return array().set(src, start, count);
+	}
+
+	static constexpr size_t size()
+	{
+		return size_;
+	}
+};
+
 /*!
  * \brief Function class as used in the *Objects base class of a store.
  *
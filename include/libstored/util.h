@@ -637,11 +637,33 @@ int strncmp(
 
 char const* banner() noexcept;
 
+size_t encode_hex(char* __restrict__ dst, void const* __restrict__ src, size_t len) noexcept;
+bool decode_hex(void* __restrict__ dst, char const* __restrict__ src, size_t len) noexcept;
+size_t memdiff(void const* a, void const* b, size_t len) noexcept;
+
 template <typename T>
 struct identity {
 	typedef T self;
 };
 
+/*!
+ * \brief Tag to construct a store in memory that is known to be zero.
+ *
+ * Memory with static storage duration, such as a global variable, is zero
+ * before any constructor runs.  When passed to the constructor of a store, it
+ * only writes the non-zero initial values, instead of clearing the whole
+ * buffer first.  The pages of a large, mostly zero store in \c .bss are
+ * therefore not touched at startup.
+ *
+ * \code
+ * MyStore store{stored::ZeroInitialized()}; // global
+ * \endcode
+ *
+ * Do not use it for stores on the stack or the heap, unless the memory is
+ * zeroed, like by \c calloc().
+ */
+struct ZeroInitialized {};
+
 /*!
  * \brief Type constructor for (wrapped) store base class types.
  *
@@ -46,7 +46,7 @@ public:
 
 	virtual fd_type fd() const override;
 
-	void encode(void const* buffer, size_t len, bool last = true) final;
+	virtual void encode(void const* buffer, size_t len, bool last = true) override;
 #		ifndef DOXYGEN
 	using base::encode;
 #		endif
@@ -55,8 +55,12 @@ protected:
 	int block(fd_type fd, bool forReading, long timeout_us = -1, bool suspend = false) final;
 	int block(bool forReading, long timeout_us = -1, bool suspend = false);
 	int recv1(long timeout_us = 0);
+	int send(void const* buffer, size_t len, bool more);
+	bool isRouter() const;
 
 private:
+	int bufferAppend(void const* buffer, size_t len);
+
 	/*! \brief The ZeroMQ context. */
 	void* m_context;
 	/*! \brief Flag to indicate if we created #m_context or not. */
@@ -69,11 +73,34 @@ private:
 	size_t m_bufferCapacity;
 	/*! \brief Allocated size of #m_buffer. */
 	size_t m_bufferSize;
+	/*! \brief \c true when #m_socket is a ROUTER socket. */
+	bool m_router;
+	/*! \brief \c true while receiving the routing envelope of a request. */
+	bool m_routing;
+	/*! \brief Routing frames of the last request, each prefixed by its length. */
+	String::type m_envelope;
+	/*! \brief \c true when #m_envelope still has to be sent before the next response part. */
+	bool m_envelopePending;
+	/*! \brief \c true when the rest of the current response is dropped. */
+	bool m_dropping;
 };
 
 /*!
  * \brief Constructs a protocol stack on top of a REQ/REP ZeroMQ socket, specifically for the
  * #stored::Debugger.
+ *
+ * By default, a REP socket is used, which serves one request at the time.  In
+ * #ModeRouter, a ROUTER socket is used instead. Requests of all connected
+ * clients are fair-queued by ZeroMQ, and every recv() handles at most
+ * #RouterBatch requests, such that a busy client cannot starve the
+ * application.  Both REQ and (pipelining) DEALER clients are supported, as the
+ * routing envelope of every request is returned with its response.
+ *
+ * A response cache can be enabled using #setCache(). Responses to read-only
+ * requests are then kept until the next call to recv(), such that clients
+ * polling the same object within one application tick share one response. Any
+ * other request flushes the cache.  As #ModeRep handles only one request per
+ * recv(), the cache is only effective in #ModeRouter.
  */
 class DebugZmqLayer : public ZmqLayer {
 	STORED_CLASS_NOCOPY(DebugZmqLayer)
@@ -81,15 +108,63 @@ public:
 	typedef ZmqLayer base;
 
 	enum { DefaultPort = 19026,
+	       RouterBatch = 64,
 	};
 
+	enum Mode { ModeRep, ModeRouter };
+
 	explicit DebugZmqLayer(
 		void* context = nullptr, int port = DefaultPort, ProtocolLayer* up = nullptr,
 		ProtocolLayer* down = nullptr);
+	DebugZmqLayer(
+		void* context, int port, Mode mode, ProtocolLayer* up = nullptr,
+		ProtocolLayer* down = nullptr);
 	/*! \brief Dtor. */
 	virtual ~DebugZmqLayer() override is_default
 
 	virtual int recv(long timeout_us = 0) override;
+	virtual void decode(void* buffer, size_t len) override;
+	virtual void encode(void const* buffer, size_t len, bool last = true) override;
+#		ifndef DOXYGEN
+	using base::encode;
+#		endif
+
+	Mode mode() const;
+	void setCache(bool enable = true);
+	bool cache() const;
+	size_t cacheHits() const;
+	size_t requests() const;
+
+protected:
+	void init(int port);
+	static bool cacheable(void const* buffer, size_t len);
+
+private:
+	/*! \brief The mode, as passed to the constructor. */
+	Mode m_mode;
+	/*! \brief Flag to indicate that read-only responses are cached. */
+	bool m_cacheEnabled;
+	/*! \brief Flag to indicate that the current response is appended to #m_cacheArena. */
+	bool m_caching;
+
+	/*! \brief A cached request, followed by its response in #m_cacheArena. */
+	struct CacheEntry {
+		size_t offset;
+		size_t requestLen;
+		size_t responseLen;
+	};
+
+	struct CacheEntryLess;
+	void cacheClear();
+
+	/*! \brief All cached requests and responses, which reuses its capacity. */
+	String::type m_cacheArena;
+	/*! \brief Entries in #m_cacheArena, sorted by request. */
+	Vector<CacheEntry>::type m_cache;
+	/*! \brief Number of requests that were served from #m_cache. */
+	size_t m_cacheHits;
+	/*! \brief Number of received requests. */
+	size_t m_requests;
 };
 
 /*!
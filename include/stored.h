@@ -15,9 +15,11 @@
 #include <libstored/compress.h>
 #include <libstored/config.h>
 #include <libstored/debugger.h>
+#include <libstored/doublebuffer.h>
 #include <libstored/fifo.h>
 #include <libstored/poller.h>
 #include <libstored/protocol.h>
+#include <libstored/snapshot.h>
 #include <libstored/synchronizer.h>
 #include <libstored/util.h>
 #include <libstored/version.h>
@@ -753,10 +753,69 @@ class Object(QObject):
         else:
             return ''
 
+class DeltaDecoder(object):
+    """Inverse of the C++ stored::DeltaLayer.
+
+    The stream consists of zigzag-encoded LEB128 varints, which are the
+    difference of a little-endian word with the same word in the previous
+    record of stride bytes. When the stream does not end on a word boundary,
+    a 0x80 0x00 tail marker is followed by the remaining bytes raw.
+    """
+    def __init__(self, stride, word=4):
+        if word not in (1, 2, 4, 8) or stride <= 0 or stride % word != 0:
+            raise ValueError('Invalid delta stride/word')
+        self._stride = stride
+        self._word = word
+        self._mask = (1 << (word * 8)) - 1
+        self.reset()
+
+    def reset(self):
+        self._prev = [0] * (self._stride // self._word)
+        self._pos = 0
+        self._zz = 0
+        self._shift = 0
+        self._tail = False
+
+    def fill(self, data):
+        if self._tail:
+            return bytes(data)
+
+        res = bytearray()
+        for i, b in enumerate(data):
+            self._zz |= (b & 0x7f) << self._shift
+            self._shift += 7
+            if b & 0x80:
+                continue
+
+            if b == 0 and self._shift > 7:
+                # Tail marker. The rest is a partial word.
+                self._tail = True
+                res += data[i + 1:]
+                break
+
+            delta = (self._zz >> 1) ^ -(self._zz & 1)
+            v = (self._prev[self._pos] + delta) & self._mask
+            self._prev[self._pos] = v
+            res += v.to_bytes(self._word, 'little')
+
+            self._zz = 0
+            self._shift = 0
+            self._pos = (self._pos + 1) % len(self._prev)
+        return bytes(res)
+
 class Stream(object):
-    def __init__(self, client, name, raw=False):
+    def __init__(self, client, name, raw=False, window_sz2=8, lookahead_sz2=4, delta=None):
+        """Stream reader.
+
+        The heatshrink parameters window_sz2 and lookahead_sz2, and the
+        delta (stride, word) tuple must match the Config::CompressStreams*
+        settings of the embedded side.
+        """
         self._client = client
         self._raw = raw
+        self._window_sz2 = window_sz2
+        self._lookahead_sz2 = lookahead_sz2
+        self._delta = None if delta is None else DeltaDecoder(*delta)
 
         if not isinstance(name, str) or len(name) != 1:
             raise ValueError('Invalid stream name ' + s)
@@ -797,7 +856,11 @@ class Stream(object):
             x = self._decoder.fill(x)
             if self._finishing:
                 x += self._decoder.finish()
+                if self._delta is not None:
+                    x = self._delta.fill(x)
                 self._reset()
+            elif self._delta is not None:
+                x = self._delta.fill(x)
 
         if not self.raw:
             x = x.decode(errors='backslashreplace')
@@ -822,7 +885,10 @@ class Stream(object):
 
     def _reset(self):
         if self._compressed:
-            self._decoder = heatshrink2.core.Encoder(heatshrink2.core.Reader(window_sz2=8, lookahead_sz2=4))
+            self._decoder = heatshrink2.core.Encoder(heatshrink2.core.Reader(
+                window_sz2=self._window_sz2, lookahead_sz2=self._lookahead_sz2))
+            if self._delta is not None:
+                self._delta.reset()
             self._finishing = False
             self._flushing = False
 
@@ -1076,12 +1142,20 @@ class ZmqClient(QObject):
     defaultPollIntervalChanged = Signal()
     closed = Signal()
 
-    def __init__(self, address='localhost', port=ZmqServer.default_port, csv=None, multi=False, parent=None, t=None, timeout=None, context=None):
+    def __init__(self, address='localhost', port=ZmqServer.default_port, csv=None, multi=False, parent=None, t=None, timeout=None, context=None, pipeline=1):
         super().__init__(parent=parent)
         self.logger = logging.getLogger(__name__)
         self._multi = multi
         self._context = context or zmq.Context.instance()
-        self._socket = self._context.socket(zmq.REQ)
+
+        # When pipeline > 1, a DEALER socket is used, which allows multiple
+        # requests in flight. Every request is prefixed by an envelope with a
+        # request id and an empty delimiter frame. Both a REP and ROUTER
+        # socket echo this envelope in the response, which is used to match
+        # responses to requests.
+        self._pipeline = max(1, int(pipeline or 1))
+        self._reqId = 0
+        self._socket = self._context.socket(zmq.REQ if self._pipeline == 1 else zmq.DEALER)
         if timeout is not None and timeout <= 0:
             timeout = None
         self._timeout = timeout
@@ -1162,24 +1236,37 @@ class ZmqClient(QObject):
     def socket(self):
         return self._socket
 
-    @Slot(str,result=str)
-    def req(self, message):
-        if isinstance(message,str):
-            return self.req(message.encode()).decode()
+    @property
+    def pipeline(self):
+        return self._pipeline
 
-        if message == b'':
+    def _send(self, message):
+        """Send a request, and return the request id.
+
+        The id is b'' when not pipelining.
+        """
+        if self._pipeline == 1:
+            self._socket.send(message)
             return b''
 
-        # Wait for all outstanding requests first.
-        self._reqAsyncFlush()
+        self._reqId = (self._reqId + 1) & 0xffffffff
+        rid = struct.pack('<I', self._reqId)
+        self._socket.send_multipart([rid, b'', message])
+        return rid
 
-        if self._socket is None:
-            return None
+    def _recv(self, flags=0):
+        """Receive a response, and return a (request id, response) tuple."""
+        frames = self._socket.recv_multipart(flags)
+        if self._pipeline == 1:
+            return b'', b''.join(frames)
 
-        self.logger.debug('req %s', message)
-        self._socket.send(message)
+        if len(frames) < 2 or frames[1] != b'':
+            self.logger.warning('Dropping response without envelope')
+            return None, b''
 
-        # Block till we have some message.
+        return frames[0], b''.join(frames[2:])
+
+    def _recvBlocking(self):
         start = time.time()
         while True:
             if self._timeout is not None and time.time() - start > self._timeout:
@@ -1188,16 +1275,82 @@ class ZmqClient(QObject):
                 raise TimeoutError()
 
             try:
-                rep = b''.join(self._socket.recv_multipart(zmq.NOBLOCK))
-                break
+                return self._recv(zmq.NOBLOCK)
             except zmq.ZMQError as e:
                 if e.errno != zmq.EAGAIN:
                     raise
             self._socket.poll(1000)
 
+    @Slot(str,result=str)
+    def req(self, message):
+        if isinstance(message,str):
+            return self.req(message.encode()).decode()
+
+        if message == b'':
+            return b''
+
+        # Wait for all outstanding requests first.
+        self._reqAsyncFlush()
+
+        if self._socket is None:
+            return None
+
+        self.logger.debug('req %s', message)
+        rid = self._send(message)
+
+        # Block till we have our message.
+        while True:
+            r, rep = self._recvBlocking()
+            if r == rid:
+                break
+            self.logger.debug('dropping stale response %s', rep)
+
         self.logger.debug('rep %s', rep)
         return rep
 
+    def reqMulti(self, messages):
+        """Execute a list of requests, and return the list of responses.
+
+        When pipelining, up to pipeline requests are in flight at the same
+        time, which hides the round-trip latency.
+        """
+        messages = [m.encode() if isinstance(m, str) else m for m in messages]
+
+        self._reqAsyncFlush()
+
+        if self._pipeline == 1:
+            return [self.req(m) for m in messages]
+
+        res = [None] * len(messages)
+        inflight = {}
+        sent = 0
+        done = 0
+
+        while done < len(messages):
+            if self._socket is None:
+                return res
+
+            while sent < len(messages) and len(inflight) < self._pipeline:
+                if messages[sent] == b'':
+                    res[sent] = b''
+                    done += 1
+                else:
+                    inflight[self._send(messages[sent])] = sent
+                sent += 1
+
+            if inflight == {}:
+                continue
+
+            rid, rep = self._recvBlocking()
+            i = inflight.pop(rid, None)
+            if i is None:
+                self.logger.debug('dropping stale response %s', rep)
+            else:
+                res[i] = rep
+                done += 1
+
+        return res
+
     def reqAsync(self, message, callback=None):
         if isinstance(message,str):
             message = message.encode()
@@ -1222,20 +1375,31 @@ class ZmqClient(QObject):
                 self.logger.warning('Async req returned an error, which was not handled')
             return
 
-        self._reqQueue.append((message, callback))
+        # Entries are [request, callback, request id]. The request id is
+        # None while the request is not sent yet.
+        self._reqQueue.append([message, callback, None])
         if len(self._reqQueue) == 1:
             self._socketNotifier.setEnabled(True)
-            self._reqAsyncSendNext()
-        else:
+        if not self._reqAsyncSendNext():
             self.logger.debug('req async queued %s', message)
 
     def _reqAsyncSendNext(self):
-        if not self._socket is None and self._reqQueue != []:
-            req, _ = self._reqQueue[0]
-            self.logger.debug('req async send %s', req)
-            self._socket.send(req)
-        else:
+        if self._socket is None or self._reqQueue == []:
             self._socketNotifier.setEnabled(False)
+            return False
+
+        sent = False
+        inflight = 0
+        for r in self._reqQueue:
+            if inflight >= self._pipeline:
+                break
+            if r[2] is None:
+                self.logger.debug('req async send %s', r[0])
+                r[2] = self._send(r[0])
+                sent = True
+            inflight += 1
+
+        return sent
 
     @Slot()
     def _reqAsyncCheckResponse(self):
@@ -1243,17 +1407,33 @@ class ZmqClient(QObject):
 
         try:
             while not self._socket is None:
-                resp = b''.join(self._socket.recv_multipart(zmq.NOBLOCK))
-                self._reqAsyncHandleResponse(resp)
+                rid, resp = self._recv(zmq.NOBLOCK)
+                self._reqAsyncHandleResponse(resp, rid)
                 res = True
         except zmq.ZMQError as e:
             pass
         return res
 
-    def _reqAsyncHandleResponse(self, resp):
+    def _reqAsyncHandleResponse(self, resp, rid=None):
         self.logger.debug('req async recv %s', resp)
         assert(self._reqQueue != [])
-        req, callback = self._reqQueue.pop(0)
+
+        i = 0
+        if rid is None:
+            if self._socket is not None:
+                # Only pipelined responses can lack an envelope, and _recv()
+                # warned about it already. Don't complete another request with it.
+                self.logger.debug('dropping unmatched response %s', resp)
+                return
+        else:
+            for i, r in enumerate(self._reqQueue):
+                if r[2] == rid:
+                    break
+            else:
+                self.logger.debug('dropping stale response %s', resp)
+                return
+
+        req, callback, _ = self._reqQueue.pop(i)
         self._reqAsyncSendNext()
         if not callback is None:
             callback(resp)
@@ -1278,7 +1458,8 @@ class ZmqClient(QObject):
                 continue
 
             try:
-                self._reqAsyncHandleResponse(b''.join(self._socket.recv_multipart(zmq.NOBLOCK)))
+                rid, resp = self._recv(zmq.NOBLOCK)
+                self._reqAsyncHandleResponse(resp, rid)
                 lastMsg = time.time()
             except zmq.ZMQError as e:
                 if e.errno != zmq.EAGAIN:
@@ -1634,8 +1815,8 @@ class ZmqClient(QObject):
                 pass
         return s
 
-    def stream(self, s, raw=False):
-        return Stream(self, s, raw)
+    def stream(self, s, raw=False, **kwargs):
+        return Stream(self, s, raw, **kwargs)
 
     def _defaultPollInterval_get(self):
         return self._defaultPollInterval
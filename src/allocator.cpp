@@ -0,0 +1,434 @@
+/*
+ * libstored, distributed debuggable data stores.
+ * Copyright (C) 2020-2022  Jochem Rutgers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include <libstored/allocator.h>
+
+#if STORED_cplusplus >= 201103L
+
+#	include <new>
+#	include <type_traits>
+
+#	ifdef STORED_HAVE_THREADS
+#		include <mutex>
+#	endif
+
+namespace stored {
+
+#	ifndef STORED_HAVE_THREADS
+static_assert(!Config::PoolThreadSafe, "PoolThreadSafe requires thread support");
+#	endif
+
+static_assert(
+	Config::PoolChunkSize >= (size_t)Pool::MaxBlockSize
+		&& Config::PoolChunkSize % (size_t)Pool::MinBlockSize == 0,
+	"PoolChunkSize must be a multiple of MinBlockSize, and not smaller than MaxBlockSize");
+static_assert(
+	Pool::blockSize(Pool::SizeClasses - 1) == (size_t)Pool::MaxBlockSize,
+	"Inconsistent size classes");
+
+namespace {
+
+struct FreeBlock {
+	FreeBlock* next;
+};
+
+/*!
+ * \brief The process-wide free lists.
+ *
+ * The instance is never destroyed, as blocks may be freed during static
+ * destruction.
+ */
+class GlobalPool {
+public:
+	static GlobalPool& instance() noexcept
+	{
+		static std::aligned_storage<sizeof(GlobalPool), alignof(GlobalPool)>::type buffer;
+		static GlobalPool* p = new(&buffer) GlobalPool();
+		return *p;
+	}
+
+	void lock() noexcept
+	{
+#	ifdef STORED_HAVE_THREADS
+		if(Config::PoolThreadSafe)
+			m_mutex.lock();
+#	endif
+	}
+
+	void unlock() noexcept
+	{
+#	ifdef STORED_HAVE_THREADS
+		if(Config::PoolThreadSafe)
+			m_mutex.unlock();
+#	endif
+	}
+
+	/*!
+	 * \brief Get a block of the given size class.
+	 * \details The lock must be held.
+	 */
+	FreeBlock* take(size_t c)
+	{
+		FreeBlock* b = m_free[c];
+		if(likely(b)) {
+			m_free[c] = b->next;
+			return b;
+		}
+
+		size_t size = Pool::blockSize(c);
+		if(unlikely(m_chunkLeft < size)) {
+			// Distribute the remainder over the smaller classes, and
+			// start a new chunk.
+			for(size_t i = c; i > 0 && m_chunkLeft > 0; i--)
+				while(m_chunkLeft >= Pool::blockSize(i - 1))
+					give(i - 1, carve(Pool::blockSize(i - 1)));
+
+			m_chunk = static_cast<char*>(::operator new(Config::PoolChunkSize));
+			m_chunkLeft = Config::PoolChunkSize;
+			m_stats.chunks++;
+			m_stats.reserved += Config::PoolChunkSize;
+		}
+
+		return carve(size);
+	}
+
+	/*!
+	 * \brief Return a block of the given size class.
+	 * \details The lock must be held.
+	 */
+	void give(size_t c, FreeBlock* b) noexcept
+	{
+		b->next = m_free[c];
+		m_free[c] = b;
+	}
+
+	/*!
+	 * \brief Process allocation counters.
+	 * \details The lock must be held.
+	 */
+	void account(size_t allocations, size_t deallocations, size_t cacheHits) noexcept
+	{
+		m_stats.allocations += allocations;
+		m_stats.deallocations += deallocations;
+		m_stats.cacheHits += cacheHits;
+		m_stats.inUse = m_stats.allocations >= m_stats.deallocations
+					? m_stats.allocations - m_stats.deallocations
+					: 0;
+		if(m_stats.inUse > m_stats.peakInUse)
+			m_stats.peakInUse = m_stats.inUse;
+	}
+
+	/*!
+	 * \brief Account a large allocation.
+	 * \details The lock must be held.
+	 */
+	void large() noexcept
+	{
+		m_stats.large++;
+	}
+
+	PoolStats const& stats() const noexcept
+	{
+		return m_stats;
+	}
+
+private:
+	GlobalPool() noexcept
+		: m_free()
+		, m_chunk()
+		, m_chunkLeft()
+		, m_stats()
+	{}
+
+	FreeBlock* carve(size_t size) noexcept
+	{
+		FreeBlock* b = reinterpret_cast<FreeBlock*>(m_chunk);
+		m_chunk += size;
+		m_chunkLeft -= size;
+		return b;
+	}
+
+private:
+	FreeBlock* m_free[Pool::SizeClasses];
+	char* m_chunk;
+	size_t m_chunkLeft;
+	PoolStats m_stats;
+#	ifdef STORED_HAVE_THREADS
+	std::mutex m_mutex;
+#	endif
+};
+
+class GlobalPoolLock {
+public:
+	explicit GlobalPoolLock(GlobalPool& pool) noexcept
+		: m_pool(pool)
+	{
+		m_pool.lock();
+	}
+
+	~GlobalPoolLock()
+	{
+		m_pool.unlock();
+	}
+
+	GlobalPoolLock(GlobalPoolLock const&) = delete;
+	void operator=(GlobalPoolLock const&) = delete;
+
+private:
+	GlobalPool& m_pool;
+};
+
+#	ifdef STORED_HAVE_THREADS
+/*!
+ * \brief State of the calling thread's ThreadCache.
+ *
+ * This flag is trivially destructible, so it can still be read during
+ * thread and static destruction, after the ThreadCache itself is gone.
+ */
+enum ThreadCacheState { ThreadCacheUnused, ThreadCacheAlive, ThreadCacheDestroyed };
+static thread_local unsigned char threadCacheState;
+
+/*!
+ * \brief Per-thread cache of free blocks.
+ *
+ * Blocks are exchanged with the GlobalPool in batches of half the cache
+ * size.  The allocation counters are accumulated locally and passed to the
+ * GlobalPool upon every exchange.
+ */
+class ThreadCache {
+public:
+	enum { Batch = Config::PoolThreadCache > 1 ? Config::PoolThreadCache / 2 : 1 };
+
+	ThreadCache() noexcept
+		: m_free()
+		, m_count()
+		, m_allocations()
+		, m_deallocations()
+		, m_cacheHits()
+	{
+		threadCacheState = ThreadCacheAlive;
+	}
+
+	~ThreadCache()
+	{
+		flush();
+		// Blocks that are freed during further thread destruction go
+		// directly to the GlobalPool.
+		threadCacheState = ThreadCacheDestroyed;
+	}
+
+	void* allocate(size_t c)
+	{
+		m_allocations++;
+
+		FreeBlock* b = m_free[c];
+		if(likely(b)) {
+			m_free[c] = b->next;
+			m_count[c]--;
+			m_cacheHits++;
+			return b;
+		}
+
+		GlobalPool& pool = GlobalPool::instance();
+		GlobalPoolLock l(pool);
+		sync(pool);
+		b = pool.take(c);
+		for(size_t i = 1; i < (size_t)Batch; i++) {
+			FreeBlock* extra = pool.take(c);
+			extra->next = m_free[c];
+			m_free[c] = extra;
+			m_count[c]++;
+		}
+		return b;
+	}
+
+	void deallocate(size_t c, void* p) noexcept
+	{
+		m_deallocations++;
+
+		FreeBlock* b = static_cast<FreeBlock*>(p);
+		b->next = m_free[c];
+		m_free[c] = b;
+
+		if(likely(++m_count[c] <= Config::PoolThreadCache))
+			return;
+
+		GlobalPool& pool = GlobalPool::instance();
+		GlobalPoolLock l(pool);
+		sync(pool);
+		for(size_t i = 0; i < (size_t)Batch; i++) {
+			b = m_free[c];
+			m_free[c] = b->next;
+			pool.give(c, b);
+		}
+		m_count[c] -= (size_t)Batch;
+	}
+
+	void flush() noexcept
+	{
+		GlobalPool& pool = GlobalPool::instance();
+		GlobalPoolLock l(pool);
+		sync(pool);
+		for(size_t c = 0; c < Pool::SizeClasses; c++) {
+			while(m_free[c]) {
+				FreeBlock* b = m_free[c];
+				m_free[c] = b->next;
+				pool.give(c, b);
+			}
+			m_count[c] = 0;
+		}
+	}
+
+	/*!
+	 * \brief Pass the local counters to the GlobalPool.
+	 * \details The lock must be held.
+	 */
+	void sync(GlobalPool& pool) noexcept
+	{
+		pool.account(m_allocations, m_deallocations, m_cacheHits);
+		m_allocations = m_deallocations = m_cacheHits = 0;
+	}
+
+private:
+	FreeBlock* m_free[Pool::SizeClasses];
+	size_t m_count[Pool::SizeClasses];
+	size_t m_allocations;
+	size_t m_deallocations;
+	size_t m_cacheHits;
+};
+
+static ThreadCache* threadCache() noexcept
+{
+	if(!Config::PoolThreadSafe || Config::PoolThreadCache == 0)
+		return nullptr;
+
+	// Do not touch the cache anymore once it has been destroyed.
+	if(unlikely(threadCacheState == ThreadCacheDestroyed))
+		return nullptr;
+
+	static thread_local ThreadCache cache;
+	return &cache;
+}
+#	endif // STORED_HAVE_THREADS
+
+} // namespace
+
+uint8_t const* Pool::sizeClassTable() noexcept
+{
+	// Index is (size - 1) / MinBlockSize.
+	static uint8_t const table[MaxBlockSize / MinBlockSize] = {
+		0, 1, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4, 5, 5, 5, 5, 5, 5,
+		5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+		6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	};
+	return table;
+}
+
+/*!
+ * \brief Allocate a block of at least the given size.
+ *
+ * The block is aligned to at least \c MinBlockSize or the alignment
+ * of \c ::operator new, whichever is smaller.
+ */
+void* Pool::allocate(size_t size)
+{
+	if(unlikely(size > (size_t)MaxBlockSize)) {
+		void* p = ::operator new(size);
+		GlobalPool& pool = GlobalPool::instance();
+		GlobalPoolLock l(pool);
+		pool.account(1, 0, 0);
+		pool.large();
+		return p;
+	}
+
+	size_t c = sizeClass(size);
+
+#	ifdef STORED_HAVE_THREADS
+	ThreadCache* cache = threadCache();
+	if(likely(cache))
+		return cache->allocate(c);
+#	endif
+
+	GlobalPool& pool = GlobalPool::instance();
+	GlobalPoolLock l(pool);
+	pool.account(1, 0, 0);
+	return pool.take(c);
+}
+
+/*!
+ * \brief Free a block, previously allocated by #allocate().
+ *
+ * The \p size must be the same as passed to #allocate().
+ */
+void Pool::deallocate(void* p, size_t size) noexcept
+{
+	if(unlikely(!p))
+		return;
+
+	if(unlikely(size > (size_t)MaxBlockSize)) {
+		::operator delete(p);
+		GlobalPool& pool = GlobalPool::instance();
+		GlobalPoolLock l(pool);
+		pool.account(0, 1, 0);
+		return;
+	}
+
+	size_t c = sizeClass(size);
+
+#	ifdef STORED_HAVE_THREADS
+	ThreadCache* cache = threadCache();
+	if(likely(cache)) {
+		cache->deallocate(c, p);
+		return;
+	}
+#	endif
+
+	GlobalPool& pool = GlobalPool::instance();
+	GlobalPoolLock l(pool);
+	pool.account(0, 1, 0);
+	pool.give(c, static_cast<FreeBlock*>(p));
+}
+
+/*!
+ * \brief Return the pool statistics.
+ *
+ * The counters of the calling thread are up to date. Counters of other
+ * threads are included as far as their caches have been exchanged blocks
+ * with the global pool.
+ */
+PoolStats Pool::stats() noexcept
+{
+	GlobalPool& pool = GlobalPool::instance();
+	GlobalPoolLock l(pool);
+#	ifdef STORED_HAVE_THREADS
+	ThreadCache* cache = threadCache();
+	if(cache)
+		cache->sync(pool);
+#	endif
+	return pool.stats();
+}
+
+/*!
+ * \brief Return all free blocks in the cache of the calling thread to the global pool.
+ *
+ * This is done automatically when the thread exits.
+ */
+void Pool::flushThreadCache() noexcept
+{
+#	ifdef STORED_HAVE_THREADS
+	ThreadCache* cache = threadCache();
+	if(cache)
+		cache->flush();
+#	endif
+}
+
+} // namespace stored
+#else  // STORED_cplusplus < 201103L
+char dummy_char_to_make_allocator_cpp_non_empty = 0; // NOLINT
+#endif // STORED_cplusplus
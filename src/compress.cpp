@@ -10,6 +10,246 @@
 #include <libstored/macros.h>
 #include <libstored/compress.h>
 
+namespace stored {
+
+//////////////////////////////
+// DeltaLayer
+//
+
+/*!
+ * \brief Ctor.
+ * \param stride the record size in bytes, which must be a multiple of \p word; 0 disables the
+ *	transform
+ * \param word the word size in bytes; 1, 2, 4, or 8
+ * \param up the layer above, which receives our decoded frames
+ * \param down the layer below, which receives our encoded frames
+ */
+DeltaLayer::DeltaLayer(size_t stride, size_t word, ProtocolLayer* up, ProtocolLayer* down)
+	: base(up, down)
+	, m_stride(stride)
+	, m_word(word)
+	, m_encodePos()
+	, m_encodeWord()
+	, m_encodeWordFill()
+	, m_encodeBuffer()
+	, m_encodeBufferSize()
+{
+	stored_assert(word == 1 || word == 2 || word == 4 || word == 8);
+	stored_assert(stride % word == 0);
+
+	m_encodePrev.resize(m_stride);
+	m_decodePrev.resize(m_stride);
+}
+
+/*!
+ * \brief Read the little-endian word at the given offset in a record.
+ */
+static uint64_t deltaLoad(uint8_t const* p, size_t word)
+{
+	uint64_t v = 0;
+	for(size_t i = word; i > 0; i--)
+		v = (v << 8U) | p[i - 1U];
+	return v;
+}
+
+/*!
+ * \brief Write the given value as a little-endian word.
+ */
+static void deltaStore(uint8_t* p, size_t word, uint64_t v)
+{
+	for(size_t i = 0; i < word; i++, v >>= 8U)
+		p[i] = (uint8_t)v;
+}
+
+/*!
+ * \brief Sign-extend the given \p word-sized value.
+ */
+static int64_t deltaSignExtend(uint64_t v, size_t word)
+{
+	unsigned shift = (unsigned)(64U - word * 8U);
+	return (int64_t)(v << shift) >> shift;
+}
+
+/*!
+ * \brief Process the word in \c m_encodeWord.
+ */
+void DeltaLayer::encodeWord()
+{
+	uint8_t* prev = &m_encodePrev[m_encodePos];
+	int64_t delta = deltaSignExtend(m_encodeWord - deltaLoad(prev, m_word), m_word);
+	deltaStore(prev, m_word, m_encodeWord);
+
+	// zigzag
+	uint64_t zz = ((uint64_t)delta << 1U) ^ (uint64_t)(delta >> 63U);
+
+	// LEB128
+	if(m_encodeBufferSize + 10U > sizeof(m_encodeBuffer))
+		encodeFlush(false);
+
+	do {
+		uint8_t b = (uint8_t)(zz & 0x7fU);
+		zz >>= 7U;
+		if(zz)
+			b |= 0x80U;
+		m_encodeBuffer[m_encodeBufferSize++] = b;
+	} while(zz);
+
+	m_encodeWord = 0;
+	m_encodeWordFill = 0;
+	m_encodePos += m_word;
+	if(m_encodePos >= m_stride)
+		m_encodePos = 0;
+}
+
+/*!
+ * \brief Append the partial word in \c m_encodeWord raw, after the tail marker.
+ */
+void DeltaLayer::encodeTail()
+{
+	if(m_encodeBufferSize + 2U + m_encodeWordFill > sizeof(m_encodeBuffer))
+		encodeFlush(false);
+
+	m_encodeBuffer[m_encodeBufferSize++] = 0x80U;
+	m_encodeBuffer[m_encodeBufferSize++] = 0;
+	deltaStore(&m_encodeBuffer[m_encodeBufferSize], m_encodeWordFill, m_encodeWord);
+	m_encodeBufferSize += m_encodeWordFill;
+
+	m_encodeWord = 0;
+	m_encodeWordFill = 0;
+}
+
+/*!
+ * \brief Pass the encoded data down.
+ */
+void DeltaLayer::encodeFlush(bool last)
+{
+	if(m_encodeBufferSize || last)
+		base::encode(m_encodeBuffer, m_encodeBufferSize, last);
+
+	m_encodeBufferSize = 0;
+}
+
+void DeltaLayer::encode(void const* buffer, size_t len, bool last)
+{
+	stored_assert(len == 0 || buffer);
+
+	if(!m_stride) {
+		base::encode(buffer, len, last);
+		return;
+	}
+
+	uint8_t const* buffer_ = static_cast<uint8_t const*>(buffer);
+
+	for(size_t i = 0; i < len; i++) {
+		m_encodeWord |= (uint64_t)buffer_[i] << (m_encodeWordFill * 8U);
+		if(++m_encodeWordFill == m_word)
+			encodeWord();
+	}
+
+	if(last) {
+		if(m_encodeWordFill)
+			encodeTail();
+
+		encodeFlush(true);
+		std::fill(m_encodePrev.begin(), m_encodePrev.end(), (uint8_t)0);
+		m_encodePos = 0;
+	} else {
+		encodeFlush(false);
+	}
+}
+
+void DeltaLayer::decode(void* buffer, size_t len)
+{
+	stored_assert(len == 0 || buffer);
+
+	if(!m_stride) {
+		base::decode(buffer, len);
+		return;
+	}
+
+	uint8_t const* buffer_ = static_cast<uint8_t const*>(buffer);
+	m_decodeBuffer.clear();
+
+	size_t pos = 0;
+	uint64_t zz = 0;
+	unsigned shift = 0;
+
+	for(size_t i = 0; i < len; i++) {
+		uint8_t b = buffer_[i];
+		if(shift < 64U)
+			zz |= (uint64_t)(b & 0x7fU) << shift;
+		shift += 7U;
+
+		if(b & 0x80U)
+			continue;
+
+		if(unlikely(b == 0 && shift > 7U)) {
+			// Tail marker. The rest is a partial word.
+			m_decodeBuffer.insert(m_decodeBuffer.end(), &buffer_[i + 1U], &buffer_[len]);
+			break;
+		}
+
+		uint64_t delta = (zz >> 1U) ^ (uint64_t)(-(int64_t)(zz & 1U));
+		uint8_t* prev = &m_decodePrev[pos];
+		deltaStore(prev, m_word, deltaLoad(prev, m_word) + delta);
+		m_decodeBuffer.insert(m_decodeBuffer.end(), prev, prev + m_word);
+
+		zz = 0;
+		shift = 0;
+		pos += m_word;
+		if(pos >= m_stride)
+			pos = 0;
+	}
+
+	std::fill(m_decodePrev.begin(), m_decodePrev.end(), (uint8_t)0);
+	base::decode(m_decodeBuffer.data(), m_decodeBuffer.size());
+}
+
+size_t DeltaLayer::mtu() const
+{
+	size_t mtu = base::mtu();
+	if(mtu == 0 || !m_stride)
+		return mtu;
+
+	size_t res = maxInput(mtu);
+	return res ? res : 1U;
+}
+
+/*!
+ * \brief Returns the number of bytes that can be encoded, such that the
+ *	output does not exceed \p len bytes.
+ */
+size_t DeltaLayer::maxInput(size_t len) const
+{
+	if(!m_stride)
+		return len;
+
+	// Worst case, a word expands to a varint of ceil(8 * word / 7) bytes.
+	// A partial word with its tail marker never takes more than that.
+	size_t worst = (m_word * 8U + 6U) / 7U;
+	return len / worst * m_word;
+}
+
+void DeltaLayer::reset()
+{
+	std::fill(m_encodePrev.begin(), m_encodePrev.end(), (uint8_t)0);
+	m_encodePos = 0;
+	m_encodeWord = 0;
+	m_encodeWordFill = 0;
+	m_encodeBufferSize = 0;
+	base::reset();
+}
+
+/*!
+ * \brief Check if the encoder has no partial data buffered.
+ */
+bool DeltaLayer::idle() const
+{
+	return m_encodeWordFill == 0 && m_encodeBufferSize == 0 && m_encodePos == 0;
+}
+
+} // namespace stored
+
 #ifdef STORED_HAVE_HEATSHRINK
 extern "C" {
 #	include <heatshrink_decoder.h>
@@ -47,8 +287,31 @@ CompressLayer::CompressLayer(ProtocolLayer* up, ProtocolLayer* down)
 	, m_decoder()
 	, m_decodeBufferSize()
 	, m_state()
+	, m_window(Window)
+	, m_lookahead(Lookahead)
 {}
 
+/*!
+ * \brief Ctor with custom heatshrink parameters.
+ * \param window the base-2 log of the window size, in the range 4..15
+ * \param lookahead the base-2 log of the lookahead size, in the range 3..window-1
+ * \param up the layer above, which receives our decoded frames
+ * \param down the layer below, which receives our encoded frames
+ */
+CompressLayer::CompressLayer(
+	uint8_t window, uint8_t lookahead, ProtocolLayer* up, ProtocolLayer* down)
+	: base(up, down)
+	, m_encoder()
+	, m_decoder()
+	, m_decodeBufferSize()
+	, m_state()
+	, m_window(window)
+	, m_lookahead(lookahead)
+{
+	stored_assert(window >= 4 && window <= 15);
+	stored_assert(lookahead >= 3 && lookahead < window);
+}
+
 /*!
  * \brief Dtor.
  */
@@ -69,7 +332,7 @@ void CompressLayer::decode(void* buffer, size_t len)
 		return;
 
 	if(unlikely(!m_decoder))
-		if(!(m_decoder = heatshrink_decoder_alloc(DecodeInputBuffer, Window, Lookahead))) {
+		if(!(m_decoder = heatshrink_decoder_alloc(DecodeInputBuffer, m_window, m_lookahead))) {
 #	ifdef STORED_cpp_exceptions
 			throw std::bad_alloc();
 #	else
@@ -132,7 +395,7 @@ void CompressLayer::encode(void const* buffer, size_t len, bool last)
 	stored_assert(len == 0 || buffer);
 
 	if(unlikely(!m_encoder))
-		if(!(m_encoder = heatshrink_encoder_alloc(Window, Lookahead))) {
+		if(!(m_encoder = heatshrink_encoder_alloc(m_window, m_lookahead))) {
 #	ifdef STORED_cpp_exceptions
 			throw std::bad_alloc();
 #	else
@@ -210,6 +473,4 @@ bool CompressLayer::idle() const
 }
 
 } // namespace stored
-#else  // !STORED_HAVE_HEATSHRINK
-char dummy_char_to_make_compress_cpp_non_empty; // NOLINT
 #endif // STORED_HAVE_HEATSHRINK
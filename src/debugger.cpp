@@ -11,6 +11,10 @@
 
 #include <cstring>
 
+#ifdef STORED_HAVE_THREADS
+#	include <atomic>
+#endif
+
 #ifdef STORED_COMPILER_ARMCC
 #	pragma clang diagnostic ignored "-Wweak-vtables"
 #endif
@@ -46,14 +50,27 @@ struct ListCmdCallbackArg {
  */
 // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
 Debugger::Debugger(char const* identification, char const* versions)
-	: m_identification(identification)
+	: m_spmPool()
+	, m_identification(identification)
 	, m_versions(versions)
 	, m_macroSize()
 	, m_traceMacro()
 	, m_traceStream()
 	, m_traceDecimate()
 	, m_traceCount()
-{}
+{
+	static_assert(
+		!Config::FixedCapacityContainers || Config::AvoidDynamicMemory,
+		"FixedCapacityContainers requires AvoidDynamicMemory");
+
+	if(Config::FixedCapacityContainers) {
+		m_macroBuffer.reserve((size_t)Config::DebuggerMacro);
+		m_spareStreams.reserve((size_t)Config::DebuggerStreams);
+		for(int i = 0; i < Config::DebuggerStreams; i++)
+			// NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+			m_spareStreams.push_back(new Stream<>());
+	}
+}
 
 /*!
  * \brief Destructor.
@@ -64,6 +81,9 @@ Debugger::~Debugger() noexcept
 		delete it->second; // NOLINT(cppcoreguidelines-owning-memory)
 	for(StreamMap::iterator it = m_streams.begin(); it != m_streams.end(); ++it)
 		delete it->second; // NOLINT(cppcoreguidelines-owning-memory)
+	for(Vector<Stream<>*>::type::iterator it = m_spareStreams.begin();
+	    it != m_spareStreams.end(); ++it)
+		delete *it; // NOLINT(cppcoreguidelines-owning-memory)
 }
 
 /*! \copydoc stored::DebugStoreBase::find() */
@@ -143,6 +163,84 @@ gotit:
 	return it->second->find(&name[1], len - 1);
 }
 
+/*!
+ * \brief Writes \p index in decimal to \p buf, followed by a \c ].
+ * \return the number of characters written
+ */
+static size_t printIndex(char* buf, size_t index)
+{
+	size_t len = 0;
+	do {
+		buf[len++] = (char)('0' + index % 10U);
+		index /= 10U;
+	} while(index);
+
+	for(size_t i = 0; i < len / 2U; i++)
+		std::swap(buf[i], buf[len - i - 1U]);
+
+	buf[len++] = ']';
+	return len;
+}
+
+/*!
+ * \brief Performs a lookup of a slice of an array.
+ *
+ * The \p name is like <tt>/array[2:5]</tt>, which selects the elements 2, 3
+ * and 4 of \c /array.  The slice must be within one array of fixed-length
+ * variables in a store, as described by its directory.
+ *
+ * \param name the name of the slice
+ * \param len the length of \p name
+ * \param first set to the first element, or an invalid variant when the slice is invalid
+ * \param count set to the number of elements in the slice, or 0 when it is invalid
+ * \return \c true when \p name has the syntax of a slice, \c false when it is a normal name
+ * \see #stored::DebugVariant::getRange()
+ */
+bool Debugger::findSlice(char const* name, size_t len, DebugVariant& first, size_t& count) const
+{
+	first = DebugVariant();
+	count = 0;
+
+	if(unlikely(!name || len < 5 || name[len - 1] != ']'))
+		return false;
+
+	// Parse [start:end] from the back.
+	size_t end = 0;
+	size_t i = len - 1;
+	size_t scale = 1;
+	for(; i > 0 && name[i - 1] >= '0' && name[i - 1] <= '9'; i--, scale *= 10)
+		end += (size_t)(name[i - 1] - '0') * scale;
+	if(scale == 1 || i == 0 || name[--i] != ':')
+		return false;
+
+	size_t colon = i;
+	for(; i > 0 && name[i - 1] >= '0' && name[i - 1] <= '9'; i--)
+		;
+	if(i == colon || i == 0 || name[i - 1] != '[')
+		return false;
+
+	size_t start = 0;
+	for(size_t j = i; j < colon; j++)
+		start = start * 10 + (size_t)(name[j] - '0');
+	if(start >= end)
+		return true;
+
+	ScratchPad<>::Snapshot snapshot = spm().snapshot();
+
+	// Construct prefix[start] and prefix[end - 1], and look them up.
+	char* element = spm().alloc<char>(len);
+	memcpy(element, name, i);
+	DebugVariant f = find(element, i + printIndex(&element[i], start));
+	DebugVariant l = find(element, i + printIndex(&element[i], end - 1U));
+
+	if(f.rangeTo(l) == end - start) {
+		first = f;
+		count = end - start;
+	}
+
+	return true;
+}
+
 /*!
  * \brief Register a store to this Debugger.
  *
@@ -217,6 +315,10 @@ Debugger::AliasMap& Debugger::aliases()
 
 /*!
  * \brief Returns the defined macros.
+ *
+ * When using Config::FixedCapacityContainers, the map only holds the
+ * location of the definitions in #macroBuffer().  Use #defineMacro() and
+ * #eraseMacro() to modify the macros in that case.
  */
 Debugger::MacroMap const& Debugger::macros() const
 {
@@ -231,6 +333,111 @@ Debugger::MacroMap& Debugger::macros()
 	return m_macros;
 }
 
+/*!
+ * \brief Returns the buffer that holds all macro definitions.
+ *
+ * The buffer is only used when using Config::FixedCapacityContainers.
+ * \see #macros()
+ */
+String::type const& Debugger::macroBuffer() const
+{
+	return m_macroBuffer;
+}
+
+// Without Config::FixedCapacityContainers, every macro has its own string.
+static inline char const* macroData(String::type const& macro, String::type const& /*buffer*/)
+{
+	return macro.data();
+}
+
+static inline size_t macroSize(String::type const& macro)
+{
+	return macro.size();
+}
+
+template <typename M>
+static void macroRelease(M& /*macros*/, String::type& /*buffer*/, String::type& /*macro*/)
+{}
+
+template <typename M>
+static void macroStore(
+	M& /*macros*/, String::type& /*buffer*/, String::type& macro, char const* definition,
+	size_t len)
+{
+	macro.assign(definition, len);
+}
+
+// With Config::FixedCapacityContainers, all macros share the same buffer.
+static inline char const* macroData(impl::DebuggerMacro const& macro, String::type const& buffer)
+{
+	return &buffer[macro.offset];
+}
+
+static inline size_t macroSize(impl::DebuggerMacro const& macro)
+{
+	return macro.size;
+}
+
+template <typename M>
+static void macroRelease(M& macros, String::type& buffer, impl::DebuggerMacro& macro)
+{
+	// Remove the definition, and move the others to fill the gap.
+	buffer.erase(macro.offset, macro.size);
+	for(typename M::iterator it = macros.begin(); it != macros.end(); ++it)
+		if(it->second.offset > macro.offset)
+			it->second.offset -= macro.size;
+
+	macro.size = 0;
+}
+
+template <typename M>
+static void macroStore(
+	M& macros, String::type& buffer, impl::DebuggerMacro& macro, char const* definition,
+	size_t len)
+{
+	macroRelease(macros, buffer, macro);
+	macro.offset = buffer.size();
+	macro.size = len;
+	buffer.append(definition, len);
+}
+
+/*!
+ * \brief Define or replace a macro.
+ * \return \c false when the total size of all definitions would exceed Config::DebuggerMacro
+ */
+bool Debugger::defineMacro(char m, char const* definition, size_t len)
+{
+	MacroMap::iterator it = m_macros.find(m);
+	size_t oldlen = it == m_macros.end() ? 0 : macroSize(it->second);
+
+	if(m_macroSize - oldlen + len > (size_t)Config::DebuggerMacro)
+		return false;
+
+	if(it == m_macros.end())
+		it = m_macros.insert(MacroMap::value_type(m, MacroMap::mapped_type())).first;
+
+	macroStore(m_macros, m_macroBuffer, it->second, definition, len);
+	m_macroSize = m_macroSize - oldlen + len;
+	return true;
+}
+
+/*!
+ * \brief Remove the given macro, if it exists.
+ */
+void Debugger::eraseMacro(char m)
+{
+	MacroMap::iterator it = m_macros.find(m);
+	if(it == m_macros.end())
+		return;
+
+	size_t size = macroSize(it->second);
+	stored_assert(size <= m_macroSize);
+	m_macroSize -= size;
+
+	macroRelease(m_macros, m_macroBuffer, it->second);
+	m_macros.erase(it);
+}
+
 /*!
  * \brief Iterates over the directory and invoke a callback for every object.
  * \param f the callback to invoke
@@ -371,6 +578,14 @@ void Debugger::process(void const* frame, size_t len, ProtocolLayer& response)
 	if(unlikely(!frame || len == 0))
 		return;
 
+	if(m_spmPool && !ScratchPadScope::current()) {
+		// Process this request using a ScratchPad from the pool.
+		ScratchPadPool::Lease lease(*m_spmPool);
+		ScratchPadScope scope(*lease);
+		Debugger::process(frame, len, response);
+		return;
+	}
+
 	ScratchPad<>::Snapshot snapshot = spm().snapshot();
 
 	char const* p = static_cast<char const*>(frame);
@@ -396,13 +611,35 @@ void Debugger::process(void const* frame, size_t len, ProtocolLayer& response)
 		if(!Config::DebuggerRead)
 			goto error;
 
-		DebugVariant v = find(++p, --len);
+		// Try a slice first, as find() ignores the trailing [start:end].
+		DebugVariant v;
+		size_t count = 0;
+		if(!findSlice(++p, --len, v, count))
+			v = find(p, len);
 		if(unlikely(!v.valid()))
 			goto error;
 
 		if(v.isVariable())
 			response.setPurgeableResponse();
 
+		if(count) {
+			// A slice of an array: all elements, full width, concatenated.
+			size_t size = v.size();
+			char* data = spm().alloc<char>(size * count);
+			if(!v.getRange(data, count))
+				goto error;
+
+			char* hex = spm().alloc<char>(size * count * 2U);
+			for(size_t i = 0; i < count; i++) {
+				void* e = data + i * size;
+				size_t elen = size;
+				encodeHex(v.type(), e, elen, false);
+				memcpy(hex + i * size * 2U, e, elen);
+			}
+			response.encode(hex, size * count * 2U, true);
+			return;
+		}
+
 		size_t size = v.size();
 		void* data = spm().alloc<char>(size);
 		size = v.get(data, size);
@@ -431,7 +668,32 @@ void Debugger::process(void const* frame, size_t len, ProtocolLayer& response)
 
 		size_t valuelen =
 			(size_t)(static_cast<char const*>(p) - static_cast<char const*>(value));
-		DebugVariant variant = find(p, len);
+		DebugVariant variant;
+		size_t count = 0;
+		if(findSlice(p, len, variant, count)) {
+			if(!count)
+				goto error;
+
+			// A slice of an array: all elements, full width, concatenated.
+			size_t size = variant.size();
+			if(valuelen != size * count * 2U)
+				goto error;
+
+			char* data = spm().alloc<char>(size * count);
+			for(size_t i = 0; i < count; i++) {
+				void const* e = static_cast<char const*>(value) + i * size * 2U;
+				size_t elen = size * 2U;
+				if(!decodeHex(variant.type(), e, elen))
+					goto error;
+				memcpy(data + i * size, e, elen);
+			}
+
+			if(!variant.setRange(data, count))
+				goto error;
+			break;
+		}
+
+		variant = find(p, len);
 		if(!variant.valid())
 			goto error;
 
@@ -531,39 +793,12 @@ void Debugger::process(void const* frame, size_t len, ProtocolLayer& response)
 		char m = p[1];
 		if(len == 2) {
 			// Erase macro
-			MacroMap::iterator it = macros().find(m);
-			if(it != macros().end()) {
-				stored_assert(it->second.size() <= m_macroSize);
-				m_macroSize -= it->second.size();
-				macros().erase(it);
-			}
+			eraseMacro(m);
 			break;
 		}
 
-		p += 2;
-		len -= 2;
-
-		MacroMap::iterator it = macros().find(m);
-		if(it == macros().end()) {
-			// New macro.
-			size_t newlen = len + m_macroSize;
-			if(newlen > Config::DebuggerMacro)
-				goto error;
-
-			std::pair<MacroMap::iterator, bool> inserted =
-				macros().insert(MacroMap::value_type(m, String::type()));
-			inserted.first->second.append(p, len);
-			m_macroSize = newlen;
-		} else {
-			// Update existing macro.
-			size_t newlen = len + m_macroSize - it->second.size();
-			if(newlen > Config::DebuggerMacro)
-				goto error;
-
-			it->second.clear();
-			it->second.append(p, len);
-			m_macroSize = newlen;
-		}
+		if(!defineMacro(m, p + 2, len - 2))
+			goto error;
 		break;
 	}
 	case CmdIdentification: {
@@ -708,7 +943,7 @@ void Debugger::process(void const* frame, size_t len, ProtocolLayer& response)
 			if(!decodeHex(Type::Blob, w, wlen))
 				goto error;
 			memcpy(addr, w, wlen);
-			addr += chunk;
+			addr += wlen;
 			p += chunk;
 			len -= chunk;
 		}
@@ -909,49 +1144,43 @@ public:
  */
 bool Debugger::runMacro(char m, ProtocolLayer& response)
 {
-	MacroMap::iterator it = macros().find(m);
+	MacroMap::const_iterator it = macros().find(m);
 
 	if(it == macros().end())
 		// Unknown macro.
 		return false;
 
-	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
-	String::type const& definition = const_cast<String::type const&>(it->second);
+	size_t size = macroSize(it->second);
 
 	// Expect the separator and at least one char to execute.
-	if(definition.size() < 2)
+	if(size < 2)
 		// Nothing to do.
 		return true;
 
+	// The macro may (re)define macros, which moves or frees the
+	// definitions. Execute a copy instead.
+	ScratchPad<>::Snapshot snapshot = spm().snapshot();
+	char* definition = spm().alloc<char>(size);
+	memcpy(definition, macroData(it->second, m_macroBuffer), size);
+
 	char sep = definition[0];
 
 	FrameMerger merger(response);
 
 	size_t pos = 0;
 	do {
-		size_t nextpos = definition.find(sep, ++pos);
-		size_t len = 0;
-		if(nextpos == String::type::npos)
-			len = definition.size() - pos;
-		else
-			len = nextpos - pos;
+		pos++;
+		char const* next =
+			static_cast<char const*>(memchr(&definition[pos], sep, size - pos));
+		size_t len = next ? (size_t)(next - &definition[pos]) : size - pos;
 		process(&definition[pos], len, merger);
-		pos = nextpos;
-	} while(pos != String::type::npos);
+		pos += len;
+	} while(pos < size);
 
 	response.encode();
 	return true;
 }
 
-/*!
- * \brief Encode the 4 LSb into ASCII hex.
- */
-static char encodeNibble(uint8_t n)
-{
-	n &= 0xfu;
-	return (char)((n < 10 ? '0' : 'a' - 10) + n);
-}
-
 /*!
  * \brief Encode data to ASCII hex.
  *
@@ -989,56 +1218,37 @@ void Debugger::encodeHex(Type::type type, void*& data, size_t& len, bool shortes
 
 	char* hex = spm().alloc<char>(len * 2 + 1);
 
-	if(Type::isFixed(type)) {
+	if(Type::isFixed(type) && len <= sizeof(uint64_t)) {
 		// big endian
-		for(size_t i = 0; i < len; i++, src++) {
+		uint8_t be[sizeof(uint64_t)];
 #ifdef STORED_LITTLE_ENDIAN
-			hex[(len - i) * 2 - 2] = encodeNibble((uint8_t)(*src >> 4u));
-			hex[(len - i) * 2 - 1] = encodeNibble(*src);
+		memcpy_swap(be, src, len);
 #else
-			hex[i * 2] = encodeNibble(*src >> 4u);
-			hex[i * 2 + 1] = encodeNibble(*src);
+		memcpy(be, src, len);
 #endif
-		}
+		size_t skip = 0;
 
-		len *= 2;
-
-		if(shortest && Type::isInt(type))
-			for(; len > 1 && hex[0] == '0'; len--, hex++)
+		if(shortest && Type::isInt(type)) {
+			// Skip leading zero bytes, and a leading zero nibble.
+			for(; skip + 1 < len && !be[skip]; skip++)
 				;
+			len = encode_hex(hex, be + skip, len - skip);
+			if(hex[0] == '0' && len > 1) {
+				hex++;
+				len--;
+			}
+		} else {
+			len = encode_hex(hex, be, len);
+		}
 	} else {
 		// just a byte sequence in hex
-		for(size_t i = 0; i < len; i++, src++) {
-			hex[i * 2] = encodeNibble((uint8_t)(*src >> 4u));
-			hex[i * 2 + 1] = encodeNibble(*src);
-		}
-
-		len *= 2;
+		len = encode_hex(hex, src, len);
 	}
 
 	hex[len] = 0;
 	data = hex;
 }
 
-/*!
- * \brief Decode a nibble.
- * \param c the nibble to decode in ASCII hex
- * \param ok will be set to \c false when decoding failed. The value is untouched when decoding was
- * successful.
- */
-static uint8_t decodeNibble(char c, bool& ok)
-{
-	if(c >= '0' && c <= '9')
-		return (uint8_t)(c - '0');
-	if(c >= 'A' && c <= 'F')
-		return (uint8_t)(c - 'A' + 10);
-	if(c >= 'a' && c <= 'f')
-		return (uint8_t)(c - 'a' + 10);
-
-	ok = false;
-	return 0;
-}
-
 /*!
  * \brief Decode ASCII hex.
  * \see #encodeHex(stored::Type::type, void*&, size_t&, bool)
@@ -1062,30 +1272,31 @@ bool Debugger::decodeHex(Type::type type, void const*& data, size_t& len)
 		bin = spm().alloc<uint8_t>(binlen);
 		memset(bin, 0, binlen);
 
-		for(size_t i = 0; i < len; i++) {
-			uint8_t b = decodeNibble(src[len - i - 1], ok);
-			if(i & 1u)
-				b = (uint8_t)(b << 4u);
+		// Decode big endian, aligned to the right.
+		uint8_t* b = bin + binlen - (len + 1) / 2;
+
+		if(len & 1u) {
+			// Odd number of nibbles; the first one is the low nibble of a byte.
+			char pad[2] = {'0', src[0]};
+			ok = decode_hex(b, pad, 2);
+			b++;
+			src++;
+			len--;
+		}
+
+		ok = decode_hex(b, src, len) && ok;
 
 #ifdef STORED_LITTLE_ENDIAN
-			bin[i / 2] |= b;
-#else
-			bin[(len - i - 1) / 2] |= b;
+		swap_endian(bin, binlen);
 #endif
-		}
 	} else {
 		if(len & 1u)
 			// Bytes must come in pair of nibbles.
 			return false;
 
-		binlen = (len + 1) / 2;
+		binlen = len / 2;
 		bin = spm().alloc<uint8_t>(binlen);
-
-		for(size_t i = 0; i + 1 < len; i += 2) {
-			bin[i / 2] = (uint8_t)(
-				(uint8_t)(decodeNibble(src[i], ok) << 4u)
-				| decodeNibble(src[i + 1], ok));
-		}
+		ok = decode_hex(bin, src, len);
 	}
 
 	data = bin;
@@ -1095,10 +1306,290 @@ bool Debugger::decodeHex(Type::type type, void const*& data, size_t& len)
 
 /*!
  * \brief Returns a scratch pad memory.
+ *
+ * This is the ScratchPad of the current ScratchPadScope, or the Debugger's
+ * own one when there is no scope.
  */
 ScratchPad<>& Debugger::spm() const
 {
-	return m_scratchpad;
+	ScratchPad<>* spm = ScratchPadScope::current();
+	return likely(!spm) ? m_scratchpad : *spm;
+}
+
+/*!
+ * \brief Set the pool to get a ScratchPad from for every request.
+ *
+ * When set, #process() acquires a ScratchPad from the pool, unless a
+ * ScratchPadScope is already active in the current thread.  This allows
+ * calling #process() concurrently from multiple threads, as long as the
+ * requests do not modify the Debugger itself, such as defining aliases,
+ * macros, streams or tracing.  Reading and writing objects is fine.
+ *
+ * The pool must outlive the Debugger, or be reset by passing \c nullptr.
+ */
+void Debugger::setScratchPadPool(ScratchPadPool* pool)
+{
+	m_spmPool = pool;
+}
+
+/*!
+ * \brief Returns the pool as set by #setScratchPadPool().
+ */
+ScratchPadPool* Debugger::scratchPadPool() const
+{
+	return m_spmPool;
+}
+
+namespace {
+// The ScratchPad of the innermost ScratchPadScope.
+#ifdef STORED_HAVE_THREADS
+thread_local ScratchPad<>* currentScratchPad;
+#else
+ScratchPad<>* currentScratchPad;
+#endif
+} // namespace
+
+/*!
+ * \brief Enter the scope.
+ */
+Debugger::ScratchPadScope::ScratchPadScope(ScratchPad<>& spm) noexcept
+	: m_prev(currentScratchPad)
+{
+	currentScratchPad = &spm;
+}
+
+/*!
+ * \brief Leave the scope.
+ */
+Debugger::ScratchPadScope::~ScratchPadScope()
+{
+	currentScratchPad = m_prev;
+}
+
+/*!
+ * \brief Returns the ScratchPad of the innermost scope of the current thread, if any.
+ */
+ScratchPad<>* Debugger::ScratchPadScope::current() noexcept
+{
+	return currentScratchPad;
+}
+
+
+
+/////////////////////////////
+// ScratchPadPool
+//
+
+namespace {
+// All existing pools, such that a thread can check if the pool of its cached
+// pad still exists.  Both are constant-initialized.
+ScratchPadPool* scratchPadPools = nullptr;
+#ifdef STORED_HAVE_THREADS
+std::mutex scratchPadPoolsMutex;
+std::atomic<uint64_t> scratchPadPoolId{0};
+#else
+uint64_t scratchPadPoolId = 0;
+#endif
+} // namespace
+
+namespace impl {
+/*!
+ * \brief The pad a thread released last, and the pool it belongs to.
+ *
+ * When the thread exits, the pad is returned to its pool.
+ */
+class ScratchPadPoolCache {
+	STORED_CLASS_NOCOPY(ScratchPadPoolCache)
+public:
+	ScratchPadPoolCache() noexcept;
+	~ScratchPadPoolCache();
+
+	void flush() noexcept;
+
+	ScratchPadPool* pool;
+	uint64_t id;
+	ScratchPadPool::Pad* pad;
+};
+} // namespace impl
+
+namespace {
+#ifdef STORED_HAVE_THREADS
+// This flag is trivially destructible, so it can still be read during thread
+// destruction, after the cache itself is gone.
+thread_local bool scratchPadPoolCacheDestroyed;
+#else
+bool scratchPadPoolCacheDestroyed;
+#endif
+
+impl::ScratchPadPoolCache* scratchPadPoolCache() noexcept
+{
+	if(unlikely(scratchPadPoolCacheDestroyed))
+		return nullptr;
+
+#ifdef STORED_HAVE_THREADS
+	static thread_local impl::ScratchPadPoolCache cache;
+#else
+	static impl::ScratchPadPoolCache cache;
+#endif
+	return &cache;
+}
+} // namespace
+
+impl::ScratchPadPoolCache::ScratchPadPoolCache() noexcept
+	: pool()
+	, id()
+	, pad()
+{}
+
+impl::ScratchPadPoolCache::~ScratchPadPoolCache()
+{
+	flush();
+	scratchPadPoolCacheDestroyed = true;
+}
+
+/*!
+ * \brief Return the cached pad to its pool, if that pool still exists.
+ */
+void impl::ScratchPadPoolCache::flush() noexcept
+{
+	if(!pad)
+		return;
+
+	ScratchPadPool::Pad* p = pad;
+	pad = nullptr;
+
+#ifdef STORED_HAVE_THREADS
+	std::lock_guard<std::mutex> lock(scratchPadPoolsMutex);
+#endif
+	for(ScratchPadPool* q = scratchPadPools; q; q = q->m_next)
+		if(q == pool && q->m_id == id) {
+			q->giveBack(*p);
+			break;
+		}
+}
+
+/*!
+ * \brief Ctor.
+ * \param reserve the number of bytes to reserve in every new ScratchPad
+ */
+ScratchPadPool::ScratchPadPool(size_t reserve)
+	: m_reserve(reserve)
+	, m_id(++scratchPadPoolId)
+	, m_next()
+{
+#ifdef STORED_HAVE_THREADS
+	std::lock_guard<std::mutex> lock(scratchPadPoolsMutex);
+#endif
+	m_next = scratchPadPools;
+	scratchPadPools = this;
+}
+
+/*!
+ * \brief Dtor.
+ * \details All pads must have been released.
+ */
+ScratchPadPool::~ScratchPadPool()
+{
+	{
+#ifdef STORED_HAVE_THREADS
+		std::lock_guard<std::mutex> lock(scratchPadPoolsMutex);
+#endif
+		for(ScratchPadPool** q = &scratchPadPools; *q; q = &(*q)->m_next)
+			if(*q == this) {
+				*q = m_next;
+				break;
+			}
+	}
+
+	impl::ScratchPadPoolCache* cache = scratchPadPoolCache();
+	if(cache && cache->pool == this && cache->id == m_id)
+		cache->pad = nullptr;
+
+	for(Vector<Pad*>::type::iterator it = m_all.begin(); it != m_all.end(); ++it) {
+		(*it)->~Pad();
+		deallocate<Pad>(*it);
+	}
+}
+
+/*!
+ * \brief Get a ScratchPad, which is not used by someone else.
+ *
+ * Return it via #release().
+ */
+ScratchPadPool::Pad& ScratchPadPool::acquire()
+{
+	impl::ScratchPadPoolCache* cache = scratchPadPoolCache();
+	if(likely(cache && cache->pad && cache->pool == this && cache->id == m_id)) {
+		Pad* pad = cache->pad;
+		cache->pad = nullptr;
+		return *pad;
+	}
+
+#ifdef STORED_HAVE_THREADS
+	std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+	if(!m_free.empty()) {
+		Pad* pad = m_free.back();
+		m_free.pop_back();
+		return *pad;
+	}
+
+	// Make sure that giveBack() does not need to allocate.  Do this while
+	// holding the lock, as concurrent acquire()s would reserve too little
+	// otherwise.
+	m_all.reserve(m_all.size() + 1U);
+	m_free.reserve(m_all.size() + 1U);
+
+	Pad* pad = new(allocate<Pad>()) Pad(m_reserve);
+	m_all.push_back(pad);
+	return *pad;
+}
+
+/*!
+ * \brief Return a ScratchPad that was returned by #acquire().
+ */
+void ScratchPadPool::release(Pad& pad) noexcept
+{
+	pad.reset();
+
+	impl::ScratchPadPoolCache* cache = scratchPadPoolCache();
+	if(likely(cache)) {
+		if(unlikely(cache->pad && (cache->pool != this || cache->id != m_id)))
+			// The thread moved on to this pool.
+			cache->flush();
+
+		if(likely(!cache->pad)) {
+			// Keep it for the next request of this thread.
+			cache->pool = this;
+			cache->id = m_id;
+			cache->pad = &pad;
+			return;
+		}
+	}
+
+	giveBack(pad);
+}
+
+/*!
+ * \brief Put a released pad in the free list.
+ */
+void ScratchPadPool::giveBack(Pad& pad) noexcept
+{
+#ifdef STORED_HAVE_THREADS
+	std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+	m_free.push_back(&pad);
+}
+
+/*!
+ * \brief Returns the total number of pads that were created by this pool.
+ */
+size_t ScratchPadPool::pads() const
+{
+#ifdef STORED_HAVE_THREADS
+	std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+	return m_all.size();
 }
 
 /*!
@@ -1207,12 +1698,10 @@ Stream<>* Debugger::stream(char s, bool alloc)
 			    ++it2)
 				if(it2->second->empty()) {
 					// Got one.
-					if(!recycle) {
+					if(!recycle)
 						recycle = it2->second;
-					} else {
-						// NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
-						delete it2->second;
-					}
+					else
+						deleteStream(it2->second);
 
 					m_streams.erase(it2);
 					cleaned = true;
@@ -1222,9 +1711,11 @@ Stream<>* Debugger::stream(char s, bool alloc)
 
 		if(m_streams.size() < Config::DebuggerStreams) {
 			// Add a new stream.
-			return m_streams
-				.insert(std::make_pair(s, recycle ? recycle : new Stream<>()))
-				.first->second;
+			if(!recycle)
+				recycle = newStream();
+			if(!recycle)
+				return nullptr;
+			return m_streams.insert(std::make_pair(s, recycle)).first->second;
 		} else {
 			// Out of buffers.
 			stored_assert(!recycle);
@@ -1234,6 +1725,40 @@ Stream<>* Debugger::stream(char s, bool alloc)
 		return nullptr;
 }
 
+/*!
+ * \brief Get a Stream instance that is not in use.
+ *
+ * With Config::FixedCapacityContainers, this is one of the preallocated
+ * instances.
+ */
+Stream<>* Debugger::newStream()
+{
+	if(!Config::FixedCapacityContainers)
+		// NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+		return new Stream<>();
+
+	if(m_spareStreams.empty())
+		return nullptr;
+
+	Stream<>* s = m_spareStreams.back();
+	m_spareStreams.pop_back();
+	return s;
+}
+
+/*!
+ * \brief Release a Stream instance that was returned by #newStream().
+ */
+void Debugger::deleteStream(Stream<>* s)
+{
+	if(!Config::FixedCapacityContainers) {
+		delete s; // NOLINT(cppcoreguidelines-owning-memory)
+		return;
+	}
+
+	s->clear();
+	m_spareStreams.push_back(s);
+}
+
 /*!
  * \brief Gets the existing streams.
  * \param buffer an #spm() allocated buffer with stream names
@@ -9,6 +9,7 @@
 
 #include <libstored/directory.h>
 
+#include <cstdio>
 #include <string>
 
 using stored::impl::decodeInt;
@@ -43,6 +44,29 @@ list(void* container, void* buffer, uint8_t const* directory, ListCallbackArg* f
 							 : static_cast<char*>(buffer) + offset;
 			f(container, name.c_str(), type, b, len, arg);
 			break;
+		} else if(*p == 0x7fu) {
+			// array, list all elements
+			p++;
+			size_t count = decodeInt<size_t>(p);
+			Type::type type = (Type::type)(*p++ ^ 0x80u);
+			size_t offset = decodeInt<size_t>(p);
+			size_t len = Type::size(type);
+
+			if(name.empty() || name[name.size() - 1] != '[') {
+				name.push_back('[');
+				erase++;
+			}
+
+			char index[24];
+			for(size_t i = 0; i < count; i++) {
+				int n = snprintf(index, sizeof(index), "%u]", (unsigned int)i);
+				stored_assert(n > 0 && (size_t)n < sizeof(index));
+				name.append(index, (size_t)n);
+				f(container, name.c_str(), type,
+				  static_cast<char*>(buffer) + offset + i * len, len, arg);
+				name.erase(name.size() - (size_t)n);
+			}
+			break;
 		} else if(*p <= 0x1f) {
 			// skip
 			name.append(*p, '?');
@@ -103,4 +127,73 @@ void list(
 	list(container, buffer, directory, f, arg, name);
 }
 
+/*!
+ * \brief Implementation for stored::impl::arrayRemaining().
+ * \private
+ */
+static size_t
+arrayRemaining(uint8_t const* p, size_t offset, Type::type type, size_t size) noexcept
+{
+	while(true) {
+		if(*p == 0 || *p >= 0x80) {
+			// end or var
+			return 0;
+		} else if(*p == 0x7fu) {
+			// array
+			p++;
+			size_t count = decodeInt<size_t>(p);
+			Type::type t = (Type::type)(*p++ ^ 0x80u);
+			size_t start = decodeInt<size_t>(p);
+
+			if(t != type || offset < start || (offset - start) % size != 0
+			   || (offset - start) / size >= count)
+				return 0;
+
+			return count - (offset - start) / size;
+		} else if(*p <= 0x1f || *p == '/') {
+			// skip or hierarchy separator
+			p++;
+		} else {
+			// char
+			p++;
+
+			// take jmp_l
+			uintptr_t jmp = decodeInt<uintptr_t>(p);
+			size_t res = arrayRemaining(p + jmp - 1, offset, type, size);
+			if(res)
+				return res;
+
+			// take jmp_g
+			jmp = decodeInt<uintptr_t>(p);
+			res = arrayRemaining(p + jmp - 1, offset, type, size);
+			if(res)
+				return res;
+		}
+	}
+}
+
+namespace impl {
+
+/*!
+ * \brief Returns the number of elements from the given one up to the end of its array.
+ *
+ * All 0x7f entries in the directory are checked for an array of \p type
+ * that holds an element at \p offset.
+ *
+ * \param directory the binary directory, to be parsed
+ * \param offset the offset of the element in the store's buffer
+ * \param type the type of the element
+ * \return the number of elements, including the one at \p offset, or 0 when
+ *	\p offset is not an element of an array
+ * \see #stored::Variant::arrayRemaining()
+ */
+size_t arrayRemaining(uint8_t const* directory, size_t offset, Type::type type) noexcept
+{
+	if(unlikely(!directory || !Type::isFixed(type)))
+		return 0;
+
+	return stored::arrayRemaining(directory, offset, type, Type::size(type));
+}
+
+} // namespace impl
 } // namespace stored
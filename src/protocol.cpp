@@ -23,6 +23,16 @@
 #	include <termios.h>
 #endif
 
+#if defined(STORED_OS_LINUX) && STORED_cplusplus >= 201103L
+#	include <sys/mman.h>
+#	include <sys/socket.h>
+#	include <sys/stat.h>
+#	include <sys/un.h>
+
+#	include <atomic>
+#	include <thread>
+#endif
+
 #if defined(STORED_OS_WINDOWS)
 // NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
 #	define write(fd, buffer, count) _write(fd, buffer, (unsigned int)(count))
@@ -1647,7 +1657,7 @@ int PolledFileLayer::block(
 	}
 
 	while(true) {
-		Poller::Result const& pres = poller.poll((int)(timeout_us / 1000L));
+		Poller::Result const& pres = poller.poll(timeout_us < 0 ? -1 : (int)(timeout_us / 1000L));
 
 		if(pres.empty()) {
 			if(timeout_us <= 0 && errno == EINTR)
@@ -3379,4 +3389,513 @@ int SerialLayer::resetAutoBaud()
 }
 #endif // STORED_OS_POSIX
 
+
+
+#if defined(STORED_OS_LINUX) && STORED_cplusplus >= 201103L
+//////////////////////////////
+// ShmLayer
+//
+
+/*!
+ * \brief Control block of one direction of a #stored::ShmLayer.
+ *
+ * Positions are free-running; the index in the ring is the position modulo
+ * the (power of two) ring size.  The producer and consumer fields are in
+ * separate cache lines.
+ */
+struct ShmLayer::Ring {
+	/*! \brief Write position; owned by the producer. */
+	alignas(64) std::atomic<uint32_t> head;
+	/*! \brief Read position; owned by the consumer. */
+	alignas(64) std::atomic<uint32_t> tail;
+	/*! \brief Set by the consumer when it wants to be woken up on new data. */
+	alignas(64) std::atomic<uint32_t> dataWaiting;
+	/*! \brief Set by the producer when it wants to be woken up on free space. */
+	std::atomic<uint32_t> spaceWaiting;
+};
+
+/*!
+ * \brief Layout of the shared memory of a #stored::ShmLayer.
+ *
+ * The structure is followed by the data of both rings.
+ */
+struct ShmLayer::Shm {
+	enum : uint32_t { Magic = 0x53544d31 /* STM1 */ };
+
+	/*! \brief #Magic, when the creator finished initialization. */
+	std::atomic<uint32_t> magic;
+	/*! \brief Size of the data of one ring. */
+	uint32_t size;
+	/*! \brief Ring 0 is written by the creator, ring 1 by the other side. */
+	Ring ring[2];
+};
+
+namespace {
+/*!
+ * \brief Every message in the ring is prefixed by its length, and padded to this alignment.
+ */
+inline uint32_t shmAlign(uint32_t x)
+{
+	return (x + 3U) & ~3U;
+}
+
+/*!
+ * \brief Fill \p addr with the abstract Unix socket address of the doorbell of the given side.
+ * \return the length of the address, or 0 when the name is too long
+ */
+socklen_t shmBellAddr(sockaddr_un& addr, char const* name, int side)
+{
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+
+	// The first byte of sun_path is left 0, which makes it an abstract address.
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+	int len = snprintf(
+		&addr.sun_path[1], sizeof(addr.sun_path) - 1, "libstored-shm%s.%d", name, side);
+
+	if(len < 0 || (size_t)len >= sizeof(addr.sun_path) - 1)
+		return 0;
+
+	return (socklen_t)(offsetof(sockaddr_un, sun_path) + 1U + (size_t)len);
+}
+} // namespace
+
+/*!
+ * \brief Ctor.
+ *
+ * The shared memory object is identified by \p name, which must start with a
+ * slash (see \c shm_open()).  The side that passes \p create as \c true
+ * creates and initializes the object, using \p size bytes (rounded up to a
+ * power of two) per ring.  It must be constructed before the other side,
+ * which uses the size as set by the creator.
+ *
+ * It sets #lastError() appropriately.  It is \c EAGAIN when the creator has
+ * not initialized the object yet.
+ */
+ShmLayer::ShmLayer(
+	char const* name, bool create, size_t size, ProtocolLayer* up, ProtocolLayer* down)
+	: base(up, down)
+	, m_name(name ? name : "")
+	, m_create(create)
+	, m_shm()
+	, m_mapSize()
+	, m_bell(-1)
+	, m_side(create ? 0 : 1)
+	, m_txLen()
+	, m_txDrop()
+	, m_armed()
+{
+	int fd = -1;
+	bool created = false;
+	void* map = nullptr;
+	sockaddr_un addr; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+	socklen_t addrLen = 0;
+
+	errno = 0;
+
+	if(create) {
+		size_t ringSize = 64;
+		while(ringSize < size && ringSize < 0x40000000U)
+			ringSize <<= 1U;
+
+		m_mapSize = sizeof(Shm) + 2U * ringSize;
+
+		// NOLINTNEXTLINE(hicpp-signed-bitwise)
+		if((fd = shm_open(m_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600)) == -1)
+			goto error;
+
+		created = true;
+
+		if(ftruncate(fd, (off_t)m_mapSize) == -1)
+			goto error;
+	} else {
+		// NOLINTNEXTLINE(hicpp-signed-bitwise)
+		if((fd = shm_open(m_name.c_str(), O_RDWR, 0)) == -1)
+			goto error;
+
+		struct stat st = {};
+		if(fstat(fd, &st) == -1)
+			goto error;
+
+		m_mapSize = (size_t)st.st_size;
+		if(m_mapSize < sizeof(Shm)) {
+			// The creator is not ready yet.
+			errno = EAGAIN;
+			goto error;
+		}
+	}
+
+	// NOLINTNEXTLINE(hicpp-signed-bitwise)
+	map = mmap(nullptr, m_mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	fd = -1;
+
+	if(map == MAP_FAILED) // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+		goto error;
+
+	if(create) {
+		m_shm = new(map) Shm();
+		m_shm->size = (uint32_t)(m_mapSize - sizeof(Shm)) / 2U;
+		m_shm->magic.store(Shm::Magic, std::memory_order_release);
+	} else {
+		m_shm = static_cast<Shm*>(map);
+		uint32_t magic = m_shm->magic.load(std::memory_order_acquire);
+		if(!magic) {
+			// The creator is not ready yet.
+			errno = EAGAIN;
+			goto error;
+		}
+
+		if(magic != Shm::Magic || sizeof(Shm) + 2U * (size_t)m_shm->size != m_mapSize) {
+			errno = EPROTO;
+			goto error;
+		}
+	}
+
+	if(!(addrLen = shmBellAddr(addr, m_name.c_str(), m_side))) {
+		errno = ENAMETOOLONG;
+		goto error;
+	}
+
+	// NOLINTNEXTLINE(hicpp-signed-bitwise)
+	if((m_bell = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) == -1)
+		goto error;
+
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+	if(bind(m_bell, reinterpret_cast<sockaddr const*>(&addr), addrLen) == -1)
+		goto error;
+
+	if(!create)
+		// Tell the creator we are here, in case it is waiting already.
+		ringBell(0);
+
+	setLastError(0);
+	return;
+
+error:
+	int e = errno ? errno : EBADF;
+	if(fd != -1)
+		::close(fd);
+	if(!m_shm && map && map != MAP_FAILED) // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+		munmap(map, m_mapSize);
+	if(created && !m_shm)
+		// close_() only unlinks when mapped.
+		shm_unlink(m_name.c_str());
+	close_();
+	setLastError(e);
+}
+
+/*!
+ * \brief Dtor.
+ *
+ * It calls #close_(), not #close() as the latter is virtual.
+ */
+ShmLayer::~ShmLayer()
+{
+	close_();
+}
+
+/*!
+ * \brief Virtual wrapper around #close_().
+ */
+void ShmLayer::close()
+{
+	close_();
+}
+
+/*!
+ * \brief Unmap the shared memory, and close the doorbell.
+ *
+ * The creator also unlinks the shared memory object.
+ */
+void ShmLayer::close_()
+{
+	if(m_shm) {
+		munmap(m_shm, m_mapSize);
+		m_shm = nullptr;
+
+		if(m_create)
+			shm_unlink(m_name.c_str());
+	}
+
+	if(m_bell != -1) {
+		::close(m_bell);
+		m_bell = -1;
+	}
+
+	base::close();
+}
+
+/*!
+ * \brief Checks if the shared memory is mapped.
+ */
+bool ShmLayer::isOpen() const
+{
+	return m_shm;
+}
+
+/*!
+ * \brief Returns the doorbell socket, which is readable when #recv() has data.
+ */
+ShmLayer::fd_type ShmLayer::fd() const
+{
+	return m_bell;
+}
+
+/*!
+ * \brief Returns the maximum message size, which is limited by the ring size.
+ */
+size_t ShmLayer::mtu() const
+{
+	return m_shm ? (size_t)(m_shm->size - sizeof(uint32_t)) : 0;
+}
+
+/*!
+ * \brief Returns the control block of the ring that is written by the given side.
+ */
+ShmLayer::Ring& ShmLayer::ring(int side) const
+{
+	stored_assert(m_shm);
+	return m_shm->ring[side];
+}
+
+/*!
+ * \brief Returns the data of the ring that is written by the given side.
+ */
+char* ShmLayer::ringData(int side) const
+{
+	stored_assert(m_shm);
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+	return reinterpret_cast<char*>(m_shm) + sizeof(Shm) + (size_t)side * m_shm->size;
+}
+
+/*!
+ * \brief Wake up the given side.
+ */
+void ShmLayer::ringBell(int side)
+{
+	sockaddr_un addr; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+	socklen_t addrLen = shmBellAddr(addr, m_name.c_str(), side);
+
+	// This fails when the other side does not exist (yet), or when its
+	// doorbell is still full of pending rings. In both cases, it will check
+	// the rings anyway.
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+	sendto(m_bell, "", 1, MSG_DONTWAIT | MSG_NOSIGNAL, reinterpret_cast<sockaddr const*>(&addr),
+	       addrLen);
+}
+
+/*!
+ * \brief Discard a pending ring of our doorbell.
+ *
+ * Normally, there is only one ring pending, as the other side only rings
+ * when the doorbell was armed. Any excess ring results in a spurious wakeup
+ * later on, which is harmless.
+ */
+void ShmLayer::drainBell()
+{
+	char buf[16]; // NOLINT(cppcoreguidelines-avoid-c-arrays,hicpp-avoid-c-arrays)
+	(void)::recv(m_bell, buf, sizeof(buf), MSG_DONTWAIT);
+}
+
+/*!
+ * \brief Wait till the transmit ring has \p len bytes of free space, counted from \p head.
+ * \return \c true on success, \c false on error, which is set in #lastError()
+ */
+bool ShmLayer::waitForSpace(ShmLayer::Ring& r, uint32_t head, uint32_t len)
+{
+	uint32_t size = m_shm->size;
+
+	while(size - (head - r.tail.load(std::memory_order_acquire)) < len) {
+		r.spaceWaiting.store(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		if(size - (head - r.tail.load(std::memory_order_acquire)) >= len)
+			break;
+
+		if(block(m_bell, true, -1))
+			return false;
+
+		drainBell();
+
+		// The drained rings may have been for received data. Make sure the
+		// fd() stays readable in that case.
+		Ring& rx = ring(1 - m_side);
+		if(m_armed
+		   && rx.head.load(std::memory_order_acquire)
+			      != rx.tail.load(std::memory_order_relaxed))
+			ringBell(m_side);
+	}
+
+	return true;
+}
+
+/*!
+ * \copydoc stored::ProtocolLayer::encode(void const*, size_t, bool)
+ * \details The message is published to the other side when \p last is \c true.
+ *	Encoding blocks while the ring is full.  Messages longer than #mtu() are
+ *	dropped, and set #lastError() to \c EMSGSIZE.
+ */
+void ShmLayer::encode(void const* buffer, size_t len, bool last)
+{
+	if(unlikely(!m_shm)) {
+		setLastError(EBADF);
+	} else if(unlikely(m_txDrop)) {
+		// Dropping the rest of this message.
+	} else if((uint64_t)m_txLen + len + sizeof(uint32_t) > m_shm->size) {
+		m_txDrop = true;
+		m_txLen = 0;
+		setLastError(EMSGSIZE);
+	} else {
+		Ring& r = ring(m_side);
+		char* data = ringData(m_side);
+		uint32_t size = m_shm->size;
+		uint32_t mask = size - 1U;
+		uint32_t head = r.head.load(std::memory_order_relaxed);
+		uint32_t end = m_txLen + (uint32_t)len;
+
+		if(!waitForSpace(r, head, shmAlign((uint32_t)sizeof(uint32_t) + end))) {
+			m_txDrop = true;
+			m_txLen = 0;
+		} else {
+			// Copy payload, possibly wrapping around the end of the ring.
+			uint32_t offset = (head + (uint32_t)sizeof(uint32_t) + m_txLen) & mask;
+			size_t chunk = std::min<size_t>(len, size - offset);
+			memcpy(data + offset, buffer, chunk);
+			memcpy(data, static_cast<char const*>(buffer) + chunk, len - chunk);
+			m_txLen = end;
+
+			if(last) {
+				// The header is aligned, so it never wraps.
+				memcpy(data + (head & mask), &end, sizeof(end));
+				r.head.store(
+					head + shmAlign((uint32_t)sizeof(uint32_t) + end),
+					std::memory_order_release);
+				m_txLen = 0;
+
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if(r.dataWaiting.load(std::memory_order_relaxed)
+				   && r.dataWaiting.exchange(0))
+					ringBell(1 - m_side);
+			}
+
+			setLastError(0);
+		}
+	}
+
+	if(last)
+		m_txDrop = false;
+
+	base::encode(buffer, len, last);
+}
+
+/*!
+ * \brief Decode all messages in the receive ring.
+ * \param timeout_us if zero, this function does not block. -1 blocks indefinitely.
+ * \return 0 on success, otherwise an errno
+ */
+int ShmLayer::recv(long timeout_us)
+{
+	if(!m_shm)
+		return setLastError(EBADF);
+
+	Ring& r = ring(1 - m_side);
+	char* data = ringData(1 - m_side);
+	uint32_t size = m_shm->size;
+	uint32_t mask = size - 1U;
+	bool got = false;
+
+	// Spinning only makes sense when the other side can run in parallel.
+	static bool const spin = std::thread::hardware_concurrency() > 1;
+
+	if(m_armed) {
+		drainBell();
+		r.dataWaiting.store(0, std::memory_order_relaxed);
+		m_armed = false;
+	}
+
+	while(true) {
+		uint32_t tail = r.tail.load(std::memory_order_relaxed);
+		uint32_t head = r.head.load(std::memory_order_acquire);
+
+		if(head != tail) {
+			got = true;
+
+			while(tail != head) {
+				uint32_t len = 0;
+				memcpy(&len, data + (tail & mask), sizeof(len));
+
+				if(unlikely(len > size - sizeof(uint32_t))) {
+					// Corrupt.
+					close();
+					return setLastError(EPROTO);
+				}
+
+				uint32_t offset = (tail + (uint32_t)sizeof(uint32_t)) & mask;
+				if(likely(offset + len <= size)) {
+					// Decode in place.
+					decode(data + offset, len);
+				} else {
+					m_rxBuffer.resize(len);
+					size_t chunk = size - offset;
+					memcpy(m_rxBuffer.data(), data + offset, chunk);
+					memcpy(m_rxBuffer.data() + chunk, data, len - chunk);
+					decode(m_rxBuffer.data(), len);
+				}
+
+				tail += shmAlign((uint32_t)sizeof(uint32_t) + len);
+				r.tail.store(tail, std::memory_order_release);
+
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if(r.spaceWaiting.load(std::memory_order_relaxed)
+				   && r.spaceWaiting.exchange(0))
+					ringBell(1 - m_side);
+
+				if(unlikely(!m_shm))
+					// Closed while decoding.
+					return setLastError(EBADF);
+			}
+
+			continue;
+		}
+
+		if(!got && timeout_us != 0 && spin) {
+			// We are going to block anyway. Spin shortly, as the other
+			// side may be just about to respond. This saves the round trip
+			// via the doorbell.
+			for(int i = 0; i < SpinCount; i++) {
+				if(r.head.load(std::memory_order_relaxed) != tail)
+					break;
+				std::atomic_signal_fence(std::memory_order_seq_cst);
+			}
+
+			if(r.head.load(std::memory_order_acquire) != tail)
+				continue;
+		}
+
+		// Empty. Arm the doorbell, such that fd() becomes readable on new data.
+		r.dataWaiting.store(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		m_armed = true;
+
+		if(r.head.load(std::memory_order_acquire) != tail)
+			// Got something in the mean time.
+			continue;
+
+		if(got)
+			return setLastError(0);
+
+		if(timeout_us == 0)
+			return setLastError(EAGAIN);
+
+		if(block(m_bell, true, timeout_us))
+			return lastError();
+
+		drainBell();
+		r.dataWaiting.store(0, std::memory_order_relaxed);
+		m_armed = false;
+	}
+}
+#endif // STORED_OS_LINUX && C++11
+
 } // namespace stored
@@ -23,19 +23,29 @@ namespace stored {
  * \param hash the hash of the store
  * \param buffer the buffer of the store
  * \param size the size of \p buffer
- */
-StoreJournal::StoreJournal(char const* hash, void* buffer, size_t size)
+ * \param keySize the result of #keySize() for \p size, as precomputed by the
+ *	generator, or 0 to compute it here
+ * \param objectSize when not \c nullptr, returns the size of the fixed-length
+ *	variable at a given key, which is used to recognize ranges of array
+ *	elements in #decodeUpdates()
+ */
+StoreJournal::StoreJournal(
+	char const* hash, void* buffer, size_t size, uint8_t keySize,
+	ObjectSizeCallback* objectSize)
 	: m_hash(hash)
 	, m_buffer(buffer)
 	, m_bufferSize(size)
-	, m_keySize(keySize(m_bufferSize))
+	, m_keySize(keySize ? keySize : StoreJournal::keySize(m_bufferSize))
 	, m_seq(1)
 	, m_seqLower()
 	, m_partialSeq()
+	, m_objectSize(objectSize)
+	, m_maxRange()
 {
 	// Size is 32 bit, where size_t might be 64. But I guess that the
 	// store is never >4G in size...
 	stored_assert(size < std::numeric_limits<Size>::max());
+	stored_assert(m_keySize == StoreJournal::keySize(m_bufferSize));
 }
 
 /*!
@@ -99,11 +109,16 @@ StoreJournal::Seq StoreJournal::bumpSeq(bool force)
 		for(size_t i = 0; i < m_changes.size(); i++) {
 			ObjectInfo& o = m_changes[i];
 			Seq o_seq = toLong(o.seq);
+			Seq o_rangeSeq = toLong(o.rangeSeq);
+			if(m_seq - o_rangeSeq > safeRange) {
+				o.rangeSeq = toShort(m_seqLower);
+				o_rangeSeq = m_seqLower;
+			}
 			if(m_seq - o_seq > safeRange) {
 				update(o.key, o.len, m_seqLower, 0, m_changes.size());
 				seqLower = m_seqLower;
 			} else
-				seqLower = std::min(seqLower, o_seq);
+				seqLower = std::min(seqLower, std::min(o_seq, o_rangeSeq));
 		}
 
 		m_seqLower = seqLower;
@@ -164,13 +179,81 @@ void StoreJournal::changed(StoreJournal::Key key, size_t len, bool insertIfNew)
 	}
 }
 
+/*!
+ * \brief Record a batch of changes at once.
+ *
+ * Only entries that have changed are recorded.  When the entries are sorted
+ * by buffer address, the tree is traversed once, instead of a lookup per
+ * key.  Otherwise, every entry is looked up separately.
+ */
+void StoreJournal::changed(BatchEntry const* batch, size_t count)
+{
+	size_t changes = 0;
+	bool sorted = true;
+	for(size_t i = 0; i < count; i++) {
+		if(batch[i].changed)
+			changes++;
+		if(i > 0 && (uintptr_t)batch[i - 1].buffer > (uintptr_t)batch[i].buffer)
+			sorted = false;
+	}
+
+	if(!changes)
+		return;
+
+	m_partialSeq = true;
+
+	if(likely(sorted) && likely(update(batch, count, seq(), 0, m_changes.size()) == changes))
+		return;
+
+	// Unsorted, or some keys are new, which is only a startup effect.
+	for(size_t i = 0; i < count; i++)
+		if(batch[i].changed)
+			changed((Key)((uintptr_t)batch[i].buffer - (uintptr_t)m_buffer), batch[i].len);
+}
+
+/*!
+ * \brief Record a change of a range of array elements.
+ *
+ * The range is recorded as one entry, at the key of the first element, with
+ * \p len being the size of that element.  #encodeUpdates() sends the whole
+ * range to a connection that did not see this change yet.  #hasChanged() and
+ * #iterateChanged() report every element in the range.
+ *
+ * \param key the key of the first element
+ * \param len the size of one element
+ * \param range the size of all elements in the range
+ * \param insertIfNew when \c true, record the change, even if it is not in the journal yet
+ */
+void StoreJournal::changedRange(StoreJournal::Key key, size_t len, size_t range, bool insertIfNew)
+{
+	stored_assert(len > 0 && len <= range);
+
+	m_partialSeq = true;
+	m_maxRange = std::max(m_maxRange, (Size)range);
+
+	if(!update(key, len, seq(), 0, m_changes.size(), range) && insertIfNew) {
+		m_changes.
+#if STORED_cplusplus >= 201103L
+			emplace_back
+#else
+			push_back
+#endif
+			(ObjectInfo(key, (Size)len, toShort(seq()), (Size)range));
+		regenerate();
+	}
+}
+
 /*!
  * \brief Update the meta data of the given key.
  * \details This function does a binary search through \c m_changes, limited by [lower,upper[.
+ *	When \p range is larger than \p len, a range of array elements starting at
+ *	\p key has changed.  The range is kept apart from \p len, which remains the
+ *	size of the object itself.
  * \return \c true of successful, \c false if key is unknown
  */
 bool StoreJournal::update(
-	StoreJournal::Key key, size_t len, StoreJournal::Seq seq, size_t lower, size_t upper)
+	StoreJournal::Key key, size_t len, StoreJournal::Seq seq, size_t lower, size_t upper,
+	size_t range)
 {
 	if(lower >= upper)
 		return false;
@@ -183,11 +266,61 @@ bool StoreJournal::update(
 	if(o.key == key) {
 		o.seq = toShort(seq);
 		o.len = (Size)len;
+		if(range > len) {
+			// An earlier range may not have been sent to all
+			// connections yet, so do not shrink it.
+			o.range = std::max(o.range, (Size)range);
+			o.rangeSeq = o.seq;
+		}
 		return true;
 	} else if(key < o.key)
-		return update(key, len, seq, lower, pivot);
+		return update(key, len, seq, lower, pivot, range);
 	else
-		return update(key, len, seq, pivot + 1, upper);
+		return update(key, len, seq, pivot + 1, upper, range);
+}
+
+/*!
+ * \brief Update the meta data of the given sorted batch.
+ * \details The batch is split at every pivot of \c m_changes, limited by [lower,upper[.
+ * \return the number of changed entries that were found
+ */
+size_t StoreJournal::update(
+	BatchEntry const* batch, size_t count, StoreJournal::Seq seq, size_t lower, size_t upper)
+{
+	if(lower >= upper || count == 0)
+		return 0;
+
+	size_t pivot = (upper - lower) / 2 + lower;
+	ObjectInfo& o = m_changes[pivot];
+	uintptr_t pivotBuffer = (uintptr_t)m_buffer + o.key;
+
+	// Find [l,r[ of the entries of this object.
+	size_t l = 0;
+	size_t r = count;
+	while(l < r) {
+		size_t m = (r - l) / 2 + l;
+		if((uintptr_t)batch[m].buffer < pivotBuffer)
+			l = m + 1;
+		else
+			r = m;
+	}
+
+	size_t found = 0;
+	for(r = l; r < count && (uintptr_t)batch[r].buffer == pivotBuffer; r++) {
+		if(batch[r].changed) {
+			o.seq = toShort(seq);
+			o.len = (Size)batch[r].len;
+			found++;
+		}
+	}
+
+	found += update(batch, l, seq, lower, pivot);
+	found += update(batch + r, count - r, seq, pivot + 1, upper);
+
+	if(found)
+		o.highest = toShort(seq);
+
+	return found;
 }
 
 /*!
@@ -235,9 +368,12 @@ bool StoreJournal::hasChanged(Key key, Seq since) const
 		ObjectInfo const& o = m_changes[pivot];
 
 		if(toLong(o.highest) < since)
-			return false;
-		if(o.key == key)
-			return toLong(o.seq) >= since;
+			break;
+		if(o.key == key) {
+			if(toLong(o.seq) >= since)
+				return true;
+			break;
+		}
 
 		if(o.key > key)
 			upper = pivot;
@@ -245,6 +381,31 @@ bool StoreJournal::hasChanged(Key key, Seq since) const
 			lower = pivot + 1;
 	}
 
+	// The key may be an element of a range that was written at once.
+	return m_maxRange && rangeChanged(key, since);
+}
+
+/*!
+ * \brief Checks if a range of array elements that covers the given key has
+ *	changed since the given sequence number.
+ */
+bool StoreJournal::rangeChanged(Key key, Seq since) const
+{
+	// Walk back from the last entry at or before the key, as long as a
+	// range that starts there could cover the key.
+	size_t i = (size_t)(std::upper_bound(
+				    m_changes.begin(), m_changes.end(), ObjectInfo(key, 0, 0),
+				    ObjectInfoComparator())
+			    - m_changes.begin());
+
+	for(; i > 0; i--) {
+		ObjectInfo const& o = m_changes[i - 1];
+		if(key - o.key >= m_maxRange)
+			break;
+		if(o.range > key - o.key && toLong(o.rangeSeq) >= since)
+			return true;
+	}
+
 	return false;
 }
 
@@ -266,7 +427,8 @@ bool StoreJournal::hasChanged(Seq since) const
  * \brief Iterate all changes since the given seq.
  *
  * The callback \p will receive the Key of the object that has changed
- * since the given seq, and the supplied \p arg.
+ * since the given seq, and the supplied \p arg.  Every element of a changed
+ * range of array elements is reported once, in order of the keys.
  */
 void StoreJournal::iterateChanged(
 	StoreJournal::Seq since, IterateChangedCallback* cb, void* arg) const
@@ -274,15 +436,17 @@ void StoreJournal::iterateChanged(
 	if(!cb)
 		return;
 
-	iterateChanged(since, cb, arg, 0, m_changes.size());
+	Key next = 0;
+	iterateChanged(since, cb, arg, 0, m_changes.size(), next);
 }
 
 /*!
  * \brief Implementation of #iterateChanged()
+ * \param next the lowest key that was not reported yet
  */
 void StoreJournal::iterateChanged(
 	StoreJournal::Seq since, IterateChangedCallback* cb, void* arg, size_t lower,
-	size_t upper) const
+	size_t upper, Key& next) const
 {
 	if(lower >= upper)
 		return;
@@ -292,10 +456,19 @@ void StoreJournal::iterateChanged(
 	if(toLong(o.highest) < since)
 		return;
 
-	iterateChanged(since, cb, arg, lower, pivot);
-	if(toLong(o.seq) >= since)
+	iterateChanged(since, cb, arg, lower, pivot, next);
+
+	if(o.range > o.len && toLong(o.rangeSeq) >= since) {
+		for(Key k = o.key; k < o.key + o.range; k += o.len)
+			if(k >= next)
+				cb(k, arg);
+		next = std::max(next, o.key + o.range);
+	} else if(toLong(o.seq) >= since && o.key >= next) {
 		cb(o.key, arg);
-	iterateChanged(since, cb, arg, pivot + 1, upper);
+		next = o.key + 1U;
+	}
+
+	iterateChanged(since, cb, arg, pivot + 1, upper, next);
 }
 
 /*!
@@ -398,7 +571,8 @@ StoreJournal::Seq StoreJournal::decodeBuffer(void*& buffer, size_t& len)
 StoreJournal::Seq
 StoreJournal::encodeUpdates(ProtocolLayer& p, StoreJournal::Seq sinceSeq, bool last)
 {
-	encodeUpdates(p, sinceSeq, 0, m_changes.size());
+	Key covered = 0;
+	encodeUpdates(p, sinceSeq, 0, m_changes.size(), covered);
 	if(last)
 		p.encode();
 	return bumpSeq();
@@ -406,9 +580,12 @@ StoreJournal::encodeUpdates(ProtocolLayer& p, StoreJournal::Seq sinceSeq, bool l
 
 /*!
  * \brief Implementation of #encodeUpdates().
+ * \param covered the end of the range of array elements that was sent last, as
+ *	objects within that range do not have to be sent again
  */
 void StoreJournal::encodeUpdates(
-	ProtocolLayer& p, StoreJournal::Seq sinceSeq, size_t lower, size_t upper)
+	ProtocolLayer& p, StoreJournal::Seq sinceSeq, size_t lower, size_t upper,
+	StoreJournal::Key& covered)
 {
 	if(lower >= upper)
 		return;
@@ -418,20 +595,26 @@ void StoreJournal::encodeUpdates(
 	if(toLong(o.highest) < sinceSeq)
 		return;
 
-	encodeUpdates(p, sinceSeq, lower, pivot);
-	if(toLong(o.seq) >= sinceSeq)
-		encodeUpdate(p, o);
-	encodeUpdates(p, sinceSeq, pivot + 1, upper);
+	encodeUpdates(p, sinceSeq, lower, pivot, covered);
+	if(toLong(o.seq) >= sinceSeq && !(o.key < covered && o.key + o.len <= covered))
+		covered = o.key + encodeUpdate(p, o, sinceSeq);
+	encodeUpdates(p, sinceSeq, pivot + 1, upper, covered);
 }
 
 /*!
  * \brief Encode one change.
+ * \details When a range of array elements starting at this object has changed
+ *	since \p sinceSeq, the whole range is sent.
+ * \return the number of bytes of the buffer that were sent
  */
-void StoreJournal::encodeUpdate(ProtocolLayer& p, StoreJournal::ObjectInfo& o)
+StoreJournal::Size StoreJournal::encodeUpdate(
+	ProtocolLayer& p, StoreJournal::ObjectInfo& o, StoreJournal::Seq sinceSeq)
 {
+	Size len = o.range > o.len && toLong(o.rangeSeq) >= sinceSeq ? o.range : o.len;
 	encodeKey(p, o.key);
-	encodeKey(p, o.len);
-	p.encode(keyToBuffer(o.key), o.len, false);
+	encodeKey(p, len);
+	p.encode(keyToBuffer(o.key), len, false);
+	return len;
 }
 
 /*!
@@ -454,7 +637,13 @@ StoreJournal::Seq StoreJournal::decodeUpdates(void*& buffer, size_t& len, bool r
 		memcpy(obj, buffer_, size);
 		buffer_ += size;
 		len -= size;
-		changed(key, size, recordAll);
+
+		Size element = m_objectSize ? m_objectSize(key) : 0;
+		if(element && element < size)
+			// A range of array elements.
+			changedRange(key, element, size, recordAll);
+		else
+			changed(key, size, recordAll);
 	}
 
 	return bumpSeq();
@@ -19,6 +19,17 @@
 #	include <cinttypes>
 #endif
 
+#if defined(__AVX2__)
+#	define STORED_SIMD_AVX2
+#	include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define STORED_SIMD_SSE2
+#	include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#	define STORED_SIMD_NEON
+#	include <arm_neon.h>
+#endif
+
 namespace stored {
 
 /*!
@@ -169,6 +180,334 @@ String::type string_literal(void const* buffer, size_t len, char const* prefix)
 	return s;
 }
 
+/*!
+ * \brief Lookup table for #encode_hex().
+ */
+static char const hex_digits[] = "0123456789abcdef";
+
+/*!
+ * \brief Lookup table for #decode_hex(), which maps ASCII to a nibble, or 0xff when invalid.
+ */
+static uint8_t const hex_values[256] = {
+	// clang-format off
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0,    1,    2,    3,    4,    5,    6,    7,    8,    9,    0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 10,   11,   12,   13,   14,   15,   0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 10,   11,   12,   13,   14,   15,   0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	// clang-format on
+};
+
+#if defined(STORED_SIMD_AVX2) || defined(STORED_SIMD_SSE2)
+/*!
+ * \brief Convert nibbles (0-15) in every byte to lower case ASCII hex.
+ */
+static inline __m128i encode_hex_nibbles(__m128i n)
+{
+	__m128i gt9 = _mm_cmpgt_epi8(n, _mm_set1_epi8(9));
+	return _mm_add_epi8(
+		_mm_add_epi8(n, _mm_set1_epi8('0')), _mm_and_si128(gt9, _mm_set1_epi8('a' - '0' - 10)));
+}
+
+/*!
+ * \brief Convert ASCII hex in every byte to nibbles.
+ * \param c the characters
+ * \param valid all bits of a byte are cleared when the corresponding character is invalid
+ */
+static inline __m128i decode_hex_nibbles(__m128i c, __m128i& valid)
+{
+	__m128i d = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+	__m128i isd = _mm_and_si128(
+		_mm_cmpgt_epi8(d, _mm_set1_epi8(-1)), _mm_cmplt_epi8(d, _mm_set1_epi8(10)));
+	__m128i l = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+	__m128i isl = _mm_and_si128(
+		_mm_cmpgt_epi8(l, _mm_set1_epi8(-1)), _mm_cmplt_epi8(l, _mm_set1_epi8(6)));
+	valid = _mm_and_si128(valid, _mm_or_si128(isd, isl));
+	return _mm_or_si128(
+		_mm_and_si128(isd, d), _mm_and_si128(isl, _mm_add_epi8(l, _mm_set1_epi8(10))));
+}
+#endif
+
+#ifdef STORED_SIMD_AVX2
+/*! \copydoc encode_hex_nibbles(__m128i) */
+static inline __m256i encode_hex_nibbles(__m256i n)
+{
+	__m256i gt9 = _mm256_cmpgt_epi8(n, _mm256_set1_epi8(9));
+	return _mm256_add_epi8(
+		_mm256_add_epi8(n, _mm256_set1_epi8('0')),
+		_mm256_and_si256(gt9, _mm256_set1_epi8('a' - '0' - 10)));
+}
+
+/*! \copydoc decode_hex_nibbles(__m128i, __m128i&) */
+static inline __m256i decode_hex_nibbles(__m256i c, __m256i& valid)
+{
+	__m256i d = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+	__m256i isd = _mm256_andnot_si256(
+		_mm256_cmpgt_epi8(d, _mm256_set1_epi8(9)),
+		_mm256_cmpgt_epi8(d, _mm256_set1_epi8(-1)));
+	__m256i l = _mm256_sub_epi8(
+		_mm256_or_si256(c, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+	__m256i isl = _mm256_andnot_si256(
+		_mm256_cmpgt_epi8(l, _mm256_set1_epi8(5)),
+		_mm256_cmpgt_epi8(l, _mm256_set1_epi8(-1)));
+	valid = _mm256_and_si256(valid, _mm256_or_si256(isd, isl));
+	return _mm256_or_si256(
+		_mm256_and_si256(isd, d),
+		_mm256_and_si256(isl, _mm256_add_epi8(l, _mm256_set1_epi8(10))));
+}
+#endif
+
+#ifdef STORED_SIMD_NEON
+/*! \brief Convert nibbles (0-15) in every byte to lower case ASCII hex. */
+static inline uint8x16_t encode_hex_nibbles(uint8x16_t n)
+{
+	uint8x16_t gt9 = vcgtq_u8(n, vdupq_n_u8(9));
+	return vaddq_u8(vaddq_u8(n, vdupq_n_u8('0')), vandq_u8(gt9, vdupq_n_u8('a' - '0' - 10)));
+}
+
+/*!
+ * \brief Convert ASCII hex in every byte to nibbles.
+ * \param c the characters
+ * \param valid all bits of a byte are cleared when the corresponding character is invalid
+ */
+static inline uint8x16_t decode_hex_nibbles(uint8x16_t c, uint8x16_t& valid)
+{
+	uint8x16_t d = vsubq_u8(c, vdupq_n_u8('0'));
+	uint8x16_t isd = vcltq_u8(d, vdupq_n_u8(10));
+	uint8x16_t l = vsubq_u8(vorrq_u8(c, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+	uint8x16_t isl = vcltq_u8(l, vdupq_n_u8(6));
+	valid = vandq_u8(valid, vorrq_u8(isd, isl));
+	return vorrq_u8(vandq_u8(isd, d), vandq_u8(isl, vaddq_u8(l, vdupq_n_u8(10))));
+}
+#endif
+
+/*!
+ * \brief Encode the given buffer as lower case ASCII hex.
+ *
+ * Every byte results in two characters, the most significant nibble first.
+ * The output is not zero-terminated.  Depending on the platform, SSE2/AVX2
+ * or NEON is used.
+ *
+ * \param dst the output buffer, which must be able to hold \p len * 2 characters
+ * \param src the data to encode
+ * \param len the number of bytes of \p src
+ * \return the number of characters written to \p dst
+ */
+size_t encode_hex(char* __restrict__ dst, void const* __restrict__ src, size_t len) noexcept
+{
+	stored_assert(len == 0 || (dst && src));
+
+	uint8_t const* s = static_cast<uint8_t const*>(src);
+	size_t i = 0;
+
+#ifdef STORED_SIMD_AVX2
+	for(; i + 32U <= len; i += 32U) {
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(s + i));
+		__m256i lo = _mm256_and_si256(v, _mm256_set1_epi8(0xf));
+		__m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0xf));
+		hi = encode_hex_nibbles(hi);
+		lo = encode_hex_nibbles(lo);
+		// unpack works per 128-bit lane, so fix the lane order afterwards.
+		__m256i a = _mm256_unpacklo_epi8(hi, lo);
+		__m256i b = _mm256_unpackhi_epi8(hi, lo);
+		_mm256_storeu_si256(
+			reinterpret_cast<__m256i*>(dst + i * 2U), _mm256_permute2x128_si256(a, b, 0x20));
+		_mm256_storeu_si256(
+			reinterpret_cast<__m256i*>(dst + i * 2U + 32U),
+			_mm256_permute2x128_si256(a, b, 0x31));
+	}
+#endif
+#if defined(STORED_SIMD_AVX2) || defined(STORED_SIMD_SSE2)
+	for(; i + 16U <= len; i += 16U) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(s + i));
+		__m128i lo = _mm_and_si128(v, _mm_set1_epi8(0xf));
+		__m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0xf));
+		hi = encode_hex_nibbles(hi);
+		lo = encode_hex_nibbles(lo);
+		_mm_storeu_si128(
+			reinterpret_cast<__m128i*>(dst + i * 2U), _mm_unpacklo_epi8(hi, lo));
+		_mm_storeu_si128(
+			reinterpret_cast<__m128i*>(dst + i * 2U + 16U), _mm_unpackhi_epi8(hi, lo));
+	}
+#endif
+#ifdef STORED_SIMD_NEON
+	for(; i + 16U <= len; i += 16U) {
+		uint8x16_t v = vld1q_u8(s + i);
+		uint8x16x2_t hex;
+		hex.val[0] = encode_hex_nibbles(vshrq_n_u8(v, 4));
+		hex.val[1] = encode_hex_nibbles(vandq_u8(v, vdupq_n_u8(0xf)));
+		// vst2 interleaves both vectors.
+		vst2q_u8(reinterpret_cast<uint8_t*>(dst + i * 2U), hex);
+	}
+#endif
+
+	for(; i < len; i++) {
+		dst[i * 2U] = hex_digits[s[i] >> 4U];
+		dst[i * 2U + 1U] = hex_digits[s[i] & 0xfU];
+	}
+
+	return len * 2U;
+}
+
+/*!
+ * \brief Decode ASCII hex into the given buffer.
+ *
+ * This is the inverse of #encode_hex().  Both upper and lower case
+ * characters are accepted.
+ *
+ * \param dst the output buffer, which must be able to hold \p len / 2 bytes
+ * \param src the ASCII hex characters
+ * \param len the number of characters in \p src, which must be even
+ * \return \c true when all characters were valid, \c false otherwise (\p dst is filled anyway)
+ */
+bool decode_hex(void* __restrict__ dst, char const* __restrict__ src, size_t len) noexcept
+{
+	stored_assert(len == 0 || (dst && src));
+	stored_assert(!(len & 1U));
+
+	uint8_t* d = static_cast<uint8_t*>(dst);
+	size_t i = 0;
+	bool ok = true;
+
+#ifdef STORED_SIMD_AVX2
+	{
+		__m256i valid = _mm256_set1_epi8(-1);
+		for(; i + 64U <= len; i += 64U) {
+			__m256i a = decode_hex_nibbles(
+				_mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + i)), valid);
+			__m256i b = decode_hex_nibbles(
+				_mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + i + 32U)),
+				valid);
+			// Even bytes hold the high nibble, odd bytes the low one.
+			a = _mm256_or_si256(
+				_mm256_and_si256(_mm256_slli_epi16(a, 4), _mm256_set1_epi16(0xf0)),
+				_mm256_srli_epi16(a, 8));
+			b = _mm256_or_si256(
+				_mm256_and_si256(_mm256_slli_epi16(b, 4), _mm256_set1_epi16(0xf0)),
+				_mm256_srli_epi16(b, 8));
+			// packus works per 128-bit lane, so fix the order afterwards.
+			_mm256_storeu_si256(
+				reinterpret_cast<__m256i*>(d + i / 2U),
+				_mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8));
+		}
+		ok = _mm256_movemask_epi8(valid) == -1;
+	}
+#endif
+#if defined(STORED_SIMD_AVX2) || defined(STORED_SIMD_SSE2)
+	{
+		__m128i valid = _mm_set1_epi8(-1);
+		for(; i + 32U <= len; i += 32U) {
+			__m128i a = decode_hex_nibbles(
+				_mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i)), valid);
+			__m128i b = decode_hex_nibbles(
+				_mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i + 16U)), valid);
+			// Even bytes hold the high nibble, odd bytes the low one.
+			a = _mm_or_si128(
+				_mm_and_si128(_mm_slli_epi16(a, 4), _mm_set1_epi16(0xf0)),
+				_mm_srli_epi16(a, 8));
+			b = _mm_or_si128(
+				_mm_and_si128(_mm_slli_epi16(b, 4), _mm_set1_epi16(0xf0)),
+				_mm_srli_epi16(b, 8));
+			_mm_storeu_si128(
+				reinterpret_cast<__m128i*>(d + i / 2U), _mm_packus_epi16(a, b));
+		}
+		ok = ok && _mm_movemask_epi8(valid) == 0xffff;
+	}
+#endif
+#ifdef STORED_SIMD_NEON
+	{
+		uint8x16_t valid = vdupq_n_u8(0xff);
+		for(; i + 32U <= len; i += 32U) {
+			// vld2 deinterleaves the high and low nibbles.
+			uint8x16x2_t hex = vld2q_u8(reinterpret_cast<uint8_t const*>(src + i));
+			uint8x16_t hi = decode_hex_nibbles(hex.val[0], valid);
+			uint8x16_t lo = decode_hex_nibbles(hex.val[1], valid);
+			vst1q_u8(d + i / 2U, vorrq_u8(vshlq_n_u8(hi, 4), lo));
+		}
+		uint8x8_t v = vand_u8(vget_low_u8(valid), vget_high_u8(valid));
+		ok = vget_lane_u64(vreinterpret_u64_u8(v), 0) == ~(uint64_t)0;
+	}
+#endif
+
+	uint8_t invalid = 0;
+	for(; i + 1U < len; i += 2U) {
+		uint8_t hi = hex_values[(uint8_t)src[i]];
+		uint8_t lo = hex_values[(uint8_t)src[i + 1U]];
+		invalid |= (uint8_t)(hi | lo);
+		d[i / 2U] = (uint8_t)((uint8_t)(hi << 4U) | (lo & 0xfU));
+	}
+
+	return ok && !(invalid & 0xf0U);
+}
+
+/*!
+ * \brief Returns the offset of the first byte that differs between \p a and \p b.
+ *
+ * The buffers are compared per SIMD register when AVX2, SSE2 or NEON is
+ * available, and per machine word otherwise.
+ *
+ * \return the offset, or \p len when the buffers are equal
+ */
+size_t memdiff(void const* a, void const* b, size_t len) noexcept
+{
+	stored_assert(len == 0 || (a && b));
+
+	uint8_t const* a_ = static_cast<uint8_t const*>(a);
+	uint8_t const* b_ = static_cast<uint8_t const*>(b);
+	size_t i = 0;
+
+#ifdef STORED_SIMD_AVX2
+	for(; i + 32U <= len; i += 32U) {
+		__m256i va = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(a_ + i));
+		__m256i vb = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(b_ + i));
+		if(_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)) != -1)
+			break;
+	}
+#endif
+#if defined(STORED_SIMD_AVX2) || defined(STORED_SIMD_SSE2)
+	for(; i + 16U <= len; i += 16U) {
+		__m128i va = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a_ + i));
+		__m128i vb = _mm_loadu_si128(reinterpret_cast<__m128i const*>(b_ + i));
+		if(_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) != 0xffff)
+			break;
+	}
+#endif
+#ifdef STORED_SIMD_NEON
+	for(; i + 16U <= len; i += 16U) {
+		uint8x16_t x = veorq_u8(vld1q_u8(a_ + i), vld1q_u8(b_ + i));
+		uint64x2_t x64 = vreinterpretq_u64_u8(x);
+		if(vgetq_lane_u64(x64, 0) | vgetq_lane_u64(x64, 1))
+			break;
+	}
+#endif
+
+	for(; i + sizeof(uintptr_t) <= len; i += sizeof(uintptr_t)) {
+		uintptr_t wa;
+		uintptr_t wb;
+		memcpy(&wa, a_ + i, sizeof(wa));
+		memcpy(&wb, b_ + i, sizeof(wb));
+		if(wa != wb)
+			break;
+	}
+
+	for(; i < len; i++)
+		if(a_[i] != b_[i])
+			return i;
+
+	return len;
+}
+
 /*!
  * \brief Return a single-line string that contains relevant configuration information of libstored.
  */
@@ -7,6 +7,7 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/.
  */
 
+#include <libstored/debugger.h>
 #include <libstored/poller.h>
 #include <libstored/protocol.h>
 
@@ -18,8 +19,10 @@
 #		include <libzth/zmq.h>
 #	endif
 
+#	include <algorithm>
 #	include <cerrno>
 #	include <cstdlib>
+#	include <cstring>
 
 #	if STORED_cplusplus < 201103L
 #		include <inttypes.h>
@@ -47,6 +50,10 @@ ZmqLayer::ZmqLayer(void* context, int type, ProtocolLayer* up, ProtocolLayer* do
 	, m_buffer()
 	, m_bufferCapacity()
 	, m_bufferSize()
+	, m_router(type == ZMQ_ROUTER)
+	, m_routing(m_router)
+	, m_envelopePending()
+	, m_dropping()
 {
 	if(!(m_socket = zmq_socket(this->context(), type)))
 		setLastError(errno);
@@ -88,6 +95,17 @@ void* ZmqLayer::socket() const
 	return m_socket;
 }
 
+/*!
+ * \brief Returns if the socket is a ROUTER socket.
+ *
+ * For ROUTER sockets, the routing envelope of a request is split off before
+ * decode(), and sent back before the first part of the response.
+ */
+bool ZmqLayer::isRouter() const
+{
+	return m_router;
+}
+
 /*!
  * \brief The ZeroMQ socket, which can be used for \c poll() or \c select().
  *
@@ -138,7 +156,7 @@ int ZmqLayer::block(bool forReading, long timeout_us, bool suspend)
 	}
 
 	while(true) {
-		Poller::Result const& pres = poller.poll((int)(timeout_us / 1000L));
+		Poller::Result const& pres = poller.poll(timeout_us < 0 ? -1 : (int)(timeout_us / 1000L));
 
 		if(pres.empty()) {
 			if(!(err = errno))
@@ -173,6 +191,7 @@ int ZmqLayer::recv1(long timeout_us)
 {
 	int res = 0;
 	int more = 0;
+	size_t msgSize = 0;
 
 	zmq_msg_t msg;
 
@@ -201,37 +220,69 @@ int ZmqLayer::recv1(long timeout_us)
 	}
 
 	more = zmq_msg_more(&msg);
+	msgSize = zmq_msg_size(&msg);
 
-	if(unlikely(m_bufferSize || more || zmq_msg_get(&msg, ZMQ_SHARED))) {
-		// Save for later processing.
-		size_t msgSize = zmq_msg_size(&msg);
-		size_t newBufferSize = m_bufferSize + msgSize;
-
-		if(newBufferSize > m_bufferCapacity) {
-			// NOLINTNEXTLINE(cppcoreguidelines-no-malloc,cppcoreguidelines-owning-memory)
-			void* p = realloc(m_buffer, newBufferSize);
-			if(!p) {
-				res = ENOMEM;
-				goto error_buffer;
+	if(unlikely(m_routing)) {
+		// Still in the routing envelope. It ends with an empty delimiter frame.
+		if(more) {
+			m_envelope.append(reinterpret_cast<char const*>(&msgSize), sizeof(msgSize));
+			m_envelope.append(static_cast<char const*>(zmq_msg_data(&msg)), msgSize);
+
+			if(!msgSize)
+				// Got the delimiter; the payload follows.
+				m_routing = false;
+
+			zmq_msg_close(&msg);
+			return setLastError(0);
+		}
+
+		// No delimiter, so the envelope is only the identity frame. The rest is payload.
+		m_routing = false;
+
+		if(m_envelope.size() > sizeof(size_t)) {
+			size_t identitySize = 0;
+			memcpy(&identitySize, m_envelope.data(), sizeof(identitySize));
+			size_t pos = sizeof(size_t) + identitySize;
+
+			while(pos + sizeof(size_t) <= m_envelope.size()) {
+				size_t frameSize = 0;
+				memcpy(&frameSize, m_envelope.data() + pos, sizeof(frameSize));
+				pos += sizeof(size_t);
+				if((res = bufferAppend(m_envelope.data() + pos, frameSize)))
+					goto error_buffer;
+				pos += frameSize;
 			}
 
-			m_buffer = p;
-			m_bufferCapacity = newBufferSize;
+			m_envelope.resize(sizeof(size_t) + identitySize);
 		}
+	}
 
-		memcpy(static_cast<char*>(m_buffer) + m_bufferSize, zmq_msg_data(&msg), msgSize);
-		m_bufferSize = newBufferSize;
+	if(unlikely(m_bufferSize || more || zmq_msg_get(&msg, ZMQ_SHARED))) {
+		// Save for later processing.
+		if((res = bufferAppend(zmq_msg_data(&msg), msgSize)))
+			goto error_buffer;
 	}
 
 	if(likely(!more)) {
+		// Send the envelope along with the response.
+		m_envelopePending = m_router;
+
 		if(likely(!m_bufferSize)) {
 			// Process immediately, without copying to the buffer.
-			decode(zmq_msg_data(&msg), zmq_msg_size(&msg));
+			decode(zmq_msg_data(&msg), msgSize);
 		} else {
 			// Process message from buffer.
 			decode(m_buffer, m_bufferSize);
 			m_bufferSize = 0;
 		}
+
+		if(m_router) {
+			// Start with a fresh envelope for the next request.
+			m_envelope.clear();
+			m_envelopePending = false;
+			m_dropping = false;
+			m_routing = true;
+		}
 	}
 
 	zmq_msg_close(&msg);
@@ -246,6 +297,31 @@ error_msg:
 	return setLastError(res);
 }
 
+/*!
+ * \brief Append the given data to #m_buffer.
+ * \return 0 on success, otherwise an \c errno
+ */
+int ZmqLayer::bufferAppend(void const* buffer, size_t len)
+{
+	size_t newBufferSize = m_bufferSize + len;
+
+	if(newBufferSize > m_bufferCapacity) {
+		// NOLINTNEXTLINE(cppcoreguidelines-no-malloc,cppcoreguidelines-owning-memory)
+		void* p = realloc(m_buffer, newBufferSize);
+		if(!p)
+			return ENOMEM;
+
+		m_buffer = p;
+		m_bufferCapacity = newBufferSize;
+	}
+
+	if(len)
+		memcpy(static_cast<char*>(m_buffer) + m_bufferSize, buffer, len);
+
+	m_bufferSize = newBufferSize;
+	return 0;
+}
+
 /*!
  * \brief Try to receive all available data from the ZeroMQ REP socket, and decode() it.
  * \param timeout_us if zero, this function does not block. -1 blocks indefinitely.
@@ -279,32 +355,80 @@ int ZmqLayer::recv(long timeout_us)
 /*!
  * \copydoc stored::ProtocolLayer::encode(void const*, size_t, bool)
  * \details Encoded data is send as REP over the ZeroMQ socket.
+ *
+ * For ROUTER sockets, the envelope of the request is sent first. If that
+ * fails, the whole response is dropped, as it cannot be routed anyway.
  */
 void ZmqLayer::encode(void const* buffer, size_t len, bool last)
+{
+	if(unlikely(m_envelopePending)) {
+		m_envelopePending = false;
+
+		char const* e = m_envelope.data();
+		size_t remaining = m_envelope.size();
+		bool partial = false;
+
+		while(remaining >= sizeof(size_t)) {
+			size_t frameSize = 0;
+			memcpy(&frameSize, e, sizeof(frameSize));
+			e += sizeof(size_t);
+			remaining -= sizeof(size_t);
+
+			if(frameSize > remaining || send(e, frameSize, true)) {
+				// Terminate the frames that were sent already, such
+				// that they are not prepended to the next response.
+				if(partial)
+					send(nullptr, 0, false);
+
+				m_dropping = true;
+				break;
+			}
+
+			partial = true;
+			e += frameSize;
+			remaining -= frameSize;
+		}
+	}
+
+	if(unlikely(m_dropping))
+		// The envelope could not be sent; skip the rest of this response.
+		m_dropping = !last;
+	else
+		send(buffer, len, !last);
+
+	base::encode(buffer, len, last);
+}
+
+/*!
+ * \brief Send one frame over the socket.
+ * \param more when \c true, pass \c ZMQ_SNDMORE
+ * \return 0 on success, otherwise an \c errno
+ */
+int ZmqLayer::send(void const* buffer, size_t len, bool more)
 {
 	// First try, assume we are writable.
 	// NOLINTNEXTLINE(hicpp-signed-bitwise,cppcoreguidelines-pro-type-cstyle-cast)
-	if(likely(zmq_send(m_socket, (void*)buffer, len, ZMQ_DONTWAIT | (last ? 0 : ZMQ_SNDMORE))
+	if(likely(zmq_send(m_socket, (void*)buffer, len, ZMQ_DONTWAIT | (more ? ZMQ_SNDMORE : 0))
 		  != -1)) {
 		// Success.
-		setLastError(0);
+		return setLastError(0);
 	} else if(setLastError(errno) != EAGAIN) { // NOLINT(bugprone-branch-clone)
 						   // Some other error occurred.
+		return lastError();
 	} else if(block(false)) {
 		// Socket is not writable, and blocking failed.
+		return lastError();
 	} else {
 		// Socket should be writable now. This is a blocking call,
 		// but it should not block anymore.
 		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-cstyle-cast)
-		if(zmq_send(m_socket, (void*)buffer, len, last ? 0 : ZMQ_SNDMORE) != -1)
+		if(zmq_send(m_socket, (void*)buffer, len, more ? ZMQ_SNDMORE : 0) == -1)
 			// Some error.
-			setLastError(errno);
+			return setLastError(errno);
 		else
 			// Success.
-			setLastError(0);
+			return setLastError(0);
 	}
-
-	base::encode(buffer, len, last);
 }
 
 
@@ -317,11 +441,46 @@ void ZmqLayer::encode(void const* buffer, size_t len, bool last)
  *
  * The given \p port used for a REQ/REP socket over TCP.
  * This is the listening side, where a client like the \c libstored.gui can connect to.
+ * When \p port is 0, the OS picks a free port. Query the socket's
+ * \c ZMQ_LAST_ENDPOINT option to find out which one.
  *
  * \see #stored::Debugger
  */
 DebugZmqLayer::DebugZmqLayer(void* context, int port, ProtocolLayer* up, ProtocolLayer* down)
 	: base(context, ZMQ_REP, up, down)
+	, m_mode(ModeRep)
+	, m_cacheEnabled()
+	, m_caching()
+	, m_cacheHits()
+	, m_requests()
+{
+	init(port);
+}
+
+/*!
+ * \brief Constructor.
+ *
+ * Like #DebugZmqLayer(void*,int,ProtocolLayer*,ProtocolLayer*), but the
+ * socket type is determined by the given \p mode.
+ *
+ * \see #stored::Debugger
+ */
+DebugZmqLayer::DebugZmqLayer(
+	void* context, int port, Mode mode, ProtocolLayer* up, ProtocolLayer* down)
+	: base(context, mode == ModeRouter ? ZMQ_ROUTER : ZMQ_REP, up, down)
+	, m_mode(mode)
+	, m_cacheEnabled()
+	, m_caching()
+	, m_cacheHits()
+	, m_requests()
+{
+	init(port);
+}
+
+/*!
+ * \brief Bind the socket to the given \p port.
+ */
+void DebugZmqLayer::init(int port)
 {
 	if(lastError())
 		return;
@@ -335,8 +494,137 @@ DebugZmqLayer::DebugZmqLayer(void* context, int port, ProtocolLayer* up, Protoco
 		setLastError(errno);
 }
 
+/*!
+ * \brief Returns the mode, as passed to the constructor.
+ */
+DebugZmqLayer::Mode DebugZmqLayer::mode() const
+{
+	return m_mode;
+}
+
+/*!
+ * \brief Enable or disable caching responses to read-only requests.
+ *
+ * The cache is flushed at every recv(), and by every request that is not
+ * read-only.  Note that when reading a function, it is only called once for
+ * all equal requests that are served from the cache.
+ */
+void DebugZmqLayer::setCache(bool enable)
+{
+	m_cacheEnabled = enable;
+	cacheClear();
+}
+
+/*!
+ * \brief Flush the cache, but keep its memory for the next tick.
+ */
+void DebugZmqLayer::cacheClear()
+{
+	m_cacheArena.clear();
+	m_cache.clear();
+}
+
+/*!
+ * \brief Compares a #CacheEntry to a raw request.
+ */
+struct DebugZmqLayer::CacheEntryLess {
+	char const* arena;
+
+	bool operator()(CacheEntry const& a, std::pair<char const*, size_t> const& b) const
+	{
+		return less(arena + a.offset, a.requestLen, b.first, b.second);
+	}
+
+	static bool less(char const* a, size_t alen, char const* b, size_t blen)
+	{
+		if(alen != blen)
+			return alen < blen;
+		return memcmp(a, b, alen) < 0;
+	}
+};
+
+/*!
+ * \brief Returns if caching is enabled.
+ * \see #setCache()
+ */
+bool DebugZmqLayer::cache() const
+{
+	return m_cacheEnabled;
+}
+
+/*!
+ * \brief Returns the number of requests that were served from the cache.
+ */
+size_t DebugZmqLayer::cacheHits() const
+{
+	return m_cacheHits;
+}
+
+/*!
+ * \brief Returns the total number of requests that were received.
+ */
+size_t DebugZmqLayer::requests() const
+{
+	return m_requests;
+}
+
+/*!
+ * \brief Checks if the response to the given request may be cached.
+ *
+ * Only requests that do not change the state of the store or the
+ * #stored::Debugger are cacheable.
+ */
+bool DebugZmqLayer::cacheable(void const* buffer, size_t len)
+{
+	if(!len)
+		return false;
+
+	switch(*static_cast<char const*>(buffer)) {
+	case Debugger::CmdCapabilities:
+	case Debugger::CmdRead:
+	case Debugger::CmdList:
+	case Debugger::CmdIdentification:
+	case Debugger::CmdVersion:
+		return true;
+	default:
+		return false;
+	}
+}
+
 int DebugZmqLayer::recv(long timeout_us)
 {
+	// Next tick; previously cached responses may be outdated.
+	cacheClear();
+
+	if(m_mode == ModeRouter) {
+		// Limit the number of requests per call, such that a busy client cannot
+		// starve the application. ZeroMQ fair-queues the requests of all
+		// clients.
+		size_t start = m_requests;
+		bool first = true;
+
+		while(m_requests - start < (size_t)RouterBatch) {
+			int res = recv1(first ? timeout_us : 0);
+
+			switch(res) {
+			case 0:
+				// Got more.
+				break;
+			case EAGAIN:
+				// That's it.
+				if(!first)
+					return setLastError(0);
+				STORED_FALLTHROUGH
+			default:
+				return res;
+			}
+
+			first = false;
+		}
+
+		return setLastError(0);
+	}
+
 	int res = base::recv(timeout_us);
 
 	if(res == EFSM) {
@@ -348,6 +636,64 @@ int DebugZmqLayer::recv(long timeout_us)
 	return res;
 }
 
+void DebugZmqLayer::decode(void* buffer, size_t len)
+{
+	m_requests++;
+
+	if(!m_cacheEnabled) {
+		base::decode(buffer, len);
+		return;
+	}
+
+	if(!cacheable(buffer, len)) {
+		// This request may change anything.
+		cacheClear();
+		base::decode(buffer, len);
+		return;
+	}
+
+	// Look up the raw request, such that a hit does not allocate.
+	std::pair<char const*, size_t> request(static_cast<char const*>(buffer), len);
+	CacheEntryLess less = {m_cacheArena.data()};
+	Vector<CacheEntry>::type::iterator it =
+		std::lower_bound(m_cache.begin(), m_cache.end(), request, less);
+	if(it != m_cache.end() && it->requestLen == len
+	   && memcmp(m_cacheArena.data() + it->offset, buffer, len) == 0) {
+		m_cacheHits++;
+		encode(m_cacheArena.data() + it->offset + it->requestLen, it->responseLen, true);
+		return;
+	}
+
+	// The response is appended to the arena, right after the request.
+	CacheEntry e = {m_cacheArena.size(), len, 0};
+	m_cacheArena.append(request.first, len);
+	size_t pos = (size_t)(it - m_cache.begin());
+
+	m_caching = true;
+	base::decode(buffer, len);
+
+	if(!m_caching) {
+		// Got the complete response.
+		e.responseLen = m_cacheArena.size() - e.offset - len;
+		m_cache.insert(m_cache.begin() + (std::ptrdiff_t)pos, e);
+	} else {
+		m_cacheArena.resize(e.offset);
+	}
+
+	m_caching = false;
+}
+
+void DebugZmqLayer::encode(void const* buffer, size_t len, bool last)
+{
+	if(m_caching) {
+		m_cacheArena.append(static_cast<char const*>(buffer), len);
+		if(last)
+			m_caching = false;
+	}
+
+	base::encode(buffer, len, last);
+}
+
 
 //////////////////////////////
 // SyncZmqLayer
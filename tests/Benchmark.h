@@ -0,0 +1,29 @@
+#ifndef TESTS_BENCHMARK_H
+#define TESTS_BENCHMARK_H
+
+/*
+ * libstored, distributed debuggable data stores.
+ * Copyright (C) 2020-2022  Jochem Rutgers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "gtest/gtest.h"
+
+#include <cstdlib>
+
+// Benchmarks take a while and only print their results.  They are skipped,
+// unless the STORED_BENCHMARK environment variable is set.  Run them like:
+//
+//     STORED_BENCHMARK=1 ./test_protocol --gtest_filter='*Benchmark*'
+//
+// Put this macro at the start of the test body.
+#define SKIP_UNLESS_BENCHMARK()                                      \
+	do {                                                         \
+		if(!getenv("STORED_BENCHMARK"))                      \
+			GTEST_SKIP() << "Set STORED_BENCHMARK to run"; \
+	} while(0)
+
+#endif // TESTS_BENCHMARK_H
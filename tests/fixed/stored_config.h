@@ -0,0 +1,29 @@
+/*!
+ * \file
+ * \brief Config for the tests of the allocation-free Debugger and Synchronizer
+ */
+
+#ifndef LIBSTORED_CONFIG_H
+#	error Do not include this file directly, include <stored> instead.
+#endif
+
+#ifndef STORED_CONFIG_H
+#	define STORED_CONFIG_H
+
+#	ifdef __cplusplus
+#		include "TestAllocator.h"
+
+namespace stored {
+struct Config : public DefaultConfig {
+	static bool const AvoidDynamicMemory = true;
+	static bool const FixedCapacityContainers = true;
+	static size_t const ScratchPadDecay = 0;
+
+	template <typename T>
+	struct Allocator {
+		typedef TestAllocator<T> type;
+	};
+};
+} // namespace stored
+#	endif // __cplusplus
+#endif	       // STORED_CONFIG_H
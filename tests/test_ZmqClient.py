@@ -12,6 +12,8 @@ import subprocess
 import libstored
 import sys
 import logging
+import os
+import time
 from PySide6.QtCore import QCoreApplication
 
 class ZmqClientTest(unittest.TestCase):
@@ -63,6 +65,57 @@ class ZmqClientTest(unittest.TestCase):
         self.assertTrue(self.c['/an int8'] != None)
         self.assertTrue(self.c['/comp/an'] != None)
 
+    def test_delta_decoder(self):
+        # Encoded by the C++ DeltaLayer(8, 4), see the DeltaLayer.Tail test.
+        enc = bytes.fromhex('828898408a98b880018000090a0b')
+        dec = bytes(range(1, 12))
+
+        d = libstored.zmq_client.DeltaDecoder(8, 4)
+        self.assertEqual(d.fill(enc), dec)
+
+        # The tail marker and raw bytes may be split over multiple fills.
+        for split in range(len(enc) + 1):
+            d.reset()
+            self.assertEqual(d.fill(enc[:split]) + d.fill(enc[split:]), dec)
+
+    def test_pipeline(self):
+        reqs = ['r/an int8'] * 200
+
+        with libstored.ZmqClient(pipeline=16) as p:
+            self.assertEqual(p.pipeline, 16)
+            self.assertEqual(p.identification(), 'zmqserver')
+
+            for c in (self.c, p):
+                res = c.reqMulti(reqs)
+                self.assertEqual(res, [res[0]] * len(reqs))
+                self.assertNotEqual(res[0], b'?')
+
+    def test_pipeline_no_envelope(self):
+        with libstored.ZmqClient(pipeline=16) as p:
+            done = []
+            p._reqQueue.append([b'r/an int8', done.append, b'\x00\x00\x00\x01'])
+
+            # A response without envelope does not complete a request.
+            p._reqAsyncHandleResponse(b'10', None)
+            self.assertEqual(done, [])
+            self.assertEqual(len(p._reqQueue), 1)
+
+            p._reqAsyncHandleResponse(b'10', b'\x00\x00\x00\x01')
+            self.assertEqual(done, [b'10'])
+            self.assertEqual(p._reqQueue, [])
+
+    @unittest.skipUnless(os.environ.get('STORED_BENCHMARK'), 'Set STORED_BENCHMARK to run')
+    def test_pipeline_benchmark(self):
+        reqs = ['r/an int8'] * 2000
+
+        with libstored.ZmqClient(pipeline=16) as p:
+            for name, c in (('req/rep', self.c), ('pipelined', p)):
+                start = time.time()
+                res = c.reqMulti(reqs)
+                dt = time.time() - start
+                print(f'{name}: {len(reqs) / dt:.0f} reads/s')
+                self.assertEqual(res, [res[0]] * len(reqs))
+
 if __name__ == '__main__':
     if len(sys.argv) == 0 or not 'zmqserver' in sys.argv[-1]:
         raise Exception('Provide path to examples/zmqserver binary as last argument')
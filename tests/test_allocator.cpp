@@ -8,10 +8,23 @@
  */
 
 #include "libstored/allocator.h"
+#include "Benchmark.h"
 #include "TestStore.h"
 #include "gtest/gtest.h"
 
+#include <chrono>
+#include <cstring>
+#include <list>
+#include <map>
 #include <new>
+#include <thread>
+#include <vector>
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+// The operators below forward to malloc()/free(), which GCC cannot match
+// when inlined in the std::allocator.
+#	pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
 
 static bool verbose_new;
 static size_t new_count;
@@ -299,6 +312,147 @@ TEST(Callable, Return)
 	EXPECT_EQ(f(&i), 4);
 }
 
+TEST(Callable, Capacity)
+{
+	size_t allocations = 0;
+	TestAllocatorBase::allocate_cb = [&](std::type_info const*, void*, size_t, size_t) {
+		allocations++;
+	};
+
+	int a = 1, b = 2, c = 3, d = 4;
+	auto lambda = [&a, &b, &c, &d]() { return a + b + c + d; };
+
+	// Does not fit in the default capacity.
+	stored::Callable<int()>::type f{std::move(lambda)};
+	EXPECT_EQ(allocations, 1U);
+	EXPECT_EQ(f(), 10);
+
+	stored::Callable<int(), 4 * sizeof(void*)>::type g{std::move(lambda)};
+	EXPECT_EQ(allocations, 1U);
+	EXPECT_EQ(g(), 10);
+
+	auto h = g;
+	EXPECT_EQ(allocations, 1U);
+	EXPECT_EQ(h(), 10);
+
+	TestAllocatorBase::allocate_cb = nullptr;
+
+	EXPECT_LT(sizeof(f), sizeof(g));
+	EXPECT_GE(sizeof(g), 4 * sizeof(void*));
+}
+
+TEST(Callable, MoveOnly)
+{
+	using F = stored::MoveOnlyCallable<int()>::type;
+	static_assert(!std::is_copy_constructible<F>::value, "");
+	static_assert(!std::is_copy_assignable<F>::value, "");
+	static_assert(std::is_nothrow_move_constructible<F>::value, "");
+	static_assert(std::is_copy_constructible<stored::Callable<int()>::type>::value, "");
+
+	F f{[p = std::unique_ptr<int>(new int(42))]() { return *p; }};
+	EXPECT_TRUE((bool)f);
+	EXPECT_EQ(f(), 42);
+
+	F g{std::move(f)};
+	EXPECT_FALSE((bool)f);
+	EXPECT_EQ(g(), 42);
+
+	// Does not fit, so it is allocated on the heap.
+	std::unique_ptr<int> q(new int(3));
+	int a = 1, b = 2;
+	f = [q = std::move(q), &a, &b]() { return *q + a + b; };
+	EXPECT_EQ(f(), 6);
+
+	g = std::move(f);
+	EXPECT_FALSE((bool)f);
+	EXPECT_EQ(g(), 6);
+
+	// A stateful lambda.
+	F h{[n = 0]() mutable { return ++n; }};
+	EXPECT_EQ(h(), 1);
+	EXPECT_EQ(h(), 2);
+}
+
+static int callable_add(int x)
+{
+	return x + 1;
+}
+
+template <typename F>
+__attribute__((noinline)) static int callable_run(F const& f, int n)
+{
+	int x = 0;
+	for(int i = 0; i < n; i++)
+		x = f(x);
+	return x;
+}
+
+template <typename F>
+static void callable_benchmark(char const* name, F const& f)
+{
+	int const n = 10000000;
+	auto start = std::chrono::steady_clock::now();
+	int x = callable_run(f, n);
+	auto dt = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - start);
+	EXPECT_GE(x, n);
+	printf("%-34s: %5.2f ns/call\n", name, (double)dt.count() / (double)n);
+}
+
+TEST(Callable, Benchmark)
+{
+	SKIP_UNLESS_BENCHMARK();
+
+	int a = 1, b = 0, c = 0;
+	auto stateless = [](int x) { return x + 1; };
+	auto capturing = [&a, &b, &c](int x) { return x + a + b + c; };
+
+	callable_benchmark("function pointer", &callable_add);
+	callable_benchmark(
+		"stored::Callable function pointer", stored::Callable<int(int)>::type{&callable_add});
+	callable_benchmark(
+		"std::function function pointer", std::function<int(int)>{&callable_add});
+	callable_benchmark("stored::Callable stateless", stored::Callable<int(int)>::type{stateless});
+	callable_benchmark("std::function stateless", std::function<int(int)>{stateless});
+	callable_benchmark(
+		"stored::Callable capture (heap)", stored::Callable<int(int)>::type{capturing});
+	callable_benchmark(
+		"stored::Callable<32> capture",
+		stored::Callable<int(int), 4 * sizeof(void*)>::type{capturing});
+	callable_benchmark("std::function capture", std::function<int(int)>{capturing});
+
+	// Allocations when constructing and copying.
+	size_t allocations = 0;
+	TestAllocatorBase::allocate_cb = [&](std::type_info const*, void*, size_t, size_t) {
+		allocations++;
+	};
+
+	std::vector<stored::Callable<int(int), 4 * sizeof(void*)>::type> sc;
+	sc.reserve(2000);
+	new_count = 0;
+	for(int i = 0; i < 1000; i++) {
+		sc.emplace_back(capturing);
+		sc.push_back(sc.back());
+	}
+	size_t stored_allocations = allocations + new_count;
+
+	std::vector<std::function<int(int)>> sf;
+	sf.reserve(2000);
+	new_count = 0;
+	for(int i = 0; i < 1000; i++) {
+		sf.emplace_back(capturing);
+		sf.push_back(sf.back());
+	}
+	size_t std_allocations = new_count;
+
+	TestAllocatorBase::allocate_cb = nullptr;
+
+	printf("allocations for 2000 capturing callables: stored::Callable<32> %zu, "
+	       "std::function %zu\n",
+	       stored_allocations, std_allocations);
+	EXPECT_EQ(stored_allocations, 0U);
+}
+
 class Allocator : public ::testing::Test {
 protected:
 	void SetUp() override
@@ -330,3 +484,250 @@ TEST_F(Allocator, Store)
 	// No non-allocator allocations are expected.
 	EXPECT_EQ(new_count, 0u);
 }
+
+TEST(Pool, SizeClass)
+{
+	EXPECT_EQ(stored::Pool::sizeClass(1), 0u);
+	EXPECT_EQ(stored::Pool::sizeClass(16), 0u);
+	EXPECT_EQ(stored::Pool::sizeClass(17), 1u);
+	EXPECT_EQ(stored::Pool::sizeClass(32), 1u);
+	EXPECT_EQ(stored::Pool::sizeClass(33), 2u);
+	EXPECT_EQ(stored::Pool::sizeClass(100), 3u);
+	EXPECT_EQ(stored::Pool::sizeClass(512), 5u);
+	EXPECT_EQ(stored::Pool::sizeClass(513), 6u);
+	EXPECT_EQ(stored::Pool::sizeClass(1024), 6u);
+
+	for(size_t s = 1; s <= stored::Pool::MaxBlockSize; s++) {
+		size_t c = stored::Pool::sizeClass(s);
+		EXPECT_GE(stored::Pool::blockSize(c), s);
+		if(c > 0) {
+			EXPECT_LT(stored::Pool::blockSize(c - 1), s);
+		}
+	}
+}
+
+TEST(Pool, Reuse)
+{
+	stored::PoolStats before = stored::Pool::stats();
+
+	void* p = stored::Pool::allocate(40);
+	ASSERT_NE(p, nullptr);
+	EXPECT_EQ((uintptr_t)p % 16u, 0u);
+	memset(p, 0x55, 40);
+
+	void* q = stored::Pool::allocate(64);
+	EXPECT_NE(p, q);
+
+	stored::PoolStats s = stored::Pool::stats();
+	EXPECT_EQ(s.allocations - before.allocations, 2u);
+	EXPECT_EQ(s.inUse, before.inUse + 2u);
+
+	stored::Pool::deallocate(p, 40);
+	// Same size class, so the block is reused.
+	void* r = stored::Pool::allocate(50);
+	EXPECT_EQ(p, r);
+
+	stored::Pool::deallocate(q, 64);
+	stored::Pool::deallocate(r, 50);
+
+	s = stored::Pool::stats();
+	EXPECT_EQ(s.allocations - before.allocations, 3u);
+	EXPECT_EQ(s.deallocations - before.deallocations, 3u);
+	EXPECT_EQ(s.inUse, before.inUse);
+	EXPECT_GE(s.peakInUse, before.inUse + 2u);
+	EXPECT_GE(s.reserved, s.chunks * stored::Config::PoolChunkSize);
+}
+
+TEST(Pool, Large)
+{
+	stored::PoolStats before = stored::Pool::stats();
+
+	size_t size = stored::Pool::MaxBlockSize + 1u;
+	void* p = stored::Pool::allocate(size);
+	memset(p, 0x55, size);
+	stored::Pool::deallocate(p, size);
+
+	stored::PoolStats s = stored::Pool::stats();
+	EXPECT_EQ(s.large - before.large, 1u);
+	EXPECT_EQ(s.inUse, before.inUse);
+}
+
+TEST(Pool, Containers)
+{
+	stored::PoolStats before = stored::Pool::stats();
+
+	{
+		using String =
+			std::basic_string<char, std::char_traits<char>, stored::PoolAllocator<char>>;
+		std::map<int, String, std::less<int>,
+			 stored::PoolAllocator<std::pair<int const, String>>>
+			m;
+		std::vector<double, stored::PoolAllocator<double>> v;
+
+		for(int i = 0; i < 1000; i++) {
+			m[i] = String(static_cast<size_t>(i % 100) + 1u, 'x');
+			v.push_back(i);
+		}
+
+		for(int i = 0; i < 1000; i++) {
+			EXPECT_EQ(m[i].size(), static_cast<size_t>(i % 100) + 1u);
+			EXPECT_EQ(v[static_cast<size_t>(i)], i);
+		}
+
+		EXPECT_GT(stored::Pool::stats().inUse, before.inUse);
+	}
+
+	EXPECT_EQ(stored::Pool::stats().inUse, before.inUse);
+}
+
+TEST(Pool, Threads)
+{
+	stored::PoolStats before = stored::Pool::stats();
+
+	// Every thread frees the blocks allocated by the previous thread.
+	static constexpr size_t Threads = 4;
+	static constexpr size_t Blocks = 1000;
+	std::vector<std::vector<void*>> blocks(Threads, std::vector<void*>(Blocks));
+	std::vector<std::thread> threads;
+
+	for(size_t t = 0; t < Threads; t++)
+		threads.emplace_back([&, t]() {
+			for(size_t i = 0; i < Blocks; i++) {
+				blocks[t][i] = stored::Pool::allocate(i % 200u + 1u);
+				memset(blocks[t][i], (int)t, i % 200u + 1u);
+			}
+		});
+
+	for(auto& t : threads)
+		t.join();
+	threads.clear();
+
+	for(size_t t = 0; t < Threads; t++)
+		for(size_t i = 0; i < Blocks; i++)
+			EXPECT_EQ(*static_cast<char*>(blocks[t][i]), (char)t);
+
+	for(size_t t = 0; t < Threads; t++)
+		threads.emplace_back([&, t]() {
+			for(size_t i = 0; i < Blocks; i++)
+				stored::Pool::deallocate(
+					blocks[(t + 1u) % Threads][i], i % 200u + 1u);
+		});
+
+	for(auto& t : threads)
+		t.join();
+
+	stored::PoolStats s = stored::Pool::stats();
+	EXPECT_EQ(s.allocations - before.allocations, Threads * Blocks);
+	EXPECT_EQ(s.deallocations - before.deallocations, Threads * Blocks);
+	EXPECT_EQ(s.inUse, before.inUse);
+}
+
+/*!
+ * \brief Replay the allocation pattern of a Debugger and Synchronizer.
+ *
+ * The Debugger (re)defines macros and aliases, and fills and drains its
+ * stream buffers.  The Synchronizer keeps a map of connections and
+ * allocates a message buffer for every update.
+ */
+template <template <typename> class A>
+static void poolWorkload(size_t iterations)
+{
+	using String = std::basic_string<char, std::char_traits<char>, A<char>>;
+	using Buffer = std::vector<char, A<char>>;
+
+	std::map<char, String, std::less<char>, A<std::pair<char const, String>>> macros;
+	std::map<char, void*, std::less<char>, A<std::pair<char const, void*>>> aliases;
+	String stream;
+	std::map<int, Buffer, std::less<int>, A<std::pair<int const, Buffer>>> connections;
+	std::list<Buffer, A<Buffer>> messages;
+
+	for(size_t i = 0; i < iterations; i++) {
+		char key = (char)('a' + (char)(i % 26u));
+
+		macros[key] = String("r/scope/some variable;e;r/other variable");
+		if(i % 3u == 0)
+			macros.erase((char)('a' + (char)((i + 7u) % 26u)));
+
+		aliases[key] = &stream;
+		if(i % 2u)
+			aliases.erase(key);
+
+		stream.append("0123456789abcdef0123456789abcdef");
+		if(stream.size() > 480u)
+			String().swap(stream);
+
+		connections[(int)(i % 4u)].assign(16u + i % 64u, 'c');
+		if(i % 16u == 0)
+			connections.erase((int)((i / 16u) % 4u));
+
+		messages.emplace_back(32u + i % 200u, 'm');
+		if(messages.size() > 8u)
+			messages.pop_front();
+	}
+}
+
+// Frees a block when the thread exits.
+struct ThreadExitFree {
+	~ThreadExitFree()
+	{
+		if(block)
+			stored::Pool::deallocate(block, 64);
+	}
+
+	void* block = nullptr;
+};
+
+TEST(Pool, ThreadExit)
+{
+	stored::PoolStats before = stored::Pool::stats();
+
+	std::thread([]() {
+		// Constructed before the thread's cache, so it is destroyed
+		// after it.  The block must go to the global pool then.
+		static thread_local ThreadExitFree f;
+		f.block = stored::Pool::allocate(64);
+		memset(f.block, 1, 64);
+	}).join();
+
+	stored::PoolStats s = stored::Pool::stats();
+	EXPECT_EQ(s.allocations - before.allocations, 1u);
+	EXPECT_EQ(s.deallocations - before.deallocations, 1u);
+	EXPECT_EQ(s.inUse, before.inUse);
+}
+
+TEST(Pool, Benchmark)
+{
+	SKIP_UNLESS_BENCHMARK();
+
+	size_t const iterations = 100000;
+
+	poolWorkload<std::allocator>(iterations);
+	new_count = 0;
+	auto start = std::chrono::steady_clock::now();
+	poolWorkload<std::allocator>(iterations);
+	auto dt_std = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - start);
+	size_t new_std = new_count;
+
+	poolWorkload<stored::PoolAllocator>(iterations);
+	stored::PoolStats before = stored::Pool::stats();
+	new_count = 0;
+	start = std::chrono::steady_clock::now();
+	poolWorkload<stored::PoolAllocator>(iterations);
+	auto dt_pool = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - start);
+	size_t new_pool = new_count;
+	stored::PoolStats s = stored::Pool::stats();
+
+	printf("std::allocator:       %.1f ns/iteration, %zu system allocations\n",
+	       (double)dt_std.count() / (double)iterations, new_std);
+	printf("stored::PoolAllocator: %.1f ns/iteration, %zu system allocations, "
+	       "%zu pool allocations, %zu cache hits, %zu large, %zu chunks\n",
+	       (double)dt_pool.count() / (double)iterations, new_pool,
+	       s.allocations - before.allocations, s.cacheHits - before.cacheHits,
+	       s.large - before.large, s.chunks);
+
+	// After warming up, the pool should not need the system anymore.
+	EXPECT_LT(new_pool, new_std);
+	EXPECT_EQ(s.inUse, before.inUse);
+}
@@ -10,6 +10,8 @@
 #include "TestStore.h"
 #include "gtest/gtest.h"
 
+#include <cstring>
+
 namespace {
 
 TEST(Array, Initialized)
@@ -40,4 +42,125 @@ TEST(Array, Dynamic)
 	EXPECT_FALSE(store.array_bool_1.get());
 }
 
+TEST(Array, Span)
+{
+	stored::TestStore store;
+	EXPECT_EQ(store.array_bool.size(), 2u);
+	EXPECT_EQ(store.array_uint16.size(), 4u);
+	EXPECT_TRUE(store.array_bool[0].get());
+	EXPECT_TRUE(store.array_bool.get(1));
+
+	store.array_uint16[2] = 3;
+	EXPECT_EQ(store.array_uint16_2.get(), 3u);
+	store.array_uint16.set(3, 4);
+	EXPECT_EQ(store.array_uint16_3.get(), 4u);
+	EXPECT_EQ(store.array_uint16.key(), store.array_uint16_0.key());
+
+	stored::Array<uint16_t, stored::TestStore> a = store.array_uint16;
+	EXPECT_TRUE(a.valid());
+	EXPECT_EQ(a.size(), 4u);
+	EXPECT_EQ(a[3].get(), 4u);
+	EXPECT_EQ(&a.container(), &store);
+	EXPECT_FALSE((stored::Array<uint16_t, stored::TestStore>().valid()));
+
+	// Elements are adjacent in the buffer.
+	for(size_t i = 1; i < a.size(); i++)
+		EXPECT_EQ(a[i].key(), a[0].key() + i * sizeof(uint16_t));
+}
+
+TEST(Array, Bulk)
+{
+	stored::TestStore store;
+	uint16_t const src[] = {1, 2, 3, 4};
+	EXPECT_EQ(store.array_uint16.set(src), 4u);
+	EXPECT_EQ(store.array_uint16_0.get(), 1u);
+	EXPECT_EQ(store.array_uint16_3.get(), 4u);
+
+	uint16_t dst[4] = {};
+	EXPECT_EQ(store.array_uint16.get(dst), 4u);
+	EXPECT_EQ(memcmp(src, dst, sizeof(dst)), 0);
+
+	// Slices are clipped to the array.
+	uint16_t const slice[] = {10, 11, 12};
+	EXPECT_EQ(store.array_uint16.set(slice, 2, 3), 2u);
+	EXPECT_EQ(store.array_uint16_1.get(), 2u);
+	EXPECT_EQ(store.array_uint16_2.get(), 10u);
+	EXPECT_EQ(store.array_uint16_3.get(), 11u);
+	EXPECT_EQ(store.array_uint16.get(dst, 1, 2), 2u);
+	EXPECT_EQ(dst[0], 2u);
+	EXPECT_EQ(dst[1], 10u);
+	EXPECT_EQ(store.array_uint16.get(dst, 4), 0u);
+
+	// The same via a Variant.
+	uint16_t v[2] = {};
+	EXPECT_EQ(store.array_uint16_2.variant().getRange(v, 2), sizeof(v));
+	EXPECT_EQ(v[0], 10u);
+	EXPECT_EQ(v[1], 11u);
+	v[1] = 12;
+	EXPECT_EQ(store.array_uint16_2.variant().setRange(v, 2), sizeof(v));
+	EXPECT_EQ(store.array_uint16_3.get(), 12u);
+
+	// A Variant range is bound to the array.
+	EXPECT_EQ(store.array_uint16_2.variant().arrayRemaining(), 2u);
+	EXPECT_EQ(store.array_uint16_2.variant().getRange(v, 3), 0u);
+
+	// The scalar array_bool_2 directly follows the array_bool elements.
+	bool b[3] = {};
+	EXPECT_EQ(store.array_bool_2.variant().arrayRemaining(), 0u);
+	EXPECT_EQ(store.array_bool_0.variant().getRange(b, 2), 2u);
+	EXPECT_EQ(store.array_bool_0.variant().getRange(b, 3), 0u);
+	EXPECT_EQ(store.array_bool_0.variant().setRange(b, 3), 0u);
+	EXPECT_EQ(store.array_bool_2.variant().getRange(b, 1), 1u);
+}
+
+class HookedArrayStore : public STORE_BASE_CLASS(TestStoreBase, HookedArrayStore) {
+	STORE_CLASS_BODY(TestStoreBase, HookedArrayStore)
+public:
+	HookedArrayStore() is_default
+
+	void __hookEntryRO(stored::Type::type type, void* buffer, size_t len) noexcept
+	{
+		reads++;
+		lastLen = len;
+		base::__hookEntryRO(type, buffer, len);
+	}
+
+	void __hookExitX(stored::Type::type type, void* buffer, size_t len, bool changed) noexcept
+	{
+		writes++;
+		lastLen = len;
+		lastChanged = changed;
+		base::__hookExitX(type, buffer, len, changed);
+	}
+
+	int reads = 0;
+	int writes = 0;
+	size_t lastLen = 0;
+	bool lastChanged = false;
+};
+
+TEST(Array, Hooks)
+{
+	HookedArrayStore store;
+	uint16_t const src[] = {1, 2, 3, 4};
+	store.array_uint16.set(src);
+	EXPECT_EQ(store.writes, 1);
+	EXPECT_EQ(store.lastLen, sizeof(src));
+	EXPECT_TRUE(store.lastChanged);
+
+	store.array_uint16.set(src + 1, 1, 2);
+	EXPECT_EQ(store.writes, 2);
+	EXPECT_EQ(store.lastLen, 2 * sizeof(uint16_t));
+	EXPECT_FALSE(store.lastChanged);
+
+	uint16_t dst[4] = {};
+	store.array_uint16.get(dst);
+	EXPECT_EQ(store.reads, 1);
+	EXPECT_EQ(store.lastLen, sizeof(dst));
+
+	store.array_uint16[0].get();
+	EXPECT_EQ(store.reads, 2);
+	EXPECT_EQ(store.lastLen, sizeof(uint16_t));
+}
+
 } // namespace
@@ -7,11 +7,25 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/.
  */
 
+#include "Benchmark.h"
 #include "TestStore.h"
 #include "gtest/gtest.h"
 
 #include <stored>
 
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#	include <x86intrin.h>
+#	define HAVE_RDTSC
+#endif
+
 namespace {
 
 TEST(Amplifier, Full)
@@ -96,4 +110,1205 @@ TEST(Amplifier, Assign)
 	EXPECT_FLOAT_EQ(amp(1.0f), 3.5f);
 }
 
+class HookedTestStore : public STORE_BASE_CLASS(TestStoreBase, HookedTestStore) {
+	STORE_CLASS_BODY(TestStoreBase, HookedTestStore)
+public:
+	HookedTestStore() is_default
+
+	void __hookEntryRO(stored::Type::type type, void* buffer, size_t len) noexcept
+	{
+		reads++;
+		base::__hookEntryRO(type, buffer, len);
+	}
+
+	void __hookExitX(stored::Type::type type, void* buffer, size_t len, bool changed) noexcept
+	{
+		if(changed && onChanged)
+			onChanged(buffer);
+
+		base::__hookExitX(type, buffer, len, changed);
+	}
+
+	int reads = 0;
+	std::function<void(void*)> onChanged;
+};
+
+class SyncTestStore : public stored::Synchronizable<stored::TestStoreBase<SyncTestStore>> {
+	friend class stored::TestStoreBase<SyncTestStore>;
+};
+
+TEST(Amplifier, Cached)
+{
+	HookedTestStore store;
+	constexpr auto amp_o = stored::Amplifier<HookedTestStore>::objects("/amp/");
+	stored::Amplifier<HookedTestStore, amp_o.flags()> amp{amp_o, store};
+	stored::Amplifier<HookedTestStore, amp_o.flags(), float, true> amp_cached{amp_o, store};
+
+	EXPECT_FLOAT_EQ(amp(1.0f), 2.5f);
+	EXPECT_FLOAT_EQ(amp_cached(1.0f), 2.5f);
+
+	// Running the cached instance does not read the store anymore.
+	store.reads = 0;
+	EXPECT_FLOAT_EQ(amp_cached(2.0f), 4.5f);
+	EXPECT_EQ(store.reads, 0);
+	EXPECT_FLOAT_EQ(amp(2.0f), 4.5f);
+	EXPECT_GT(store.reads, 0);
+
+	store.amp__gain = 3.0f;
+	EXPECT_FLOAT_EQ(amp(1.0f), 3.5f);
+	EXPECT_FLOAT_EQ(amp_cached(1.0f), 2.5f);
+
+	amp_cached.refresh();
+	EXPECT_FLOAT_EQ(amp_cached(1.0f), 3.5f);
+}
+
+TEST(Amplifier, CachedHook)
+{
+	HookedTestStore store;
+	constexpr auto amp_o = stored::Amplifier<HookedTestStore>::objects("/amp/");
+	stored::Amplifier<HookedTestStore, amp_o.flags(), float, true> amp{amp_o, store};
+	store.onChanged = [&](void* buffer) { amp.refreshIfUsed(buffer); };
+
+	EXPECT_FLOAT_EQ(amp(1.0f), 2.5f);
+
+	// Input and output do not invalidate the parameters.
+	amp(5.0f);
+	store.reads = 0;
+	EXPECT_FLOAT_EQ(amp(1.0f), 2.5f);
+	EXPECT_EQ(store.reads, 0);
+
+	store.amp__gain = 3.0f;
+	EXPECT_FLOAT_EQ(amp(1.0f), 3.5f);
+
+	store.amp__override = 1.0f;
+	EXPECT_FLOAT_EQ(amp(1.0f), 1.0f);
+
+	store.amp__override = std::numeric_limits<float>::quiet_NaN();
+	store.amp__high = 2.0f;
+	EXPECT_FLOAT_EQ(amp(1.0f), 2.0f);
+}
+
+TEST(Amplifier, CachedJournal)
+{
+	SyncTestStore store;
+	constexpr auto amp_o = stored::Amplifier<SyncTestStore>::objects("/amp/");
+	stored::Amplifier<SyncTestStore, amp_o.flags(), float, true> amp{amp_o, store};
+
+	EXPECT_TRUE(amp.refreshIfChanged(store.journal()));
+	EXPECT_FLOAT_EQ(amp(1.0f), 2.5f);
+	EXPECT_FALSE(amp.refreshIfChanged(store.journal()));
+
+	// Input and output are in the journal too, but are not parameters.
+	amp(2.0f);
+	EXPECT_FALSE(amp.refreshIfChanged(store.journal()));
+
+	store.amp__offset = 1.0f;
+	EXPECT_FLOAT_EQ(amp(1.0f), 2.5f);
+	EXPECT_TRUE(amp.refreshIfChanged(store.journal()));
+	EXPECT_FLOAT_EQ(amp(1.0f), 3.0f);
+	EXPECT_FALSE(amp.refreshIfChanged(store.journal()));
+	EXPECT_FLOAT_EQ(amp(1.0f), 3.0f);
+}
+
+class ComponentTestStore : public STORE_BASE_CLASS(TestStoreBase, ComponentTestStore) {
+	STORE_CLASS_BODY(TestStoreBase, ComponentTestStore)
+public:
+	ComponentTestStore() is_default
+
+	void __pid_0__frequency(bool set, float& value)
+	{
+		if(!set)
+			value = 100.0f;
+	}
+
+	void __pid_1__frequency(bool set, float& value)
+	{
+		if(!set)
+			value = 100.0f;
+	}
+
+	void __pid_2__frequency(bool set, float& value)
+	{
+		if(!set)
+			value = 100.0f;
+	}
+
+	void __pid_3__frequency(bool set, float& value)
+	{
+		if(!set)
+			value = 100.0f;
+	}
+
+	void __lowpass__sample_frequency(bool set, float& value)
+	{
+		if(!set)
+			value = 1000.0f;
+	}
+
+	void __sine__sample_frequency(bool set, float& value)
+	{
+		if(!set)
+			value = 1000.0f;
+	}
+
+	void __ramp__sample_frequency(bool set, float& value)
+	{
+		if(!set)
+			value = 1000.0f;
+	}
+
+	void __q15_pid__frequency(bool set, float& value)
+	{
+		if(!set)
+			value = 100.0f;
+	}
+
+	void __q16_lowpass__sample_frequency(bool set, float& value)
+	{
+		if(!set)
+			value = 1000.0f;
+	}
+
+	void __q15_sine__sample_frequency(bool set, float& value)
+	{
+		if(!set)
+			value = 1000.0f;
+	}
+
+	void __q31_sine__sample_frequency(bool set, float& value)
+	{
+		if(!set)
+			value = 1000.0f;
+	}
+};
+
+// Only pass the ids of the objects in the store, as the abbreviated names are
+// not unique otherwise.
+#define PID_IDS 'f', 'y', 's', 'e', 'p', 'i', 'd', 'k', 'I', 'l', 'h', 'r', 'F', 'u'
+constexpr auto pid0_o = stored::PID<ComponentTestStore>::objects<PID_IDS>("/pid 0/");
+constexpr auto pid1_o = stored::PID<ComponentTestStore>::objects<PID_IDS>("/pid 1/");
+constexpr auto pid2_o = stored::PID<ComponentTestStore>::objects<PID_IDS>("/pid 2/");
+constexpr auto pid3_o = stored::PID<ComponentTestStore>::objects<PID_IDS>("/pid 3/");
+constexpr stored::PIDObjects<ComponentTestStore> pids_o[] = {pid0_o, pid1_o, pid2_o, pid3_o};
+
+using PIDBank4 = stored::PIDBank<ComponentTestStore, 4, pid0_o.flags()>;
+using PID4 = stored::PID<ComponentTestStore, pid0_o.flags()>;
+
+TEST(PID, Cached)
+{
+	ComponentTestStore store;
+	ComponentTestStore store_cached;
+	PID4 pid{pid0_o, store};
+	stored::PID<ComponentTestStore, pid0_o.flags(), float, true> pid_cached{pid0_o, store_cached};
+
+	store.pid_0__reset = true;
+	store_cached.pid_0__reset = true;
+	store.pid_0__setpoint = 1.0f;
+	store_cached.pid_0__setpoint = 1.0f;
+
+	float y = 0;
+	for(int i = 0; i < 10; i++) {
+		float u = pid(y);
+		EXPECT_FLOAT_EQ(pid_cached(y), u);
+		y += u * 0.01f;
+	}
+
+	// Changes are applied at reset.
+	store.pid_0__Kp = 3.0f;
+	store_cached.pid_0__Kp = 3.0f;
+	EXPECT_NE(pid(y), pid_cached(y));
+
+	store.pid_0__reset = true;
+	store_cached.pid_0__reset = true;
+	EXPECT_FLOAT_EQ(pid(y), pid_cached(y));
+	EXPECT_FLOAT_EQ(pid.Ki(), pid_cached.Ki());
+}
+
+TEST(PIDBank, Equivalence)
+{
+	ComponentTestStore store_bank;
+	ComponentTestStore store_pid;
+
+	PIDBank4 bank{pids_o, store_bank};
+	PID4 pid[4] = {
+		PID4{pid0_o, store_pid}, PID4{pid1_o, store_pid}, PID4{pid2_o, store_pid},
+		PID4{pid3_o, store_pid}};
+
+	// Ki and Kd are only computed at a reset.
+	for(auto* s : {&store_bank, &store_pid}) {
+		s->pid_0__reset = true;
+		s->pid_1__reset = true;
+		s->pid_2__reset = true;
+		s->pid_3__reset = true;
+	}
+
+	store_bank.pid_0__setpoint = 1.0f;
+	store_pid.pid_0__setpoint = 1.0f;
+	store_bank.pid_2__setpoint = -3.0f;
+	store_pid.pid_2__setpoint = -3.0f;
+
+	float y[4] = {0.0f, 0.5f, 1.0f, -1.0f};
+	float u[4] = {};
+
+	for(int step = 0; step < 200; step++) {
+		if(step == 50) {
+			// Saturate some of them.
+			store_bank.pid_1__setpoint = 100.0f;
+			store_pid.pid_1__setpoint = 100.0f;
+			store_bank.pid_3__setpoint = -100.0f;
+			store_pid.pid_3__setpoint = -100.0f;
+		}
+
+		bank(y, u);
+
+		for(size_t i = 0; i < 4; i++) {
+			EXPECT_FLOAT_EQ(u[i], pid[i](y[i])) << "step " << step << " pid " << i;
+			EXPECT_FLOAT_EQ(bank.int_(i), pid[i].int_()) << "step " << step << " pid " << i;
+			y[i] += u[i] * 0.01f;
+		}
+	}
+
+	EXPECT_FLOAT_EQ(store_bank.pid_1__u.get(), store_pid.pid_1__u.get());
+	EXPECT_FLOAT_EQ(store_bank.pid_3__int.get(), store_pid.pid_3__int.get());
+	EXPECT_FLOAT_EQ(store_bank.pid_3__u.get(), -10.0f);
+
+	for(size_t i = 0; i < 4; i++) {
+		EXPECT_FLOAT_EQ(bank.Ki(i), pid[i].Ki());
+		EXPECT_FLOAT_EQ(bank.Kd(i), pid[i].Kd());
+		EXPECT_TRUE(bank.isHealthy(i));
+	}
+}
+
+TEST(PIDBank, Refresh)
+{
+	ComponentTestStore store;
+	PIDBank4 bank{pids_o, store};
+
+	float y[4] = {};
+	float u[4] = {};
+
+	store.pid_0__setpoint = 1.0f;
+	store.pid_0__reset = true;
+	store.pid_1__reset = true;
+	bank(y, u);
+	float u0 = u[0];
+	EXPECT_GT(u0, 1.0f);
+
+	// Parameters are cached; changing Kp does not have effect yet.
+	store.pid_0__Kp = 0.0f;
+	store.pid_1__Kp = 0.0f;
+	bank(y, u);
+	EXPECT_GT(u[0], u0);
+
+	// After a reset, the new values are used.
+	store.pid_0__reset = true;
+	bank(y, u);
+	EXPECT_FALSE(store.pid_0__reset.get());
+	EXPECT_FLOAT_EQ(bank.Ki(0), 0.0f);
+	EXPECT_GT(bank.Ki(1), 0.0f);
+
+	// A refresh reloads the parameters, but Ki and Kd are only computed at a reset.
+	bank.refresh();
+	bank(y, u);
+	EXPECT_GT(bank.Ki(1), 0.0f);
+
+	// Override and enable are cached too.
+	store.pid_1__override = 3.0f;
+	bank(y, u);
+	EXPECT_FLOAT_EQ(u[1], 0.0f);
+	bank.refresh(1);
+	bank(y, u);
+	EXPECT_FLOAT_EQ(u[1], 3.0f);
+	EXPECT_FLOAT_EQ(store.pid_1__u.get(), 3.0f);
+	EXPECT_FLOAT_EQ(bank.u(1), 3.0f);
+
+	// A reset is not processed while overridden.
+	store.pid_1__reset = true;
+	bank(y, u);
+	EXPECT_TRUE(store.pid_1__reset.get());
+
+	store.pid_1__override = std::numeric_limits<float>::quiet_NaN();
+	store.pid_0__enable = false;
+	bank.refresh();
+	float int0 = bank.int_(0);
+	float u0_prev = bank.u(0);
+	store.pid_0__u = 5.0f;
+	bank(y, u);
+	EXPECT_FALSE(store.pid_1__reset.get());
+	EXPECT_FLOAT_EQ(bank.Ki(1), 0.0f);
+	EXPECT_FLOAT_EQ(u[1], 0.0f);
+
+	// While disabled, the previous output is returned, but not written.
+	EXPECT_FLOAT_EQ(bank.int_(0), int0);
+	EXPECT_FLOAT_EQ(u[0], u0_prev);
+	EXPECT_FLOAT_EQ(store.pid_0__u.get(), 5.0f);
+
+	// Use y from the store.
+	store.pid_2__y = 1.0f;
+	bank(u);
+	EXPECT_LT(u[2], 0.0f);
+}
+
+TEST(PIDBank, MatchesPID)
+{
+	using PIDCached = stored::PID<ComponentTestStore, pid0_o.flags(), float, true>;
+
+	ComponentTestStore store_bank;
+	ComponentTestStore store_pid;
+
+	PIDBank4 bank{pids_o, store_bank};
+	PIDCached pid[4] = {
+		PIDCached{pid0_o, store_pid}, PIDCached{pid1_o, store_pid},
+		PIDCached{pid2_o, store_pid}, PIDCached{pid3_o, store_pid}};
+
+	auto refresh = [&](size_t i) {
+		bank.refresh(i);
+		pid[i].refresh();
+	};
+
+	float const nan = std::numeric_limits<float>::quiet_NaN();
+	float y[4] = {0.0f, 0.5f, 1.0f, -1.0f};
+	float u[4] = {};
+
+	for(int step = 0; step < 120; step++) {
+		for(auto* s : {&store_bank, &store_pid}) {
+			switch(step) {
+			case 0:
+				// pid 2 and 3 run without reset, so without Ki and Kd.
+				s->pid_0__reset = true;
+				s->pid_1__reset = true;
+				s->pid_0__setpoint = 1.0f;
+				s->pid_1__setpoint = -2.0f;
+				s->pid_2__setpoint = 3.0f;
+				break;
+			case 20:
+				s->pid_1__enable = false;
+				s->pid_1__u = 7.0f;
+				break;
+			case 30:
+				s->pid_2__override = 2.0f;
+				s->pid_2__reset = true;
+				break;
+			case 40:
+				s->pid_0__Kp = 3.0f;
+				s->pid_0__Ti = 0.2f;
+				break;
+			case 60:
+				s->pid_1__enable = true;
+				break;
+			case 70:
+				s->pid_2__override = nan;
+				break;
+			case 90:
+				s->pid_0__reset = true;
+				s->pid_3__reset = true;
+				break;
+			default:;
+			}
+		}
+
+		switch(step) {
+		case 20:
+		case 60:
+			refresh(1);
+			break;
+		case 30:
+		case 70:
+			refresh(2);
+			break;
+		case 40:
+			// Kp is used from now on, but Ti only after the reset at step 90.
+			refresh(0);
+			break;
+		default:;
+		}
+
+		bank(y, u);
+
+		for(size_t i = 0; i < 4; i++) {
+			float ui = pid[i](y[i]);
+			EXPECT_FLOAT_EQ(u[i], ui) << "step " << step << " pid " << i;
+			EXPECT_FLOAT_EQ(bank.u(i), pid[i].u()) << "step " << step << " pid " << i;
+			EXPECT_FLOAT_EQ(bank.int_(i), pid[i].int_())
+				<< "step " << step << " pid " << i;
+			EXPECT_FLOAT_EQ(bank.Ki(i), pid[i].Ki()) << "step " << step << " pid " << i;
+			EXPECT_FLOAT_EQ(bank.Kd(i), pid[i].Kd()) << "step " << step << " pid " << i;
+			y[i] += u[i] * 0.01f;
+		}
+
+		EXPECT_FLOAT_EQ(store_bank.pid_1__u.get(), store_pid.pid_1__u.get())
+			<< "step " << step;
+		EXPECT_EQ(store_bank.pid_2__reset.get(), store_pid.pid_2__reset.get())
+			<< "step " << step;
+
+		if(step == 50) {
+			// Disabled, so u is not written.
+			EXPECT_FLOAT_EQ(store_bank.pid_1__u.get(), 7.0f);
+			// Overridden, so the reset is still pending.
+			EXPECT_TRUE(store_bank.pid_2__reset.get());
+		}
+	}
+
+	EXPECT_FALSE(store_bank.pid_2__reset.get());
+	EXPECT_FLOAT_EQ(store_bank.pid_3__u.get(), store_pid.pid_3__u.get());
+	EXPECT_FLOAT_EQ(store_bank.pid_0__int.get(), store_pid.pid_0__int.get());
+}
+
+TEST(PIDBank, CachedHook)
+{
+	HookedTestStore store;
+	constexpr auto pid_o = stored::PID<HookedTestStore>::objects<PID_IDS>("/pid 0/");
+	constexpr stored::PIDObjects<HookedTestStore> o[] = {
+		pid_o, stored::PID<HookedTestStore>::objects<PID_IDS>("/pid 1/")};
+	stored::PIDBank<HookedTestStore, 2, pid_o.flags()> bank{o, store};
+	void* changed = nullptr;
+	store.onChanged = [&](void* buffer) {
+		changed = buffer;
+		bank.refreshIfUsed(buffer);
+	};
+
+	float y[2] = {};
+	float u[2] = {};
+	store.pid_0__setpoint = 1.0f;
+	bank(y, u);
+	EXPECT_FLOAT_EQ(u[0], 1.1f);
+
+	// Inputs and outputs do not invalidate the parameters.
+	store.pid_0__setpoint = 2.0f;
+	EXPECT_FALSE(bank.refreshIfUsed(changed));
+	bank(y, u);
+	EXPECT_FALSE(bank.refreshIfUsed(changed));
+	EXPECT_FLOAT_EQ(u[0], 2.2f);
+
+	store.pid_0__Kp = 3.0f;
+	EXPECT_TRUE(bank.refreshIfUsed(0, changed));
+	EXPECT_FALSE(bank.refreshIfUsed(1, changed));
+	bank(y, u);
+	EXPECT_FLOAT_EQ(u[0], 6.2f);
+}
+
+TEST(PIDBank, CachedJournal)
+{
+	SyncTestStore store;
+	constexpr auto pid_o = stored::PID<SyncTestStore>::objects<PID_IDS>("/pid 0/");
+	constexpr stored::PIDObjects<SyncTestStore> o[] = {
+		pid_o, stored::PID<SyncTestStore>::objects<PID_IDS>("/pid 1/")};
+	stored::PIDBank<SyncTestStore, 2, pid_o.flags()> bank{o, store};
+
+	float y[2] = {};
+	float u[2] = {};
+	store.pid_0__setpoint = 1.0f;
+	EXPECT_TRUE(bank.refreshIfChanged(store.journal()));
+	bank(y, u);
+	EXPECT_FLOAT_EQ(u[0], 1.1f);
+	EXPECT_FALSE(bank.refreshIfChanged(store.journal()));
+
+	store.pid_1__Kp = 3.0f;
+	EXPECT_FALSE(bank.refreshIfChanged(0, store.journal()));
+	EXPECT_TRUE(bank.refreshIfChanged(1, store.journal()));
+	bank(y, u);
+
+	// Inputs are in the journal too, but are not parameters.
+	store.pid_0__setpoint = 2.0f;
+	EXPECT_FALSE(bank.refreshIfChanged(store.journal()));
+
+	store.pid_0__Kp = 3.0f;
+	EXPECT_TRUE(bank.refreshIfChanged(store.journal()));
+	bank(y, u);
+	EXPECT_FLOAT_EQ(u[0], 6.2f);
+	EXPECT_FALSE(bank.refreshIfChanged(store.journal()));
+}
+
+#undef PID_IDS
+
+TEST(PIDBank, Benchmark)
+{
+	SKIP_UNLESS_BENCHMARK();
+
+	constexpr size_t N = 64;
+	constexpr size_t Runs = 20000;
+
+	ComponentTestStore store;
+	store.pid_0__setpoint = 1.0f;
+	store.pid_1__setpoint = 2.0f;
+	store.pid_2__setpoint = -1.0f;
+	store.pid_3__setpoint = 0.5f;
+
+	stored::PIDObjects<ComponentTestStore> o[N];
+	for(size_t i = 0; i < N; i++)
+		o[i] = pids_o[i % 4];
+
+	auto bank = std::make_unique<stored::PIDBank<ComponentTestStore, N, pid0_o.flags()>>(o, store);
+
+	std::vector<PID4> pid;
+	for(size_t i = 0; i < N; i++)
+		pid.emplace_back(o[i], store);
+
+	float y[N] = {};
+	float u[N] = {};
+	float sum = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	for(size_t r = 0; r < Runs; r++) {
+		(*bank)(y, u);
+		for(size_t i = 0; i < N; i++)
+			y[i] = u[i] * 0.5f;
+	}
+	auto bank_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			       std::chrono::steady_clock::now() - start)
+			       .count();
+	sum += u[0];
+
+	for(size_t i = 0; i < N; i++)
+		y[i] = 0;
+
+	start = std::chrono::steady_clock::now();
+	for(size_t r = 0; r < Runs; r++) {
+		for(size_t i = 0; i < N; i++)
+			y[i] = pid[i](y[i]) * 0.5f;
+	}
+	auto pid_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			      std::chrono::steady_clock::now() - start)
+			      .count();
+	sum += y[0];
+
+	printf("PIDBank<%u>: %.1f ns/controller, %u x PID: %.1f ns/controller (%g)\n",
+	       (unsigned)N, (double)bank_ns / (double)(Runs * N), (unsigned)N,
+	       (double)pid_ns / (double)(Runs * N), (double)sum);
+}
+
+static std::vector<float> blockInput(size_t len)
+{
+	std::vector<float> in(len);
+	for(size_t i = 0; i < len; i++)
+		in[i] = (float)((i * 7u) % 23u) - 11.0f + (i > len / 2 ? 30.0f : 0.0f);
+	return in;
+}
+
+TEST(Amplifier, Block)
+{
+	ComponentTestStore store;
+	ComponentTestStore store_block;
+	constexpr auto amp_o = stored::Amplifier<ComponentTestStore>::objects("/amp/");
+	stored::Amplifier<ComponentTestStore, amp_o.flags()> amp{amp_o, store};
+	stored::Amplifier<ComponentTestStore, amp_o.flags()> amp_block{amp_o, store_block};
+
+	auto in = blockInput(100);
+	std::vector<float> out(in.size());
+	amp_block(in.data(), out.data(), in.size());
+
+	for(size_t i = 0; i < in.size(); i++)
+		EXPECT_FLOAT_EQ(out[i], amp(in[i]));
+
+	EXPECT_FLOAT_EQ(store_block.amp__input.get(), in.back());
+	EXPECT_FLOAT_EQ(store_block.amp__output.get(), out.back());
+
+	store_block.amp__override = 3.0f;
+	float in3[3] = {1.0f, 2.0f, 3.0f};
+	float out3[3] = {};
+	amp_block(in3, out3);
+	EXPECT_FLOAT_EQ(out3[0], 3.0f);
+	EXPECT_FLOAT_EQ(out3[2], 3.0f);
+}
+
+TEST(LowPass, Block)
+{
+	ComponentTestStore store;
+	ComponentTestStore store_block;
+	constexpr auto lp_o = stored::LowPass<ComponentTestStore>::objects("/lowpass/");
+	stored::LowPass<ComponentTestStore, lp_o.flags()> lp{lp_o, store};
+	stored::LowPass<ComponentTestStore, lp_o.flags()> lp_block{lp_o, store_block};
+
+	auto in = blockInput(100);
+	std::vector<float> out(in.size());
+
+	// Split in blocks of different sizes.
+	lp_block(in.data(), out.data(), 1);
+	lp_block(in.data() + 1, out.data() + 1, 40);
+	lp_block(in.data() + 41, out.data() + 41, in.size() - 41);
+
+	for(size_t i = 0; i < in.size(); i++)
+		EXPECT_FLOAT_EQ(out[i], lp(in[i]));
+
+	EXPECT_FLOAT_EQ(store_block.lowpass__input.get(), in.back());
+	EXPECT_FLOAT_EQ(store_block.lowpass__output.get(), out.back());
+
+	store.lowpass__enable = false;
+	store_block.lowpass__enable = false;
+	lp_block(in.data(), out.data(), 10);
+	for(size_t i = 0; i < 10; i++)
+		EXPECT_FLOAT_EQ(out[i], lp(in[i]));
+
+	store.lowpass__enable = true;
+	store_block.lowpass__enable = true;
+	lp_block(in.data(), out.data(), 10);
+	for(size_t i = 0; i < 10; i++)
+		EXPECT_FLOAT_EQ(out[i], lp(in[i]));
+}
+
+TEST(Sine, Block)
+{
+	ComponentTestStore store;
+	ComponentTestStore store_block;
+	constexpr auto sine_o = stored::Sine<ComponentTestStore>::objects("/sine/");
+	stored::Sine<ComponentTestStore, sine_o.flags()> sine{sine_o, store};
+	stored::Sine<ComponentTestStore, sine_o.flags()> sine_block{sine_o, store_block};
+
+	std::vector<float> out(500);
+	sine_block(out.data(), 123);
+	sine_block(out.data() + 123, out.size() - 123);
+
+	for(size_t i = 0; i < out.size(); i++)
+		EXPECT_FLOAT_EQ(out[i], sine());
+
+	EXPECT_FLOAT_EQ(store_block.sine__output.get(), out.back());
+
+	// The phase keeps running when the output is overridden.
+	store.sine__override = 1.0f;
+	store_block.sine__override = 1.0f;
+	float out10[10] = {};
+	sine_block(out10);
+	for(size_t i = 0; i < 10; i++)
+		EXPECT_FLOAT_EQ(out10[i], sine());
+
+	store.sine__override = std::numeric_limits<float>::quiet_NaN();
+	store_block.sine__override = std::numeric_limits<float>::quiet_NaN();
+	sine_block(out10);
+	for(size_t i = 0; i < 10; i++)
+		EXPECT_FLOAT_EQ(out10[i], sine());
+}
+
+TEST(Ramp, Block)
+{
+	ComponentTestStore store;
+	ComponentTestStore store_block;
+	constexpr auto ramp_o = stored::Ramp<ComponentTestStore>::objects("/ramp/");
+	stored::Ramp<ComponentTestStore, ramp_o.flags()> ramp{ramp_o, store};
+	stored::Ramp<ComponentTestStore, ramp_o.flags()> ramp_block{ramp_o, store_block};
+
+	std::vector<float> in(1000, 1.0f);
+	for(size_t i = in.size() / 2; i < in.size(); i++)
+		in[i] = -0.5f;
+
+	std::vector<float> out(in.size());
+	for(size_t i = 0; i < in.size(); i += 100)
+		ramp_block(in.data() + i, out.data() + i, 100);
+
+	for(size_t i = 0; i < in.size(); i++)
+		EXPECT_FLOAT_EQ(out[i], ramp(in[i]));
+
+	EXPECT_FLOAT_EQ(out.back(), -0.5f);
+	EXPECT_FLOAT_EQ(store_block.ramp__input.get(), in.back());
+	EXPECT_FLOAT_EQ(store_block.ramp__output.get(), out.back());
+
+	store.ramp__enable = false;
+	store_block.ramp__enable = false;
+	ramp_block(in.data(), out.data(), 10);
+	for(size_t i = 0; i < 10; i++)
+		EXPECT_FLOAT_EQ(out[i], ramp(in[i]));
+
+	store.ramp__enable = true;
+	store_block.ramp__enable = true;
+	ramp_block(in.data(), out.data(), 100);
+	for(size_t i = 0; i < 100; i++)
+		EXPECT_FLOAT_EQ(out[i], ramp(in[i]));
+}
+
+TEST(Sine, Methods)
+{
+	ComponentTestStore store;
+	constexpr auto sine_o = stored::Sine<ComponentTestStore>::objects("/sine/");
+	stored::Sine<ComponentTestStore, sine_o.flags()> exact{sine_o, store};
+	stored::Sine<ComponentTestStore, sine_o.flags(), float, false, stored::SineMethod::Table>
+		table{sine_o, store};
+	stored::Sine<
+		ComponentTestStore, sine_o.flags(), float, false, stored::SineMethod::Oscillator>
+		osc{sine_o, store};
+
+	double exact_err = 0;
+	double table_err = 0;
+	double osc_err = 0;
+
+	for(int i = 0; i < 10000; i++) {
+		// Amplitude 2, frequency 3 Hz, phase 0.5 rad, sample frequency 1 kHz.
+		double y = 2.0 * std::sin(2.0 * stored::pi<double> * 3.0 * (double)i / 1000.0 + 0.5);
+		exact_err = std::max(exact_err, std::fabs((double)exact() - y));
+		table_err = std::max(table_err, std::fabs((double)table() - y));
+		osc_err = std::max(osc_err, std::fabs((double)osc() - y));
+	}
+
+	EXPECT_LT(exact_err, 2e-3);
+	EXPECT_LT(table_err, 2e-5);
+	EXPECT_LT(osc_err, 1e-3);
+
+	// Change parameters on the fly.  Contrary to SineMethod::Exact, which
+	// keeps the time within the period, the phase remains continuous.
+	// Compare the oscillator against the table.
+	store.sine__frequency = 7.0f;
+	store.sine__phase = -1.0f;
+
+	for(int i = 0; i < 1000; i++)
+		EXPECT_NEAR(osc(), table(), 2e-3f);
+
+	// Block computation is identical to per-sample computation.
+	float out[100];
+	float out_osc[100];
+	table(out);
+	osc(out_osc);
+	for(size_t i = 0; i < 100; i++)
+		EXPECT_NEAR(out_osc[i], out[i], 2e-3f);
+
+	store.sine__override = 1.0f;
+	EXPECT_FLOAT_EQ(table(), 1.0f);
+	EXPECT_FLOAT_EQ(osc(), 1.0f);
+
+	store.sine__override = std::numeric_limits<float>::quiet_NaN();
+	store.sine__enable = false;
+	EXPECT_FLOAT_EQ(table(), 0.0f);
+	EXPECT_FLOAT_EQ(osc(), 0.0f);
+
+	// The phase keeps running while disabled.
+	store.sine__enable = true;
+	EXPECT_NEAR(osc(), table(), 2e-3f);
+}
+
+TEST(Sine, MethodsBenchmark)
+{
+	SKIP_UNLESS_BENCHMARK();
+
+	constexpr size_t Len = 256;
+	constexpr int Runs = 2000;
+
+	ComponentTestStore store;
+	constexpr auto sine_o = stored::Sine<ComponentTestStore>::objects("/sine/");
+	stored::Sine<ComponentTestStore, sine_o.flags(), float, true> exact{sine_o, store};
+	stored::Sine<ComponentTestStore, sine_o.flags(), float, true, stored::SineMethod::Table>
+		table{sine_o, store};
+	stored::Sine<
+		ComponentTestStore, sine_o.flags(), float, true, stored::SineMethod::Oscillator>
+		osc{sine_o, store};
+
+	std::vector<double> ref(Len * Runs);
+	for(size_t i = 0; i < ref.size(); i++)
+		ref[i] = 2.0 * std::sin(2.0 * stored::pi<double> * 3.0 * (double)i / 1000.0 + 0.5);
+
+	std::vector<float> out(Len);
+	float sum = 0;
+
+	auto measure = [&](char const* name, auto& sine) {
+		double err = 0;
+		long ns = 0;
+		for(int r = 0; r < Runs; r++) {
+			auto t0 = std::chrono::steady_clock::now();
+			sine(out.data(), Len);
+			auto t1 = std::chrono::steady_clock::now();
+			ns += (long)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0)
+				      .count();
+
+			for(size_t i = 0; i < Len; i++)
+				err = std::max(
+					err, std::fabs((double)out[i] - ref[(size_t)r * Len + i]));
+			sum += out[Len - 1];
+		}
+
+		printf("%-11s %6.2f ns/sample, max error %g over %u samples\n", name,
+		       (double)ns / (double)(Runs * (long)Len), err, (unsigned)(Runs * Len));
+	};
+
+	measure("Exact:", exact);
+	measure("Table:", table);
+	measure("Oscillator:", osc);
+	printf("(checksum %g)\n", (double)sum);
+}
+
+TEST(Block, Benchmark)
+{
+	SKIP_UNLESS_BENCHMARK();
+
+	constexpr size_t Len = 256;
+	constexpr int Runs = 2000;
+
+	ComponentTestStore store;
+	constexpr auto amp_o = stored::Amplifier<ComponentTestStore>::objects("/amp/");
+	stored::Amplifier<ComponentTestStore, amp_o.flags(), float, true> amp{amp_o, store};
+	constexpr auto lp_o = stored::LowPass<ComponentTestStore>::objects("/lowpass/");
+	stored::LowPass<ComponentTestStore, lp_o.flags(), float, true> lp{lp_o, store};
+	constexpr auto sine_o = stored::Sine<ComponentTestStore>::objects("/sine/");
+	stored::Sine<ComponentTestStore, sine_o.flags(), float, true> sine{sine_o, store};
+	constexpr auto ramp_o = stored::Ramp<ComponentTestStore>::objects("/ramp/");
+	stored::Ramp<ComponentTestStore, ramp_o.flags(), float, true> ramp{ramp_o, store};
+
+	auto in = blockInput(Len);
+	std::vector<float> out(Len);
+	float sum = 0;
+
+	auto measure = [&](char const* name, std::function<void()> const& sample,
+			   std::function<void()> const& block) {
+		auto t0 = std::chrono::steady_clock::now();
+		for(int r = 0; r < Runs; r++)
+			sample();
+		auto t1 = std::chrono::steady_clock::now();
+		for(int r = 0; r < Runs; r++)
+			block();
+		auto t2 = std::chrono::steady_clock::now();
+
+		auto sample_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+		auto block_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count();
+		printf("%-9s per-sample: %6.2f ns/sample, block of %u: %6.2f ns/sample\n", name,
+		       (double)sample_ns / (double)(Runs * (long)Len), (unsigned)Len,
+		       (double)block_ns / (double)(Runs * (long)Len));
+	};
+
+	measure(
+		"Amplifier",
+		[&]() {
+			for(size_t i = 0; i < Len; i++)
+				out[i] = amp(in[i]);
+			sum += out[Len - 1];
+		},
+		[&]() {
+			amp(in.data(), out.data(), Len);
+			sum += out[Len - 1];
+		});
+
+	measure(
+		"LowPass",
+		[&]() {
+			for(size_t i = 0; i < Len; i++)
+				out[i] = lp(in[i]);
+			sum += out[Len - 1];
+		},
+		[&]() {
+			lp(in.data(), out.data(), Len);
+			sum += out[Len - 1];
+		});
+
+	measure(
+		"Sine",
+		[&]() {
+			for(size_t i = 0; i < Len; i++)
+				out[i] = sine();
+			sum += out[Len - 1];
+		},
+		[&]() {
+			sine(out.data(), Len);
+			sum += out[Len - 1];
+		});
+
+	measure(
+		"Ramp",
+		[&]() {
+			for(size_t i = 0; i < Len; i++)
+				out[i] = ramp(in[i]);
+			sum += out[Len - 1];
+		},
+		[&]() {
+			ramp(in.data(), out.data(), Len);
+			sum += out[Len - 1];
+		});
+
+	printf("(checksum %g)\n", (double)sum);
+}
+
+TEST(Fixed, Arithmetic)
+{
+	using stored::Q15;
+	using stored::Q31;
+
+	EXPECT_EQ(sizeof(Q15), sizeof(int16_t));
+	EXPECT_EQ(sizeof(Q31), sizeof(int32_t));
+
+	EXPECT_EQ(Q15(0.5f).raw(), 16384);
+	EXPECT_EQ(Q15(-0.5).raw(), -16384);
+	EXPECT_EQ(Q15(0).raw(), 0);
+	EXPECT_FLOAT_EQ((float)Q15(0.25f), 0.25f);
+	EXPECT_DOUBLE_EQ((double)Q31(-0.125), -0.125);
+
+	// Saturation.
+	EXPECT_EQ(Q15(1).raw(), 32767);
+	EXPECT_EQ(Q15(-1).raw(), -32767);
+	EXPECT_EQ(Q15(100.0f).raw(), 32767);
+	EXPECT_EQ(Q15(-2.0f).raw(), -32767);
+	EXPECT_EQ((Q15(0.75f) + Q15(0.75f)).raw(), 32767);
+	EXPECT_EQ((Q15(-0.75f) - Q15(0.75f)).raw(), -32767);
+	EXPECT_EQ((Q15(0.5f) / Q15(0.25f)).raw(), 32767);
+	EXPECT_EQ((Q15(0.5f) / Q15(0)).raw(), 32767);
+	EXPECT_EQ((Q15(-0.5f) / Q15(0)).raw(), -32767);
+	EXPECT_EQ((Q15(0) / Q15(0)).raw(), 0);
+	EXPECT_EQ((-std::numeric_limits<Q15>::lowest()).raw(), 32767);
+	EXPECT_EQ(std::numeric_limits<Q15>::min().raw(), 1);
+	EXPECT_GT(std::numeric_limits<Q15>::min(), Q15(0));
+	EXPECT_EQ((Q31(0.75) + Q31(0.75)).raw(), 2147483647);
+
+	// Rounding.
+	EXPECT_EQ((Q15(0.5f) * Q15(0.5f)).raw(), 8192);
+	EXPECT_EQ((Q15::fromRaw(1) * Q15(0.5f)).raw(), 1);
+	EXPECT_EQ((Q15(0.25f) / Q15(0.5f)).raw(), 16384);
+	EXPECT_EQ((Q31(0.5) * Q31(-0.5)).raw(), -536870912);
+
+	// Other formats.
+	using Q16 = stored::Fixed<int32_t, 16>;
+	EXPECT_FLOAT_EQ((float)(Q16(10) * Q16(0.5f)), 5.0f);
+	EXPECT_FLOAT_EQ((float)(Q16(-3) / Q16(4)), -0.75f);
+
+	// NaN marker.
+	EXPECT_TRUE(stored::impl::isnan(std::numeric_limits<Q15>::quiet_NaN()));
+	EXPECT_TRUE(stored::impl::isnan(Q31(std::numeric_limits<float>::quiet_NaN())));
+	EXPECT_TRUE(std::isnan((float)std::numeric_limits<Q15>::quiet_NaN()));
+	EXPECT_FALSE(stored::impl::isnan(std::numeric_limits<Q15>::lowest()));
+	EXPECT_FALSE(stored::impl::isnan(Q15(-5)));
+}
+
+TEST(Fixed, SinTurns)
+{
+	for(int i = -1000; i <= 1000; i++) {
+		double x = (double)i / 1000.0;
+		auto phase = (uint32_t)(int64_t)(x * 4294967296.0);
+		double s = std::sin(2.0 * stored::pi<double> * x);
+		EXPECT_NEAR((double)(stored::impl::sin_turns<int32_t, 31>(phase)), s, 1e-6);
+		EXPECT_NEAR((double)(stored::impl::sin_turns<int16_t, 15>(phase)), s, 1e-4);
+	}
+}
+
+TEST(Fixed, Amplifier)
+{
+	ComponentTestStore store;
+	constexpr auto amp_o = stored::Amplifier<ComponentTestStore>::objects("/amp/");
+	stored::Amplifier<ComponentTestStore, amp_o.flags()> amp{amp_o, store};
+	constexpr auto q15_o = stored::Amplifier<ComponentTestStore, 0, stored::Q15>::objects(
+		"/q15 amp/");
+	stored::Amplifier<ComponentTestStore, q15_o.flags(), stored::Q15> q15{q15_o, store};
+	constexpr auto q31_o = stored::Amplifier<ComponentTestStore, 0, stored::Q31>::objects(
+		"/q31 amp/");
+	stored::Amplifier<ComponentTestStore, q31_o.flags(), stored::Q31> q31{q31_o, store};
+
+	store.amp__gain = 0.75f;
+	store.amp__offset = 0.125f;
+	store.amp__low = -0.5f;
+	store.amp__high = 0.8f;
+	store.q15_amp__gain = stored::Q15(0.75f).raw();
+	store.q15_amp__offset = stored::Q15(0.125f).raw();
+	store.q15_amp__low = stored::Q15(-0.5f).raw();
+	store.q15_amp__high = stored::Q15(0.8f).raw();
+	store.q31_amp__gain = stored::Q31(0.75).raw();
+	store.q31_amp__offset = stored::Q31(0.125).raw();
+	store.q31_amp__low = stored::Q31(-0.5).raw();
+	store.q31_amp__high = stored::Q31(0.8).raw();
+
+	for(int i = -100; i < 100; i++) {
+		float x = (float)i / 100.0f;
+		float y = amp(x);
+		EXPECT_NEAR((float)q15(stored::Q15(x)), y, 1e-4f);
+		EXPECT_NEAR((float)q31(stored::Q31(x)), y, 1e-6f);
+	}
+
+	EXPECT_EQ(store.q15_amp__input.get(), stored::Q15(0.99f).raw());
+	EXPECT_NEAR((float)stored::Q15::fromRaw(store.q15_amp__output.get()), 0.8f, 1e-4f);
+
+	store.q15_amp__override = stored::Q15(0.25f).raw();
+	EXPECT_FLOAT_EQ((float)q15(stored::Q15(0.5f)), 0.25f);
+}
+
+TEST(Fixed, LowPass)
+{
+	using Q16 = stored::Fixed<int32_t, 16>;
+
+	ComponentTestStore store;
+	constexpr auto lp_o = stored::LowPass<ComponentTestStore>::objects("/lowpass/");
+	stored::LowPass<ComponentTestStore, lp_o.flags()> lp{lp_o, store};
+	constexpr auto fixed_o =
+		stored::LowPass<ComponentTestStore, 0, Q16>::objects("/q16 lowpass/");
+	stored::LowPass<ComponentTestStore, fixed_o.flags(), Q16> fixed{fixed_o, store};
+
+	store.q16_lowpass__cutoff_frequency = Q16(10).raw();
+
+	auto in = blockInput(500);
+	for(auto x : in) {
+		float y = lp(x);
+		EXPECT_NEAR((float)fixed(Q16(x)), y, 1e-3f);
+	}
+}
+
+TEST(Fixed, PID)
+{
+	ComponentTestStore store;
+	PID4 pid{pid0_o, store};
+	constexpr auto q15_o = stored::PID<ComponentTestStore, 0, stored::Q15>::objects<
+		'f', 'y', 's', 'e', 'p', 'i', 'd', 'k', 'I', 'l', 'h', 'r', 'F', 'u'>("/q15 pid/");
+	stored::PID<ComponentTestStore, q15_o.flags(), stored::Q15> q15{q15_o, store};
+
+	store.pid_0__Kp = 0.5f;
+	store.pid_0__Ti = 0.5f;
+	store.pid_0__Td = 0.01f;
+	store.pid_0__Kff = 0.1f;
+	store.pid_0__low = -0.9f;
+	store.pid_0__high = 0.9f;
+	store.q15_pid__Kp = stored::Q15(0.5f).raw();
+	store.q15_pid__Ti = stored::Q15(0.5f).raw();
+	store.q15_pid__Td = stored::Q15(0.01f).raw();
+	store.q15_pid__Kff = stored::Q15(0.1f).raw();
+	store.q15_pid__low = stored::Q15(-0.9f).raw();
+	store.q15_pid__high = stored::Q15(0.9f).raw();
+	store.pid_0__reset = true;
+	store.q15_pid__reset = true;
+
+	// Simple first-order plant.
+	float y = 0;
+	stored::Q15 y15 = 0;
+	float max_err = 0;
+
+	for(int i = 0; i < 2000; i++) {
+		float sp = i < 1000 ? 0.5f : -0.25f;
+		store.pid_0__setpoint = sp;
+		store.q15_pid__setpoint = stored::Q15(sp).raw();
+		store.pid_0__y = y;
+		store.q15_pid__y = y15.raw();
+
+		float u = pid();
+		stored::Q15 u15 = q15();
+		max_err = std::max(max_err, std::fabs((float)u15 - u));
+
+		y += (u - y) * 0.05f;
+		y15 += (u15 - y15) * stored::Q15(0.05f);
+	}
+
+	EXPECT_LT(max_err, 1e-2f);
+	EXPECT_NEAR(y, -0.25f, 1e-2f);
+	EXPECT_NEAR((float)y15, -0.25f, 1e-2f);
+
+	store.q15_pid__override = stored::Q15(0.125f).raw();
+	EXPECT_FLOAT_EQ((float)q15(), 0.125f);
+}
+
+TEST(Fixed, Sine)
+{
+	ComponentTestStore store;
+	constexpr auto sine_o = stored::Sine<ComponentTestStore>::objects("/sine/");
+	stored::Sine<ComponentTestStore, sine_o.flags()> sine{sine_o, store};
+	constexpr auto q15_o = stored::Sine<ComponentTestStore, 0, stored::Q15>::objects("/q15 sine/");
+	stored::Sine<ComponentTestStore, q15_o.flags(), stored::Q15> q15{q15_o, store};
+	constexpr auto q31_o = stored::Sine<ComponentTestStore, 0, stored::Q31>::objects("/q31 sine/");
+	stored::Sine<ComponentTestStore, q31_o.flags(), stored::Q31> q31{q31_o, store};
+
+	store.sine__amplitude = 0.9f;
+	store.sine__frequency = 0.75f;
+	store.sine__phase = 0.5f;
+	store.q15_sine__amplitude = stored::Q15(0.9f).raw();
+	store.q15_sine__frequency = stored::Q15(0.75f).raw();
+	store.q15_sine__phase = stored::Q15(0.5f).raw();
+	store.q31_sine__amplitude = stored::Q31(0.9).raw();
+	store.q31_sine__frequency = stored::Q31(0.75).raw();
+	store.q31_sine__phase = stored::Q31(0.5).raw();
+
+	// Run for a few periods.
+	for(int i = 0; i < 4000; i++) {
+		float y = sine();
+		EXPECT_NEAR((float)q15(), y, 2e-4f);
+		EXPECT_NEAR((float)q31(), y, 1e-4f);
+	}
+
+	store.q15_sine__override = stored::Q15(0.5f).raw();
+	EXPECT_FLOAT_EQ((float)q15(), 0.5f);
+	store.q15_sine__enable = false;
+	store.q15_sine__override = std::numeric_limits<stored::Q15>::quiet_NaN().raw();
+	EXPECT_FLOAT_EQ((float)q15(), 0.0f);
+}
+
+TEST(Fixed, Benchmark)
+{
+	SKIP_UNLESS_BENCHMARK();
+
+	// The host probably has an FPU, so float is fast here.  The fixed-point
+	// numbers give an indication of the integer cost, which is what a
+	// controller without FPU executes.
+	constexpr int Runs = 100000;
+	using Q16 = stored::Fixed<int32_t, 16>;
+
+	ComponentTestStore store;
+	store.pid_0__reset = true;
+	store.q15_pid__reset = true;
+	store.q15_pid__Kp = stored::Q15(0.5f).raw();
+	store.q15_pid__Ti = stored::Q15(0.5f).raw();
+	store.q15_sine__amplitude = stored::Q15(0.9f).raw();
+	store.q15_sine__frequency = stored::Q15(0.75f).raw();
+	store.q31_sine__amplitude = stored::Q31(0.9).raw();
+	store.q31_sine__frequency = stored::Q31(0.75).raw();
+	store.q16_lowpass__cutoff_frequency = Q16(10).raw();
+
+	constexpr auto amp_o = stored::Amplifier<ComponentTestStore>::objects("/amp/");
+	constexpr auto amp15_o =
+		stored::Amplifier<ComponentTestStore, 0, stored::Q15>::objects("/q15 amp/");
+	constexpr auto amp31_o =
+		stored::Amplifier<ComponentTestStore, 0, stored::Q31>::objects("/q31 amp/");
+	stored::Amplifier<ComponentTestStore, amp_o.flags(), float, true> amp{amp_o, store};
+	stored::Amplifier<ComponentTestStore, amp15_o.flags(), stored::Q15, true> amp15{
+		amp15_o, store};
+	stored::Amplifier<ComponentTestStore, amp31_o.flags(), stored::Q31, true> amp31{
+		amp31_o, store};
+
+	constexpr auto lp_o = stored::LowPass<ComponentTestStore>::objects("/lowpass/");
+	constexpr auto lp16_o =
+		stored::LowPass<ComponentTestStore, 0, Q16>::objects("/q16 lowpass/");
+	stored::LowPass<ComponentTestStore, lp_o.flags(), float, true> lp{lp_o, store};
+	stored::LowPass<ComponentTestStore, lp16_o.flags(), Q16, true> lp16{lp16_o, store};
+
+	constexpr auto pid15_o = stored::PID<ComponentTestStore, 0, stored::Q15>::objects<
+		'f', 'y', 's', 'e', 'p', 'i', 'd', 'k', 'I', 'l', 'h', 'r', 'F', 'u'>("/q15 pid/");
+	stored::PID<ComponentTestStore, pid0_o.flags(), float, true> pid{pid0_o, store};
+	stored::PID<ComponentTestStore, pid15_o.flags(), stored::Q15, true> pid15{pid15_o, store};
+
+	constexpr auto sine_o = stored::Sine<ComponentTestStore>::objects("/sine/");
+	constexpr auto sine15_o =
+		stored::Sine<ComponentTestStore, 0, stored::Q15>::objects("/q15 sine/");
+	constexpr auto sine31_o =
+		stored::Sine<ComponentTestStore, 0, stored::Q31>::objects("/q31 sine/");
+	stored::Sine<ComponentTestStore, sine_o.flags(), float, true> sine{sine_o, store};
+	stored::Sine<ComponentTestStore, sine15_o.flags(), stored::Q15, true> sine15{
+		sine15_o, store};
+	stored::Sine<ComponentTestStore, sine31_o.flags(), stored::Q31, true> sine31{
+		sine31_o, store};
+
+	double sum = 0;
+
+	auto measure = [&](char const* name, auto&& f) {
+		auto t0 = std::chrono::steady_clock::now();
+#ifdef HAVE_RDTSC
+		auto c0 = __rdtsc();
+#endif
+		for(int i = 0; i < Runs; i++)
+			sum += (double)f((i & 0xff) - 128);
+#ifdef HAVE_RDTSC
+		auto c1 = __rdtsc();
+#endif
+		auto t1 = std::chrono::steady_clock::now();
+		auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+
+#ifdef HAVE_RDTSC
+		printf("%-14s %6.2f ns/call, %6.1f TSC cycles/call\n", name,
+		       (double)ns / (double)Runs, (double)(c1 - c0) / (double)Runs);
+#else
+		printf("%-14s %6.2f ns/call\n", name, (double)ns / (double)Runs);
+#endif
+	};
+
+	measure("Amplifier", [&](int x) { return amp((float)x / 256.0f); });
+	measure("Amplifier Q15", [&](int x) { return amp15(stored::Q15::fromRaw((int16_t)x)); });
+	measure("Amplifier Q31", [&](int x) { return amp31(stored::Q31::fromRaw(x << 16)); });
+	measure("LowPass", [&](int x) { return lp((float)x / 256.0f); });
+	measure("LowPass Q16", [&](int x) { return lp16(Q16::fromRaw(x << 8)); });
+	measure("PID", [&](int x) {
+		store.pid_0__y = (float)x / 256.0f;
+		return pid();
+	});
+	measure("PID Q15", [&](int x) {
+		store.q15_pid__y = (int16_t)(x << 7);
+		return pid15();
+	});
+	measure("Sine", [&](int) { return sine(); });
+	measure("Sine Q15", [&](int) { return sine15(); });
+	measure("Sine Q31", [&](int) { return sine31(); });
+
+	printf("(checksum %g)\n", sum);
+}
+
 } // namespace
@@ -7,6 +7,7 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/.
  */
 
+#include "Benchmark.h"
 #include "TestStore.h"
 #include "gtest/gtest.h"
 
@@ -14,6 +15,13 @@
 
 #include "LoggingLayer.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #define DECODE(stack, str)	do { char msg_[] = "" str; (stack).decode(msg_, sizeof(msg_) - 1); } while(0)
 
 namespace {
@@ -193,6 +201,63 @@ TEST(Debugger, Write)
 	EXPECT_EQ(store.default_int8.get(), 0x10);
 }
 
+TEST(Debugger, Slice)
+{
+	stored::Debugger d;
+	stored::TestStore store;
+	d.map(store);
+	LoggingLayer ll;
+	ll.wrap(d);
+
+	uint16_t const src[] = {1, 0x203, 3, 4};
+	store.array_uint16.set(src);
+
+	DECODE(d, "r/array uint16[0:4]");
+	EXPECT_EQ(ll.encoded().at(0), "0001020300030004");
+	DECODE(d, "r/array uint16[1:3]");
+	EXPECT_EQ(ll.encoded().at(1), "02030003");
+	DECODE(d, "r/array bool[0:2]");
+	EXPECT_EQ(ll.encoded().at(2), "0101");
+
+	DECODE(d, "w0010ff11/array uint16[2:4]");
+	EXPECT_EQ(ll.encoded().at(3), "!");
+	EXPECT_EQ(store.array_uint16_1.get(), 0x203u);
+	EXPECT_EQ(store.array_uint16_2.get(), 0x10u);
+	EXPECT_EQ(store.array_uint16_3.get(), 0xff11u);
+
+	// The number of digits must match the slice exactly.
+	DECODE(d, "w10ff11/array uint16[2:4]");
+	EXPECT_EQ(ll.encoded().at(4), "?");
+
+	// Out of bounds, empty, or not an array of variables.
+	DECODE(d, "r/array uint16[2:5]");
+	EXPECT_EQ(ll.encoded().at(5), "?");
+	DECODE(d, "r/array uint16[2:2]");
+	EXPECT_EQ(ll.encoded().at(6), "?");
+	DECODE(d, "r/array f int[0:2]");
+	EXPECT_EQ(ll.encoded().at(7), "?");
+	DECODE(d, "r/array string[0:2]");
+	EXPECT_EQ(ll.encoded().at(8), "?");
+
+	// The scalar /array bool[2] directly follows the array /array bool.
+	DECODE(d, "r/array bool[0:3]");
+	EXPECT_EQ(ll.encoded().at(9), "?");
+	DECODE(d, "w000000/array bool[0:3]");
+	EXPECT_EQ(ll.encoded().at(10), "?");
+	EXPECT_TRUE(store.array_bool_2.get() == false);
+	DECODE(d, "r/array bool[2:3]");
+	EXPECT_EQ(ll.encoded().at(11), "?");
+
+	stored::DebugVariant v;
+	size_t count = 0;
+	EXPECT_TRUE(d.findSlice("/array uint16[1:4]", 18, v, count));
+	EXPECT_TRUE(v.valid());
+	EXPECT_EQ(count, 3u);
+	EXPECT_EQ(v, d.find("/array uint16[1]"));
+	EXPECT_FALSE(d.findSlice("/array uint16[1]", 16, v, count));
+	EXPECT_FALSE(v.valid());
+}
+
 TEST(Debugger, Echo)
 {
 	stored::Debugger d;
@@ -263,6 +328,30 @@ TEST(Debugger, Macro)
 	EXPECT_EQ(ll.encoded().at(6), "?");
 }
 
+class MacroDebugger : public stored::Debugger {
+public:
+	using stored::Debugger::macros;
+};
+
+TEST(Debugger, MacroMap)
+{
+	MacroDebugger d;
+	stored::TestStore store;
+	d.map(store);
+	LoggingLayer ll;
+	ll.wrap(d);
+
+	DECODE(d, "m1;r/default uint8");
+	ASSERT_EQ(d.macros().size(), 1u);
+	EXPECT_EQ(d.macros()['1'], ";r/default uint8");
+
+	// The map can be modified directly.
+	d.macros()['2'] = "|r/default uint16";
+	store.default_uint16 = 3;
+	DECODE(d, "2");
+	EXPECT_EQ(ll.encoded().at(1), "3");
+}
+
 TEST(Debugger, ReadMem)
 {
 	stored::Debugger d;
@@ -302,6 +391,123 @@ TEST(Debugger, WriteMem)
 #endif
 }
 
+TEST(Debugger, ReadWriteMemLarge)
+{
+	stored::Debugger d;
+	LoggingLayer ll;
+	ll.wrap(d);
+
+	std::vector<uint8_t> mem(4099);
+	std::string expected;
+	for(size_t i = 0; i < mem.size(); i++) {
+		mem[i] = (uint8_t)(i * 37u + 11u);
+		char hex[3];
+		snprintf(hex, sizeof(hex), "%02x", (unsigned)mem[i]);
+		expected += hex;
+	}
+
+	char buf[32];
+	snprintf(buf, sizeof(buf), "R%" PRIxPTR " %zx", (uintptr_t)mem.data(), mem.size());
+	d.decode(buf, strlen(buf));
+	EXPECT_EQ(ll.encoded().at(0), expected);
+
+	// Write back inverted, in mixed case.
+	std::string w = buf;
+	w[0] = 'W';
+	w.resize(w.find(' ') + 1);
+	for(size_t i = 0; i < expected.size(); i++) {
+		int n = expected[i] <= '9' ? expected[i] - '0' : expected[i] - 'a' + 10;
+		w += ((i & 1u) ? "0123456789ABCDEF" : "0123456789abcdef")[15 - n];
+	}
+	d.decode(&w[0], w.size());
+	EXPECT_EQ(ll.encoded().at(1), "!");
+	for(size_t i = 0; i < mem.size(); i++)
+		EXPECT_EQ(mem[i], (uint8_t) ~(uint8_t)(i * 37u + 11u));
+
+	// Invalid characters are rejected.
+	w[w.size() - 100] = 'g';
+	d.decode(&w[0], w.size());
+	EXPECT_EQ(ll.encoded().at(2), "?");
+}
+
+TEST(Debugger, HexShortest)
+{
+	stored::Debugger d;
+	stored::TestStore store;
+	d.map(store);
+	LoggingLayer ll;
+	ll.wrap(d);
+
+	store.default_int32 = 0x1234;
+	DECODE(d, "r/default int32");
+	EXPECT_EQ(ll.encoded().at(0), "1234");
+
+	store.default_int32 = -2;
+	DECODE(d, "r/default int32");
+	EXPECT_EQ(ll.encoded().at(1), "fffffffe");
+
+	store.default_uint64 = 0x10000;
+	DECODE(d, "r/default uint64");
+	EXPECT_EQ(ll.encoded().at(2), "10000");
+
+	DECODE(d, "w00000abc/default int32");
+	EXPECT_EQ(store.default_int32.get(), 0xabc);
+	DECODE(d, "wABC/default uint64");
+	EXPECT_EQ(store.default_uint64.get(), 0xabcu);
+}
+
+TEST(Debugger, HexBenchmark)
+{
+	SKIP_UNLESS_BENCHMARK();
+
+	std::vector<uint8_t> mem(4096);
+	for(size_t i = 0; i < mem.size(); i++)
+		mem[i] = (uint8_t)(i * 13u);
+
+	std::vector<char> hex(mem.size() * 2);
+	int const rounds = 1000;
+
+	auto start = std::chrono::steady_clock::now();
+	for(int i = 0; i < rounds; i++)
+		stored::encode_hex(hex.data(), mem.data(), mem.size());
+	double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("encode_hex:  %8.1f MB/s\n", (double)(mem.size() * rounds) / dt * 1e-6);
+
+	start = std::chrono::steady_clock::now();
+	for(int i = 0; i < rounds; i++)
+		EXPECT_TRUE(stored::decode_hex(mem.data(), hex.data(), hex.size()));
+	dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("decode_hex:  %8.1f MB/s\n", (double)(mem.size() * rounds) / dt * 1e-6);
+
+	stored::Debugger d;
+	LoggingLayer ll;
+	ll.wrap(d);
+
+	char buf[32];
+	snprintf(buf, sizeof(buf), "R%" PRIxPTR " %zx", (uintptr_t)mem.data(), mem.size());
+	std::string r = buf;
+
+	start = std::chrono::steady_clock::now();
+	for(int i = 0; i < rounds; i++) {
+		ll.encoded().clear();
+		d.decode(&r[0], r.size());
+	}
+	dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	EXPECT_EQ(ll.encoded().at(0).size(), mem.size() * 2);
+	printf("Debugger R:  %8.1f MB/s\n", (double)(mem.size() * rounds) / dt * 1e-6);
+
+	std::string w = "W" + r.substr(1, r.find(' ')) + ll.encoded().at(0);
+
+	start = std::chrono::steady_clock::now();
+	for(int i = 0; i < rounds; i++) {
+		ll.encoded().clear();
+		d.decode(&w[0], w.size());
+	}
+	dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	EXPECT_EQ(ll.encoded().at(0), "!");
+	printf("Debugger W:  %8.1f MB/s\n", (double)(mem.size() * rounds) / dt * 1e-6);
+}
+
 static std::string decompress(std::string const& s)
 {
 	LoggingLayer decompressed;
@@ -410,6 +616,352 @@ TEST(Debugger, Trace)
 	EXPECT_EQ(ll.encoded().at(11), "");
 }
 
+#ifdef STORED_HAVE_THREADS
+class ResponseLayer : public stored::ProtocolLayer {
+public:
+	void encode(void const* buffer, size_t len, bool last = true) final
+	{
+		m_response.append(static_cast<char const*>(buffer), len);
+		if(last) {
+			responses++;
+			if(m_response != expected)
+				errors++;
+			m_response.clear();
+		}
+	}
+
+	using stored::ProtocolLayer::encode;
+
+	std::string expected;
+	size_t responses = 0;
+	size_t errors = 0;
+
+private:
+	std::string m_response;
+};
+
+TEST(Debugger, ScratchPadPool)
+{
+	stored::Debugger d;
+	stored::TestStore store;
+	d.map(store);
+	store.init_decimal = 42;
+
+	stored::ScratchPadPool pool;
+	d.setScratchPadPool(&pool);
+
+	int const clients = 4;
+	int const requests = 1000;
+	std::vector<ResponseLayer> responses(clients);
+	std::vector<std::thread> threads;
+
+	for(int c = 0; c < clients; c++)
+		threads.emplace_back([&, c]() {
+			ResponseLayer& r = responses[(size_t)c];
+			r.expected = "2a";
+			for(int i = 0; i < requests; i++)
+				d.process("r/init decimal", 14, r);
+		});
+
+	for(auto& t : threads)
+		t.join();
+
+	for(auto& r : responses) {
+		EXPECT_EQ(r.responses, (size_t)requests);
+		EXPECT_EQ(r.errors, 0u);
+	}
+
+	EXPECT_GE(pool.pads(), 1u);
+	EXPECT_LE(pool.pads(), (size_t)clients);
+
+	// Scopes override the pool.
+	stored::ScratchPad<> spm;
+	{
+		stored::Debugger::ScratchPadScope scope(spm);
+		EXPECT_EQ(stored::Debugger::ScratchPadScope::current(), &spm);
+		d.process("r/init decimal", 14, responses[0]);
+	}
+	EXPECT_EQ(stored::Debugger::ScratchPadScope::current(), nullptr);
+	EXPECT_GT(spm.max(), 0u);
+	EXPECT_EQ(responses[0].errors, 0u);
+}
+
+TEST(Debugger, ScratchPadPoolThreads)
+{
+	stored::Debugger d;
+	stored::TestStore store;
+	d.map(store);
+	store.init_decimal = 42;
+
+	stored::ScratchPadPool pool;
+	d.setScratchPadPool(&pool);
+
+	// One short-lived thread per connection.  Exiting threads return their
+	// pad, so the pool does not grow with every thread that ever existed.
+	int const clients = 4;
+	ResponseLayer r;
+	r.expected = "2a";
+	std::mutex mutex;
+	for(int round = 0; round < 50; round++) {
+		std::vector<std::thread> threads;
+		for(int c = 0; c < clients; c++)
+			threads.emplace_back([&]() {
+				std::lock_guard<std::mutex> l(mutex);
+				d.process("r/init decimal", 14, r);
+			});
+
+		for(auto& t : threads)
+			t.join();
+	}
+
+	EXPECT_EQ(r.responses, (size_t)(50 * clients));
+	EXPECT_EQ(r.errors, 0u);
+	EXPECT_GE(pool.pads(), 1u);
+	EXPECT_LE(pool.pads(), (size_t)clients);
+
+	// A thread that moves on to another pool returns its pad.
+	stored::ScratchPadPool a;
+	stored::ScratchPadPool b;
+	d.setScratchPadPool(&a);
+	d.process("r/init decimal", 14, r);
+	d.setScratchPadPool(&b);
+	d.process("r/init decimal", 14, r);
+
+	std::thread([&]() {
+		stored::ScratchPadPool::Lease x(a);
+		stored::ScratchPadPool::Lease y(a);
+	}).join();
+	EXPECT_EQ(a.pads(), 2u);
+	EXPECT_EQ(b.pads(), 1u);
+	EXPECT_EQ(r.errors, 0u);
+
+	d.setScratchPadPool();
+}
+
+TEST(Debugger, ScratchPadPoolBenchmark)
+{
+	SKIP_UNLESS_BENCHMARK();
+
+	stored::Debugger d;
+	stored::TestStore store;
+	d.map(store);
+	store.init_decimal = 42;
+
+	int const requests = 20000;
+
+	for(int pooled = 0; pooled < 2; pooled++) {
+		stored::ScratchPadPool pool;
+		d.setScratchPadPool(pooled ? &pool : nullptr);
+		std::mutex mutex;
+
+		for(int clients = 1; clients <= 8; clients *= 2) {
+			std::vector<ResponseLayer> responses((size_t)clients);
+			std::vector<std::thread> threads;
+
+			auto start = std::chrono::steady_clock::now();
+
+			for(int c = 0; c < clients; c++)
+				threads.emplace_back([&, c]() {
+					ResponseLayer& r = responses[(size_t)c];
+					r.expected = "2a";
+					for(int i = 0; i < requests; i++) {
+						if(pooled) {
+							d.process("r/init decimal", 14, r);
+						} else {
+							// Without pool, the Debugger's ScratchPad
+							// must be protected.
+							std::lock_guard<std::mutex> lock(mutex);
+							d.process("r/init decimal", 14, r);
+						}
+					}
+				});
+
+			for(auto& t : threads)
+				t.join();
+
+			double dt = std::chrono::duration<double>(
+					    std::chrono::steady_clock::now() - start)
+					    .count();
+
+			for(auto& r : responses)
+				EXPECT_EQ(r.errors, 0u);
+
+			printf("%d clients, %-6s: %10.0f requests/s\n", clients,
+			       pooled ? "pool" : "mutex", (double)(clients * requests) / dt);
+		}
+
+		d.setScratchPadPool();
+	}
+}
+#endif // STORED_HAVE_THREADS
+
+
+#if defined(STORED_HAVE_ZMQ) && !defined(STORED_COMPILER_MINGW)
+// MinGW does not implement std::thread.
+
+// Returns the endpoint to connect to a socket that is bound to an ephemeral port.
+static inline std::string zmqEndpoint(void* socket)
+{
+	char buf[64] = {};
+	size_t len = sizeof(buf) - 1;
+	if(zmq_getsockopt(socket, ZMQ_LAST_ENDPOINT, buf, &len) == -1)
+		return std::string();
+
+	char const* port = strrchr(buf, ':');
+	return port ? std::string("tcp://localhost") + port : std::string();
+}
+
+TEST(Debugger, ZmqRouter)
+{
+	stored::Debugger d;
+	stored::TestStore store;
+	d.map(store);
+	store.default_int16 = 0x123;
+	store.default_uint8 = 7;
+
+	void* context = zmq_ctx_new();
+
+	{
+		stored::DebugZmqLayer zmq(context, 0, stored::DebugZmqLayer::ModeRouter);
+		ASSERT_EQ(zmq.lastError(), 0);
+		zmq.wrap(d);
+		zmq.setCache();
+
+		void* dealer = zmq_socket(context, ZMQ_DEALER);
+		ASSERT_EQ(zmq_connect(dealer, zmqEndpoint(zmq.socket()).c_str()), 0);
+
+		// Pipeline some requests, such that they are handled within the same recv().
+		char const* reqs[] = {
+			"r/default int8",  "w10/default int8", "r/default int8",
+			"r/default int8",  "r/default int16",  "r/default uint8",
+			"r/default int16", "r/default uint8",  "r/default int8"};
+		for(size_t i = 0; i < sizeof(reqs) / sizeof(reqs[0]); i++) {
+			zmq_send(dealer, "", 0, ZMQ_SNDMORE);
+			zmq_send(dealer, reqs[i], strlen(reqs[i]), 0);
+		}
+
+		while(zmq.requests() < sizeof(reqs) / sizeof(reqs[0]))
+			zmq.recv(1000);
+
+		char const* resps[] = {"0", "!", "10", "10", "123", "7", "123", "7", "10"};
+		for(size_t i = 0; i < sizeof(resps) / sizeof(resps[0]); i++) {
+			char buf[16] = {};
+			EXPECT_EQ(zmq_recv(dealer, buf, sizeof(buf), 0), 0);
+			int len = zmq_recv(dealer, buf, sizeof(buf) - 1, 0);
+			ASSERT_GE(len, 0);
+			EXPECT_EQ(std::string(buf, (size_t)len), resps[i]);
+		}
+
+		// The write flushed the cache, so only the reads after it hit.
+		EXPECT_EQ(zmq.cacheHits(), 4U);
+
+		zmq_close(dealer);
+	}
+
+	zmq_ctx_term(context);
+}
+
+TEST(Debugger, ZmqRepCache)
+{
+	stored::Debugger d;
+	stored::TestStore store;
+	d.map(store);
+
+	void* context = zmq_ctx_new();
+
+	{
+		stored::DebugZmqLayer zmq(context, 0);
+		ASSERT_EQ(zmq.lastError(), 0);
+		zmq.wrap(d);
+		zmq.setCache();
+
+		void* req = zmq_socket(context, ZMQ_REQ);
+		ASSERT_EQ(zmq_connect(req, zmqEndpoint(zmq.socket()).c_str()), 0);
+
+		// Every recv() is a new tick, so the second read sees the change.
+		char const* resps[] = {"0", "10"};
+		for(size_t i = 0; i < sizeof(resps) / sizeof(resps[0]); i++) {
+			zmq_send(req, "r/default int8", 14, 0);
+			while(zmq.requests() < i + 1U)
+				zmq.recv(1000);
+
+			char buf[16] = {};
+			int len = zmq_recv(req, buf, sizeof(buf) - 1, 0);
+			ASSERT_GE(len, 0);
+			EXPECT_EQ(std::string(buf, (size_t)len), resps[i]);
+
+			store.default_int8 = 0x10;
+		}
+
+		EXPECT_EQ(zmq.cacheHits(), 0U);
+
+		zmq_close(req);
+	}
+
+	zmq_ctx_term(context);
+}
+
+TEST(Debugger, ZmqRouterLoad)
+{
+	SKIP_UNLESS_BENCHMARK();
+
+	stored::Debugger d;
+	stored::TestStore store;
+	d.map(store);
+
+	int const clients = 8;
+	int const requests = 1000;
+
+	void* context = zmq_ctx_new();
+
+	for(int cache = 0; cache < 2; cache++) {
+		// Use a fresh port for every run, as the previous socket may still linger.
+		stored::DebugZmqLayer zmq(context, 0, stored::DebugZmqLayer::ModeRouter);
+		ASSERT_EQ(zmq.lastError(), 0);
+		std::string endpoint = zmqEndpoint(zmq.socket());
+		zmq.wrap(d);
+		zmq.setCache(cache != 0);
+
+		std::atomic<int> done{0};
+		std::atomic<int> errors{0};
+		std::vector<std::thread> threads;
+
+		auto start = std::chrono::steady_clock::now();
+
+		for(int c = 0; c < clients; c++)
+			threads.emplace_back([&]() {
+				void* req = zmq_socket(context, ZMQ_REQ);
+				zmq_connect(req, endpoint.c_str());
+
+				for(int i = 0; i < requests; i++) {
+					char buf[16];
+					zmq_send(req, "r/init decimal", 14, 0);
+					if(zmq_recv(req, buf, sizeof(buf), 0) != 2 || memcmp(buf, "2a", 2) != 0)
+						errors++;
+				}
+
+				zmq_close(req);
+				done++;
+			});
+
+		while(done < clients)
+			zmq.recv(1000);
+
+		for(auto& t : threads)
+			t.join();
+
+		double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+				    .count();
+
+		EXPECT_EQ(errors.load(), 0);
+		EXPECT_EQ(zmq.requests(), (size_t)(clients * requests));
+		printf("%d clients, cache %-3s: %8.0f requests/s, %zu cache hits\n", clients,
+		       cache ? "on" : "off", (double)(clients * requests) / dt, zmq.cacheHits());
+	}
+
+	zmq_ctx_term(context);
+}
+#endif // STORED_HAVE_ZMQ && !STORED_COMPILER_MINGW
 
 } // namespace
 
@@ -7,12 +7,17 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/.
  */
 
+#include "Benchmark.h"
 #include "TestStore.h"
 #include "gtest/gtest.h"
 
 #include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <functional>
 #include <list>
+#include <string>
+#include <vector>
 
 namespace {
 
@@ -133,6 +138,40 @@ TEST(Directory, List)
 		EXPECT_TRUE(std::find(names.begin(), names.end(), n.c_str()) != names.end());
 }
 
+TEST(Directory, Array)
+{
+	stored::TestStore store;
+
+	// An array is one object in the directory, which resolves the index.
+	auto v = store.find("/array uint16[3]");
+	ASSERT_TRUE(v.valid());
+	EXPECT_EQ(v.type(), stored::Type::Uint16);
+	EXPECT_EQ(v.size(), sizeof(uint16_t));
+	EXPECT_EQ(v.key(), store.array_uint16_3.key());
+
+	EXPECT_FALSE(store.find("/array uint16[4]").valid());
+	EXPECT_FALSE(store.find("/array uint16[]").valid());
+	EXPECT_FALSE(store.find("/array uint16[1").valid());
+	EXPECT_FALSE(store.find("/array uint16").valid());
+
+	// Not an element, but a variable with a [ in its name.
+	EXPECT_EQ(store.find("/array bool[1]").key(), store.array_bool_1.key());
+	EXPECT_EQ(store.find("/array bool[2]").key(), store.array_bool_2.key());
+
+	std::vector<std::string> names;
+	store.list([&](stored::TestStore*, char const* name, stored::Type::type, void* buffer,
+		       size_t) {
+		if(strncmp(name, "/array uint16", 13) == 0) {
+			names.push_back(name);
+			EXPECT_EQ(store.find(name).buffer(), buffer);
+		}
+	});
+
+	ASSERT_EQ(names.size(), 4u);
+	EXPECT_EQ(names[0], "/array uint16[0]");
+	EXPECT_EQ(names[3], "/array uint16[3]");
+}
+
 TEST(Directory, Constexpr)
 {
 	static_assert(stored::TestStoreData::shortDirectory() != nullptr, "");
@@ -156,4 +195,146 @@ TEST(Directory, Constexpr)
 		"");
 }
 
+TEST(Directory, Path)
+{
+	constexpr auto v = stored::TestStore::pathVariable<int8_t>("/default int8");
+	static_assert(v.valid(), "");
+
+	constexpr auto v_short = stored::TestStore::pathVariable<bool>("/sc/i.....b");
+	static_assert(v_short.valid(), "");
+
+	constexpr auto f = stored::TestStore::pathFunction<double>("/f read/write");
+	static_assert(f.valid(), "");
+
+	stored::TestStore store;
+	v.apply(store) = 3;
+	EXPECT_EQ(store.default_int8.get(), 3);
+
+	v_short.apply(store) = true;
+	EXPECT_TRUE(store.scope__inner_bool.get());
+
+	EXPECT_TRUE(f == stored::TestStore::freeFunction<double>("/f read/write"));
+
+	// These do not compile:
+	// stored::TestStore::pathVariable<int16_t>("/default int8");  // other type
+	// stored::TestStore::pathVariable<int8_t>("/default int7");   // unknown
+	// stored::TestStore::pathVariable<int8_t>("/default int");    // ambiguous
+	// stored::TestStore::pathFunction<double>("/default double"); // not a function
+}
+
+TEST(Directory, FindEnd)
+{
+	char const* name = "/s/inner bool";
+	char const* end = nullptr;
+	EXPECT_FALSE(stored::impl::find(stored::TestStoreData::shortDirectory(), name,
+					std::numeric_limits<size_t>::max(), &end)
+			     .valid());
+	// Stopped at the end of the ambiguous scope name.
+	EXPECT_EQ(end, name + 2);
+
+	name = "/default int9";
+	EXPECT_FALSE(stored::impl::find(stored::TestStoreData::shortDirectory(), name,
+					std::numeric_limits<size_t>::max(), &end)
+			     .valid());
+	EXPECT_EQ(*end, '9');
+}
+
+// Returns the start of the buffer of the given store.
+char* storeBuffer(stored::TestStore& store)
+{
+	char* b = nullptr;
+	store.list([&](stored::TestStore*, char const*, stored::Type::type type, void* buffer,
+		       size_t) {
+		if(!b && !stored::Type::isFunction(type))
+			b = static_cast<char*>(buffer) - store.bufferToKey(buffer);
+	});
+	return b;
+}
+
+TEST(Directory, VariableTable)
+{
+	stored::TestStore store;
+	char* buffer = storeBuffer(store);
+	size_t count = 0;
+
+	store.list([&](stored::TestStore*, char const* name, stored::Type::type type,
+		       void* b, size_t len) {
+		if(stored::Type::isFunction(type))
+			return;
+
+		count++;
+		size_t offset = store.bufferToKey(b);
+		auto const* offsets = stored::TestStore::variableOffsets();
+		auto const* end = offsets + stored::TestStore::VariableCount;
+		auto const* o = std::lower_bound(offsets, end, offset);
+		ASSERT_NE(o, end) << name;
+		ASSERT_EQ(*o, offset) << name;
+
+		size_t i = (size_t)(o - offsets);
+		EXPECT_EQ(stored::TestStore::variableTypes()[i], (uint8_t)type) << name;
+		EXPECT_EQ(stored::TestStore::variableSizes()[i], len) << name;
+		EXPECT_STREQ(stored::TestStore::variableName(i), name);
+		EXPECT_EQ(buffer + offset, b);
+	});
+
+	EXPECT_EQ(count, (size_t)stored::TestStore::VariableCount);
+	EXPECT_TRUE(std::is_sorted(stored::TestStore::variableOffsets(),
+				   stored::TestStore::variableOffsets()
+					   + stored::TestStore::VariableCount));
+}
+
+TEST(Directory, DiffBenchmark)
+{
+	SKIP_UNLESS_BENCHMARK();
+
+	stored::TestStore a;
+	stored::TestStore b;
+	char* bufferA = storeBuffer(a);
+	char* bufferB = storeBuffer(b);
+	size_t const rounds = 20000;
+
+	auto measure = [&](auto&& diff) {
+		size_t changes = 0;
+		auto start = std::chrono::steady_clock::now();
+		for(size_t i = 0; i < rounds; i++) {
+			b.default_int32 = (int32_t)(i + 1U);
+			b.scope__inner_int = (int32_t)(i + 2U);
+			changes += diff();
+		}
+		double dt = std::chrono::duration<double, std::nano>(
+				    std::chrono::steady_clock::now() - start)
+				    .count();
+		EXPECT_EQ(changes, rounds * 2U);
+		return dt / (double)rounds;
+	};
+
+	// Iterate the directory, like stored::list() users do.
+	double list = measure([&]() {
+		size_t changes = 0;
+		a.list([&](stored::TestStore*, char const*, stored::Type::type type, void* buffer,
+			   size_t len) {
+			if(!stored::Type::isFunction(type)
+			   && memcmp(buffer, bufferB + a.bufferToKey(buffer), len) != 0)
+				changes++;
+		});
+		return changes;
+	});
+
+	// Iterate the variable tables.
+	double table = measure([&]() {
+		size_t changes = 0;
+		auto const* offsets = stored::TestStore::variableOffsets();
+		auto const* sizes = stored::TestStore::variableSizes();
+		for(size_t i = 0; i < stored::TestStore::VariableCount; i++)
+			if(memcmp(bufferA + offsets[i], bufferB + offsets[i], sizes[i]) != 0)
+				changes++;
+		return changes;
+	});
+
+	printf("%u variables, %u byte store, ns per full-store diff:\n",
+	       (unsigned)stored::TestStore::VariableCount, (unsigned)stored::TestStore::BufferSize);
+	printf("  list()           %8.1f\n", list);
+	printf("  variable tables  %8.1f\n", table);
+}
+
 } // namespace
@@ -0,0 +1,264 @@
+/*
+ * libstored, distributed debuggable data stores.
+ * Copyright (C) 2020-2022  Jochem Rutgers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "Benchmark.h"
+#include "TestStore.h"
+#include "gtest/gtest.h"
+
+#include <libstored/debugger.h>
+#include <libstored/doublebuffer.h>
+#include <libstored/synchronizer.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+class DoubleBufferSyncStore
+	: public STORE_T(DoubleBufferSyncStore, stored::Synchronizable, stored::TestStoreBase) {
+	STORE_CLASS(DoubleBufferSyncStore, stored::Synchronizable, stored::TestStoreBase)
+public:
+	DoubleBufferSyncStore() is_default
+};
+
+namespace {
+
+TEST(DoubleBuffer, Swap)
+{
+	stored::DoubleBuffer<stored::TestStore> db;
+	EXPECT_EQ(db.swap(), 0u);
+	EXPECT_EQ(db.swaps(), 1u);
+
+	// Outputs of the control loop are published at the swap.
+	db.back().default_int32 = 1;
+	db.back().default_string.set("abc", 3);
+	EXPECT_EQ(db.front().default_int32.get(), 0);
+	EXPECT_EQ(db.swap(), 2u);
+	EXPECT_EQ(db.front().default_int32.get(), 1);
+	char str[4] = {};
+	EXPECT_EQ(db.front().default_string.get(str, 3), 3u);
+	EXPECT_STREQ(str, "abc");
+
+	// Inputs are only visible to the control loop after the swap.
+	db.front().default_int8 = 2;
+	EXPECT_EQ(db.back().default_int8.get(), 0);
+	EXPECT_EQ(db.swap(), 1u);
+	EXPECT_EQ(db.back().default_int8.get(), 2);
+
+	// Writing the same value again is not a change.
+	db.back().default_int8 = 2;
+	EXPECT_EQ(db.swap(), 0u);
+
+	// When both sides write the same variable, the front wins.
+	db.front().default_int16 = 3;
+	db.back().default_int16 = 4;
+	db.back().default_uint16 = 5;
+	EXPECT_EQ(db.swap(), 2u);
+	EXPECT_EQ(db.front().default_int16.get(), 3);
+	EXPECT_EQ(db.back().default_int16.get(), 3);
+	EXPECT_EQ(db.front().default_uint16.get(), 5u);
+
+	// Arrays are compared per element.
+	uint16_t const a[] = {1, 2, 3, 4};
+	db.back().array_uint16.set(a);
+	db.front().array_uint16[1] = 6;
+	EXPECT_EQ(db.swap(), 4u);
+	EXPECT_EQ(db.front().array_uint16_0.get(), 1u);
+	EXPECT_EQ(db.front().array_uint16_1.get(), 6u);
+	EXPECT_EQ(db.back().array_uint16_1.get(), 6u);
+	EXPECT_EQ(db.front().array_uint16_3.get(), 4u);
+}
+
+TEST(DoubleBuffer, Size)
+{
+	// The shadow buffer and variable tables are allocated separately.
+	EXPECT_LT(
+		sizeof(stored::DoubleBuffer<stored::TestStore>),
+		2U * sizeof(stored::TestStore) + 256U);
+}
+
+TEST(DoubleBuffer, Journal)
+{
+	stored::DoubleBuffer<DoubleBufferSyncStore, stored::TestStore> db;
+	auto key = [](auto const& o) { return (stored::StoreJournal::Key)o.key(); };
+
+	auto now = db.front().journal().bumpSeq();
+	db.back().default_int32 = 1;
+	db.back().default_double = 2;
+	EXPECT_FALSE(db.front().journal().hasChanged(now));
+
+	db.swap();
+	EXPECT_TRUE(db.front().journal().hasChanged(key(db.front().default_int32), now));
+	EXPECT_TRUE(db.front().journal().hasChanged(key(db.front().default_double), now));
+	EXPECT_FALSE(db.front().journal().hasChanged(key(db.front().default_int8), now));
+
+	// Synchronize the front store with another store.
+	DoubleBufferSyncStore other;
+	stored::Synchronizer s1;
+	stored::Synchronizer s2;
+	stored::ProtocolLayer l1;
+	stored::ProtocolLayer l2;
+	stored::Loopback loop(l1, l2);
+	s1.map(db.front());
+	s2.map(other);
+	s1.connect(l1);
+	s2.connect(l2);
+	s2.syncFrom(other, l2);
+	EXPECT_EQ(other.default_int32.get(), 1);
+
+	db.back().default_int32 = 3;
+	s1.process();
+	EXPECT_EQ(other.default_int32.get(), 1);
+
+	db.swap();
+	s1.process();
+	EXPECT_EQ(other.default_int32.get(), 3);
+
+	// Changes received by the front store are inputs of the next tick.
+	other.default_int8 = 4;
+	s2.process();
+	EXPECT_EQ(db.front().default_int8.get(), 4);
+	EXPECT_EQ(db.back().default_int8.get(), 0);
+	db.swap();
+	EXPECT_EQ(db.back().default_int8.get(), 4);
+}
+
+#ifndef STORED_COMPILER_MINGW
+// MinGW does not implement std::thread.
+
+// Let a debugger write pairs of variables, while a control loop checks them.
+// Returns the number of ticks in which the control loop read a torn pair.
+template <typename Tick, typename Lock>
+size_t tearing(stored::Debugger& d, Tick&& tick, Lock& lock, size_t ticks)
+{
+	std::atomic<bool> stop{false};
+	std::thread debugger([&]() {
+		char req[32];
+		for(unsigned i = 1; !stop; i++) {
+			// Both writes are one update, like a macro of the client.
+			std::lock_guard<Lock> l(lock);
+			int len = snprintf(req, sizeof(req), "w%x/default int32", i);
+			d.decode(req, (size_t)len);
+			len = snprintf(req, sizeof(req), "w%x/default uint32", i);
+			d.decode(req, (size_t)len);
+		}
+	});
+
+	size_t torn = 0;
+	for(size_t i = 0; i < ticks; i++) {
+		if(!tick())
+			torn++;
+	}
+
+	stop = true;
+	debugger.join();
+	return torn;
+}
+
+TEST(DoubleBuffer, Tearing)
+{
+	size_t const ticks = 2000;
+
+	// Single store, which is only locked per debugger request.
+	stored::TestStore single;
+	stored::Debugger d1;
+	d1.map(single);
+	std::mutex mutex;
+	auto singleTick = [&]() {
+		int32_t a;
+		uint32_t b;
+		{
+			std::lock_guard<std::mutex> l(mutex);
+			a = single.default_int32.get();
+		}
+		// Some processing in between.
+		std::this_thread::yield();
+		{
+			std::lock_guard<std::mutex> l(mutex);
+			b = single.default_uint32.get();
+		}
+		return (uint32_t)a == b;
+	};
+	size_t tornSingle = tearing(d1, singleTick, mutex, ticks);
+
+	// Double buffered; the control loop never locks.
+	stored::DoubleBuffer<stored::TestStore> db;
+	stored::Debugger d2;
+	d2.map(db.front());
+	auto doubleTick = [&]() {
+		int32_t a = db.back().default_int32.get();
+		std::this_thread::yield();
+		uint32_t b = db.back().default_uint32.get();
+		db.swap();
+		return (uint32_t)a == b;
+	};
+	size_t tornDouble = tearing(d2, doubleTick, db, ticks);
+	// Without double buffering, the debugger writes between the two reads.
+	EXPECT_GT(tornSingle, 0u);
+	EXPECT_EQ(tornDouble, 0u);
+}
+
+#endif // STORED_COMPILER_MINGW
+
+TEST(DoubleBuffer, Benchmark)
+{
+	SKIP_UNLESS_BENCHMARK();
+
+	stored::DoubleBuffer<DoubleBufferSyncStore, stored::TestStore> db;
+	size_t const rounds = 100000;
+
+	auto measure = [&](auto&& f) {
+		auto start = std::chrono::steady_clock::now();
+		for(size_t i = 0; i < rounds; i++)
+			f(i);
+		return std::chrono::duration<double, std::nano>(
+			       std::chrono::steady_clock::now() - start)
+			       .count()
+		       / (double)rounds;
+	};
+
+	double none = measure([&](size_t) { db.swap(); });
+	double one = measure([&](size_t i) {
+		db.back().default_int32 = (int32_t)i;
+		db.swap();
+	});
+	double four = measure([&](size_t i) {
+		db.back().default_int32 = (int32_t)i;
+		db.back().default_uint64 = i;
+		db.back().default_float = (float)i;
+		db.front().default_int8 = (int8_t)i;
+		db.swap();
+	});
+	double array = measure([&](size_t i) {
+		uint16_t a[4] = {(uint16_t)i, (uint16_t)(i + 1), (uint16_t)(i + 2), (uint16_t)(i + 3)};
+		db.back().array_uint16.set(a);
+		db.swap();
+	});
+
+	char src[stored::TestStore::BufferSize];
+	char dst[stored::TestStore::BufferSize];
+	memset(src, 0, sizeof(src));
+	unsigned sum = 0;
+	double copy = measure([&](size_t i) {
+		src[i % sizeof(src)] = (char)i;
+		memcpy(dst, src, sizeof(dst));
+		// Prevent optimizing the copy away.
+		sum += (unsigned char)dst[(i * 7U) % sizeof(dst)];
+	});
+
+	printf("%u byte store, ns per swap:\n", (unsigned)stored::TestStore::BufferSize);
+	printf("  no changes               %8.1f\n", none);
+	printf("  1 output                 %8.1f\n", one);
+	printf("  3 outputs, 1 input       %8.1f\n", four);
+	printf("  4 array elements         %8.1f\n", array);
+	printf("  (memcpy of whole buffer) %8.1f (%u)\n", copy, sum);
+}
+
+} // namespace
@@ -0,0 +1,247 @@
+/*
+ * libstored, distributed debuggable data stores.
+ * Copyright (C) 2020-2022  Jochem Rutgers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+// These tests are built against tests/fixed/stored_config.h, which enables
+// Config::FixedCapacityContainers.
+
+#include "TestStore.h"
+#include "gtest/gtest.h"
+
+#include <libstored/debugger.h>
+#include <libstored/synchronizer.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+static_assert(stored::Config::FixedCapacityContainers, "");
+static_assert(stored::Config::AvoidDynamicMemory, "");
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+// The operators below forward to malloc()/free(), which GCC cannot match
+// when inlined in the std::allocator.
+#	pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+// Count all heap allocations, also the ones that bypass Config::Allocator.
+static size_t new_count;
+
+void* operator new(std::size_t count)
+{
+	void* ptr = malloc(count ? count : 1);
+	if(!ptr)
+		throw std::bad_alloc();
+	new_count++;
+	return ptr;
+}
+
+void* operator new[](std::size_t count)
+{
+	return operator new(count);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+	free(ptr);
+}
+
+#define DECODE(stack, str)	do { char msg_[] = "" str; (stack).decode(msg_, sizeof(msg_) - 1); } while(0)
+
+#define EXPECT_SYNCED(store1, store2)                                      \
+	do {                                                               \
+		auto _map1 = (store1).map();                               \
+		auto _map2 = (store2).map();                               \
+		for(auto& _o : _map1)                                      \
+			EXPECT_EQ(_o.second.get(), _map2[_o.first].get()); \
+	} while(0)
+
+class SyncTestStore : public stored::Synchronizable<stored::TestStoreBase<SyncTestStore>> {
+	friend class stored::TestStoreBase<SyncTestStore>;
+};
+
+namespace {
+
+TEST(FixedCapacity, Debugger)
+{
+	stored::Debugger d;
+	stored::TestStore store;
+	d.map(store);
+
+	uint32_t mem = 0;
+	char readMem[32];
+	snprintf(readMem, sizeof(readMem), "R%" PRIxPTR " 4", (uintptr_t)&mem);
+	char writeMem[32];
+	snprintf(writeMem, sizeof(writeMem), "W%" PRIxPTR " 01020304", (uintptr_t)&mem);
+
+	auto workload = [&]() {
+		DECODE(d, "?");
+		DECODE(d, "i");
+		DECODE(d, "v");
+		DECODE(d, "l");
+		DECODE(d, "e hello");
+		DECODE(d, "r/default uint8");
+		DECODE(d, "w10/default uint8");
+		DECODE(d, "r/default float");
+
+		DECODE(d, "a0/default int16");
+		DECODE(d, "r0");
+		DECODE(d, "a0/default uint16");
+		DECODE(d, "w20");
+		DECODE(d, "a1/default float");
+		DECODE(d, "a0");
+
+		DECODE(d, "mm|r/default uint8|e;|r1");
+		DECODE(d, "m");
+		DECODE(d, "mn|r/default int32");
+		DECODE(d, "mm|r/default uint16");
+		DECODE(d, "m");
+		DECODE(d, "mn");
+
+		DECODE(d, "mt|r/default uint8|e;");
+		DECODE(d, "ttT");
+		for(int i = 0; i < 10; i++)
+			d.trace();
+		DECODE(d, "fT");
+		DECODE(d, "sT");
+		DECODE(d, "t");
+
+		d.stream('x', "some data");
+		DECODE(d, "s");
+		DECODE(d, "sx");
+		d.stream('y', "more data");
+		DECODE(d, "sy");
+
+		d.decode(readMem, strlen(readMem));
+		d.decode(writeMem, strlen(writeMem));
+
+		DECODE(d, "r/array uint16[0:4]");
+		DECODE(d, "w0010ff11/array uint16[2:4]");
+		DECODE(d, "r/array bool[0:2]");
+		DECODE(d, "r/array uint16[2:5]");
+	};
+
+	// Warm-up.
+	workload();
+
+	size_t allocations = 0;
+	TestAllocatorBase::allocate_cb = [&](std::type_info const*, void*, size_t, size_t) {
+		allocations++;
+	};
+
+	new_count = 0;
+
+	for(int i = 0; i < 100; i++)
+		workload();
+
+	size_t news = new_count;
+	TestAllocatorBase::allocate_cb = nullptr;
+	EXPECT_EQ(allocations, 0u);
+	EXPECT_EQ(news, 0u);
+#ifdef STORED_LITTLE_ENDIAN
+	EXPECT_EQ(mem, 0x04030201u);
+#else
+	EXPECT_EQ(mem, 0x01020304u);
+#endif
+	EXPECT_EQ(store.array_uint16_2.get(), 0x10u);
+	EXPECT_EQ(store.array_uint16_3.get(), 0xff11u);
+}
+
+TEST(FixedCapacity, Synchronizer)
+{
+	SyncTestStore store1;
+	SyncTestStore store2;
+
+	stored::Synchronizer s1;
+	stored::Synchronizer s2;
+
+	stored::ProtocolLayer l1;
+	stored::ProtocolLayer l2;
+	stored::Loopback loop(l1, l2);
+
+	s1.map(store1);
+	s2.map(store2);
+	s1.connect(l1);
+	s2.connect(l2);
+	s2.syncFrom(store2, l2);
+
+	auto workload = [&](int i) {
+		store1.default_uint8 = (uint8_t)i;
+		store1.default_int32 = i;
+		store1.default_float = (float)i;
+		s1.process();
+		store2.default_uint16 = (uint16_t)i;
+		s2.process();
+		s1.process();
+	};
+
+	// Warm-up.
+	workload(0);
+
+	size_t allocations = 0;
+	TestAllocatorBase::allocate_cb = [&](std::type_info const*, void*, size_t, size_t) {
+		allocations++;
+	};
+
+	new_count = 0;
+
+	for(int i = 1; i < 100; i++)
+		workload(i);
+
+	size_t news = new_count;
+	TestAllocatorBase::allocate_cb = nullptr;
+	EXPECT_EQ(allocations, 0u);
+	EXPECT_EQ(news, 0u);
+	EXPECT_SYNCED(store1, store2);
+	EXPECT_EQ(store1.default_uint16.get(), 99);
+}
+
+class MacroDebugger : public stored::Debugger {
+public:
+	using stored::Debugger::macroBuffer;
+	using stored::Debugger::macros;
+};
+
+TEST(FixedCapacity, Macros)
+{
+	MacroDebugger d;
+	stored::TestStore store;
+	d.map(store);
+
+	DECODE(d, "ma|r/default uint8");
+	DECODE(d, "mb|r/default int8");
+	DECODE(d, "mc|r/default uint16");
+	EXPECT_EQ(d.macroBuffer(), "|r/default uint8|r/default int8|r/default uint16");
+
+	// Redefining and erasing macros moves the other definitions.
+	DECODE(d, "mb|e;");
+	DECODE(d, "ma");
+	EXPECT_EQ(d.macroBuffer(), "|r/default uint16|e;");
+	ASSERT_EQ(d.macros().size(), 2u);
+	EXPECT_EQ(d.macros().find('c')->second.offset, 0u);
+	EXPECT_EQ(d.macros().find('b')->second.offset, 17u);
+	EXPECT_EQ(d.macros().find('b')->second.size, 3u);
+}
+} // namespace
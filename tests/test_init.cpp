@@ -12,6 +12,9 @@
 
 namespace {
 
+// Static storage, which is zero before the constructor runs.
+stored::TestStore zeroInitializedStore{stored::ZeroInitialized()};
+
 TEST(Init, Decimal)
 {
 	stored::TestStore store;
@@ -59,4 +62,12 @@ TEST(Init, String)
 	EXPECT_TRUE(strcmp(buf, "a b\"c") == 0);
 }
 
+TEST(Init, ZeroInitialized)
+{
+	stored::TestStore store;
+	EXPECT_TRUE(store.diff(zeroInitializedStore).empty());
+	EXPECT_EQ(zeroInitializedStore.init_decimal.get(), 42);
+	EXPECT_EQ(zeroInitializedStore.default_int32.get(), 0);
+}
+
 } // namespace
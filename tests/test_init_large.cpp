@@ -0,0 +1,78 @@
+/*
+ * libstored, distributed debuggable data stores.
+ * Copyright (C) 2020-2022  Jochem Rutgers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "Benchmark.h"
+#include "LargeStore.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace {
+
+TEST(Init, LargeStore)
+{
+	// Too large for the stack.
+	std::unique_ptr<stored::LargeStore> large{new stored::LargeStore()};
+	EXPECT_EQ(large->version.get(), 1u);
+	EXPECT_EQ(large->gain.get(), 0.5);
+	char status[8] = {};
+	large->status.get(status, sizeof(status) - 1);
+	EXPECT_STREQ(status, "ok");
+	EXPECT_EQ(large->samples_0.get(), 0);
+}
+
+TEST(Init, Startup)
+{
+	SKIP_UNLESS_BENCHMARK();
+
+	size_t const rounds = 16;
+
+	// Measure the construction in fresh memory, like a store in .bss
+	// of a process that just started.
+	auto measure = [&](bool zeroInitialized) {
+		std::vector<void*> mem;
+		for(size_t i = 0; i < rounds; i++) {
+			void* p = calloc(1, sizeof(stored::LargeStore));
+			stored_assert(p);
+			mem.push_back(p);
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		for(void* p : mem) {
+			if(zeroInitialized)
+				new(p) stored::LargeStore(stored::ZeroInitialized());
+			else
+				new(p) stored::LargeStore();
+		}
+		double dt = std::chrono::duration<double, std::micro>(
+				    std::chrono::steady_clock::now() - start)
+				    .count();
+
+		for(void* p : mem) {
+			stored::LargeStore* store = static_cast<stored::LargeStore*>(p);
+			EXPECT_EQ(store->version.get(), 1u);
+			store->~LargeStore();
+			free(p);
+		}
+
+		return dt / (double)rounds;
+	};
+
+	double cleared = measure(false);
+	double zero = measure(true);
+	printf("construction of a %u byte store: %.2f us, zero-initialized: %.2f us\n",
+	       (unsigned)stored::LargeStore::BufferSize, cleared, zero);
+}
+
+
+} // namespace
@@ -0,0 +1,89 @@
+/*
+ * libstored, distributed debuggable data stores.
+ * Copyright (C) 2020-2022  Jochem Rutgers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "LayoutStore.h"
+#include "gtest/gtest.h"
+
+#include <cstring>
+
+namespace {
+
+TEST(Layout, Alignment)
+{
+	static_assert(alignof(stored::LayoutStoreData) == 64, "");
+	EXPECT_EQ(stored::LayoutStore::BufferSize % 64U, 0U);
+
+	stored::LayoutStore store;
+	EXPECT_EQ(store.control_counter.key() % 64U, 0U);
+	EXPECT_EQ(store.main__run.key() % 64U, 0U);
+	EXPECT_EQ(store.block_0__a.key() % 64U, 0U);
+	EXPECT_EQ(store.block_1__a.key() % 64U, 0U);
+}
+
+TEST(Layout, Writers)
+{
+	stored::LayoutStore store;
+
+	// All variables of one writer share the lines, other writers do not.
+	size_t control[] = {
+		store.control_counter.key(), store.control_output.key(),
+		store.control_status.key()};
+	size_t main[] = {
+		store.main__run.key(), store.main__setpoint.key(), store.main__config.key()};
+
+	for(size_t c : control)
+		for(size_t m : main)
+			EXPECT_NE(c / 64U, m / 64U);
+
+	EXPECT_NE(store.unassigned.key() / 64U, store.control_counter.key() / 64U);
+	EXPECT_NE(store.unassigned.key() / 64U, store.main__run.key() / 64U);
+
+	// Scopes inherit the writer.
+	EXPECT_EQ(store.main__run.key() / 64U, store.main__config.key() / 64U);
+}
+
+TEST(Layout, Temperature)
+{
+	stored::LayoutStore store;
+
+	// Hot variables come first; cold ones last.
+	EXPECT_LT(store.control_counter.key(), store.control_output.key());
+	EXPECT_LT(store.control_output.key(), store.control_status.key());
+	EXPECT_LT(store.main__run.key(), store.main__setpoint.key());
+	EXPECT_LT(store.main__setpoint.key(), store.main__config.key());
+}
+
+TEST(Layout, Block)
+{
+	stored::LayoutStore store;
+	EXPECT_EQ(store.block_0__b.key(), store.block_0__a.key() + 1U);
+	EXPECT_EQ(store.block_1__b.key(), store.block_1__a.key() + 1U);
+	EXPECT_NE(store.block_0__a.key() / 64U, store.block_1__a.key() / 64U);
+	EXPECT_NE(store.block_0__a.key() / 64U, store.unassigned.key() / 64U);
+}
+
+TEST(Layout, Init)
+{
+	stored::LayoutStore store;
+	EXPECT_EQ(store.control_counter.get(), 1);
+	EXPECT_EQ(store.control_output.get(), 0);
+	EXPECT_EQ(store.main__run.get(), true);
+	EXPECT_EQ(store.main__setpoint.get(), 2.5F);
+	EXPECT_EQ(store.main__config.get(), 0);
+	EXPECT_EQ(store.block_0__a.get(), 3);
+	EXPECT_EQ(store.block_0__b.get(), 0);
+	EXPECT_EQ(store.block_1__a.get(), 3);
+	EXPECT_EQ(store.unassigned.get(), 5);
+
+	char status[17] = {};
+	store.control_status.get(status, sizeof(status));
+	EXPECT_STREQ(status, "ok");
+}
+
+} // namespace
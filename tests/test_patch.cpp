@@ -0,0 +1,257 @@
+/*
+ * libstored, distributed debuggable data stores.
+ * Copyright (C) 2020-2022  Jochem Rutgers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "Benchmark.h"
+#include "TestStore.h"
+#include "gtest/gtest.h"
+
+#include <libstored/synchronizer.h>
+
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+class PatchSyncStore : public STORE_T(PatchSyncStore, stored::Synchronizable, stored::TestStoreBase) {
+	STORE_CLASS(PatchSyncStore, stored::Synchronizable, stored::TestStoreBase)
+public:
+	PatchSyncStore() is_default
+};
+
+namespace {
+
+class HookedPatchStore : public STORE_BASE_CLASS(TestStoreBase, HookedPatchStore) {
+	STORE_CLASS_BODY(TestStoreBase, HookedPatchStore)
+public:
+	HookedPatchStore() is_default
+
+	void __hookEntryBatchX(stored::BatchEntry const* batch, size_t count) noexcept
+	{
+		batches++;
+		base::__hookEntryBatchX(batch, count);
+	}
+
+	void __hookExitX(stored::Type::type type, void* buffer, size_t len, bool changed) noexcept
+	{
+		writes++;
+		if(changed)
+			changes++;
+		base::__hookExitX(type, buffer, len, changed);
+	}
+
+	int batches = 0;
+	int writes = 0;
+	int changes = 0;
+};
+
+TEST(Patch, Diff)
+{
+	stored::TestStore a;
+	stored::TestStore b;
+
+	stored::StorePatch patch = a.diff(b);
+	EXPECT_TRUE(patch.empty());
+
+	b.default_int8 = 1;
+	b.default_double = 2;
+	b.default_string.set("abc", 3);
+	b.array_uint16[2] = 3;
+	a.diff(b, patch);
+	ASSERT_EQ(patch.size(), 4u);
+
+	// Sorted by key, which is the offset in the buffer.
+	for(size_t i = 1; i < patch.size(); i++)
+		EXPECT_LT(patch.key(i - 1), patch.key(i));
+
+	size_t bytes = 0;
+	for(size_t i = 0; i < patch.size(); i++) {
+		bytes += patch.len(i);
+		if(patch.key(i) == b.default_string.key()) {
+			EXPECT_EQ(patch.type(i), stored::Type::String);
+			EXPECT_EQ(patch.len(i), b.default_string.size());
+			EXPECT_EQ(memcmp(patch.data(i), "abc", 4), 0);
+		} else if(patch.key(i) == b.array_uint16_2.key()) {
+			// Only the changed element.
+			EXPECT_EQ(patch.len(i), sizeof(uint16_t));
+		}
+	}
+	EXPECT_EQ(patch.bytes(), bytes);
+
+	EXPECT_EQ(a.apply(patch), 4u);
+	EXPECT_EQ(a.default_int8.get(), 1);
+	EXPECT_EQ(a.default_double.get(), 2);
+	EXPECT_EQ(a.array_uint16_2.get(), 3u);
+	char str[4] = {};
+	EXPECT_EQ(a.default_string.get(str, 3), 3u);
+	EXPECT_STREQ(str, "abc");
+
+	a.diff(b, patch);
+	EXPECT_TRUE(patch.empty());
+}
+
+TEST(Patch, Apply)
+{
+	stored::TestStore a;
+	HookedPatchStore b;
+	a.default_int32 = 1;
+	a.default_uint64 = 2;
+	a.init_float_1 = 3;
+
+	stored::StorePatch patch = b.diff(a);
+	EXPECT_EQ(patch.size(), 3u);
+
+	EXPECT_EQ(b.apply(patch), 3u);
+	EXPECT_EQ(b.batches, 1);
+	EXPECT_EQ(b.writes, 3);
+	EXPECT_EQ(b.changes, 3);
+	EXPECT_EQ(b.default_int32.get(), 1);
+	EXPECT_EQ(b.default_uint64.get(), 2u);
+	EXPECT_EQ(b.init_float_1.get(), 3.f);
+
+	// Applying it again does not change anything, but still calls the hooks.
+	EXPECT_EQ(b.apply(patch), 0u);
+	EXPECT_EQ(b.batches, 2);
+	EXPECT_EQ(b.writes, 6);
+	EXPECT_EQ(b.changes, 3);
+
+	b.enableHooks(false);
+	b.default_int32 = 4;
+	EXPECT_EQ(b.apply(patch), 1u);
+	EXPECT_EQ(b.batches, 2);
+	EXPECT_EQ(b.default_int32.get(), 1);
+}
+
+TEST(Patch, Journal)
+{
+	stored::TestStore a;
+	PatchSyncStore b;
+	auto now = b.journal().bumpSeq();
+
+	a.default_int16 = 1;
+	a.scope__inner_int = 2;
+	b.apply(b.diff(a));
+
+	EXPECT_TRUE(b.journal().hasChanged(
+		(stored::StoreJournal::Key)b.default_int16.key(), now));
+	EXPECT_TRUE(b.journal().hasChanged(
+		(stored::StoreJournal::Key)b.scope__inner_int.key(), now));
+	EXPECT_FALSE(b.journal().hasChanged(
+		(stored::StoreJournal::Key)b.default_int32.key(), now));
+}
+
+TEST(Patch, Memdiff)
+{
+	char a[100];
+	char b[100];
+	for(size_t i = 0; i < sizeof(a); i++)
+		a[i] = b[i] = (char)i;
+
+	EXPECT_EQ(stored::memdiff(a, b, sizeof(a)), sizeof(a));
+	EXPECT_EQ(stored::memdiff(a, b, 0), 0u);
+
+	for(size_t i = 0; i < sizeof(a); i++) {
+		b[i] = 'x';
+		EXPECT_EQ(stored::memdiff(a, b, sizeof(a)), i);
+		EXPECT_EQ(stored::memdiff(a + 1, b + 1, sizeof(a) - 1), i > 0 ? i - 1 : sizeof(a) - 1);
+		b[i] = a[i];
+	}
+}
+
+// Stand-in for a store, as used by StorePatch::apply().
+struct NoHooks {
+	void hookEntryBatchX(stored::BatchEntry const*, size_t) noexcept {}
+	void hookExitBatchX(stored::BatchEntry const*, size_t) noexcept {}
+};
+
+TEST(Patch, Benchmark)
+{
+	SKIP_UNLESS_BENCHMARK();
+
+	// Large stores are mimicked by variable tables of 8, 4, 2, 1 and 1 byte
+	// variables.  The store's diff() only forwards to StorePatch::diff().
+	static uint8_t const sizePattern[] = {8, 4, 2, 1, 1};
+	static uint8_t const typePattern[] = {
+		stored::Type::Uint64, stored::Type::Uint32, stored::Type::Uint16,
+		stored::Type::Uint8, stored::Type::Uint8};
+
+	printf("store size   changes   diff MB/s   memcmp/var MB/s   apply ns\n");
+
+	for(size_t size = 0x10000; size <= 0x100000; size *= 16) {
+		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> sizes;
+		std::vector<uint8_t> types;
+		for(size_t offset = 0, i = 0; offset < size; i++) {
+			offsets.push_back((uint32_t)offset);
+			sizes.push_back(sizePattern[i % sizeof(sizePattern)]);
+			types.push_back(typePattern[i % sizeof(typePattern)]);
+			offset += sizes.back();
+		}
+
+		size_t count = offsets.size();
+		std::vector<char> a(size);
+		std::vector<char> b(size);
+		stored::StorePatch patch;
+		patch.reserve(count, size);
+		NoHooks container;
+
+		for(size_t changes = 0; changes <= 1000; changes = changes ? changes * 10 : 10) {
+			b = a;
+			for(size_t c = 0; c < changes; c++)
+				b[offsets[(c * 7919U) % count]]++;
+
+			size_t rounds = (size_t)0x4000000 / size;
+			size_t found = 0;
+
+			auto start = std::chrono::steady_clock::now();
+			for(size_t r = 0; r < rounds; r++) {
+				patch.diff(a.data(), b.data(), types.data(), offsets.data(),
+					   sizes.data(), count);
+				found += patch.size();
+			}
+			double diff = std::chrono::duration<double>(
+					      std::chrono::steady_clock::now() - start)
+					      .count();
+			EXPECT_EQ(found, rounds * changes);
+
+			// Compare every variable separately, like a list() based diff would.
+			found = 0;
+			start = std::chrono::steady_clock::now();
+			for(size_t r = 0; r < rounds; r++)
+				for(size_t i = 0; i < count; i++)
+					if(memcmp(&a[offsets[i]], &b[offsets[i]], sizes[i]) != 0)
+						found++;
+			double naive = std::chrono::duration<double>(
+					       std::chrono::steady_clock::now() - start)
+					       .count();
+			EXPECT_EQ(found, rounds * changes);
+
+			stored::StorePatch forth;
+			stored::StorePatch back;
+			forth.diff(a.data(), b.data(), types.data(), offsets.data(), sizes.data(),
+				   count);
+			back.diff(b.data(), a.data(), types.data(), offsets.data(), sizes.data(),
+				  count);
+			std::vector<char> c = a;
+			found = 0;
+			start = std::chrono::steady_clock::now();
+			for(size_t r = 0; r < rounds; r++)
+				found += (r % 2 ? back : forth).apply(container, c.data(), size);
+			double apply = std::chrono::duration<double, std::nano>(
+					       std::chrono::steady_clock::now() - start)
+					       .count();
+			EXPECT_EQ(found, rounds * changes);
+
+			double mb = (double)(size * rounds) / 1e6;
+			printf("%7u KB %10u %11.0f %17.0f %10.0f\n", (unsigned)(size / 1024U),
+			       (unsigned)changes, mb / diff, mb / naive,
+			       apply / (double)rounds);
+		}
+	}
+}
+
+} // namespace
@@ -9,13 +9,25 @@
 
 #include "libstored/compress.h"
 #include "libstored/fifo.h"
+#include "libstored/poller.h"
 #include "libstored/protocol.h"
+#include "Benchmark.h"
 #include "LoggingLayer.h"
 #include "gtest/gtest.h"
 
+#include <atomic>
 #include <chrono>
+#include <cmath>
 #include <fcntl.h>
 #include <thread>
+#include <vector>
+
+#ifdef STORED_OS_LINUX
+#	include <csignal>
+#	include <sys/mman.h>
+#	include <sys/resource.h>
+#	include <unistd.h>
+#endif
 
 #define DECODE(stack, str)                              \
 	do {                                            \
@@ -1027,6 +1039,199 @@ TEST(CompressLayer, Compress)
 	EXPECT_EQ(top.decoded().at(0), "Hello World! Nice World!");
 }
 
+TEST(DeltaLayer, Encode)
+{
+	stored::DeltaLayer l(8, 4);
+	LoggingLayer bottom;
+	bottom.wrap(l);
+
+	uint32_t rec[] = {100, 0x80000000u, 101, 0x7fffffffu, 99, 0x80000000u};
+	l.encode(rec, sizeof(rec));
+	EXPECT_EQ(bottom.encoded().size(), 1u);
+	// 100 -> 200 (zigzag) = c8 01, 0x80000000 -> ffffffff = ff ff ff ff 0f,
+	// then deltas +1 -> 02, -1 -> 01, -2 -> 03, +1 -> 02.
+	EXPECT_EQ(bottom.encoded().at(0), "\xc8\x01\xff\xff\xff\xff\x0f\x02\x01\x03\x02");
+
+	// State is reset after the last part of a message.
+	bottom.encoded().clear();
+	l.encode(rec, 4);
+	EXPECT_EQ(bottom.allEncoded(), "\xc8\x01");
+}
+
+TEST(DeltaLayer, RoundTrip)
+{
+	LoggingLayer top;
+	stored::DeltaLayer l(12, 2);
+	l.wrap(top);
+	LoggingLayer bottom;
+	bottom.wrap(l);
+
+	std::vector<int16_t> samples;
+	for(int i = 0; i < 60; i++)
+		samples.push_back((int16_t)(i * 7 - 200));
+
+	// Encode in odd-sized chunks to exercise partial words and records.
+	char const* p = reinterpret_cast<char const*>(samples.data());
+	size_t len = samples.size() * sizeof(int16_t);
+	for(size_t i = 0; i < len; i += 7)
+		top.encode(p + i, std::min<size_t>(7, len - i), false);
+	top.encode(nullptr, 0);
+
+	std::string msg = bottom.allEncoded();
+	EXPECT_LT(msg.size(), len);
+
+	std::vector<char> buf(msg.begin(), msg.end());
+	bottom.decode(buf.data(), buf.size());
+	ASSERT_EQ(top.decoded().size(), 1u);
+	EXPECT_EQ(top.decoded().at(0), std::string(p, len));
+}
+
+TEST(DeltaLayer, Tail)
+{
+	LoggingLayer top;
+	stored::DeltaLayer l(8, 4);
+	l.wrap(top);
+	LoggingLayer bottom;
+	bottom.wrap(l);
+
+	std::string data = "\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b";
+
+	// The partial word follows the tail marker raw.
+	l.encode(data.data(), 5);
+	EXPECT_EQ(bottom.allEncoded(), std::string("\x82\x88\x98\x40\x80\x00\x05", 7));
+
+	// tests/test_ZmqClient.py decodes these exact bytes.
+	bottom.encoded().clear();
+	l.encode(data.data(), data.size());
+	EXPECT_EQ(
+		bottom.allEncoded(),
+		std::string("\x82\x88\x98\x40\x8a\x98\xb8\x80\x01\x80\x00\x09\x0a\x0b", 14));
+
+	// Lengths that are not a multiple of the word size decode to the same length.
+	for(size_t len = 1; len <= data.size(); len++) {
+		bottom.encoded().clear();
+		top.decoded().clear();
+		l.encode(data.data(), len);
+
+		std::string msg = bottom.allEncoded();
+		std::vector<char> buf(msg.begin(), msg.end());
+		bottom.decode(buf.data(), buf.size());
+		ASSERT_EQ(top.decoded().size(), 1u);
+		EXPECT_EQ(top.decoded().at(0), data.substr(0, len));
+	}
+}
+
+TEST(DeltaLayer, MaxInput)
+{
+	stored::DeltaLayer l(8, 4);
+	LoggingLayer bottom;
+	bottom.wrap(l);
+
+	// Worst case: every delta is large, which takes a 5-byte varint.
+	std::string data;
+	for(size_t i = 0; i < 64; i++) {
+		uint32_t w = i % 4U < 2U ? 0xc0000000u : 0x40000000u;
+		data.append(reinterpret_cast<char const*>(&w), sizeof(w));
+	}
+
+	for(size_t out = 0; out < 200; out++) {
+		size_t in = std::min(l.maxInput(out), data.size());
+		bottom.encoded().clear();
+		l.encode(data.data(), in);
+		EXPECT_LE(bottom.allEncoded().size(), out);
+	}
+
+	bottom.encoded().clear();
+	l.encode(data.data(), data.size());
+	EXPECT_EQ(bottom.allEncoded().size(), data.size() / 4U * 5U);
+
+	EXPECT_EQ(stored::DeltaLayer().maxInput(10), 10u);
+}
+
+TEST(DeltaLayer, PassThrough)
+{
+	stored::DeltaLayer l;
+	LoggingLayer bottom;
+	bottom.wrap(l);
+
+	l.encode("abc", 3);
+	EXPECT_EQ(bottom.encoded().at(0), "abc");
+}
+
+/*!
+ * \brief Generate binary trace samples: a counter, a slow sine, a noisy sensor and a flag.
+ */
+static std::string traceData(size_t samples)
+{
+	std::string data;
+	uint32_t noise = 1;
+	for(size_t i = 0; i < samples; i++) {
+		noise = noise * 1103515245u + 12345u;
+		int32_t rec[4] = {
+			(int32_t)i, (int32_t)(10000.0 * std::sin((double)i * 0.01)),
+			(int32_t)(2000 + (noise >> 28U)), (int32_t)((i / 100U) & 1U)};
+		data.append(reinterpret_cast<char const*>(rec), sizeof(rec));
+	}
+	return data;
+}
+
+static void benchmarkCompress(
+	char const* name, stored::ProtocolLayer& top, stored::ProtocolLayer& last,
+	std::string const& data)
+{
+	LoggingLayer bottom;
+	bottom.wrap(last);
+
+	auto start = std::chrono::steady_clock::now();
+	for(size_t i = 0; i < data.size(); i += 16)
+		top.encode(data.data() + i, 16, false);
+	top.encode();
+	auto dt = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+			  .count();
+
+	size_t out = bottom.allEncoded().size();
+	printf("%-24s ratio %5.2f  %6.2f ns/B\n", name, (double)data.size() / (double)out,
+	       dt / (double)data.size());
+}
+
+TEST(DeltaLayer, Benchmark)
+{
+	SKIP_UNLESS_BENCHMARK();
+
+	std::string data = traceData(10000);
+
+	{
+		stored::ProtocolLayer l;
+		benchmarkCompress("raw", l, l, data);
+	}
+	{
+		stored::DeltaLayer l(16, 4);
+		benchmarkCompress("delta", l, l, data);
+	}
+#ifdef STORED_HAVE_HEATSHRINK
+	{
+		stored::CompressLayer l;
+		benchmarkCompress("heatshrink 8/4", l, l, data);
+	}
+	{
+		stored::CompressLayer l(11, 4);
+		benchmarkCompress("heatshrink 11/4", l, l, data);
+	}
+	{
+		stored::CompressLayer c;
+		stored::DeltaLayer l(16, 4);
+		c.wrap(l);
+		benchmarkCompress("delta + heatshrink 8/4", l, c, data);
+	}
+	{
+		stored::CompressLayer c(11, 4);
+		stored::DeltaLayer l(16, 4);
+		c.wrap(l);
+		benchmarkCompress("delta + heatshrink 11/4", l, c, data);
+	}
+#endif
+}
+
 template <typename L>
 static int recvAll(L& l)
 {
@@ -1142,6 +1347,275 @@ TEST(FileLayer, DoublePipe)
 	EXPECT_EQ(top1.allDecoded(), "Beautiful Tomorrow");
 }
 
+#if defined(STORED_OS_LINUX)
+TEST(ShmLayer, Normal)
+{
+	stored::ShmLayer p1("/libstored-test-shm", true, 64);
+	ASSERT_EQ(p1.lastError(), 0);
+	stored::ShmLayer p2("/libstored-test-shm", false);
+	ASSERT_EQ(p2.lastError(), 0);
+	EXPECT_EQ(p1.mtu(), 60);
+
+	LoggingLayer top1;
+	p1.wrap(top1);
+
+	LoggingLayer top2;
+	p2.wrap(top2);
+
+	EXPECT_EQ(p2.recv(), EAGAIN);
+
+	p1.encode("Great ", 6, false);
+	p1.encode("Big ", 4);
+	p2.encode("Beautiful ", 10);
+	p2.encode("Tomorrow", 8);
+
+	EXPECT_EQ(p2.recv(), 0);
+	EXPECT_EQ(p2.recv(), EAGAIN);
+	EXPECT_EQ(p1.recv(), 0);
+
+	// Message boundaries are preserved.
+	ASSERT_EQ(top2.decoded().size(), 1);
+	EXPECT_EQ(top2.decoded().at(0), "Great Big ");
+	ASSERT_EQ(top1.decoded().size(), 2);
+	EXPECT_EQ(top1.decoded().at(0), "Beautiful ");
+	EXPECT_EQ(top1.decoded().at(1), "Tomorrow");
+
+	// Wrap around the end of the ring.
+	top2.clear();
+	for(int i = 0; i < 10; i++) {
+		p1.encode("0123456789abcdefghijklmnopqrstuvwxyz", 36);
+		EXPECT_EQ(p2.recv(), 0);
+		EXPECT_EQ(top2.decoded().at((size_t)i), "0123456789abcdefghijklmnopqrstuvwxyz");
+	}
+
+	// Too large.
+	std::string big(61, 'x');
+	p1.encode(big.data(), big.size());
+	EXPECT_EQ(p1.lastError(), EMSGSIZE);
+	EXPECT_EQ(p2.recv(), EAGAIN);
+
+	p1.encode("ok", 2);
+	EXPECT_EQ(p1.lastError(), 0);
+	EXPECT_EQ(p2.recv(), 0);
+	EXPECT_EQ(top2.decoded().back(), "ok");
+}
+
+TEST(ShmLayer, Poller)
+{
+	stored::ShmLayer p1("/libstored-test-shm-poller", true);
+	stored::ShmLayer p2("/libstored-test-shm-poller", false);
+	ASSERT_EQ(p2.lastError(), 0);
+
+	LoggingLayer top2;
+	p2.wrap(top2);
+
+	stored::Poller poller;
+	stored::PollableFileLayer pollable(p2, stored::Pollable::PollIn);
+	ASSERT_EQ(poller.add(pollable), 0);
+
+	// Arm the doorbell.
+	EXPECT_EQ(p2.recv(), EAGAIN);
+	EXPECT_TRUE(poller.poll(0).empty());
+
+	p1.encode("ding", 4);
+	p1.encode("dong", 4);
+	EXPECT_EQ(poller.poll(1000).size(), 1);
+	EXPECT_EQ(p2.recv(), 0);
+	EXPECT_EQ(top2.allDecoded(), "dingdong");
+	EXPECT_TRUE(poller.poll(0).empty());
+}
+
+TEST(ShmLayer, NotReady)
+{
+	char const* name = "/libstored-test-shm-notready";
+	shm_unlink(name);
+
+	// The joiner is too early; the object is there, but not initialized.
+	int fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+	ASSERT_NE(fd, -1);
+	ASSERT_EQ(ftruncate(fd, 4096), 0);
+	close(fd);
+
+	stored::ShmLayer p2(name, false);
+	EXPECT_EQ(p2.lastError(), EAGAIN);
+	EXPECT_FALSE(p2.isOpen());
+	shm_unlink(name);
+
+	// Not there at all.
+	stored::ShmLayer p3(name, false);
+	EXPECT_EQ(p3.lastError(), ENOENT);
+}
+
+TEST(ShmLayer, CreateFails)
+{
+	char const* name = "/libstored-test-shm-createfails";
+
+	// Let ftruncate() fail.
+	rlimit old = {};
+	ASSERT_EQ(getrlimit(RLIMIT_FSIZE, &old), 0);
+	rlimit lim = old;
+	lim.rlim_cur = 1024;
+	void (*sig)(int) = signal(SIGXFSZ, SIG_IGN);
+	ASSERT_EQ(setrlimit(RLIMIT_FSIZE, &lim), 0);
+
+	stored::ShmLayer p1(name, true, 4096);
+	int e = p1.lastError();
+
+	setrlimit(RLIMIT_FSIZE, &old);
+	signal(SIGXFSZ, sig);
+
+	EXPECT_EQ(e, EFBIG);
+	EXPECT_FALSE(p1.isOpen());
+
+	// No stale object is left behind.
+	int fd = shm_open(name, O_RDWR, 0);
+	EXPECT_EQ(fd, -1);
+	if(fd == -1) {
+		EXPECT_EQ(errno, ENOENT);
+	} else {
+		close(fd);
+		shm_unlink(name);
+	}
+}
+
+TEST(ShmLayer, Blocking)
+{
+	stored::ShmLayer p1("/libstored-test-shm-blocking", true, 256);
+	stored::ShmLayer p2("/libstored-test-shm-blocking", false);
+	ASSERT_EQ(p2.lastError(), 0);
+
+	LoggingLayer top2;
+	p2.wrap(top2);
+
+	// Write much more than fits in the ring; the producer waits for the consumer.
+	std::thread t([&]() {
+		for(int i = 0; i < 1000; i++)
+			p1.encode("0123456789", 10);
+	});
+
+	while(top2.decoded().size() < 1000)
+		ASSERT_EQ(p2.recv(1000000), 0);
+
+	t.join();
+	EXPECT_EQ(top2.decoded().back(), "0123456789");
+}
+#endif // STORED_OS_LINUX
+
+#if !defined(STORED_OS_WINDOWS)
+class EchoLayer : public stored::ProtocolLayer {
+	STORED_CLASS_NOCOPY(EchoLayer)
+public:
+	EchoLayer() = default;
+
+	void decode(void* buffer, size_t len) override
+	{
+		bytes += len;
+		if(echo)
+			encode(buffer, len, true);
+	}
+
+	bool echo = true;
+	size_t bytes = 0;
+};
+
+static bool recvOk(int res)
+{
+	return res == 0 || res == EAGAIN || res == EINTR;
+}
+
+/*!
+ * \brief Measure ping-pong latency and one-way throughput between the given transports.
+ */
+static void benchmarkTransport(char const* name, stored::PolledLayer& a, stored::PolledLayer& b)
+{
+	ASSERT_EQ(a.lastError(), 0);
+	ASSERT_EQ(b.lastError(), 0);
+
+	EchoLayer echo;
+	b.wrap(echo);
+
+	EchoLayer count;
+	count.echo = false;
+	a.wrap(count);
+
+	std::atomic<bool> stop{false};
+	std::thread t([&]() {
+		while(!stop && recvOk(b.recv(10000)))
+			;
+	});
+
+	int const roundtrips = 10000;
+	char msg[] = "ping";
+
+	auto start = std::chrono::steady_clock::now();
+	for(int i = 0; i < roundtrips; i++) {
+		size_t expect = count.bytes + 4;
+		a.encode(msg, 4);
+		while(count.bytes < expect)
+			ASSERT_TRUE(recvOk(a.recv(-1)));
+	}
+	double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	double latency = dt / roundtrips * 1e6;
+
+	stop = true;
+	t.join();
+
+	echo.echo = false;
+	echo.bytes = 0;
+
+	std::vector<char> block(1024, 'x');
+	size_t const total = 32U << 20U;
+
+	start = std::chrono::steady_clock::now();
+	t = std::thread([&]() {
+		while(echo.bytes < total && recvOk(b.recv(10000)))
+			;
+	});
+
+	for(size_t sent = 0; sent < total; sent += block.size())
+		a.encode(block.data(), block.size());
+
+	t.join();
+	dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	EXPECT_EQ(echo.bytes, total);
+	printf("%-8s %8.2f us/roundtrip %8.1f MB/s\n", name, latency, (double)total / dt * 1e-6);
+}
+
+TEST(ShmLayer, Benchmark)
+{
+	SKIP_UNLESS_BENCHMARK();
+
+#	ifdef STORED_OS_LINUX
+	{
+		stored::ShmLayer a("/libstored-test-shm-benchmark", true);
+		stored::ShmLayer b("/libstored-test-shm-benchmark", false);
+		benchmarkTransport("shm", a, b);
+	}
+#	endif
+
+	{
+		int fds_ab[2];
+		int fds_ba[2];
+		ASSERT_EQ(pipe(fds_ab), 0);
+		ASSERT_EQ(pipe(fds_ba), 0);
+		stored::DoublePipeLayer a(fds_ba[0], fds_ab[1]);
+		stored::DoublePipeLayer b(fds_ab[0], fds_ba[1]);
+		benchmarkTransport("pipe", a, b);
+	}
+
+#	ifdef STORED_HAVE_ZMQ
+	void* context = zmq_ctx_new();
+	{
+		stored::SyncZmqLayer a(context, "inproc://benchmark", true);
+		stored::SyncZmqLayer b(context, "inproc://benchmark", false);
+		benchmarkTransport("zmq", a, b);
+	}
+	zmq_ctx_term(context);
+#	endif
+}
+#endif // !STORED_OS_WINDOWS
+
 TEST(FifoLoopback1, FifoLoopback1)
 {
 	LoggingLayer top;
@@ -0,0 +1,234 @@
+/*
+ * libstored, distributed debuggable data stores.
+ * Copyright (C) 2020-2022  Jochem Rutgers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "Benchmark.h"
+#include "TestStore.h"
+#include "gtest/gtest.h"
+
+#include <libstored/snapshot.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class SnapshotTestStore
+	: public STORE_T(SnapshotTestStore, stored::Snapshottable, stored::TestStoreBase) {
+	STORE_CLASS(SnapshotTestStore, stored::Snapshottable, stored::TestStoreBase)
+public:
+	SnapshotTestStore() is_default
+};
+
+namespace {
+
+TEST(Snapshot, Seq)
+{
+	SnapshotTestStore store;
+	auto s = store.seq();
+	EXPECT_EQ(s % 2u, 0u);
+
+	store.default_int32 = 1;
+	EXPECT_EQ(store.seq(), s + 2u);
+
+	store.beginWrite();
+	EXPECT_EQ(store.seq() % 2u, 1u);
+	store.default_int32 = 2;
+	store.default_int64 = 2;
+	EXPECT_EQ(store.seq(), s + 3u);
+	store.endWrite();
+	EXPECT_EQ(store.seq(), s + 4u);
+
+	{
+		stored::Transaction<SnapshotTestStore> t(store);
+		t.set(store.default_int32, 3);
+		t.set(store.default_int64, 3);
+	}
+	EXPECT_EQ(store.seq(), s + 6u);
+
+	std::vector<char> buffer(SnapshotTestStore::BufferSize);
+	EXPECT_EQ(store.snapshot(buffer.data()), s + 6u);
+
+	int32_t i32 = 0;
+	memcpy(&i32, &buffer[store.default_int32.key()], sizeof(i32));
+	EXPECT_EQ(i32, 3);
+
+	int64_t i64 = 0;
+	EXPECT_EQ(store.read([&]() { i64 = store.default_int64.get(); }), s + 6u);
+	EXPECT_EQ(i64, 3);
+}
+
+TEST(Snapshot, Hooks)
+{
+	SnapshotTestStore store;
+	store.enableHooks();
+	EXPECT_TRUE(store.hooksEnabled());
+
+	// The store requires its hooks, also when accessed via the base class.
+	stored::TestStoreBase<SnapshotTestStore>& base = store;
+	EXPECT_TRUE(base.hooksEnabled());
+	if(!stored::Config::EnableAssert) {
+		// Otherwise, this asserts.
+		base.enableHooks(false);
+		EXPECT_TRUE(store.hooksEnabled());
+	}
+
+	auto s = store.seq();
+	store.default_int32 = 1;
+	EXPECT_EQ(store.seq(), s + 2u);
+}
+
+#ifndef STORED_COMPILER_MINGW
+// MinGW does not implement std::thread.
+
+TEST(Snapshot, Consistent)
+{
+	SnapshotTestStore store;
+	std::atomic<bool> stop{false};
+
+	std::thread writer([&]() {
+		int32_t i = 0;
+		while(!stop) {
+			i++;
+			if(i % 2) {
+				stored::Transaction<SnapshotTestStore> t(store);
+				t.set(store.default_int32, i);
+				t.set(store.default_int64, i);
+				t.set(store.default_double, i);
+			} else {
+				store.beginWrite();
+				store.default_int32 = i;
+				store.default_int64 = i;
+				store.default_double = i;
+				store.endWrite();
+			}
+
+			if(i % 16 == 0)
+				std::this_thread::yield();
+		}
+	});
+
+	auto key_i32 = store.default_int32.key();
+	auto key_i64 = store.default_int64.key();
+	auto key_d = store.default_double.key();
+
+	size_t inconsistent = 0;
+	std::vector<char> buffer(SnapshotTestStore::BufferSize);
+	int32_t last = 0;
+
+	for(int r = 0; r < 10000; r++) {
+		int32_t i32 = 0;
+		int64_t i64 = 0;
+		double d = 0;
+
+		if(r % 2) {
+			store.snapshot(buffer.data());
+			memcpy(&i32, &buffer[key_i32], sizeof(i32));
+			memcpy(&i64, &buffer[key_i64], sizeof(i64));
+			memcpy(&d, &buffer[key_d], sizeof(d));
+		} else {
+			store.read([&]() {
+				i32 = store.default_int32.get();
+				i64 = store.default_int64.get();
+				d = store.default_double.get();
+			});
+		}
+
+		if(i64 != i32 || d != (double)i32 || i32 < last)
+			inconsistent++;
+
+		last = i32;
+
+		if(r % 16 == 0)
+			std::this_thread::yield();
+	}
+
+	stop = true;
+	writer.join();
+
+	EXPECT_EQ(inconsistent, 0u);
+	EXPECT_GT(last, 0);
+}
+
+TEST(Snapshot, Benchmark)
+{
+	SKIP_UNLESS_BENCHMARK();
+
+	SnapshotTestStore store;
+	std::mutex mutex;
+
+	// Returns the number of snapshots per second of all readers together.
+	auto run = [&](size_t readers, bool seqlock) {
+		std::atomic<bool> stop{false};
+		std::atomic<size_t> snapshots{0};
+
+		std::thread writer([&]() {
+			int32_t i = 0;
+			while(!stop) {
+				i++;
+				if(seqlock) {
+					stored::Transaction<SnapshotTestStore> t(store);
+					t.set(store.default_int32, i);
+					t.set(store.default_int64, i);
+					t.set(store.default_double, i);
+				} else {
+					std::lock_guard<std::mutex> l(mutex);
+					store.default_int32 = i;
+					store.default_int64 = i;
+					store.default_double = i;
+				}
+
+				// A control loop that publishes at about 100 kHz.
+				std::this_thread::sleep_for(std::chrono::microseconds(10));
+			}
+		});
+
+		std::vector<std::thread> threads;
+		for(size_t r = 0; r < readers; r++)
+			threads.emplace_back([&]() {
+				std::vector<char> buffer(SnapshotTestStore::BufferSize);
+				size_t count = 0;
+				while(!stop) {
+					if(seqlock) {
+						store.snapshot(buffer.data());
+					} else {
+						// Never retries, as the writer holds the mutex too.
+						std::lock_guard<std::mutex> l(mutex);
+						store.snapshot(buffer.data());
+					}
+					count++;
+				}
+				snapshots += count;
+			});
+
+		auto start = std::chrono::steady_clock::now();
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		stop = true;
+
+		for(auto& t : threads)
+			t.join();
+		writer.join();
+
+		double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+				    .count();
+		return (double)snapshots / dt;
+	};
+
+	printf("%u hardware threads, %u byte store\n", std::thread::hardware_concurrency(),
+	       (unsigned)SnapshotTestStore::BufferSize);
+	printf("readers    seqlock snapshots/s    mutex snapshots/s\n");
+	for(size_t readers = 1; readers <= 16; readers *= 2)
+		printf("%7u %24.3g %20.3g\n", (unsigned)readers, run(readers, true),
+		       run(readers, false));
+}
+
+#endif // STORED_COMPILER_MINGW
+
+} // namespace
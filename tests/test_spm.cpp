@@ -8,8 +8,11 @@
  */
 
 #include "libstored/spm.h"
+#include "Benchmark.h"
 #include "gtest/gtest.h"
 
+#include <chrono>
+
 namespace {
 
 TEST(ScrachPad, Alloc)
@@ -43,8 +46,8 @@ TEST(ScrachPad, Alloc)
 	EXPECT_NE(spm.alloc<float>(3), nullptr);
 }
 
-template <size_t S>
-void spmInfo(stored::ScratchPad<S>& spm)
+template <size_t S, size_t D>
+void spmInfo(stored::ScratchPad<S, D>& spm)
 {
 	printf("%p: buffer=%p size=%zu cap=%zu max=%zu chunks=%zu\n", &spm,
 	       spm.template alloc<char>(0), spm.size(), spm.capacity(), spm.max(), spm.chunks());
@@ -196,4 +199,138 @@ TEST(ScratchPad, Stress)
 	spmInfo(spm);
 }
 
+TEST(ScratchPad, Spare)
+{
+	stored::ScratchPad<> spm;
+	EXPECT_NE(spm.alloc<char>(16), nullptr);
+
+	// Overflow within a nested snapshot repeatedly, like Debugger 'R' does.
+	for(int i = 0; i < 10; i++) {
+		auto s = spm.snapshot();
+		EXPECT_NE(spm.alloc<char>(spm.capacity() - spm.size() + 100), nullptr);
+		EXPECT_EQ(spm.chunks(), 2);
+	}
+
+	// The overflow chunk was retained after the first rollback.
+	EXPECT_EQ(spm.stats().allocations, 2);
+	EXPECT_EQ(spm.stats().deallocations, 0);
+	EXPECT_EQ(spm.chunks(), 1);
+
+	// Reset coalesces into one chunk.
+	size_t hwm = spm.max();
+	spm.reset();
+	EXPECT_EQ(spm.chunks(), 1);
+	EXPECT_GE(spm.capacity(), hwm);
+	EXPECT_EQ(spm.stats().coalesces, 1);
+	EXPECT_EQ(spm.stats().allocations - spm.stats().deallocations, 1);
+
+	// Steady state.
+	size_t allocations = spm.stats().allocations;
+	for(int i = 0; i < 10; i++) {
+		EXPECT_NE(spm.alloc<char>(hwm), nullptr);
+		spm.reset();
+	}
+	EXPECT_EQ(spm.stats().allocations, allocations);
+	EXPECT_EQ(spm.chunks(), 1);
+	EXPECT_EQ(spm.stats().resets, 11);
+	EXPECT_EQ(spm.stats().peak, hwm);
+}
+
+TEST(ScratchPad, Decay)
+{
+	stored::ScratchPad<0xffff, 4> spm;
+
+	EXPECT_NE(spm.alloc<char>(1000), nullptr);
+	spm.reset();
+	EXPECT_EQ(spm.max(), 750);
+	size_t cap = spm.capacity();
+	EXPECT_GE(cap, 1000);
+
+	// Small requests let the high-water mark decay, until the chunk is
+	// replaced by a smaller one.
+	size_t allocations = spm.stats().allocations;
+	int resets = 0;
+	while(spm.capacity() == cap) {
+		EXPECT_NE(spm.alloc<char>(10), nullptr);
+		spm.reset();
+		resets++;
+		ASSERT_LT(resets, 100);
+	}
+
+	EXPECT_EQ(spm.stats().allocations, allocations + 1);
+	EXPECT_EQ(spm.chunks(), 1);
+	EXPECT_LT(spm.capacity(), cap / 2);
+	EXPECT_GE(spm.capacity(), 10);
+	printf("shrunk after %d resets to %zu\n", resets, spm.capacity());
+
+	// Without decay, the chunk is kept.
+	stored::ScratchPad<0xffff, 0> keep;
+	EXPECT_NE(keep.alloc<char>(1000), nullptr);
+	for(int i = 0; i < 100; i++) {
+		keep.reset();
+		EXPECT_NE(keep.alloc<char>(10), nullptr);
+	}
+	EXPECT_EQ(keep.max(), 1000);
+	EXPECT_EQ(keep.stats().allocations, 1);
+}
+
+template <typename SPM>
+void spmBurst(SPM& spm, size_t requests)
+{
+	for(size_t r = 0; r < requests; r++) {
+		// Every request starts with an empty snapshot, like Debugger::process().
+		auto request = spm.snapshot();
+
+		// Decoded name and response of a small request.
+		EXPECT_NE(spm.template alloc<char>(48), nullptr);
+		EXPECT_NE(spm.template alloc<void*>(2), nullptr);
+
+		if(r % 64 == 63) {
+			// A large 'R', processed in chunks.
+			for(int chunk = 0; chunk < 64; chunk++) {
+				auto s = spm.snapshot();
+				EXPECT_NE(spm.template alloc<char>(128), nullptr);
+			}
+		}
+
+		if(r % 512 == 511) {
+			// A large 'l', which accumulates.
+			for(int object = 0; object < 300; object++)
+				EXPECT_NE(spm.template alloc<char>(40), nullptr);
+		}
+	}
+}
+
+template <typename SPM>
+void spmBurstBenchmark(char const* name)
+{
+	size_t allocations = 0;
+	TestAllocatorBase::allocate_cb = [&](std::type_info const*, void*, size_t, size_t) {
+		allocations++;
+	};
+
+	SPM spm;
+	size_t const requests = 1000000;
+
+	auto start = std::chrono::steady_clock::now();
+	spmBurst(spm, requests);
+	auto dt = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - start);
+
+	TestAllocatorBase::allocate_cb = nullptr;
+
+	printf("%-12s: %5.1f ns/request, %zu allocations, %zu coalesces, capacity %zu\n", name,
+	       (double)dt.count() / (double)requests, allocations, spm.stats().coalesces,
+	       spm.capacity());
+}
+
+TEST(ScratchPad, BurstBenchmark)
+{
+	SKIP_UNLESS_BENCHMARK();
+
+	spmBurstBenchmark<stored::ScratchPad<0xffff, 0>>("no decay");
+	spmBurstBenchmark<stored::ScratchPad<0xffff, 256>>("decay 1/256");
+	spmBurstBenchmark<stored::ScratchPad<0xffff, 16>>("decay 1/16");
+}
+
 } // namespace
@@ -7,6 +7,7 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/.
  */
 
+#include "Benchmark.h"
 #include "TestStore.h"
 #include "gtest/gtest.h"
 
@@ -14,6 +15,7 @@
 #include "LoggingLayer.h"
 
 #include <chrono>
+#include <vector>
 
 class SyncTestStore : public stored::Synchronizable<stored::TestStoreBase<SyncTestStore>> {
 	friend class stored::TestStoreBase<SyncTestStore>;
@@ -330,4 +332,335 @@ TEST(Synchronizer, Sync5)
 	EXPECT_GT(count, 100);
 }
 
+TEST(Synchronizer, Transaction)
+{
+	SyncTestStore store1;
+	SyncTestStore store2;
+
+	stored::Synchronizer s1;
+	stored::Synchronizer s2;
+
+	stored::ProtocolLayer l1;
+	stored::ProtocolLayer l2;
+	stored::Loopback loop(l1, l2);
+
+	s1.map(store1);
+	s2.map(store2);
+	s1.connect(l1);
+	s2.connect(l2);
+	s2.syncFrom(store2, l2);
+
+	// Make sure some keys are in the journal already, and others are not.
+	store1.default_int32 = 1;
+	s1.process();
+
+	auto now = store1.journal().bumpSeq();
+	auto key = [](auto const& o) { return (stored::StoreJournal::Key)o.key(); };
+
+	{
+		stored::Transaction<SyncTestStore, 4> t(store1);
+		t.set(store1.default_float, 2.5f);
+		t.set(store1.default_int32, 2);
+		t.set(store1.default_uint8, 3);
+		t.set(store1.default_int32, 4);
+		t.set(store1.default_bool, false);
+		EXPECT_EQ(t.size(), 5u - 4u); // committed once because of the capacity
+
+		t.set(store1.default_uint16.variable(), 5);
+		t.set(store1.default_double, 6);
+		EXPECT_EQ(t.size(), 3u);
+
+		EXPECT_EQ(store1.default_int32.get(), 4);
+		EXPECT_EQ(store1.default_uint16.get(), 0);
+		EXPECT_FALSE(store1.journal().hasChanged(key(store1.default_uint16), now));
+	}
+
+	EXPECT_EQ(store1.default_float.get(), 2.5f);
+	EXPECT_EQ(store1.default_int32.get(), 4);
+	EXPECT_EQ(store1.default_uint8.get(), 3);
+	EXPECT_EQ(store1.default_uint16.get(), 5);
+	EXPECT_EQ(store1.default_double.get(), 6);
+
+	EXPECT_TRUE(store1.journal().hasChanged(key(store1.default_float), now));
+	EXPECT_TRUE(store1.journal().hasChanged(key(store1.default_int32), now));
+	EXPECT_TRUE(store1.journal().hasChanged(key(store1.default_uint8), now));
+	EXPECT_TRUE(store1.journal().hasChanged(key(store1.default_uint16), now));
+	EXPECT_TRUE(store1.journal().hasChanged(key(store1.default_double), now));
+	// Not changed, so not recorded.
+	EXPECT_FALSE(store1.journal().hasChanged(key(store1.default_bool), now));
+	EXPECT_FALSE(store1.journal().hasChanged(key(store1.default_int16), now));
+
+	// All keys are known now; the next transaction does not insert.
+	now = store1.journal().bumpSeq();
+	{
+		stored::Transaction<SyncTestStore> t(store1);
+		t.set(store1.default_double, 7);
+		t.set(store1.default_uint8, 8);
+		t.clear();
+		t.set(store1.default_uint8, 9);
+		t.commit();
+		EXPECT_EQ(t.size(), 0u);
+	}
+
+	EXPECT_EQ(store1.default_double.get(), 6);
+	EXPECT_EQ(store1.default_uint8.get(), 9);
+	EXPECT_TRUE(store1.journal().hasChanged(key(store1.default_uint8), now));
+	EXPECT_FALSE(store1.journal().hasChanged(key(store1.default_double), now));
+	EXPECT_FALSE(store1.journal().hasChanged(key(store1.default_int32), now));
+
+	s1.process();
+	s2.process();
+	EXPECT_SYNCED(store1, store2);
+	EXPECT_EQ(store2.default_uint16.get(), 5);
+}
+
+TEST(Synchronizer, Array)
+{
+	SyncTestStore store1;
+	SyncTestStore store2;
+
+	stored::Synchronizer s1;
+	stored::Synchronizer s2;
+
+	stored::ProtocolLayer l1;
+	stored::ProtocolLayer l2;
+	stored::Loopback loop(l1, l2);
+
+	s1.map(store1);
+	s2.map(store2);
+	s1.connect(l1);
+	s2.connect(l2);
+	s2.syncFrom(store2, l2);
+
+	auto now = store1.journal().bumpSeq();
+
+	// A bulk write is recorded as one range, at the first element.  All
+	// elements are reported as changed.
+	uint16_t const src[] = {1, 2, 3, 4};
+	store1.array_uint16.set(src);
+
+	size_t keySize = stored::StoreJournal::keySize(SyncTestStore::BufferSize);
+	std::vector<stored::StoreJournal::Key> keys;
+	store1.journal().iterateChanged(
+		now, [&](stored::StoreJournal::Key k) { keys.push_back(k); });
+	ASSERT_EQ(keys.size(), 4u);
+	for(size_t i = 0; i < keys.size(); i++)
+		EXPECT_EQ(keys[i], (stored::StoreJournal::Key)store1.array_uint16[i].key());
+	EXPECT_TRUE(store1.journal().hasChanged(
+		(stored::StoreJournal::Key)store1.array_uint16_3.key(), now));
+	EXPECT_FALSE(store1.journal().hasChanged(
+		(stored::StoreJournal::Key)store1.array_bool_0.key(), now));
+
+	{
+		LoggingLayer ll;
+		store1.journal().encodeUpdates(ll, now);
+		ASSERT_EQ(ll.encoded().size(), 1u);
+		// Key, length and all elements.
+		EXPECT_EQ(ll.encoded().at(0).size(), 2U * keySize + sizeof(src));
+	}
+
+	// An element within the pending range is sent as part of the range.
+	store1.array_uint16[2] = 7;
+
+	{
+		LoggingLayer ll;
+		store1.journal().encodeUpdates(ll, now);
+		ASSERT_EQ(ll.encoded().size(), 1u);
+		EXPECT_EQ(ll.encoded().at(0).size(), 2U * keySize + sizeof(src));
+	}
+
+	// Writing the first element does not truncate the pending range.
+	store1.array_uint16[0] = 5;
+
+	s1.process();
+	EXPECT_EQ(store2.array_uint16_0.get(), 5u);
+	EXPECT_EQ(store2.array_uint16_2.get(), 7u);
+	EXPECT_EQ(store2.array_uint16_3.get(), 4u);
+	EXPECT_SYNCED(store1, store2);
+
+	// The receiver records the range too, and reports all elements.
+	SyncTestStore store3;
+	auto now3 = store3.journal().bumpSeq();
+	{
+		LoggingLayer ll;
+		store1.journal().encodeUpdates(ll, now);
+		std::string msg = ll.allEncoded();
+		void* buf = &msg[0];
+		size_t len = msg.size();
+		EXPECT_NE(store3.journal().decodeUpdates(buf, len), 0u);
+	}
+
+	keys.clear();
+	store3.journal().iterateChanged(
+		now3, [&](stored::StoreJournal::Key k) { keys.push_back(k); });
+	ASSERT_EQ(keys.size(), 4u);
+	for(size_t i = 0; i < keys.size(); i++)
+		EXPECT_EQ(keys[i], (stored::StoreJournal::Key)store3.array_uint16[i].key());
+	EXPECT_TRUE(store3.journal().hasChanged(
+		(stored::StoreJournal::Key)store3.array_uint16_3.key(), now3));
+
+	// Afterwards, writing one element only sends that element.
+	now = store1.journal().bumpSeq();
+	store1.array_uint16[0] = 6;
+	size_t c = 0;
+	store1.journal().iterateChanged(now, [&](stored::StoreJournal::Key) { c++; });
+	EXPECT_EQ(c, 1u);
+	EXPECT_FALSE(store1.journal().hasChanged(
+		(stored::StoreJournal::Key)store1.array_uint16_3.key(), now));
+
+	LoggingLayer ll;
+	store1.journal().encodeUpdates(ll, now);
+	ASSERT_EQ(ll.encoded().size(), 1u);
+	// Key, length and the element itself.
+	EXPECT_EQ(ll.encoded().at(0).size(), 2U * keySize + sizeof(uint16_t));
+}
+
+TEST(Synchronizer, HooksDisabled)
+{
+	SyncTestStore store;
+	auto key = (stored::StoreJournal::Key)store.default_int32.key();
+	EXPECT_TRUE(store.hooksEnabled());
+
+	// Not synchronized yet, so the journal is not needed.
+	store.enableHooks(false);
+	EXPECT_FALSE(store.hooksEnabled());
+
+	auto now = store.journal().bumpSeq();
+	store.default_int32 = 1;
+	EXPECT_EQ(store.default_int32.get(), 1);
+	EXPECT_FALSE(store.journal().hasChanged(key, now));
+
+	// Mapping enables the hooks again.
+	stored::Synchronizer s;
+	s.map(store);
+	EXPECT_TRUE(store.hooksEnabled());
+
+	store.default_int32 = 2;
+	EXPECT_TRUE(store.journal().hasChanged(key, now));
+
+	// Not even through the base class, the hooks can be disabled while mapped.
+	stored::TestStoreBase<SyncTestStore>& base = store;
+	EXPECT_TRUE(base.hooksEnabled());
+
+	// Once unmapped, the store falls back to its own setting.
+	s.unmap(store);
+	EXPECT_FALSE(store.hooksEnabled());
+	store.enableHooks();
+	EXPECT_TRUE(store.hooksEnabled());
+}
+
+TEST(Synchronizer, HooksBenchmark)
+{
+	SKIP_UNLESS_BENCHMARK();
+
+	enum { Accesses = 1000000, Rounds = 5 };
+
+	stored::TestStore plain;
+	SyncTestStore inactive;
+	inactive.enableHooks(false);
+	SyncTestStore active;
+	stored::Synchronizer s;
+	s.map(active);
+
+	// Returns the best ns per get() and set() pair.
+	auto measure = [&](auto& store) {
+		auto& v = store.default_int32;
+		uint32_t sum = 0;
+		double best = 0;
+		for(int r = 0; r < Rounds; r++) {
+			auto start = std::chrono::steady_clock::now();
+			for(int32_t i = 0; i < Accesses; i++) {
+				v.set(i);
+				sum += (uint32_t)v.get();
+			}
+			double dt = std::chrono::duration<double, std::nano>(
+					    std::chrono::steady_clock::now() - start)
+					    .count()
+				    / Accesses;
+			if(r == 0 || dt < best)
+				best = dt;
+		}
+		EXPECT_NE(sum, 0u);
+		return best;
+	};
+
+	printf("ns per get() and set(): %.2f plain store, %.2f synchronizable with hooks "
+	       "disabled, %.2f synchronizable and mapped\n",
+	       measure(plain), measure(inactive), measure(active));
+}
+
+TEST(Synchronizer, TransactionBenchmark)
+{
+	SKIP_UNLESS_BENCHMARK();
+
+	enum { Writes = 50, Ticks = 5000, Rounds = 10 };
+
+	SyncTestStore store;
+	store.reserveHeap();
+
+	// Let the journal contain all variables, as it does after running for a while.
+	std::vector<stored::Variable<float, SyncTestStore>> vars;
+	for(auto& o : store.map()) {
+		if(!o.second.isVariable())
+			continue;
+
+		store.journal().changed(
+			(stored::StoreJournal::Key)o.second.key(), o.second.size());
+
+		if(o.second.type() == stored::Type::Float && vars.size() < (size_t)Writes)
+			vars.push_back(o.second.variable<float>());
+	}
+	ASSERT_EQ(vars.size(), (size_t)Writes);
+
+	// The map is sorted by name, which is a random order in the store.
+	auto ordered = vars;
+	std::sort(ordered.begin(), ordered.end(), [](auto const& a, auto const& b) {
+		return a.key() < b.key();
+	});
+
+	float x = 0;
+	auto measure = [&](auto&& tick) {
+		double best = 0;
+		for(int r = 0; r < Rounds; r++) {
+			auto start = std::chrono::steady_clock::now();
+			for(int i = 0; i < Ticks; i++) {
+				x += 1.0f;
+				tick(x);
+				store.journal().bumpSeq();
+			}
+			double dt = std::chrono::duration<double, std::nano>(
+					    std::chrono::steady_clock::now() - start)
+					    .count()
+				    / Ticks;
+			if(r == 0 || dt < best)
+				best = dt;
+		}
+		return best;
+	};
+
+	double single = measure([&](float v) {
+		for(auto& var : vars)
+			var.set(v);
+	});
+
+	double ordered_ = measure([&](float v) {
+		stored::Transaction<SyncTestStore, Writes> t(store);
+		for(auto& var : ordered)
+			t.set(var, v);
+	});
+
+	double unordered = measure([&](float v) {
+		stored::Transaction<SyncTestStore, Writes> t(store);
+		for(auto& var : vars)
+			t.set(var, v);
+	});
+
+	for(auto& var : vars)
+		EXPECT_EQ(var.get(), x);
+
+	printf("%d writes per tick: %.0f ns single, %.0f ns transaction in store order, "
+	       "%.0f ns transaction in random order\n",
+	       (int)Writes, single, ordered_, unordered);
+}
+
 } // namespace
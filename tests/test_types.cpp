@@ -187,4 +187,55 @@ TEST(Types, FreeVariable)
 	EXPECT_EQ(v.get(), 11);
 }
 
+// A hand-written container, which does not provide hooksEnabled().
+class HookCounter {
+public:
+	typedef uintptr_t Key;
+
+	void hookEntryX(stored::Type::type, void*, size_t) noexcept
+	{
+		x++;
+	}
+
+	void hookExitX(stored::Type::type, void*, size_t, bool) noexcept {}
+
+	void hookEntryRO(stored::Type::type, void*, size_t) noexcept
+	{
+		ro++;
+	}
+
+	void hookExitRO(stored::Type::type, void*, size_t) noexcept {}
+
+	int x = 0;
+	int ro = 0;
+};
+
+// The same, but with the hooks disabled.
+class DisabledHookCounter : public HookCounter {
+public:
+	bool hooksEnabled() const noexcept
+	{
+		return false;
+	}
+};
+
+TEST(Types, HandWrittenContainer)
+{
+	int32_t buffer = 0;
+
+	HookCounter c;
+	stored::Variable<int32_t, HookCounter> v(c, buffer);
+	v = 1;
+	EXPECT_EQ(v.get(), 1);
+	EXPECT_EQ(c.x, 1);
+	EXPECT_EQ(c.ro, 1);
+
+	DisabledHookCounter d;
+	stored::Variable<int32_t, DisabledHookCounter> w(d, buffer);
+	w = 2;
+	EXPECT_EQ(w.get(), 2);
+	EXPECT_EQ(d.x, 0);
+	EXPECT_EQ(d.ro, 0);
+}
+
 } // namespace